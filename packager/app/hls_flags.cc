@@ -24,3 +24,13 @@ DEFINE_string(hls_playlist_type,
               "VOD, EVENT, or LIVE. This defines the EXT-X-PLAYLIST-TYPE in "
               "the HLS specification. For hls_playlist_type of LIVE, "
               "EXT-X-PLAYLIST-TYPE tag is omitted.");
+DEFINE_double(hls_can_skip_until,
+              0,
+              "For EVENT and LIVE playlists, if positive, writes a Playlist "
+              "Delta Update next to each Media Playlist, with '_delta' "
+              "inserted before the extension, in which the segments starting "
+              "this many seconds or more before the end of the playlist are "
+              "skipped. It is advertised with "
+              "EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL, and should be served for "
+              "playlist requests with _HLS_skip=YES. Should be at least six "
+              "times the target duration.");
@@ -39,6 +39,12 @@ DEFINE_double(minimum_update_period,
               "Indicates to the player how often to refresh the media "
               "presentation description in seconds. This value is used for "
               "dynamic MPD only.");
+DEFINE_double(mpd_patch_retention,
+              0.0,
+              "If positive, generates MPD Patch documents next to the dynamic "
+              "MPD, so players can update the MPD without fetching it in "
+              "full. Specifies, in seconds, how long the patch of each "
+              "published MPD is kept up to date.");
 DEFINE_double(time_shift_buffer_depth,
               1800.0,
               "Guaranteed duration of the time shifting buffer for dynamic "
@@ -16,6 +16,7 @@ DECLARE_bool(output_media_info);
 DECLARE_string(mpd_output);
 DECLARE_string(base_urls);
 DECLARE_double(minimum_update_period);
+DECLARE_double(mpd_patch_retention);
 DECLARE_double(min_buffer_time);
 DECLARE_double(time_shift_buffer_depth);
 DECLARE_double(suggested_presentation_delay);
@@ -11,6 +11,7 @@
 #include "packager/media/base/muxer_options.h"
 #include "packager/media/formats/mp2t/ts_muxer.h"
 #include "packager/media/formats/mp4/mp4_muxer.h"
+#include "packager/media/formats/packed_audio/packed_audio_writer.h"
 #include "packager/media/formats/webm/webm_muxer.h"
 #include "packager/packager.h"
 
@@ -40,6 +41,11 @@ std::shared_ptr<Muxer> MuxerFactory::CreateMuxer(
     case CONTAINER_MPEG2TS:
       muxer = std::make_shared<mp2t::TsMuxer>(options);
       break;
+    case CONTAINER_AAC:
+    case CONTAINER_AC3:
+    case CONTAINER_EAC3:
+      muxer = std::make_shared<PackedAudioWriter>(options);
+      break;
     case CONTAINER_MOV:
       muxer = std::make_shared<mp4::MP4Muxer>(options);
       break;
@@ -15,6 +15,7 @@
 #include "packager/app/packager_util.h"
 #include "packager/app/playready_key_encryption_flags.h"
 #include "packager/app/raw_key_encryption_flags.h"
+#include "packager/app/service_mode.h"
 #include "packager/app/stream_descriptor.h"
 #include "packager/app/vlog_flags.h"
 #include "packager/app/widevine_encryption_flags.h"
@@ -49,6 +50,27 @@ DEFINE_string(test_version,
               "",
               "Packager version for testing. Ignored if --override_version is "
               "false. Should be used for testing only.");
+DEFINE_bool(service_mode,
+            false,
+            "Run packager as a long running service. Packaging jobs are read "
+            "from stdin as JSON objects, one per line, and job status is "
+            "reported to stdout. Stream descriptors are specified in the jobs "
+            "instead of the command line. Other flags apply to all the jobs.");
+DEFINE_int32(service_max_concurrent_jobs,
+             4,
+             "The maximum number of jobs running concurrently in service "
+             "mode.");
+DEFINE_uint64(memory_budget_mb,
+              0,
+              "Memory budget in megabytes for the media data buffered while "
+              "packaging. Reading input is throttled while the buffered data "
+              "exceeds the budget. 0 means unlimited.");
+DEFINE_string(latency_trace_output,
+              "",
+              "If set, record the wall clock time of every segment from the "
+              "ingest of its first sample to the publication of the manifests "
+              "and write latency histograms of the stages to this file in "
+              "JSON. Intended for live packaging.");
 
 namespace shaka {
 namespace {
@@ -83,6 +105,9 @@ const char kUsage[] =
     "    derived from the file extension of the output file.\n"
     "  - skip_encryption=0|1: Optional. Defaults to 0 if not specified. If\n"
     "    it is set to 1, no encryption of the stream will be made.\n"
+    "  - protection_scheme: Optional value which overrides\n"
+    "    --protection_scheme for the output, so the same input stream can\n"
+    "    be packaged with different protection schemes in one pass.\n"
     "  - drm_label: Optional value for custom DRM label, which defines the\n"
     "    encryption key applied to the stream. Typical values include AUDIO,\n"
     "    SD, HD, UHD1, UHD2. For raw key, it should be a label defined in\n"
@@ -147,22 +172,8 @@ bool GetHlsPlaylistType(const std::string& playlist_type,
 }
 
 bool GetProtectionScheme(uint32_t* protection_scheme) {
-  if (FLAGS_protection_scheme == "cenc") {
-    *protection_scheme = EncryptionParams::kProtectionSchemeCenc;
-    return true;
-  }
-  if (FLAGS_protection_scheme == "cbc1") {
-    *protection_scheme = EncryptionParams::kProtectionSchemeCbc1;
-    return true;
-  }
-  if (FLAGS_protection_scheme == "cbcs") {
-    *protection_scheme = EncryptionParams::kProtectionSchemeCbcs;
-    return true;
-  }
-  if (FLAGS_protection_scheme == "cens") {
-    *protection_scheme = EncryptionParams::kProtectionSchemeCens;
+  if (media::ParseProtectionScheme(FLAGS_protection_scheme, protection_scheme))
     return true;
-  }
   LOG(ERROR) << "Unrecognized protection_scheme " << FLAGS_protection_scheme;
   return false;
 }
@@ -311,6 +322,10 @@ base::Optional<PackagingParams> GetPackagingParams() {
       widevine.content_id = FLAGS_content_id_bytes;
       widevine.policy = FLAGS_policy;
       widevine.group_id = FLAGS_group_id_bytes;
+      widevine.enable_key_cache = FLAGS_enable_key_cache;
+      widevine.key_cache_directory = FLAGS_key_cache_dir;
+      widevine.key_cache_encryption_key = FLAGS_key_cache_encryption_key_bytes;
+      widevine.key_prefetch_horizon_in_seconds = FLAGS_key_prefetch_horizon;
       if (!GetWidevineSigner(&widevine.signer))
         return base::nullopt;
       break;
@@ -384,6 +399,8 @@ base::Optional<PackagingParams> GetPackagingParams() {
   mp4_params.include_pssh_in_stream = FLAGS_mp4_include_pssh_in_stream;
 
   packaging_params.output_media_info = FLAGS_output_media_info;
+  packaging_params.memory_budget = FLAGS_memory_budget_mb << 20;
+  packaging_params.latency_trace_output = FLAGS_latency_trace_output;
 
   MpdParams& mpd_params = packaging_params.mpd_params;
   mpd_params.generate_static_live_mpd = FLAGS_generate_static_mpd;
@@ -393,6 +410,7 @@ base::Optional<PackagingParams> GetPackagingParams() {
   mpd_params.generate_dash_if_iop_compliant_mpd =
       FLAGS_generate_dash_if_iop_compliant_mpd;
   mpd_params.minimum_update_period = FLAGS_minimum_update_period;
+  mpd_params.mpd_patch_retention = FLAGS_mpd_patch_retention;
   mpd_params.min_buffer_time = FLAGS_min_buffer_time;
   mpd_params.time_shift_buffer_depth = FLAGS_time_shift_buffer_depth;
   mpd_params.suggested_presentation_delay = FLAGS_suggested_presentation_delay;
@@ -406,6 +424,7 @@ base::Optional<PackagingParams> GetPackagingParams() {
   hls_params.base_url = FLAGS_hls_base_url;
   hls_params.key_uri = FLAGS_hls_key_uri;
   hls_params.time_shift_buffer_depth = FLAGS_time_shift_buffer_depth;
+  hls_params.can_skip_until = FLAGS_hls_can_skip_until;
 
   TestParams& test_params = packaging_params.test_params;
   test_params.dump_stream_info = FLAGS_dump_stream_info;
@@ -428,7 +447,7 @@ int PackagerMain(int argc, char** argv) {
   google::SetVersionString(shaka::Packager::GetLibraryVersion());
   google::SetUsageMessage(base::StringPrintf(kUsage, argv[0]));
   google::ParseCommandLineFlags(&argc, &argv, true);
-  if (argc < 2) {
+  if (argc < 2 && !FLAGS_service_mode) {
     google::ShowUsageWithFlags("Usage");
     return kSuccess;
   }
@@ -442,6 +461,24 @@ int PackagerMain(int argc, char** argv) {
   if (!packaging_params)
     return kArgumentValidationFailed;
 
+  if (FLAGS_service_mode) {
+    if (argc > 1) {
+      LOG(ERROR) << "Stream descriptors should be specified in the jobs in "
+                    "service mode.";
+      return kArgumentValidationFailed;
+    }
+    if (FLAGS_service_max_concurrent_jobs <= 0) {
+      LOG(ERROR) << "--service_max_concurrent_jobs should be positive.";
+      return kArgumentValidationFailed;
+    }
+    PackagerServiceParams service_params;
+    service_params.max_concurrent_jobs = FLAGS_service_max_concurrent_jobs;
+    return RunServiceMode(packaging_params.value(), service_params, &std::cin,
+                          &std::cout)
+               ? kSuccess
+               : kPackagingFailed;
+  }
+
   std::vector<StreamDescriptor> stream_descriptors;
   for (int i = 1; i < argc; ++i) {
     base::Optional<StreamDescriptor> stream_descriptor =
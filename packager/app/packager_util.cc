@@ -11,6 +11,7 @@
 #include "packager/base/strings/string_split.h"
 #include "packager/file/file.h"
 #include "packager/media/base/media_handler.h"
+#include "packager/media/base/key_cache.h"
 #include "packager/media/base/muxer_options.h"
 #include "packager/media/base/playready_key_source.h"
 #include "packager/media/base/raw_key_source.h"
@@ -73,6 +74,16 @@ std::unique_ptr<KeySource> CreateEncryptionKeySource(
         widevine_key_source->set_signer(std::move(request_signer));
       }
       widevine_key_source->set_group_id(widevine.group_id);
+      widevine_key_source->set_key_prefetch_horizon(
+          base::TimeDelta::FromSecondsD(
+              widevine.key_prefetch_horizon_in_seconds));
+      if (widevine.enable_key_cache) {
+        std::shared_ptr<KeyCache> key_cache = KeyCache::GetSharedCache(
+            widevine.key_cache_directory, widevine.key_cache_encryption_key);
+        if (!key_cache)
+          return nullptr;
+        widevine_key_source->set_key_cache(std::move(key_cache));
+      }
 
       Status status =
           widevine_key_source->FetchKeys(widevine.content_id, widevine.policy);
@@ -176,6 +187,27 @@ std::unique_ptr<KeySource> CreateDecryptionKeySource(
   return decryption_key_source;
 }
 
+bool ParseProtectionScheme(const std::string& protection_scheme_name,
+                           uint32_t* protection_scheme) {
+  if (protection_scheme_name == "cenc") {
+    *protection_scheme = EncryptionParams::kProtectionSchemeCenc;
+    return true;
+  }
+  if (protection_scheme_name == "cbc1") {
+    *protection_scheme = EncryptionParams::kProtectionSchemeCbc1;
+    return true;
+  }
+  if (protection_scheme_name == "cbcs") {
+    *protection_scheme = EncryptionParams::kProtectionSchemeCbcs;
+    return true;
+  }
+  if (protection_scheme_name == "cens") {
+    *protection_scheme = EncryptionParams::kProtectionSchemeCens;
+    return true;
+  }
+  return false;
+}
+
 MpdOptions GetMpdOptions(bool on_demand_profile, const MpdParams& mpd_params) {
   MpdOptions mpd_options;
   mpd_options.dash_profile =
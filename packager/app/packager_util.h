@@ -10,6 +10,7 @@
 #define PACKAGER_APP_PACKAGER_UTIL_H_
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "packager/media/base/fourccs.h"
@@ -44,6 +45,14 @@ std::unique_ptr<KeySource> CreateEncryptionKeySource(
 std::unique_ptr<KeySource> CreateDecryptionKeySource(
     const DecryptionParams& decryption_params);
 
+/// Parses a protection scheme name, i.e. cenc, cbc1, cbcs or cens.
+/// @param protection_scheme_name is the name to parse.
+/// @param[out] protection_scheme is set to the matching
+///        EncryptionParams::kProtectionScheme* value on success.
+/// @return true on success, false if the name is not recognized.
+bool ParseProtectionScheme(const std::string& protection_scheme_name,
+                           uint32_t* protection_scheme);
+
 /// @return MpdOptions from provided inputs.
 MpdOptions GetMpdOptions(bool on_demand_profile, const MpdParams& mpd_params);
 
@@ -0,0 +1,208 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/app/service_mode.h"
+
+#include <map>
+#include <memory>
+
+#include "packager/app/stream_descriptor.h"
+#include "packager/base/json/json_reader.h"
+#include "packager/base/json/json_writer.h"
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/values.h"
+
+namespace shaka {
+namespace {
+
+const char kJobIdKey[] = "job_id";
+const char kCancelKey[] = "cancel";
+const char kStreamsKey[] = "streams";
+const char kMpdOutputKey[] = "mpd_output";
+const char kHlsMasterPlaylistOutputKey[] = "hls_master_playlist_output";
+const char kStateKey[] = "state";
+const char kErrorKey[] = "error";
+
+const char* JobStateToString(PackagerService::JobState state) {
+  switch (state) {
+    case PackagerService::JobState::kQueued:
+      return "queued";
+    case PackagerService::JobState::kRunning:
+      return "running";
+    case PackagerService::JobState::kCompleted:
+      return "completed";
+    case PackagerService::JobState::kFailed:
+      return "failed";
+    case PackagerService::JobState::kCancelled:
+      return "cancelled";
+  }
+  return "unknown";
+}
+
+bool ParseJobRequest(const base::DictionaryValue& request,
+                     const PackagingParams& base_params,
+                     PackagingParams* packaging_params,
+                     std::vector<StreamDescriptor>* stream_descriptors) {
+  const base::ListValue* streams = nullptr;
+  if (!request.GetList(kStreamsKey, &streams) || streams->GetSize() == 0) {
+    LOG(ERROR) << "Job request does not contain any streams.";
+    return false;
+  }
+  for (size_t i = 0; i < streams->GetSize(); ++i) {
+    std::string descriptor_string;
+    if (!streams->GetString(i, &descriptor_string)) {
+      LOG(ERROR) << "Stream descriptors should be strings.";
+      return false;
+    }
+    base::Optional<StreamDescriptor> stream_descriptor =
+        ParseStreamDescriptor(descriptor_string);
+    if (!stream_descriptor)
+      return false;
+    stream_descriptors->push_back(stream_descriptor.value());
+  }
+
+  *packaging_params = base_params;
+  request.GetString(kMpdOutputKey, &packaging_params->mpd_params.mpd_output);
+  request.GetString(kHlsMasterPlaylistOutputKey,
+                    &packaging_params->hls_params.master_playlist_output);
+  return true;
+}
+
+// Serializes job state reports from the service worker threads.
+class StatusReporter {
+ public:
+  explicit StatusReporter(std::ostream* output) : output_(output) {}
+
+  void Report(const std::string& job_id,
+              const std::string& state,
+              const std::string& error) {
+    base::DictionaryValue report;
+    report.SetString(kJobIdKey, job_id);
+    report.SetString(kStateKey, state);
+    if (!error.empty())
+      report.SetString(kErrorKey, error);
+    std::string json;
+    base::JSONWriter::Write(report, &json);
+
+    base::AutoLock auto_lock(lock_);
+    *output_ << json << std::endl;
+  }
+
+ private:
+  StatusReporter(const StatusReporter&) = delete;
+  StatusReporter& operator=(const StatusReporter&) = delete;
+
+  base::Lock lock_;
+  std::ostream* output_;
+};
+
+}  // namespace
+
+bool RunServiceMode(const PackagingParams& base_params,
+                    const PackagerServiceParams& service_params,
+                    std::istream* input,
+                    std::ostream* output) {
+  DCHECK(input);
+  DCHECK(output);
+
+  StatusReporter reporter(output);
+  base::Lock lock;
+  // Protected by |lock|.
+  std::map<int64_t, std::string> job_names;
+  std::map<std::string, int64_t> job_ids;
+  bool all_succeeded = true;
+
+  PackagerService service(service_params);
+  service.set_job_callback([&](int64_t job_id,
+                               const PackagerService::JobInfo& job_info) {
+    std::string job_name;
+    {
+      base::AutoLock auto_lock(lock);
+      job_name = job_names[job_id];
+      if (job_info.state == PackagerService::JobState::kFailed ||
+          job_info.state == PackagerService::JobState::kCancelled) {
+        all_succeeded = false;
+      }
+    }
+    reporter.Report(job_name, JobStateToString(job_info.state),
+                    job_info.status.ok() ? "" : job_info.status.ToString());
+  });
+  if (!service.Start().ok())
+    return false;
+
+  std::string line;
+  while (std::getline(*input, line)) {
+    if (line.empty())
+      continue;
+    std::unique_ptr<base::Value> root(base::JSONReader::Read(line));
+    const base::DictionaryValue* request = nullptr;
+    if (!root || !root->GetAsDictionary(&request)) {
+      LOG(ERROR) << "'" << line << "' is not a JSON object.";
+      reporter.Report("", "rejected", "Malformed request.");
+      continue;
+    }
+
+    std::string cancel_job_name;
+    if (request->GetString(kCancelKey, &cancel_job_name)) {
+      int64_t job_id = -1;
+      {
+        base::AutoLock auto_lock(lock);
+        auto iter = job_ids.find(cancel_job_name);
+        if (iter != job_ids.end())
+          job_id = iter->second;
+      }
+      if (job_id < 0)
+        reporter.Report(cancel_job_name, "rejected", "Unknown job.");
+      else
+        service.CancelJob(job_id);
+      continue;
+    }
+
+    std::string job_name;
+    request->GetString(kJobIdKey, &job_name);
+    PackagingParams packaging_params;
+    std::vector<StreamDescriptor> stream_descriptors;
+    if (!ParseJobRequest(*request, base_params, &packaging_params,
+                         &stream_descriptors)) {
+      reporter.Report(job_name, "rejected", "Invalid job request.");
+      continue;
+    }
+
+    // Hold the lock so the job callback cannot observe the job before it is
+    // registered.
+    base::AutoLock auto_lock(lock);
+    if (!job_name.empty() && job_ids.find(job_name) != job_ids.end()) {
+      reporter.Report(job_name, "rejected", "Duplicated job id.");
+      continue;
+    }
+    const int64_t job_id = service.AddJob(packaging_params, stream_descriptors);
+    if (job_id < 0) {
+      reporter.Report(job_name, "rejected", "Service is not running.");
+      continue;
+    }
+    // Jobs without a job id are named after the id assigned by the service.
+    // The generated name does not replace a job named alike by the client.
+    if (job_name.empty())
+      job_name = base::Int64ToString(job_id);
+    job_names[job_id] = job_name;
+    job_ids.insert(std::make_pair(job_name, job_id));
+    reporter.Report(job_name,
+                    JobStateToString(PackagerService::JobState::kQueued), "");
+  }
+
+  // Wait for all accepted jobs to complete. No more jobs are added at this
+  // point, so |job_names| can be accessed without the lock.
+  for (const auto& entry : job_names) {
+    PackagerService::JobInfo job_info;
+    service.WaitForJob(entry.first, &job_info);
+  }
+  service.Shutdown();
+  return all_succeeded;
+}
+
+}  // namespace shaka
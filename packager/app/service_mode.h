@@ -0,0 +1,39 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef APP_SERVICE_MODE_H_
+#define APP_SERVICE_MODE_H_
+
+#include <iostream>
+#include <string>
+
+#include "packager/packager.h"
+#include "packager/packager_service.h"
+
+namespace shaka {
+
+/// Runs the packager as a long running service. Job requests are read from
+/// @a input, one JSON object per line:
+///   {"job_id": "<id>", "streams": ["<stream descriptor>", ...],
+///    "mpd_output": "<path>", "hls_master_playlist_output": "<path>"}
+/// or, to cancel a queued / running job:
+///   {"cancel": "<id>"}
+/// The optional output fields override the corresponding fields in
+/// @a base_params. A job without "job_id" is identified by the numeric id
+/// assigned by the service, as reported in its "queued" state. Job state
+/// changes are reported to @a output as JSON lines:
+///   {"job_id": "<id>", "state": "<state>", "error": "<error>"}
+/// The service exits when @a input reaches end of file, after all accepted
+/// jobs have completed.
+/// @return true if all jobs completed successfully, false otherwise.
+bool RunServiceMode(const PackagingParams& base_params,
+                    const PackagerServiceParams& service_params,
+                    std::istream* input,
+                    std::ostream* output);
+
+}  // namespace shaka
+
+#endif  // APP_SERVICE_MODE_H_
@@ -6,6 +6,7 @@
 
 #include "packager/app/stream_descriptor.h"
 
+#include "packager/app/packager_util.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/string_split.h"
@@ -29,6 +30,7 @@ enum FieldType {
   kTrickPlayFactorField,
   kSkipEncryptionField,
   kDrmStreamLabelField,
+  kProtectionSchemeField,
 };
 
 struct FieldNameToTypeMapping {
@@ -61,6 +63,7 @@ const FieldNameToTypeMapping kFieldNameTypeMappings[] = {
     {"skip_encryption", kSkipEncryptionField},
     {"drm_stream_label", kDrmStreamLabelField},
     {"drm_label", kDrmStreamLabelField},
+    {"protection_scheme", kProtectionSchemeField},
 };
 
 FieldType GetFieldType(const std::string& field_name) {
@@ -161,6 +164,14 @@ base::Optional<StreamDescriptor> ParseStreamDescriptor(
         descriptor.drm_label = iter->second;
         break;
       }
+      case kProtectionSchemeField: {
+        if (!media::ParseProtectionScheme(iter->second,
+                                          &descriptor.protection_scheme)) {
+          LOG(ERROR) << "Unrecognized protection_scheme " << iter->second;
+          return base::nullopt;
+        }
+        break;
+      }
       default:
         LOG(ERROR) << "Unknown field in stream descriptor (\"" << iter->first
                    << "\").";
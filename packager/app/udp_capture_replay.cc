@@ -0,0 +1,181 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gflags/gflags.h>
+
+#include <memory>
+#include <vector>
+
+#include "packager/app/vlog_flags.h"
+#include "packager/base/at_exit.h"
+#include "packager/base/command_line.h"
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_split.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/file/udp_capture.h"
+#include "packager/version/version.h"
+
+#if defined(OS_WIN)
+#include <codecvt>
+#include <functional>
+#include <locale>
+#endif  // defined(OS_WIN)
+
+DEFINE_string(capture,
+              "",
+              "UDP stream to capture, of the form udp://ip:port[?options]. "
+              "Add a timeout option to stop the capture when the stream goes "
+              "quiet.");
+DEFINE_string(capture_file, "", "Capture file written by --capture.");
+DEFINE_double(capture_duration,
+              0,
+              "Duration of the capture in seconds. 0 means unlimited. "
+              "Requires a timeout option in --capture.");
+DEFINE_string(replay,
+              "",
+              "Comma separated list of channels to replay simultaneously, "
+              "each of the form <capture_file>=udp://ip:port[?interface=ip].");
+DEFINE_double(replay_speed,
+              1,
+              "Replay speed relative to the capture: 1 replays in real time, "
+              "2 twice as fast, etc. 0 replays as fast as possible.");
+
+namespace shaka {
+namespace {
+const char kUsage[] =
+    "UDP capture and replay driver program.\n"
+    "This program captures a live UDP stream, with the arrival times of its "
+    "datagrams, to a file, and replays captures to UDP destinations, e.g. "
+    "to benchmark live packaging over loopback.\n"
+    "Sample Usage:\n"
+    "%s --capture=udp://239.1.1.1:1234?timeout=5000000 "
+    "--capture_file=channel1.udpc --capture_duration=60\n"
+    "%s --replay=channel1.udpc=udp://127.0.0.1:5001,"
+    "channel2.udpc=udp://127.0.0.1:5002 --replay_speed=2";
+
+const char kUdpPrefix[] = "udp://";
+
+enum ExitStatus {
+  kSuccess = 0,
+  kArgumentValidationFailed,
+  kCaptureFailed,
+  kReplayFailed,
+};
+
+ExitStatus CheckRequiredFlags() {
+  if (FLAGS_capture.empty() == FLAGS_replay.empty()) {
+    LOG(ERROR) << "Exactly one of --capture and --replay is required.";
+    return kArgumentValidationFailed;
+  }
+  if (!FLAGS_capture.empty() && FLAGS_capture_file.empty()) {
+    LOG(ERROR) << "--capture_file is required with --capture.";
+    return kArgumentValidationFailed;
+  }
+  if (FLAGS_capture_duration < 0) {
+    LOG(ERROR) << "--capture_duration should not be negative.";
+    return kArgumentValidationFailed;
+  }
+  if (FLAGS_replay_speed < 0) {
+    LOG(ERROR) << "--replay_speed should not be negative.";
+    return kArgumentValidationFailed;
+  }
+  return kSuccess;
+}
+
+ExitStatus RunCapture() {
+  const int64_t duration =
+      static_cast<int64_t>(FLAGS_capture_duration * 1000000);
+  const int64_t num_datagrams =
+      CaptureUdp(FLAGS_capture, FLAGS_capture_file, duration);
+  if (num_datagrams < 0)
+    return kCaptureFailed;
+  LOG(INFO) << "Captured " << num_datagrams << " datagrams from "
+            << FLAGS_capture << " to " << FLAGS_capture_file;
+  return kSuccess;
+}
+
+ExitStatus RunReplay() {
+  std::vector<std::unique_ptr<UdpReplayer>> replayers;
+  for (const std::string& channel :
+       base::SplitString(FLAGS_replay, ",", base::TRIM_WHITESPACE,
+                         base::SPLIT_WANT_NONEMPTY)) {
+    // The destination may have options with '=', so split on the prefix.
+    const size_t pos = channel.find(std::string("=") + kUdpPrefix);
+    if (pos == std::string::npos || pos == 0) {
+      LOG(ERROR) << "Invalid replay channel '" << channel
+                 << "'. It should be of the form "
+                    "<capture_file>=udp://ip:port[?options].";
+      return kArgumentValidationFailed;
+    }
+    replayers.emplace_back(new UdpReplayer(
+        channel.substr(0, pos), channel.substr(pos + 1), FLAGS_replay_speed));
+  }
+
+  for (const std::unique_ptr<UdpReplayer>& replayer : replayers)
+    replayer->Start();
+
+  ExitStatus status = kSuccess;
+  for (const std::unique_ptr<UdpReplayer>& replayer : replayers) {
+    if (!replayer->Join())
+      status = kReplayFailed;
+    LOG(INFO) << "Replayed " << replayer->num_datagrams_sent()
+              << " datagrams (" << replayer->num_bytes_sent() << " bytes).";
+  }
+  return status;
+}
+
+int UdpCaptureReplayMain(int argc, char** argv) {
+  base::AtExitManager exit;
+  // Needed to enable VLOG/DVLOG through --vmodule or --v.
+  base::CommandLine::Init(argc, argv);
+
+  // Set up logging.
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LOG_TO_SYSTEM_DEBUG_LOG;
+  CHECK(logging::InitLogging(log_settings));
+
+  google::SetVersionString(GetPackagerVersion());
+  google::SetUsageMessage(base::StringPrintf(kUsage, argv[0], argv[0]));
+  google::ParseCommandLineFlags(&argc, &argv, true);
+
+  ExitStatus status = CheckRequiredFlags();
+  if (status != kSuccess) {
+    google::ShowUsageWithFlags("Usage");
+    return status;
+  }
+
+  return FLAGS_capture.empty() ? RunReplay() : RunCapture();
+}
+
+}  // namespace
+}  // namespace shaka
+
+#if defined(OS_WIN)
+// Windows wmain, which converts wide character arguments to UTF-8.
+int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
+  std::unique_ptr<char* [], std::function<void(char**)>> utf8_argv(
+      new char*[argc], [argc](char** utf8_args) {
+        // TODO(tinskip): This leaks, but if this code is enabled, it crashes.
+        // Figure out why. I suspect gflags does something funny with the
+        // argument array.
+        // for (int idx = 0; idx < argc; ++idx)
+        //   delete[] utf8_args[idx];
+        delete[] utf8_args;
+      });
+  std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+  for (int idx = 0; idx < argc; ++idx) {
+    std::string utf8_arg(converter.to_bytes(argv[idx]));
+    utf8_arg += '\0';
+    utf8_argv[idx] = new char[utf8_arg.size()];
+    memcpy(utf8_argv[idx], &utf8_arg[0], utf8_arg.size());
+  }
+  return shaka::UdpCaptureReplayMain(argc, utf8_argv.get());
+}
+#else
+int main(int argc, char** argv) {
+  return shaka::UdpCaptureReplayMain(argc, argv);
+}
+#endif  // !defined(OS_WIN)
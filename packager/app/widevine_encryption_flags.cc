@@ -64,6 +64,28 @@ DEFINE_int32(crypto_period_duration,
              "Crypto period duration in seconds. If it is non-zero, key "
              "rotation is enabled.");
 DEFINE_hex_bytes(group_id, "", "Identifier for a group of licenses (hex).");
+DEFINE_double(key_prefetch_horizon,
+              0,
+              "With key rotation, prefetch the keys needed in the next "
+              "key_prefetch_horizon seconds, plus the time to fetch them. The "
+              "number of crypto periods prefetched adapts to the rate the "
+              "keys are consumed and the key server latency. If 0, key "
+              "requests are sent back to back, as fast as a key pool of one "
+              "key request worth of crypto periods takes the keys.");
+DEFINE_bool(enable_key_cache,
+            false,
+            "Cache the keys fetched from the key server, so the keys for the "
+            "same content, policy and crypto period are only fetched once. "
+            "The cache is shared by all the jobs in service mode.");
+DEFINE_string(key_cache_dir,
+              "",
+              "Optional directory to persist the key cache to, so it survives "
+              "restarts. The entries are encrypted with "
+              "--key_cache_encryption_key.");
+DEFINE_hex_bytes(key_cache_encryption_key,
+                 "",
+                 "16 or 32 byte AES key (hex) used to encrypt the persisted "
+                 "key cache entries. Required with --key_cache_dir.");
 
 namespace shaka {
 namespace {
@@ -171,10 +193,38 @@ bool ValidateWidevineCryptoFlags() {
     success = false;
   }
 
+  if (FLAGS_enable_key_cache && !FLAGS_enable_widevine_encryption) {
+    PrintError("--enable_key_cache is only valid with "
+               "--enable_widevine_encryption");
+    success = false;
+  }
+  if (!ValidateFlag("key_cache_dir", FLAGS_key_cache_dir,
+                    FLAGS_enable_key_cache, kOptional, "--enable_key_cache")) {
+    success = false;
+  }
+  if (!ValidateFlag("key_cache_encryption_key",
+                    FLAGS_key_cache_encryption_key_bytes,
+                    !FLAGS_key_cache_dir.empty(), !kOptional,
+                    "--key_cache_dir")) {
+    success = false;
+  }
+  const size_t key_cache_encryption_key_size =
+      FLAGS_key_cache_encryption_key_bytes.size();
+  if (key_cache_encryption_key_size != 0 &&
+      key_cache_encryption_key_size != 16 &&
+      key_cache_encryption_key_size != 32) {
+    PrintError("--key_cache_encryption_key should be 16 or 32 bytes.");
+    success = false;
+  }
+
   if (FLAGS_crypto_period_duration < 0) {
     PrintError("--crypto_period_duration should not be negative.");
     success = false;
   }
+  if (FLAGS_key_prefetch_horizon < 0) {
+    PrintError("--key_prefetch_horizon should not be negative.");
+    success = false;
+  }
   return success;
 }
 
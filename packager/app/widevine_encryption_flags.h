@@ -27,7 +27,11 @@ DECLARE_hex_bytes(aes_signing_key);
 DECLARE_hex_bytes(aes_signing_iv);
 DECLARE_string(rsa_signing_key_path);
 DECLARE_int32(crypto_period_duration);
+DECLARE_double(key_prefetch_horizon);
 DECLARE_hex_bytes(group_id);
+DECLARE_bool(enable_key_cache);
+DECLARE_string(key_cache_dir);
+DECLARE_hex_bytes(key_cache_encryption_key);
 
 namespace shaka {
 
@@ -6,6 +6,8 @@
 
 #include "packager/file/callback_file.h"
 
+#include <string.h>
+
 #include "packager/base/logging.h"
 
 namespace shaka {
@@ -16,6 +18,8 @@ CallbackFile::CallbackFile(const char* file_name, const char* mode)
 CallbackFile::~CallbackFile() {}
 
 bool CallbackFile::Close() {
+  if (buffer_)
+    callback_params_->file_ready_func(name_, std::move(buffer_));
   delete this;
   return true;
 }
@@ -29,6 +33,15 @@ int64_t CallbackFile::Read(void* buffer, uint64_t length) {
 }
 
 int64_t CallbackFile::Write(const void* buffer, uint64_t length) {
+  if (buffer_) {
+    if (length == 0)
+      return 0;
+    if (buffer_->size() < position_ + length)
+      buffer_->resize(position_ + length);
+    memcpy(buffer_->data() + position_, buffer, length);
+    position_ += length;
+    return length;
+  }
   if (!callback_params_->write_func) {
     LOG(ERROR) << "Write function not defined.";
     return -1;
@@ -37,6 +50,8 @@ int64_t CallbackFile::Write(const void* buffer, uint64_t length) {
 }
 
 int64_t CallbackFile::Size() {
+  if (buffer_)
+    return buffer_->size();
   LOG(INFO) << "CallbackFile does not support Size().";
   return -1;
 }
@@ -47,11 +62,21 @@ bool CallbackFile::Flush() {
 }
 
 bool CallbackFile::Seek(uint64_t position) {
+  if (buffer_) {
+    if (position > buffer_->size())
+      return false;
+    position_ = position;
+    return true;
+  }
   VLOG(1) << "CallbackFile does not support Seek().";
   return false;
 }
 
 bool CallbackFile::Tell(uint64_t* position) {
+  if (buffer_) {
+    *position = position_;
+    return true;
+  }
   VLOG(1) << "CallbackFile does not support Tell().";
   return false;
 }
@@ -62,7 +87,11 @@ bool CallbackFile::Open() {
     LOG(ERROR) << "CallbackFile does not support file mode " << file_mode_;
     return false;
   }
-  return ParseCallbackFileName(file_name(), &callback_params_, &name_);
+  if (!ParseCallbackFileName(file_name(), &callback_params_, &name_))
+    return false;
+  if (file_mode_[0] == 'w' && callback_params_->file_ready_func)
+    buffer_.reset(new std::vector<uint8_t>);
+  return true;
 }
 
 }  // namespace shaka
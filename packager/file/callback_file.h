@@ -4,12 +4,20 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "packager/file/file.h"
 
 namespace shaka {
 
 /// Implements CallbackFile, which delegates read/write calls to the callback
-/// functions set through the file name.
+/// functions set through the file name. If a file ready function is set, the
+/// written content is kept in memory and handed over to that function when the
+/// file is closed.
 class CallbackFile : public File {
  public:
   /// @param file_name is the callback file name, which should have callback
@@ -42,6 +50,10 @@ class CallbackFile : public File {
   const BufferCallbackParams* callback_params_ = nullptr;
   std::string name_;
   std::string file_mode_;
+  // Content written so far if the file is delivered with the file ready
+  // function, nullptr otherwise.
+  std::shared_ptr<std::vector<uint8_t>> buffer_;
+  uint64_t position_ = 0;
 };
 
 }  // namespace shaka
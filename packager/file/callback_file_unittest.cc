@@ -10,6 +10,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <vector>
 
 #include "packager/file/file.h"
 #include "packager/file/file_closer.h"
@@ -163,4 +164,49 @@ TEST(CallbackFileTest, WriteFunctionNotDefined) {
   ASSERT_EQ(-1, writer->Write(kBuffer, kBufferSize));
 }
 
+TEST(CallbackFileTest, FileReady) {
+  MockFunction<void(const std::string& name,
+                    std::shared_ptr<const std::vector<uint8_t>> buffer)>
+      mock_file_ready_func;
+  MockFunction<int64_t(const std::string& name, const void* buffer,
+                       uint64_t length)>
+      mock_write_func;
+  BufferCallbackParams callback_params;
+  callback_params.write_func = mock_write_func.AsStdFunction();
+  callback_params.file_ready_func = mock_file_ready_func.AsStdFunction();
+
+  std::string file_name =
+      File::MakeCallbackFileName(callback_params, kBufferLabel);
+
+  std::unique_ptr<File, FileCloser> writer(File::Open(file_name.c_str(), "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(static_cast<int64_t>(kBufferSize),
+            writer->Write(kBuffer, kBufferSize));
+  ASSERT_EQ(static_cast<int64_t>(kBufferSize),
+            writer->Write(kBuffer, kBufferSize));
+  EXPECT_EQ(static_cast<int64_t>(2 * kBufferSize), writer->Size());
+
+  // Overwrite the beginning of the file.
+  const uint8_t kHeader[] = {9, 9};
+  ASSERT_TRUE(writer->Seek(0));
+  ASSERT_EQ(static_cast<int64_t>(sizeof(kHeader)),
+            writer->Write(kHeader, sizeof(kHeader)));
+  uint64_t position = 0;
+  ASSERT_TRUE(writer->Tell(&position));
+  EXPECT_EQ(sizeof(kHeader), position);
+  EXPECT_FALSE(writer->Seek(2 * kBufferSize + 1));
+
+  std::vector<uint8_t> expected(kBuffer, kBuffer + kBufferSize);
+  expected.insert(expected.end(), kBuffer, kBuffer + kBufferSize);
+  expected[0] = expected[1] = 9;
+  EXPECT_CALL(mock_write_func, Call(_, _, _)).Times(0);
+  EXPECT_CALL(mock_file_ready_func, Call(StrEq(kBufferLabel), _))
+      .WillOnce(WithArgs<1>(Invoke(
+          [&expected](std::shared_ptr<const std::vector<uint8_t>> buffer) {
+            ASSERT_TRUE(buffer);
+            EXPECT_EQ(expected, *buffer);
+          })));
+  writer.reset();
+}
+
 }  // namespace shaka
@@ -17,6 +17,10 @@
 #include "packager/base/strings/stringprintf.h"
 #include "packager/file/callback_file.h"
 #include "packager/file/file_util.h"
+#include "packager/file/http_file.h"
+#if defined(__linux__)
+#include "packager/file/io_uring_file.h"
+#endif  // defined(__linux__)
 #include "packager/file/local_file.h"
 #include "packager/file/memory_file.h"
 #include "packager/file/threaded_io_file.h"
@@ -29,6 +33,18 @@ DEFINE_uint64(io_cache_size,
 DEFINE_uint64(io_block_size,
               2ULL << 20,
               "Size of the block size used for threaded I/O, in bytes.");
+DEFINE_bool(io_uring,
+            false,
+            "Linux only. Write local files asynchronously through io_uring, "
+            "with the completions of all files handled by a single thread, "
+            "instead of threaded I/O. Blocks of --io_block_size bytes are "
+            "submitted as they fill up. Falls back to threaded I/O if "
+            "io_uring is not supported by the kernel.");
+DEFINE_bool(io_uring_direct_io,
+            false,
+            "Open local output files with O_DIRECT when --io_uring is set, "
+            "so that full blocks bypass the page cache. Useful for large "
+            "segments. --io_block_size should be a multiple of 4096.");
 
 // Needed for Windows weirdness which somewhere defines CopyFile as CopyFileW.
 #ifdef CopyFile
@@ -38,6 +54,8 @@ DEFINE_uint64(io_block_size,
 namespace shaka {
 
 const char* kCallbackFilePrefix = "callback://";
+const char* kHttpFilePrefix = "http://";
+const char* kHttpsFilePrefix = "https://";
 const char* kLocalFilePrefix = "file://";
 const char* kMemoryFilePrefix = "memory://";
 const char* kUdpFilePrefix = "udp://";
@@ -87,12 +105,31 @@ bool WriteLocalFileAtomically(const char* file_name,
   return true;
 }
 
+File* CreateHttpFile(const char* file_name, const char* mode) {
+  // HttpFile needs the full url.
+  return new HttpFile((std::string(kHttpFilePrefix) + file_name).c_str(), mode);
+}
+
+bool DeleteHttpFile(const char* file_name) {
+  return HttpFile::Delete((std::string(kHttpFilePrefix) + file_name).c_str());
+}
+
+File* CreateHttpsFile(const char* file_name, const char* mode) {
+  return new HttpFile((std::string(kHttpsFilePrefix) + file_name).c_str(),
+                      mode);
+}
+
+bool DeleteHttpsFile(const char* file_name) {
+  return HttpFile::Delete((std::string(kHttpsFilePrefix) + file_name).c_str());
+}
+
 File* CreateUdpFile(const char* file_name, const char* mode) {
-  if (strcmp(mode, "r")) {
-    NOTIMPLEMENTED() << "UdpFile only supports read (receive) mode.";
+  if (strcmp(mode, "r") && strcmp(mode, "w")) {
+    NOTIMPLEMENTED() << "UdpFile only supports read (receive) and write "
+                        "(send) modes.";
     return NULL;
   }
-  return new UdpFile(file_name);
+  return new UdpFile(file_name, mode);
 }
 
 File* CreateMemoryFile(const char* file_name, const char* mode) {
@@ -104,6 +141,11 @@ bool DeleteMemoryFile(const char* file_name) {
   return true;
 }
 
+bool WriteMemoryFileAtomically(const char* file_name,
+                               const std::string& contents) {
+  return MemoryFile::WriteFileAtomically(file_name, contents);
+}
+
 static const FileTypeInfo kFileTypeInfo[] = {
     {
         kLocalFilePrefix,
@@ -112,8 +154,15 @@ static const FileTypeInfo kFileTypeInfo[] = {
         &WriteLocalFileAtomically,
     },
     {kUdpFilePrefix, &CreateUdpFile, nullptr, nullptr},
-    {kMemoryFilePrefix, &CreateMemoryFile, &DeleteMemoryFile, nullptr},
+    {
+        kMemoryFilePrefix,
+        &CreateMemoryFile,
+        &DeleteMemoryFile,
+        &WriteMemoryFileAtomically,
+    },
     {kCallbackFilePrefix, &CreateCallbackFile, nullptr, nullptr},
+    {kHttpFilePrefix, &CreateHttpFile, &DeleteHttpFile, nullptr},
+    {kHttpsFilePrefix, &CreateHttpsFile, &DeleteHttpsFile, nullptr},
 };
 
 base::StringPiece GetFileTypePrefix(base::StringPiece file_name) {
@@ -138,6 +187,18 @@ const FileTypeInfo* GetFileTypeInfo(base::StringPiece file_name,
 }  // namespace
 
 File* File::Create(const char* file_name, const char* mode) {
+#if defined(__linux__)
+  if (FLAGS_io_uring && (!strcmp(mode, "w") || !strcmp(mode, "a"))) {
+    base::StringPiece real_file_name;
+    if (GetFileTypeInfo(file_name, &real_file_name) == &kFileTypeInfo[0] &&
+        IoUringFile::IsSupported()) {
+      // IoUringFile writes asynchronously without a thread per file.
+      return new IoUringFile(real_file_name.data(), mode, FLAGS_io_block_size,
+                             FLAGS_io_uring_direct_io);
+    }
+  }
+#endif  // defined(__linux__)
+
   std::unique_ptr<File, FileCloser> internal_file(
       CreateInternalFile(file_name, mode));
 
@@ -147,6 +208,16 @@ File* File::Create(const char* file_name, const char* mode) {
     // Disable caching for memory and callback files.
     return internal_file.release();
   }
+  if ((file_type_prefix == kHttpFilePrefix ||
+       file_type_prefix == kHttpsFilePrefix) &&
+      strcmp(mode, "r")) {
+    // HttpFile buffers uploads internally.
+    return internal_file.release();
+  }
+  if (file_type_prefix == kUdpFilePrefix && strcmp(mode, "r")) {
+    // Buffering would break the datagram boundaries of UdpFile writes.
+    return internal_file.release();
+  }
 
   if (FLAGS_io_cache_size) {
     // Enable threaded I/O for "r", "w", and "a" modes only.
@@ -268,13 +339,8 @@ bool File::WriteFileAtomically(const char* file_name,
     return file_type->atomic_write_function(real_file_name.data(), contents);
 
   // Provide a default implementation which may not be atomic unfortunately.
-
-  // Skip the warning message for memory files, which is meant for testing
-  // anyway..
-  if (strncmp(file_name, kMemoryFilePrefix, strlen(kMemoryFilePrefix)) != 0) {
-    LOG(WARNING) << "Writing to " << file_name
-                 << " is not guaranteed to be atomic.";
-  }
+  LOG(WARNING) << "Writing to " << file_name
+               << " is not guaranteed to be atomic.";
   return WriteStringToFile(file_name, contents);
 }
 
@@ -20,15 +20,21 @@
         'file_util.cc',
         'file_util.h',
         'file_closer.h',
+        'http_file.cc',
+        'http_file.h',
         'io_cache.cc',
         'io_cache.h',
         'local_file.cc',
         'local_file.h',
+        'memory_accountant.cc',
+        'memory_accountant.h',
         'memory_file.cc',
         'memory_file.h',
         'public/buffer_callback_params.h',
         'threaded_io_file.cc',
         'threaded_io_file.h',
+        'udp_capture.cc',
+        'udp_capture.h',
         'udp_file.cc',
         'udp_file.h',
         'udp_options.cc',
@@ -36,8 +42,17 @@
       ],
       'dependencies': [
         '../base/base.gyp:base',
+        '../third_party/curl/curl.gyp:libcurl',
         '../third_party/gflags/gflags.gyp:gflags',
       ],
+      'conditions': [
+        ['OS=="linux"', {
+          'sources': [
+            'io_uring_file.cc',
+            'io_uring_file.h',
+          ],
+        }],
+      ],
     },
     {
       'target_name': 'file_unittest',
@@ -46,10 +61,20 @@
         'callback_file_unittest.cc',
         'file_unittest.cc',
         'file_util_unittest.cc',
+        'http_file_unittest.cc',
         'io_cache_unittest.cc',
+        'memory_accountant_unittest.cc',
         'memory_file_unittest.cc',
+        'udp_capture_unittest.cc',
         'udp_options_unittest.cc',
       ],
+      'conditions': [
+        ['OS=="linux"', {
+          'sources': [
+            'io_uring_file_unittest.cc',
+          ],
+        }],
+      ],
       'dependencies': [
         '../media/test/media_test.gyp:run_tests_with_atexit_manager',
         '../testing/gmock.gyp:gmock',
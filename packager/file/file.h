@@ -17,6 +17,8 @@
 namespace shaka {
 
 extern const char* kCallbackFilePrefix;
+extern const char* kHttpFilePrefix;
+extern const char* kHttpsFilePrefix;
 extern const char* kLocalFilePrefix;
 extern const char* kMemoryFilePrefix;
 extern const char* kUdpFilePrefix;
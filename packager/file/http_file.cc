@@ -0,0 +1,419 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/http_file.h"
+
+#include <curl/curl.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/location.h"
+#include "packager/base/logging.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/threading/worker_pool.h"
+
+namespace shaka {
+
+namespace {
+
+const char kUserAgentString[] = "shaka-packager-http_file/1.0";
+// Size of the buffer between the writer and the upload task.
+const uint64_t kUploadCacheSize = 2ULL << 20;
+// Size of the blocks fetched with Range requests in read mode.
+const uint64_t kReadBlockSize = 1ULL << 20;
+// Number of blocks, including the block being read, that are fetched in
+// parallel in read mode.
+const uint64_t kNumReadAheadBlocks = 4;
+// Maximum time to wait for socket activity in one iteration, in milliseconds.
+const int kMultiWaitTimeoutMs = 1000;
+
+// Process wide libcurl state. The share handle lets all HttpFile transfers
+// re-use connections, DNS lookups and SSL sessions.
+class CurlSharedState {
+ public:
+  static CurlSharedState* GetInstance() {
+    // Intentionally leaked: transfers may still be running on worker threads
+    // during static destruction.
+    static CurlSharedState* instance = new CurlSharedState;
+    return instance;
+  }
+
+  CURLSH* share() { return share_; }
+
+ private:
+  CurlSharedState() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    share_ = curl_share_init();
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &CurlSharedState::Lock);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &CurlSharedState::Unlock);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  }
+
+  static void Lock(CURL* handle,
+                   curl_lock_data data,
+                   curl_lock_access access,
+                   void* user_data) {
+    static_cast<CurlSharedState*>(user_data)->locks_[data].Acquire();
+  }
+
+  static void Unlock(CURL* handle, curl_lock_data data, void* user_data) {
+    static_cast<CurlSharedState*>(user_data)->locks_[data].Release();
+  }
+
+  CURLSH* share_;
+  base::Lock locks_[CURL_LOCK_DATA_LAST];
+
+  DISALLOW_COPY_AND_ASSIGN(CurlSharedState);
+};
+
+size_t DiscardResponse(char* ptr, size_t size, size_t nmemb, void* user_data) {
+  return size * nmemb;
+}
+
+// Creates a curl handle with the options common to all HttpFile transfers.
+CURL* CreateCurlHandle(const std::string& url) {
+  CURL* curl = curl_easy_init();
+  if (!curl) {
+    LOG(ERROR) << "curl_easy_init() failed.";
+    return nullptr;
+  }
+  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(curl, CURLOPT_USERAGENT, kUserAgentString);
+  curl_easy_setopt(curl, CURLOPT_SHARE,
+                   CurlSharedState::GetInstance()->share());
+  curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+  curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+  // Signals are not thread safe.
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, DiscardResponse);
+  return curl;
+}
+
+void LogCurlError(CURL* curl, CURLcode res, const std::string& url) {
+  long response_code = 0;
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+  LOG(ERROR) << "HTTP request to '" << url
+             << "' failed: " << curl_easy_strerror(res)
+             << ". Response code: " << response_code << ".";
+}
+
+}  // namespace
+
+struct HttpFile::Block {
+  // The range covered by the block.
+  uint64_t start = 0;
+  uint64_t size = 0;
+  std::string data;
+  // The transfer handle. Null once the transfer completes.
+  CURL* curl = nullptr;
+  bool failed = false;
+};
+
+HttpFile::HttpFile(const char* file_name, const char* mode)
+    : File(file_name),
+      file_mode_(mode),
+      cache_(file_mode_ == "r" || file_mode_ == "rb" ? 0 : kUploadCacheSize,
+             file_mode_ != "r" && file_mode_ != "rb"),
+      task_exit_event_(base::WaitableEvent::ResetPolicy::MANUAL,
+                       base::WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+HttpFile::~HttpFile() {
+  while (!blocks_.empty())
+    RemoveBlock(blocks_.begin()->first);
+  if (multi_)
+    curl_multi_cleanup(multi_);
+  if (curl_)
+    curl_easy_cleanup(curl_);
+}
+
+bool HttpFile::Close() {
+  bool result = true;
+  if (curl_) {
+    // Closing the cache signals the end of the upload.
+    cache_.Close();
+    task_exit_event_.Wait();
+    result = !upload_failed_;
+  }
+  delete this;
+  return result;
+}
+
+int64_t HttpFile::Read(void* buffer, uint64_t length) {
+  DCHECK(multi_);
+  if (position_ >= size_ || length == 0)
+    return 0;
+
+  Block* block = FetchBlock(position_ / kReadBlockSize);
+  if (!block)
+    return -1;
+  const uint64_t offset = position_ - block->start;
+  DCHECK_LT(offset, block->data.size());
+  const uint64_t bytes_read =
+      std::min(length, static_cast<uint64_t>(block->data.size() - offset));
+  memcpy(buffer, block->data.data() + offset, bytes_read);
+  position_ += bytes_read;
+  return bytes_read;
+}
+
+int64_t HttpFile::Write(const void* buffer, uint64_t length) {
+  DCHECK(curl_);
+  if (base::subtle::NoBarrier_Load(&upload_aborted_))
+    return -1;
+  if (length == 0)
+    return 0;
+
+  const uint64_t bytes_written = cache_.Write(buffer, length);
+  if (bytes_written == 0) {
+    // The cache is only closed underneath us if the upload is aborted.
+    return -1;
+  }
+  position_ += bytes_written;
+  return bytes_written;
+}
+
+int64_t HttpFile::Size() {
+  return multi_ ? size_ : position_;
+}
+
+bool HttpFile::Flush() {
+  if (multi_)
+    return true;
+  // Data is sent as it is written. Wait until the upload task has picked up
+  // everything written so far.
+  cache_.WaitUntilEmptyOrClosed();
+  return !base::subtle::NoBarrier_Load(&upload_aborted_);
+}
+
+bool HttpFile::Seek(uint64_t position) {
+  if (!multi_) {
+    VLOG(1) << "HttpFile does not support Seek() in write mode.";
+    return false;
+  }
+  if (position > size_)
+    return false;
+  // Blocks are fetched on demand by the next Read.
+  position_ = position;
+  return true;
+}
+
+bool HttpFile::Tell(uint64_t* position) {
+  DCHECK(position);
+  *position = position_;
+  return true;
+}
+
+bool HttpFile::Open() {
+  if (file_mode_ == "r" || file_mode_ == "rb")
+    return OpenForRead();
+  if (file_mode_ == "w" || file_mode_ == "wb")
+    return OpenForWrite();
+  LOG(ERROR) << "HttpFile does not support file mode " << file_mode_;
+  return false;
+}
+
+bool HttpFile::OpenForRead() {
+  // Get the file size with a HEAD request.
+  CURL* curl = CreateCurlHandle(file_name());
+  if (!curl)
+    return false;
+  curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+  CURLcode res = curl_easy_perform(curl);
+  curl_off_t content_length = -1;
+  if (res == CURLE_OK) {
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                      &content_length);
+  } else {
+    LogCurlError(curl, res, file_name());
+  }
+  curl_easy_cleanup(curl);
+  if (res != CURLE_OK)
+    return false;
+  if (content_length < 0) {
+    LOG(ERROR) << "Unable to get the size of '" << file_name() << "'.";
+    return false;
+  }
+  size_ = content_length;
+
+  multi_ = curl_multi_init();
+  if (!multi_) {
+    LOG(ERROR) << "curl_multi_init() failed.";
+    return false;
+  }
+  return true;
+}
+
+HttpFile::Block* HttpFile::FetchBlock(uint64_t block_index) {
+  const uint64_t num_blocks = (size_ + kReadBlockSize - 1) / kReadBlockSize;
+  const uint64_t last_block_index =
+      std::min(block_index + kNumReadAheadBlocks, num_blocks);
+
+  // Drop the blocks outside of the read-ahead window, e.g. after a Seek.
+  for (auto iter = blocks_.begin(); iter != blocks_.end();) {
+    const uint64_t index = (iter++)->first;
+    if (index < block_index || index >= last_block_index)
+      RemoveBlock(index);
+  }
+  for (uint64_t index = block_index; index < last_block_index; ++index) {
+    if (blocks_.find(index) == blocks_.end() && !StartBlockFetch(index))
+      return nullptr;
+  }
+
+  Block* block = blocks_[block_index].get();
+  while (block->curl) {
+    int running_handles = 0;
+    CURLMcode mres = curl_multi_perform(multi_, &running_handles);
+    if (mres == CURLM_OK)
+      mres = curl_multi_wait(multi_, nullptr, 0, kMultiWaitTimeoutMs, nullptr);
+    if (mres != CURLM_OK) {
+      LOG(ERROR) << "curl_multi failed: " << curl_multi_strerror(mres);
+      return nullptr;
+    }
+
+    int messages_left = 0;
+    while (CURLMsg* message = curl_multi_info_read(multi_, &messages_left)) {
+      if (message->msg != CURLMSG_DONE)
+        continue;
+      Block* done_block = nullptr;
+      curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &done_block);
+      DCHECK(done_block);
+      if (message->data.result != CURLE_OK) {
+        LogCurlError(done_block->curl, message->data.result, file_name());
+        done_block->failed = true;
+      } else if (done_block->data.size() != done_block->size) {
+        LOG(ERROR) << "Expecting " << done_block->size << " bytes at offset "
+                   << done_block->start << " of '" << file_name()
+                   << "', but received " << done_block->data.size() << ".";
+        done_block->failed = true;
+      }
+      curl_multi_remove_handle(multi_, done_block->curl);
+      curl_easy_cleanup(done_block->curl);
+      done_block->curl = nullptr;
+    }
+  }
+  if (block->failed) {
+    // Allow the block to be fetched again on the next read.
+    RemoveBlock(block_index);
+    return nullptr;
+  }
+  return block;
+}
+
+bool HttpFile::StartBlockFetch(uint64_t block_index) {
+  std::unique_ptr<Block> block(new Block);
+  block->start = block_index * kReadBlockSize;
+  block->size = std::min(kReadBlockSize, size_ - block->start);
+  block->data.reserve(block->size);
+  block->curl = CreateCurlHandle(file_name());
+  if (!block->curl)
+    return false;
+  const std::string range = base::StringPrintf(
+      "%" PRIu64 "-%" PRIu64, block->start, block->start + block->size - 1);
+  curl_easy_setopt(block->curl, CURLOPT_RANGE, range.c_str());
+  curl_easy_setopt(block->curl, CURLOPT_WRITEFUNCTION,
+                   &HttpFile::WriteBlockCallback);
+  curl_easy_setopt(block->curl, CURLOPT_WRITEDATA, block.get());
+  curl_easy_setopt(block->curl, CURLOPT_PRIVATE, block.get());
+  CURLMcode mres = curl_multi_add_handle(multi_, block->curl);
+  if (mres != CURLM_OK) {
+    LOG(ERROR) << "curl_multi_add_handle() failed: "
+               << curl_multi_strerror(mres);
+    curl_easy_cleanup(block->curl);
+    return false;
+  }
+  blocks_[block_index] = std::move(block);
+  return true;
+}
+
+void HttpFile::RemoveBlock(uint64_t block_index) {
+  auto iter = blocks_.find(block_index);
+  if (iter == blocks_.end())
+    return;
+  if (iter->second->curl) {
+    curl_multi_remove_handle(multi_, iter->second->curl);
+    curl_easy_cleanup(iter->second->curl);
+  }
+  blocks_.erase(iter);
+}
+
+size_t HttpFile::WriteBlockCallback(char* data,
+                                    size_t size,
+                                    size_t nmemb,
+                                    void* user_data) {
+  Block* block = static_cast<Block*>(user_data);
+  const size_t total_size = size * nmemb;
+  // A server which does not support Range requests returns the whole file.
+  // Abort the transfer instead of buffering it.
+  if (block->data.size() + total_size > block->size)
+    return 0;
+  block->data.append(data, total_size);
+  return total_size;
+}
+
+bool HttpFile::OpenForWrite() {
+  curl_ = CreateCurlHandle(file_name());
+  if (!curl_)
+    return false;
+  // Without CURLOPT_INFILESIZE, libcurl uses chunked transfer encoding.
+  curl_easy_setopt(curl_, CURLOPT_UPLOAD, 1L);
+  curl_easy_setopt(curl_, CURLOPT_READFUNCTION, &HttpFile::ReadCallback);
+  curl_easy_setopt(curl_, CURLOPT_READDATA, this);
+
+  base::WorkerPool::PostTask(
+      FROM_HERE, base::Bind(&HttpFile::UploadTask, base::Unretained(this)),
+      true /* task_is_slow */);
+  return true;
+}
+
+void HttpFile::UploadTask() {
+  struct curl_slist* headers = nullptr;
+  headers = curl_slist_append(headers, "Transfer-Encoding: chunked");
+  // Do not wait for "100 Continue" before streaming the body.
+  headers = curl_slist_append(headers, "Expect:");
+  curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
+
+  CURLcode res = curl_easy_perform(curl_);
+  curl_slist_free_all(headers);
+  if (res != CURLE_OK) {
+    LogCurlError(curl_, res, file_name());
+    upload_failed_ = true;
+    base::subtle::NoBarrier_Store(&upload_aborted_, 1);
+  }
+  // Unblock the writer if the transfer ended prematurely.
+  cache_.Close();
+  task_exit_event_.Signal();
+}
+
+size_t HttpFile::ReadCallback(char* buffer,
+                              size_t size,
+                              size_t nitems,
+                              void* user_data) {
+  HttpFile* file = static_cast<HttpFile*>(user_data);
+  // Blocks until data is available. Returns 0, i.e. end of upload, when the
+  // cache is closed and drained.
+  return file->cache_.Read(buffer, size * nitems);
+}
+
+bool HttpFile::Delete(const char* url) {
+  CURL* curl = CreateCurlHandle(url);
+  if (!curl)
+    return false;
+  curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+  CURLcode res = curl_easy_perform(curl);
+  if (res != CURLE_OK)
+    LogCurlError(curl, res, url);
+  curl_easy_cleanup(curl);
+  return res == CURLE_OK;
+}
+
+}  // namespace shaka
@@ -0,0 +1,119 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_HTTP_FILE_H_
+#define PACKAGER_FILE_HTTP_FILE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "packager/base/atomicops.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/file/file.h"
+#include "packager/file/io_cache.h"
+
+typedef void CURL;
+typedef void CURLM;
+
+namespace shaka {
+
+/// Implements HttpFile, which reads data from or uploads data to a HTTP(S)
+/// server. Connections are pooled and re-used across HttpFile instances.
+/// In write mode, the data is streamed to the server with a chunked PUT
+/// request while it is being written, so no temporary storage is needed.
+/// In read mode, the file is fetched in blocks with Range requests. Several
+/// blocks ahead of the read position are fetched in parallel, so reading can
+/// start as soon as the first block arrives. Seeking is supported in read
+/// mode.
+class HttpFile : public File {
+ public:
+  /// @param file_name is the url of the file, including the "http://" or
+  ///        "https://" prefix.
+  /// @param mode C string containing a file access mode. "r" and "w" are
+  ///        supported.
+  HttpFile(const char* file_name, const char* mode);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+  /// Delete a file on the server with a HTTP DELETE request.
+  /// @param url is the url of the file to be deleted.
+  /// @return true if successful, or false otherwise.
+  static bool Delete(const char* url);
+
+ protected:
+  ~HttpFile() override;
+
+  bool Open() override;
+
+ private:
+  HttpFile(const HttpFile&) = delete;
+  HttpFile& operator=(const HttpFile&) = delete;
+
+  struct Block;
+
+  bool OpenForRead();
+  bool OpenForWrite();
+
+  // Makes sure |block_index| and the read-ahead blocks after it are fetched or
+  // being fetched, and waits until |block_index| is complete.
+  // @return the block on success, nullptr otherwise.
+  Block* FetchBlock(uint64_t block_index);
+  // Starts a Range request for |block_index|.
+  bool StartBlockFetch(uint64_t block_index);
+  // Drops the block, aborting the transfer if it is still running.
+  void RemoveBlock(uint64_t block_index);
+  // CURLOPT_WRITEFUNCTION callback for block fetches.
+  static size_t WriteBlockCallback(char* data,
+                                   size_t size,
+                                   size_t nmemb,
+                                   void* user_data);
+
+  // Runs the upload on a worker thread. Data is pulled from |cache_| until it
+  // is closed.
+  void UploadTask();
+  // CURLOPT_READFUNCTION callback.
+  static size_t ReadCallback(char* buffer,
+                             size_t size,
+                             size_t nitems,
+                             void* user_data);
+
+  std::string file_mode_;
+  uint64_t position_ = 0;
+
+  // Read mode states.
+  uint64_t size_ = 0;
+  CURLM* multi_ = nullptr;
+  // Fetched or being fetched blocks, indexed by block index.
+  std::map<uint64_t, std::unique_ptr<Block>> blocks_;
+
+  // Write mode states.
+  CURL* curl_ = nullptr;
+  IoCache cache_;
+  // Set by the upload task on failure. Only accessed after |task_exit_event_|
+  // is signalled or from the upload task.
+  bool upload_failed_ = false;
+  // Set by the upload task when the transfer is aborted. Write fails
+  // immediately after.
+  base::subtle::Atomic32 upload_aborted_ = 0;
+  // Signalled when the upload task exits.
+  base::WaitableEvent task_exit_event_;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_HTTP_FILE_H_
@@ -0,0 +1,453 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/http_file.h"
+
+#include <gtest/gtest.h>
+
+#if !defined(OS_WIN)
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <map>
+#include <memory>
+
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_split.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/threading/simple_thread.h"
+#include "packager/file/file.h"
+#include "packager/file/file_closer.h"
+
+namespace shaka {
+namespace {
+
+const uint8_t kWriteBuffer[] = {1, 2, 3, 4, 5, 6, 7, 8};
+const int64_t kWriteBufferSize = sizeof(kWriteBuffer);
+
+// Large enough to span several read blocks.
+std::string GenerateContent(size_t size) {
+  std::string content(size, 0);
+  for (size_t i = 0; i < size; ++i)
+    content[i] = static_cast<char>(i * 31 % 251);
+  return content;
+}
+
+// A minimal HTTP/1.1 server stand-in, listening on the loopback interface.
+// Each connection is served on its own thread and supports keep-alive,
+// chunked and Content-Length request bodies. Uploaded files are kept in
+// memory.
+class LocalHttpServer : public base::SimpleThread {
+ public:
+  LocalHttpServer() : base::SimpleThread("LocalHttpServer") {}
+
+  ~LocalHttpServer() override { Stop(); }
+
+  bool Listen() {
+    listen_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_socket_ < 0)
+      return false;
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t addr_len = sizeof(addr);
+    if (bind(listen_socket_, reinterpret_cast<struct sockaddr*>(&addr),
+             sizeof(addr)) < 0 ||
+        listen(listen_socket_, 8) < 0 ||
+        getsockname(listen_socket_, reinterpret_cast<struct sockaddr*>(&addr),
+                    &addr_len) < 0) {
+      return false;
+    }
+    port_ = ntohs(addr.sin_port);
+    Start();
+    return true;
+  }
+
+  void Stop() {
+    if (listen_socket_ >= 0) {
+      shutdown(listen_socket_, SHUT_RDWR);
+      close(listen_socket_);
+      listen_socket_ = -1;
+    }
+    if (HasBeenStarted() && !HasBeenJoined())
+      Join();
+    // Connections may be kept alive by the client connection pool.
+    for (auto& connection : connections_)
+      connection->Stop();
+    connections_.clear();
+  }
+
+  std::string Url(const std::string& path) const {
+    return base::StringPrintf("http://127.0.0.1:%d/%s", port_, path.c_str());
+  }
+
+  bool GetFile(const std::string& path, std::string* content) {
+    base::AutoLock auto_lock(lock_);
+    auto iter = files_.find("/" + path);
+    if (iter == files_.end())
+      return false;
+    *content = iter->second;
+    return true;
+  }
+
+  void SetFile(const std::string& path, const std::string& content) {
+    base::AutoLock auto_lock(lock_);
+    files_["/" + path] = content;
+  }
+
+  int num_connections() {
+    base::AutoLock auto_lock(lock_);
+    return num_connections_;
+  }
+
+  int num_chunked_requests() {
+    base::AutoLock auto_lock(lock_);
+    return num_chunked_requests_;
+  }
+
+  int num_range_requests() {
+    base::AutoLock auto_lock(lock_);
+    return num_range_requests_;
+  }
+
+ private:
+  struct Request {
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> headers;
+    std::string body;
+  };
+
+  class Connection : public base::SimpleThread {
+   public:
+    Connection(LocalHttpServer* server, int socket)
+        : base::SimpleThread("LocalHttpServerConnection"),
+          server_(server),
+          socket_(socket) {}
+
+    void Stop() {
+      shutdown(socket_, SHUT_RDWR);
+      if (HasBeenStarted() && !HasBeenJoined())
+        Join();
+      close(socket_);
+    }
+
+   private:
+    void Run() override {
+      Request request;
+      while (ReadRequest(&request)) {
+        if (!Send(server_->HandleRequest(request)))
+          break;
+      }
+    }
+
+    // Reads more data from the socket into |buffer_|.
+    bool Fill() {
+      char data[4096];
+      const ssize_t size = recv(socket_, data, sizeof(data), 0);
+      if (size <= 0)
+        return false;
+      buffer_.append(data, size);
+      return true;
+    }
+
+    bool ReadLine(std::string* line) {
+      size_t pos;
+      while ((pos = buffer_.find("\r\n")) == std::string::npos) {
+        if (!Fill())
+          return false;
+      }
+      *line = buffer_.substr(0, pos);
+      buffer_.erase(0, pos + 2);
+      return true;
+    }
+
+    bool ReadBytes(size_t size, std::string* data) {
+      while (buffer_.size() < size) {
+        if (!Fill())
+          return false;
+      }
+      data->append(buffer_, 0, size);
+      buffer_.erase(0, size);
+      return true;
+    }
+
+    bool ReadChunkedBody(std::string* body) {
+      std::string line;
+      while (true) {
+        uint32_t chunk_size = 0;
+        if (!ReadLine(&line) ||
+            !base::HexStringToUInt(line.substr(0, line.find(';')),
+                                   &chunk_size)) {
+          return false;
+        }
+        if (chunk_size == 0) {
+          // Skip trailers.
+          while (ReadLine(&line) && !line.empty()) {
+          }
+          return true;
+        }
+        if (!ReadBytes(chunk_size, body) || !ReadLine(&line))
+          return false;
+      }
+    }
+
+    bool ReadRequest(Request* request) {
+      *request = Request();
+      std::string line;
+      if (!ReadLine(&line))
+        return false;
+      std::vector<std::string> request_line = base::SplitString(
+          line, " ", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+      if (request_line.size() != 3)
+        return false;
+      request->method = request_line[0];
+      request->path = request_line[1];
+
+      while (true) {
+        if (!ReadLine(&line))
+          return false;
+        if (line.empty())
+          break;
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos)
+          return false;
+        std::string value;
+        base::TrimWhitespaceASCII(line.substr(colon + 1), base::TRIM_ALL,
+                                  &value);
+        request->headers[base::ToLowerASCII(line.substr(0, colon))] = value;
+      }
+
+      if (request->headers["transfer-encoding"] == "chunked")
+        return ReadChunkedBody(&request->body);
+      if (!request->headers["content-length"].empty()) {
+        size_t content_length = 0;
+        return base::StringToSizeT(request->headers["content-length"],
+                                   &content_length) &&
+               ReadBytes(content_length, &request->body);
+      }
+      return true;
+    }
+
+    bool Send(const std::string& data) {
+      size_t sent = 0;
+      while (sent < data.size()) {
+        const ssize_t size =
+            send(socket_, data.data() + sent, data.size() - sent, 0);
+        if (size <= 0)
+          return false;
+        sent += size;
+      }
+      return true;
+    }
+
+    LocalHttpServer* const server_;
+    const int socket_;
+    std::string buffer_;
+  };
+
+  void Run() override {
+    while (true) {
+      const int socket = accept(listen_socket_, nullptr, nullptr);
+      if (socket < 0)
+        return;
+      {
+        base::AutoLock auto_lock(lock_);
+        ++num_connections_;
+      }
+      connections_.emplace_back(new Connection(this, socket));
+      connections_.back()->Start();
+    }
+  }
+
+  std::string HandleRequest(const Request& request) {
+    base::AutoLock auto_lock(lock_);
+    auto iter = request.headers.find("transfer-encoding");
+    if (iter != request.headers.end() && iter->second == "chunked")
+      ++num_chunked_requests_;
+
+    if (request.method == "PUT") {
+      files_[request.path] = request.body;
+      return Response("201 Created", "");
+    }
+    if (request.method == "DELETE") {
+      if (files_.erase(request.path) == 0)
+        return Response("404 Not Found", "");
+      return Response("200 OK", "");
+    }
+    if (request.method == "HEAD" || request.method == "GET") {
+      auto file_iter = files_.find(request.path);
+      if (file_iter == files_.end())
+        return Response("404 Not Found", "");
+      const std::string& content = file_iter->second;
+      const bool head_only = request.method == "HEAD";
+      auto range_iter = request.headers.find("range");
+      if (range_iter == request.headers.end())
+        return Response("200 OK", content, head_only);
+
+      ++num_range_requests_;
+      // Only "bytes=first-last" is supported.
+      uint64_t first = 0;
+      uint64_t last = 0;
+      if (sscanf(range_iter->second.c_str(), "bytes=%" SCNu64 "-%" SCNu64,
+                 &first, &last) != 2 ||
+          first > last || last >= content.size()) {
+        return Response("416 Range Not Satisfiable", "");
+      }
+      return Response("206 Partial Content",
+                      content.substr(first, last - first + 1), head_only);
+    }
+    return Response("405 Method Not Allowed", "");
+  }
+
+  static std::string Response(const std::string& status,
+                              const std::string& body,
+                              bool head_only = false) {
+    return base::StringPrintf("HTTP/1.1 %s\r\nContent-Length: %zu\r\n\r\n",
+                              status.c_str(), body.size()) +
+           (head_only ? "" : body);
+  }
+
+  int listen_socket_ = -1;
+  int port_ = 0;
+  // Only accessed on the accept thread, or after it is joined.
+  std::vector<std::unique_ptr<Connection>> connections_;
+
+  base::Lock lock_;
+  // Protected by |lock_|.
+  std::map<std::string, std::string> files_;
+  int num_connections_ = 0;
+  int num_chunked_requests_ = 0;
+  int num_range_requests_ = 0;
+};
+
+}  // namespace
+
+class HttpFileTest : public testing::Test {
+ protected:
+  void SetUp() override { ASSERT_TRUE(server_.Listen()); }
+
+  LocalHttpServer server_;
+};
+
+TEST_F(HttpFileTest, UploadWithChunkedTransferEncoding) {
+  std::unique_ptr<File, FileCloser> file(
+      File::Open(server_.Url("segment.m4s").c_str(), "w"));
+  ASSERT_TRUE(file);
+  const int kNumWrites = 1000;
+  for (int i = 0; i < kNumWrites; ++i)
+    ASSERT_EQ(kWriteBufferSize, file->Write(kWriteBuffer, kWriteBufferSize));
+  EXPECT_EQ(kNumWrites * kWriteBufferSize, file->Size());
+  ASSERT_TRUE(file.release()->Close());
+
+  std::string expected;
+  for (int i = 0; i < kNumWrites; ++i)
+    expected.append(std::begin(kWriteBuffer), std::end(kWriteBuffer));
+  std::string content;
+  ASSERT_TRUE(server_.GetFile("segment.m4s", &content));
+  EXPECT_EQ(expected, content);
+  EXPECT_EQ(1, server_.num_chunked_requests());
+}
+
+TEST_F(HttpFileTest, ReusesConnections) {
+  const int kNumFiles = 5;
+  for (int i = 0; i < kNumFiles; ++i) {
+    const std::string name = base::StringPrintf("segment%d.m4s", i);
+    ASSERT_TRUE(File::WriteStringToFile(server_.Url(name).c_str(), name));
+  }
+  for (int i = 0; i < kNumFiles; ++i) {
+    const std::string name = base::StringPrintf("segment%d.m4s", i);
+    std::string content;
+    ASSERT_TRUE(server_.GetFile(name, &content));
+    EXPECT_EQ(name, content);
+  }
+  EXPECT_EQ(1, server_.num_connections());
+}
+
+TEST_F(HttpFileTest, Delete) {
+  server_.SetFile("segment.m4s", "data");
+  EXPECT_TRUE(File::Delete(server_.Url("segment.m4s").c_str()));
+  std::string content;
+  EXPECT_FALSE(server_.GetFile("segment.m4s", &content));
+  EXPECT_FALSE(File::Delete(server_.Url("segment.m4s").c_str()));
+}
+
+TEST_F(HttpFileTest, UploadFailure) {
+  std::unique_ptr<File, FileCloser> file(
+      File::Open("http://127.0.0.1:1/segment.m4s", "w"));
+  ASSERT_TRUE(file);
+  file->Write(kWriteBuffer, kWriteBufferSize);
+  EXPECT_FALSE(file.release()->Close());
+}
+
+TEST_F(HttpFileTest, SeekNotSupported) {
+  std::unique_ptr<File, FileCloser> file(
+      File::Open(server_.Url("segment.m4s").c_str(), "w"));
+  ASSERT_TRUE(file);
+  EXPECT_FALSE(file->Seek(0));
+  uint64_t position = 1;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(0u, position);
+}
+
+TEST_F(HttpFileTest, Read) {
+  const std::string kContent = GenerateContent(5 * 1024 * 1024 + 123);
+  server_.SetFile("input.mp4", kContent);
+
+  EXPECT_EQ(static_cast<int64_t>(kContent.size()),
+            File::GetFileSize(server_.Url("input.mp4").c_str()));
+  std::string content;
+  ASSERT_TRUE(
+      File::ReadFileToString(server_.Url("input.mp4").c_str(), &content));
+  EXPECT_EQ(kContent, content);
+  // The file is fetched in blocks with Range requests.
+  EXPECT_LT(1, server_.num_range_requests());
+}
+
+TEST_F(HttpFileTest, SeekAndRead) {
+  const std::string kContent = GenerateContent(3 * 1024 * 1024);
+  server_.SetFile("input.mp4", kContent);
+
+  std::unique_ptr<File, FileCloser> file(
+      File::Open(server_.Url("input.mp4").c_str(), "r"));
+  ASSERT_TRUE(file);
+  EXPECT_EQ(static_cast<int64_t>(kContent.size()), file->Size());
+
+  // Jump to the end of the file, e.g. to read a trailing moov box, then back.
+  const uint64_t kPositions[] = {kContent.size() - 100, 10, 2 * 1024 * 1024};
+  for (uint64_t position : kPositions) {
+    ASSERT_TRUE(file->Seek(position));
+    char buffer[100];
+    ASSERT_EQ(static_cast<int64_t>(sizeof(buffer)),
+              file->Read(buffer, sizeof(buffer)));
+    EXPECT_EQ(kContent.substr(position, sizeof(buffer)),
+              std::string(buffer, sizeof(buffer)));
+    uint64_t tell = 0;
+    ASSERT_TRUE(file->Tell(&tell));
+    EXPECT_EQ(position + sizeof(buffer), tell);
+  }
+  char buffer[1];
+  ASSERT_TRUE(file->Seek(kContent.size()));
+  EXPECT_EQ(0, file->Read(buffer, sizeof(buffer)));
+}
+
+TEST_F(HttpFileTest, OpenMissingFileForReadFails) {
+  std::unique_ptr<File, FileCloser> file(
+      File::Open(server_.Url("missing.mp4").c_str(), "r"));
+  EXPECT_FALSE(file);
+}
+
+}  // namespace shaka
+
+#endif  // !defined(OS_WIN)
@@ -17,7 +17,9 @@ namespace shaka {
 using base::AutoLock;
 using base::AutoUnlock;
 
-IoCache::IoCache(uint64_t cache_size)
+IoCache::IoCache(uint64_t cache_size) : IoCache(cache_size, false) {}
+
+IoCache::IoCache(uint64_t cache_size, bool charge_memory)
     : cache_size_(cache_size),
       read_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                   base::WaitableEvent::InitialState::NOT_SIGNALED),
@@ -29,7 +31,10 @@ IoCache::IoCache(uint64_t cache_size)
       end_ptr_(&circular_buffer_[0] + cache_size + 1),
       r_ptr_(circular_buffer_.data()),
       w_ptr_(circular_buffer_.data()),
-      closed_(false) {}
+      closed_(false) {
+  if (charge_memory)
+    memory_charge_.reset(new MemoryCharge(MemoryComponent::kIoCache));
+}
 
 IoCache::~IoCache() {
   Close();
@@ -59,6 +64,8 @@ uint64_t IoCache::Read(void* buffer, uint64_t size) {
     r_ptr_ += second_chunk_size;
     DCHECK_GT(end_ptr_, r_ptr_);
   }
+  if (memory_charge_)
+    memory_charge_->Release(size);
   read_event_.Signal();
   return size;
 }
@@ -94,6 +101,8 @@ uint64_t IoCache::Write(const void* buffer, uint64_t size) {
       r_ptr += second_chunk_size;
     }
     bytes_left -= write_size;
+    if (memory_charge_)
+      memory_charge_->Charge(write_size);
     write_event_.Signal();
   }
   return size;
@@ -102,6 +111,8 @@ uint64_t IoCache::Write(const void* buffer, uint64_t size) {
 void IoCache::Clear() {
   AutoLock lock(lock_);
   r_ptr_ = w_ptr_ = circular_buffer_.data();
+  if (memory_charge_)
+    memory_charge_->ReleaseAll();
   // Let any writers know that there is room in the cache.
   read_event_.Signal();
 }
@@ -117,6 +128,8 @@ void IoCache::Reopen() {
   AutoLock lock(lock_);
   CHECK(closed_);
   r_ptr_ = w_ptr_ = circular_buffer_.data();
+  if (memory_charge_)
+    memory_charge_->ReleaseAll();
   closed_ = false;
   read_event_.Reset();
   write_event_.Reset();
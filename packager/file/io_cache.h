@@ -8,10 +8,12 @@
 #define PACKAGER_FILE_IO_CACHE_H_
 
 #include <stdint.h>
+#include <memory>
 #include <vector>
 #include "packager/base/macros.h"
 #include "packager/base/synchronization/lock.h"
 #include "packager/base/synchronization/waitable_event.h"
+#include "packager/file/memory_accountant.h"
 
 namespace shaka {
 
@@ -19,6 +21,12 @@ namespace shaka {
 class IoCache {
  public:
   explicit IoCache(uint64_t cache_size);
+  /// @param cache_size is the size of the cache in bytes.
+  /// @param charge_memory indicates whether the cached bytes are charged to
+  ///        MemoryComponent::kIoCache. Only set it for output caches, which
+  ///        are drained by their writer thread independently of the
+  ///        demuxers throttled by MemoryAccountant.
+  IoCache(uint64_t cache_size, bool charge_memory);
   ~IoCache();
 
   /// Read data from the cache. This function may block until there is data in
@@ -75,6 +83,8 @@ class IoCache {
   uint8_t* r_ptr_;
   uint8_t* w_ptr_;
   bool closed_;
+  // Null if the cached bytes are not charged to the memory accountant.
+  std::unique_ptr<MemoryCharge> memory_charge_;
 
   DISALLOW_COPY_AND_ASSIGN(IoCache);
 };
@@ -0,0 +1,749 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/io_uring_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "packager/base/files/file_util.h"
+#include "packager/base/logging.h"
+#include "packager/base/threading/simple_thread.h"
+
+// The io_uring system calls have the same numbers on most architectures, but
+// may be missing from older C library headers.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+namespace shaka {
+
+/// A block of memory written by IoUringFile.
+struct IoUringBuffer {
+  uint8_t* data = nullptr;
+  // Index in the buffers registered with the ring, -1 if not registered.
+  int index = -1;
+};
+
+namespace {
+
+const unsigned kQueueDepth = 64;
+const size_t kNumRegisteredBuffers = 8;
+const uint64_t kDirectIoAlignment = 4096;
+// Offset to write at the current file position.
+const uint64_t kCurrentPosition = static_cast<uint64_t>(-1);
+
+int IoUringSetup(unsigned entries, struct io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd,
+                 unsigned to_submit,
+                 unsigned min_complete,
+                 unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int ring_fd,
+                    unsigned opcode,
+                    const void* arg,
+                    unsigned num_args) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, ring_fd, opcode, arg, num_args));
+}
+
+// Blocks are aligned so that they can be written with direct I/O.
+uint8_t* AllocateBlock(uint64_t size) {
+  void* block = nullptr;
+  if (posix_memalign(&block, kDirectIoAlignment, size) != 0)
+    return nullptr;
+  return static_cast<uint8_t*>(block);
+}
+
+bool IsAligned(uint64_t value) {
+  return value % kDirectIoAlignment == 0;
+}
+
+}  // namespace
+
+/// A write submitted to the ring.
+struct IoUringRequest {
+  IoUringFile* file = nullptr;
+  IoUringBuffer* buffer = nullptr;
+  // Offset of the block in the file, or kCurrentPosition.
+  uint64_t offset = 0;
+  uint64_t size = 0;
+  // Bytes already written, which is less than |size| after short writes.
+  uint64_t written = 0;
+};
+
+/// Process wide io_uring instance shared by all IoUringFile objects. Writes
+/// are submitted by the threads writing the files, and completions are reaped
+/// by a single thread, started with the first write.
+class IoUring : public base::DelegateSimpleThread::Delegate {
+ public:
+  /// @return the process wide instance.
+  static IoUring* GetInstance();
+
+  /// @return true if the ring was set up successfully.
+  bool initialized() const { return ring_fd_ >= 0; }
+  /// @return true if the ring failed, after which no write is submitted.
+  bool failed();
+
+  /// @return a buffer of @a size bytes, registered with the ring if possible.
+  ///         The buffers of the first requested size are registered.
+  IoUringBuffer* AcquireBuffer(uint64_t size);
+  /// Release a buffer returned by AcquireBuffer().
+  void ReleaseBuffer(IoUringBuffer* buffer);
+
+  /// Submit a write, together with any writes queued before. Blocks while
+  /// the queue is full. Takes ownership of @a request, which is completed
+  /// with a failure if the ring fails before the kernel sees it.
+  /// @return false if the ring failed, true otherwise.
+  bool SubmitWrite(IoUringRequest* request);
+
+  /// Make the submissions fail with @a error, which fails the ring. 0 stops
+  /// the failures and restores the ring, which should have no writes in
+  /// flight then.
+  void SetSubmitErrorForTesting(int error);
+
+ private:
+  IoUring();
+  // Never called: the instance is leaked.
+  ~IoUring() override;
+
+  bool Initialize();
+  void RegisterBuffers(uint64_t size);
+
+  // Queue |request| and submit the queued writes. |submit_lock_| must be
+  // held.
+  bool QueueAndSubmit(IoUringRequest* request);
+  bool SubmitQueued();
+  // Remove the queued writes, which the kernel has not seen, from the
+  // submission queue and complete them with a failure. |submit_lock_| must be
+  // held.
+  void FailQueuedRequests();
+
+  // base::DelegateSimpleThread::Delegate implementation. Reaps completions.
+  void Run() override;
+  void OnCompletion(IoUringRequest* request, int result);
+  // Complete |request| and delete it. |release_buffer| is false if the kernel
+  // may still read the buffer, which is then leaked.
+  void CompleteRequest(IoUringRequest* request,
+                       bool success,
+                       bool release_buffer);
+
+  int ring_fd_ = -1;
+  unsigned sq_entries_ = 0;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  struct io_uring_sqe* sqes_ = nullptr;
+  unsigned cq_mask_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  struct io_uring_cqe* cqes_ = nullptr;
+  // The regions mapped by Initialize(), with their sizes.
+  std::vector<std::pair<void*, size_t>> mappings_;
+
+  base::Lock submit_lock_;
+  base::ConditionVariable slot_available_;
+  unsigned num_in_flight_ = 0;
+  bool failed_ = false;
+  // The requests submitted to the ring and not completed yet.
+  std::unordered_set<IoUringRequest*> outstanding_requests_;
+  // The outstanding requests queued and not seen by the kernel yet, in
+  // submission order.
+  std::deque<IoUringRequest*> queued_requests_;
+  int submit_error_for_testing_ = 0;
+
+  base::Lock buffer_lock_;
+  bool started_ = false;
+  uint64_t registered_buffer_size_ = 0;
+  std::vector<IoUringBuffer> registered_buffers_;
+  std::vector<IoUringBuffer*> free_registered_buffers_;
+  std::unique_ptr<base::DelegateSimpleThread> completion_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUring);
+};
+
+IoUring* IoUring::GetInstance() {
+  // Intentionally leaked: files may still be written during static
+  // destruction.
+  static IoUring* instance = new IoUring;
+  return instance;
+}
+
+IoUring::IoUring() : slot_available_(&submit_lock_) {
+  if (!Initialize() && ring_fd_ >= 0) {
+    for (const std::pair<void*, size_t>& mapping : mappings_)
+      munmap(mapping.first, mapping.second);
+    mappings_.clear();
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+IoUring::~IoUring() {}
+
+bool IoUring::Initialize() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = IoUringSetup(kQueueDepth, &params);
+  if (ring_fd_ < 0) {
+    LOG(WARNING) << "io_uring is not available: " << strerror(errno);
+    return false;
+  }
+  // IORING_OP_WRITE was added in the same kernel version (5.6).
+  if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+    LOG(WARNING) << "io_uring is too old. Linux 5.6 or later is required.";
+    return false;
+  }
+
+  size_t sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  size_t cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap)
+    sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+  void* sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) {
+    LOG(ERROR) << "Failed to map io_uring submission queue.";
+    return false;
+  }
+  mappings_.push_back(std::make_pair(sq_ring, sq_ring_size));
+  void* cq_ring = sq_ring;
+  if (!single_mmap) {
+    cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) {
+      LOG(ERROR) << "Failed to map io_uring completion queue.";
+      return false;
+    }
+    mappings_.push_back(std::make_pair(cq_ring, cq_ring_size));
+  }
+  const size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    LOG(ERROR) << "Failed to map io_uring submission queue entries.";
+    return false;
+  }
+  mappings_.push_back(std::make_pair(sqes, sqes_size));
+
+  uint8_t* sq = static_cast<uint8_t*>(sq_ring);
+  sq_entries_ = params.sq_entries;
+  sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  uint8_t* cq = static_cast<uint8_t*>(cq_ring);
+  cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  return true;
+}
+
+IoUringBuffer* IoUring::AcquireBuffer(uint64_t size) {
+  DCHECK(initialized());
+  {
+    base::AutoLock auto_lock(buffer_lock_);
+    if (!started_) {
+      // Buffers must be registered before the completion thread waits on the
+      // ring, since registration waits for the ring to be idle.
+      RegisterBuffers(size);
+      completion_thread_.reset(
+          new base::DelegateSimpleThread(this, "IoUringCompletion"));
+      completion_thread_->Start();
+      started_ = true;
+    }
+    if (size == registered_buffer_size_ && !free_registered_buffers_.empty()) {
+      IoUringBuffer* buffer = free_registered_buffers_.back();
+      free_registered_buffers_.pop_back();
+      return buffer;
+    }
+  }
+  // Out of registered buffers.
+  uint8_t* data = AllocateBlock(size);
+  if (!data)
+    return nullptr;
+  IoUringBuffer* buffer = new IoUringBuffer;
+  buffer->data = data;
+  return buffer;
+}
+
+void IoUring::ReleaseBuffer(IoUringBuffer* buffer) {
+  DCHECK(buffer);
+  if (buffer->index >= 0) {
+    base::AutoLock auto_lock(buffer_lock_);
+    free_registered_buffers_.push_back(buffer);
+    return;
+  }
+  free(buffer->data);
+  delete buffer;
+}
+
+void IoUring::RegisterBuffers(uint64_t size) {
+  buffer_lock_.AssertAcquired();
+  registered_buffers_.resize(kNumRegisteredBuffers);
+  std::vector<struct iovec> iovecs(kNumRegisteredBuffers);
+  bool allocated = true;
+  for (size_t i = 0; i < kNumRegisteredBuffers; ++i) {
+    registered_buffers_[i].data = AllocateBlock(size);
+    allocated &= registered_buffers_[i].data != nullptr;
+    iovecs[i].iov_base = registered_buffers_[i].data;
+    iovecs[i].iov_len = size;
+  }
+  if (!allocated ||
+      IoUringRegister(ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                      static_cast<unsigned>(iovecs.size())) < 0) {
+    // Typically caused by RLIMIT_MEMLOCK on older kernels. Writes still work
+    // with unregistered buffers, which are mapped on each write.
+    LOG(WARNING) << "Failed to register io_uring buffers: "
+                 << strerror(errno);
+    for (IoUringBuffer& buffer : registered_buffers_)
+      free(buffer.data);
+    registered_buffers_.clear();
+    return;
+  }
+  registered_buffer_size_ = size;
+  for (size_t i = 0; i < kNumRegisteredBuffers; ++i) {
+    registered_buffers_[i].index = static_cast<int>(i);
+    free_registered_buffers_.push_back(&registered_buffers_[i]);
+  }
+}
+
+bool IoUring::failed() {
+  base::AutoLock auto_lock(submit_lock_);
+  return failed_;
+}
+
+bool IoUring::SubmitWrite(IoUringRequest* request) {
+  {
+    base::AutoLock auto_lock(submit_lock_);
+    // Keep the writes in flight within the queue depth, so that the
+    // completion queue, which is twice as large, never overflows.
+    while (num_in_flight_ >= sq_entries_ && !failed_)
+      slot_available_.Wait();
+    if (!failed_) {
+      ++num_in_flight_;
+      outstanding_requests_.insert(request);
+      // On failure, the request is completed with the other queued requests.
+      return QueueAndSubmit(request);
+    }
+  }
+  CompleteRequest(request, false, true);
+  return false;
+}
+
+void IoUring::SetSubmitErrorForTesting(int error) {
+  base::AutoLock auto_lock(submit_lock_);
+  DCHECK(queued_requests_.empty());
+  submit_error_for_testing_ = error;
+  if (error == 0) {
+    DCHECK_EQ(0u, num_in_flight_);
+    failed_ = false;
+  }
+}
+
+bool IoUring::QueueAndSubmit(IoUringRequest* request) {
+  submit_lock_.AssertAcquired();
+  DCHECK(!failed_);
+
+  // The tail is only written by this thread, under |submit_lock_|.
+  const unsigned tail = *sq_tail_;
+  const unsigned index = tail & sq_mask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->fd = request->file->fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(request->buffer->data) +
+              request->written;
+  sqe->len = static_cast<uint32_t>(request->size - request->written);
+  sqe->off = request->offset == kCurrentPosition
+                 ? kCurrentPosition
+                 : request->offset + request->written;
+  if (request->buffer->index >= 0) {
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->buf_index = static_cast<uint16_t>(request->buffer->index);
+  } else {
+    sqe->opcode = IORING_OP_WRITE;
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  queued_requests_.push_back(request);
+  return SubmitQueued();
+}
+
+bool IoUring::SubmitQueued() {
+  submit_lock_.AssertAcquired();
+  // All the writes queued so far are submitted with a single system call.
+  while (!queued_requests_.empty()) {
+    const unsigned num_queued = static_cast<unsigned>(queued_requests_.size());
+    int result = -1;
+    if (submit_error_for_testing_ != 0)
+      errno = submit_error_for_testing_;
+    else
+      result = IoUringEnter(ring_fd_, num_queued, 0, 0);
+    if (result >= 0) {
+      // The kernel consumes the queued writes in order.
+      const unsigned num_submitted =
+          std::min(num_queued, static_cast<unsigned>(result));
+      queued_requests_.erase(queued_requests_.begin(),
+                             queued_requests_.begin() + num_submitted);
+      continue;
+    }
+    if (errno == EINTR || errno == EAGAIN)
+      continue;
+    if (errno == EBUSY) {
+      // The completion queue is full. The queued writes are submitted by the
+      // completion thread once it has made room.
+      return true;
+    }
+    // The writes already seen by the kernel stay outstanding until their
+    // completions are reaped, since the kernel may still read their buffers.
+    LOG(ERROR) << "Failed to submit io_uring writes: " << strerror(errno);
+    failed_ = true;
+    FailQueuedRequests();
+    slot_available_.Broadcast();
+    return false;
+  }
+  return true;
+}
+
+void IoUring::FailQueuedRequests() {
+  submit_lock_.AssertAcquired();
+  // The tail is only written under |submit_lock_|, and the kernel only reads
+  // it when writes are submitted.
+  __atomic_store_n(sq_tail_,
+                   *sq_tail_ - static_cast<unsigned>(queued_requests_.size()),
+                   __ATOMIC_RELEASE);
+  for (IoUringRequest* request : queued_requests_) {
+    outstanding_requests_.erase(request);
+    --num_in_flight_;
+    CompleteRequest(request, false, true);
+  }
+  queued_requests_.clear();
+}
+
+void IoUring::Run() {
+  while (true) {
+    const int result = IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+    if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      LOG(ERROR) << "Failed to wait for io_uring completions: "
+                 << strerror(errno);
+      base::AutoLock auto_lock(submit_lock_);
+      failed_ = true;
+      FailQueuedRequests();
+      // The completions of the other writes will never be reaped. The kernel
+      // may still read their buffers, so the buffers are leaked.
+      for (IoUringRequest* request : outstanding_requests_)
+        CompleteRequest(request, false, false);
+      outstanding_requests_.clear();
+      num_in_flight_ = 0;
+      slot_available_.Broadcast();
+      return;
+    }
+
+    // The head is only written by this thread.
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const struct io_uring_cqe& cqe = cqes_[head & cq_mask_];
+      IoUringRequest* request =
+          reinterpret_cast<IoUringRequest*>(cqe.user_data);
+      const int result = cqe.res;
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      OnCompletion(request, result);
+    }
+
+    base::AutoLock auto_lock(submit_lock_);
+    if (!queued_requests_.empty())
+      SubmitQueued();
+  }
+}
+
+void IoUring::OnCompletion(IoUringRequest* request, int result) {
+  {
+    base::AutoLock auto_lock(submit_lock_);
+    DCHECK_EQ(1u, outstanding_requests_.count(request));
+    if (result > 0)
+      request->written += result;
+    const bool retry =
+        result == -EINTR || result == -EAGAIN ||
+        (result > 0 && request->written < request->size);
+    if (retry && !failed_) {
+      // Resubmit the rest of a short write. The request keeps its slot, and
+      // is completed with the other queued requests if the ring fails.
+      QueueAndSubmit(request);
+      return;
+    }
+    outstanding_requests_.erase(request);
+    --num_in_flight_;
+    slot_available_.Signal();
+  }
+
+  const bool success = request->written == request->size;
+  if (!success) {
+    LOG(ERROR) << "Failed to write " << request->file->file_name() << ": "
+               << (result < 0 ? strerror(-result) : "no progress");
+  }
+  CompleteRequest(request, success, true);
+}
+
+void IoUring::CompleteRequest(IoUringRequest* request,
+                              bool success,
+                              bool release_buffer) {
+  if (release_buffer)
+    ReleaseBuffer(request->buffer);
+  request->file->OnWriteComplete(request->size, success);
+  delete request;
+}
+
+IoUringFile::IoUringFile(const char* file_name,
+                         const char* mode,
+                         uint64_t block_size,
+                         bool direct_io)
+    : File(file_name),
+      file_mode_(mode),
+      block_size_(block_size),
+      direct_io_(direct_io),
+      writes_done_(&lock_),
+      pending_memory_(MemoryComponent::kIoCache) {
+  DCHECK_GT(block_size_, 0u);
+}
+
+IoUringFile::~IoUringFile() {
+  DCHECK_EQ(0, num_pending_writes_);
+}
+
+bool IoUringFile::IsSupported() {
+  IoUring* io_uring = IoUring::GetInstance();
+  return io_uring->initialized() && !io_uring->failed();
+}
+
+void IoUringFile::SetRingErrorForTesting(int error) {
+  IoUring::GetInstance()->SetSubmitErrorForTesting(error);
+}
+
+bool IoUringFile::Close() {
+  // Pending writes must complete before the file goes away, even on errors.
+  bool result = SubmitBlock();
+  result &= WaitForWrites();
+  if (fd_ >= 0 && close(fd_) != 0) {
+    LOG(ERROR) << "Failed to close " << file_name() << ": "
+               << strerror(errno);
+    result = false;
+  }
+  delete this;
+  return result;
+}
+
+int64_t IoUringFile::Read(void* buffer, uint64_t length) {
+  NOTIMPLEMENTED() << "IoUringFile only supports writing.";
+  return -1;
+}
+
+int64_t IoUringFile::Write(const void* buffer, uint64_t length) {
+  DCHECK(buffer);
+  DCHECK_GE(fd_, 0);
+  {
+    base::AutoLock auto_lock(lock_);
+    if (error_)
+      return -1;
+  }
+
+  const uint8_t* data = static_cast<const uint8_t*>(buffer);
+  uint64_t bytes_written = 0;
+  while (bytes_written < length) {
+    if (!buffer_) {
+      buffer_ = IoUring::GetInstance()->AcquireBuffer(block_size_);
+      if (!buffer_) {
+        LOG(ERROR) << "Failed to allocate io_uring buffer.";
+        return -1;
+      }
+      buffer_offset_ = position_;
+      buffer_size_ = 0;
+    }
+    const uint64_t size =
+        std::min(length - bytes_written, block_size_ - buffer_size_);
+    memcpy(buffer_->data + buffer_size_, data + bytes_written, size);
+    buffer_size_ += size;
+    bytes_written += size;
+    position_ += size;
+    size_ = std::max(size_, position_);
+    if (buffer_size_ == block_size_ && !SubmitBlock())
+      return -1;
+  }
+  return bytes_written;
+}
+
+int64_t IoUringFile::Size() {
+  DCHECK_GE(fd_, 0);
+  return size_;
+}
+
+bool IoUringFile::Flush() {
+  DCHECK_GE(fd_, 0);
+  const bool submitted = SubmitBlock();
+  return WaitForWrites() && submitted;
+}
+
+bool IoUringFile::Seek(uint64_t position) {
+  if (!seekable_)
+    return false;
+  // Wait for the pending writes, which may overlap the writes after the
+  // seek.
+  if (!Flush())
+    return false;
+  position_ = position;
+  return true;
+}
+
+bool IoUringFile::Tell(uint64_t* position) {
+  DCHECK(position);
+  *position = position_;
+  return true;
+}
+
+bool IoUringFile::Open() {
+  if (!IsSupported())
+    return false;
+
+  int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+  if (file_mode_ == "w") {
+    flags |= O_TRUNC;
+  } else if (file_mode_ != "a") {
+    LOG(ERROR) << "IoUringFile does not support mode " << file_mode_;
+    return false;
+  }
+
+  // Create upper level directories, like LocalFile.
+  base::FilePath file_path(base::FilePath::FromUTF8Unsafe(file_name()));
+  base::File::Error error;
+  if (!base::CreateDirectoryAndGetError(file_path.DirName(), &error)) {
+    LOG(ERROR) << "Failed to create directories for file '"
+               << file_path.AsUTF8Unsafe()
+               << "'. Error: " << base::File::ErrorToString(error);
+    return false;
+  }
+
+  if (direct_io_) {
+    fd_ = open(file_name().c_str(), flags | O_DIRECT, 0666);
+    // Some file systems, e.g. tmpfs, do not support direct I/O.
+    if (fd_ < 0) {
+      VLOG(1) << "Direct I/O is not available for " << file_name();
+      direct_io_ = false;
+    }
+  }
+  if (fd_ < 0)
+    fd_ = open(file_name().c_str(), flags, 0666);
+  if (fd_ < 0) {
+    LOG(ERROR) << "Failed to open " << file_name() << ": " << strerror(errno);
+    return false;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd_, &file_stat) != 0) {
+    LOG(ERROR) << "Failed to stat " << file_name() << ": " << strerror(errno);
+    close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  seekable_ = S_ISREG(file_stat.st_mode);
+  if (file_mode_ == "a" && seekable_)
+    position_ = size_ = file_stat.st_size;
+  return true;
+}
+
+bool IoUringFile::SubmitBlock() {
+  if (!buffer_)
+    return true;
+  IoUringBuffer* buffer = buffer_;
+  buffer_ = nullptr;
+
+  // Writes at the current position must be serialized.
+  if (!seekable_ && !WaitForWrites()) {
+    IoUring::GetInstance()->ReleaseBuffer(buffer);
+    return false;
+  }
+
+  if (direct_io_ && !(IsAligned(buffer_offset_) && IsAligned(buffer_size_))) {
+    // Unaligned blocks cannot be written with direct I/O.
+    const int flags = fcntl(fd_, F_GETFL);
+    if (flags < 0 || fcntl(fd_, F_SETFL, flags & ~O_DIRECT) < 0) {
+      LOG(ERROR) << "Failed to turn off direct I/O for " << file_name()
+                 << ": " << strerror(errno);
+      IoUring::GetInstance()->ReleaseBuffer(buffer);
+      base::AutoLock auto_lock(lock_);
+      error_ = true;
+      return false;
+    }
+    direct_io_ = false;
+  }
+
+  IoUringRequest* request = new IoUringRequest;
+  request->file = this;
+  request->buffer = buffer;
+  request->offset = seekable_ ? buffer_offset_ : kCurrentPosition;
+  request->size = buffer_size_;
+  {
+    base::AutoLock auto_lock(lock_);
+    ++num_pending_writes_;
+    pending_memory_.Charge(buffer_size_);
+  }
+  // If the ring fails, the request is completed with a failure, which sets
+  // |error_|.
+  return IoUring::GetInstance()->SubmitWrite(request);
+}
+
+bool IoUringFile::WaitForWrites() {
+  // Returns when the ring fails too: the writes not seen by the kernel are
+  // failed at once, and the others when they complete, or when the completion
+  // thread stops.
+  base::AutoLock auto_lock(lock_);
+  while (num_pending_writes_ > 0)
+    writes_done_.Wait();
+  return !error_;
+}
+
+void IoUringFile::OnWriteComplete(uint64_t size, bool success) {
+  base::AutoLock auto_lock(lock_);
+  pending_memory_.Release(size);
+  if (!success)
+    error_ = true;
+  --num_pending_writes_;
+  writes_done_.Signal();
+}
+
+}  // namespace shaka
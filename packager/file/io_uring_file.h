@@ -0,0 +1,106 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_IO_URING_FILE_H_
+#define PACKAGER_FILE_IO_URING_FILE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/file/file.h"
+#include "packager/file/memory_accountant.h"
+
+namespace shaka {
+
+struct IoUringBuffer;
+
+/// Implements IoUringFile, which writes local files asynchronously through a
+/// process wide io_uring instance. Linux only.
+///
+/// Writes are copied into blocks, which are submitted to the ring as soon as
+/// they are full. The completions of all the files are reaped by a single
+/// thread, so unlike ThreadedIoFile there is no thread per file.
+class IoUringFile : public File {
+ public:
+  /// @param file_name C string containing the name of the file to be written.
+  /// @param mode C string containing the file access mode. Only "w" and "a"
+  ///        are supported.
+  /// @param block_size is the size of the blocks submitted to the ring.
+  /// @param direct_io opens the file with O_DIRECT, so that full blocks
+  ///        bypass the page cache. Direct I/O is turned off for the rest of
+  ///        the file on the first write which is not aligned, e.g. the last
+  ///        partial block.
+  IoUringFile(const char* file_name,
+              const char* mode,
+              uint64_t block_size,
+              bool direct_io);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+  /// @return true if io_uring is supported by the running kernel, and the
+  ///         process wide ring has not failed.
+  static bool IsSupported();
+
+  /// Make the submissions to the process wide ring fail with @a error, which
+  /// fails the ring and the writes not submitted yet. 0 restores the ring.
+  /// Should only be called when no writes are in flight.
+  static void SetRingErrorForTesting(int error);
+
+ protected:
+  ~IoUringFile() override;
+
+  bool Open() override;
+
+ private:
+  friend class IoUring;
+
+  // Submit the current block, if any.
+  bool SubmitBlock();
+  // Wait until all the submitted blocks are written.
+  bool WaitForWrites();
+  // Called when a block of |size| bytes is written or failed, usually on the
+  // completion thread.
+  void OnWriteComplete(uint64_t size, bool success);
+
+  const std::string file_mode_;
+  const uint64_t block_size_;
+  bool direct_io_;
+  int fd_ = -1;
+  // Non regular files, e.g. pipes, are written one block at a time at the
+  // current position.
+  bool seekable_ = true;
+  uint64_t position_ = 0;
+  uint64_t size_ = 0;
+  // The block being filled, and its offset in the file.
+  IoUringBuffer* buffer_ = nullptr;
+  uint64_t buffer_offset_ = 0;
+  uint64_t buffer_size_ = 0;
+
+  base::Lock lock_;
+  base::ConditionVariable writes_done_;
+  int num_pending_writes_ = 0;
+  bool error_ = false;
+  // Bytes submitted and not written yet.
+  MemoryCharge pending_memory_;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUringFile);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_IO_URING_FILE_H_
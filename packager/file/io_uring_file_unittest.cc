@@ -0,0 +1,226 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/io_uring_file.h"
+
+#include <errno.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "packager/base/files/file_util.h"
+#include "packager/file/file_closer.h"
+
+DECLARE_uint64(io_block_size);
+DECLARE_bool(io_uring);
+DECLARE_bool(io_uring_direct_io);
+
+namespace shaka {
+namespace {
+
+const uint64_t kBlockSize = 4096;
+// Not a multiple of the block size, so the last block is partial.
+const size_t kDataSize = 5 * kBlockSize + 100;
+
+}  // namespace
+
+class IoUringFileTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    saved_io_block_size_ = FLAGS_io_block_size;
+    if (!IoUringFile::IsSupported())
+      return;
+    FLAGS_io_block_size = kBlockSize;
+    FLAGS_io_uring = true;
+    ASSERT_TRUE(
+        base::CreateNewTempDirectory(base::FilePath::StringType(), &temp_dir_));
+
+    data_.resize(kDataSize);
+    for (size_t i = 0; i < kDataSize; ++i)
+      data_[i] = static_cast<char>(i * 7);
+  }
+
+  void TearDown() override {
+    FLAGS_io_block_size = saved_io_block_size_;
+    FLAGS_io_uring = false;
+    FLAGS_io_uring_direct_io = false;
+    if (!temp_dir_.empty())
+      base::DeleteFile(temp_dir_, true);
+  }
+
+  std::string GetFileName(const std::string& name) {
+    return temp_dir_.Append(base::FilePath::FromUTF8Unsafe(name))
+        .AsUTF8Unsafe();
+  }
+
+  std::string ReadFile(const std::string& file_name) {
+    std::string contents;
+    EXPECT_TRUE(base::ReadFileToString(
+        base::FilePath::FromUTF8Unsafe(file_name), &contents));
+    return contents;
+  }
+
+  // Write |data_| in chunks of |chunk_size| bytes.
+  void WriteInChunks(File* file, size_t chunk_size) {
+    for (size_t offset = 0; offset < data_.size(); offset += chunk_size) {
+      const size_t size = std::min(chunk_size, data_.size() - offset);
+      ASSERT_EQ(static_cast<int64_t>(size),
+                file->Write(data_.data() + offset, size));
+    }
+  }
+
+  uint64_t saved_io_block_size_ = 0;
+  base::FilePath temp_dir_;
+  std::string data_;
+};
+
+TEST_F(IoUringFileTest, Write) {
+  if (!IoUringFile::IsSupported())
+    return;
+  // Upper level directories are created.
+  const std::string file_name = GetFileName("a/b/output");
+  File* file = File::Open(file_name.c_str(), "w");
+  ASSERT_TRUE(file);
+  EXPECT_TRUE(dynamic_cast<IoUringFile*>(file));
+  WriteInChunks(file, 1000);
+  EXPECT_EQ(static_cast<int64_t>(kDataSize), file->Size());
+  ASSERT_TRUE(file->Close());
+  EXPECT_EQ(data_, ReadFile(file_name));
+}
+
+TEST_F(IoUringFileTest, FlushAndSeek) {
+  if (!IoUringFile::IsSupported())
+    return;
+  const std::string file_name = GetFileName("output");
+  File* file = File::Open(file_name.c_str(), "w");
+  ASSERT_TRUE(file);
+  WriteInChunks(file, kBlockSize / 2);
+  ASSERT_TRUE(file->Flush());
+  EXPECT_EQ(data_, ReadFile(file_name));
+
+  // Overwrite some data across a block boundary.
+  const std::string kPatch = "patched";
+  const uint64_t kPatchPosition = kBlockSize - 3;
+  ASSERT_TRUE(file->Seek(kPatchPosition));
+  ASSERT_EQ(static_cast<int64_t>(kPatch.size()),
+            file->Write(kPatch.data(), kPatch.size()));
+  uint64_t position = 0;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(kPatchPosition + kPatch.size(), position);
+  EXPECT_EQ(static_cast<int64_t>(kDataSize), file->Size());
+  ASSERT_TRUE(file->Close());
+
+  data_.replace(kPatchPosition, kPatch.size(), kPatch);
+  EXPECT_EQ(data_, ReadFile(file_name));
+}
+
+TEST_F(IoUringFileTest, Append) {
+  if (!IoUringFile::IsSupported())
+    return;
+  const std::string file_name = GetFileName("output");
+  const std::string kExistingData = "existing data";
+  ASSERT_TRUE(File::WriteStringToFile(file_name.c_str(), kExistingData));
+
+  File* file = File::Open(file_name.c_str(), "a");
+  ASSERT_TRUE(file);
+  EXPECT_EQ(static_cast<int64_t>(kExistingData.size()), file->Size());
+  WriteInChunks(file, kDataSize);
+  ASSERT_TRUE(file->Close());
+  EXPECT_EQ(kExistingData + data_, ReadFile(file_name));
+}
+
+TEST_F(IoUringFileTest, DirectIo) {
+  if (!IoUringFile::IsSupported())
+    return;
+  // Falls back to buffered I/O if the file system does not support O_DIRECT.
+  FLAGS_io_uring_direct_io = true;
+  const std::string file_name = GetFileName("output");
+  File* file = File::Open(file_name.c_str(), "w");
+  ASSERT_TRUE(file);
+  WriteInChunks(file, 3000);
+  ASSERT_TRUE(file->Close());
+  EXPECT_EQ(data_, ReadFile(file_name));
+}
+
+// More files than registered buffers, written concurrently.
+TEST_F(IoUringFileTest, ManyFiles) {
+  if (!IoUringFile::IsSupported())
+    return;
+  const size_t kNumFiles = 20;
+  std::vector<std::unique_ptr<File, FileCloser>> files;
+  for (size_t i = 0; i < kNumFiles; ++i) {
+    files.emplace_back(
+        File::Open(GetFileName("output" + std::to_string(i)).c_str(), "w"));
+    ASSERT_TRUE(files.back());
+  }
+  const size_t kChunkSize = 500;
+  for (size_t offset = 0; offset < data_.size(); offset += kChunkSize) {
+    const size_t size = std::min(kChunkSize, data_.size() - offset);
+    for (auto& file : files)
+      ASSERT_EQ(static_cast<int64_t>(size),
+                file->Write(data_.data() + offset, size));
+  }
+  for (auto& file : files)
+    ASSERT_TRUE(file.release()->Close());
+  for (size_t i = 0; i < kNumFiles; ++i)
+    EXPECT_EQ(data_, ReadFile(GetFileName("output" + std::to_string(i))));
+}
+
+// The writes not seen by the kernel when the ring fails complete with an
+// error instead of blocking the files forever, while the writes in flight
+// still complete.
+TEST_F(IoUringFileTest, RingFailure) {
+  if (!IoUringFile::IsSupported())
+    return;
+  const std::string file_name = GetFileName("output");
+  File* file = File::Open(file_name.c_str(), "w");
+  ASSERT_TRUE(file);
+  const size_t kNumBlocksWritten = 3;
+  const std::string kDataWritten =
+      data_.substr(0, kNumBlocksWritten * kBlockSize);
+  ASSERT_EQ(static_cast<int64_t>(kDataWritten.size()),
+            file->Write(kDataWritten.data(), kDataWritten.size()));
+
+  IoUringFile::SetRingErrorForTesting(EIO);
+  EXPECT_EQ(-1, file->Write(data_.data(), kBlockSize));
+  EXPECT_EQ(-1, file->Write(data_.data(), kBlockSize));
+  EXPECT_FALSE(file->Flush());
+  EXPECT_FALSE(file->Close());
+  EXPECT_EQ(kDataWritten, ReadFile(file_name));
+
+  // The files opened after the failure do not use the ring.
+  EXPECT_FALSE(IoUringFile::IsSupported());
+  file = File::Open(file_name.c_str(), "w");
+  ASSERT_TRUE(file);
+  EXPECT_FALSE(dynamic_cast<IoUringFile*>(file));
+  ASSERT_TRUE(file->Close());
+
+  // The ring works again once restored.
+  IoUringFile::SetRingErrorForTesting(0);
+  ASSERT_TRUE(IoUringFile::IsSupported());
+  file = File::Open(file_name.c_str(), "w");
+  ASSERT_TRUE(file);
+  EXPECT_TRUE(dynamic_cast<IoUringFile*>(file));
+  WriteInChunks(file, kBlockSize);
+  ASSERT_TRUE(file->Close());
+  EXPECT_EQ(data_, ReadFile(file_name));
+}
+
+TEST_F(IoUringFileTest, ReadModeNotAffected) {
+  if (!IoUringFile::IsSupported())
+    return;
+  const std::string file_name = GetFileName("output");
+  ASSERT_TRUE(File::WriteStringToFile(file_name.c_str(), data_));
+  std::string contents;
+  ASSERT_TRUE(File::ReadFileToString(file_name.c_str(), &contents));
+  EXPECT_EQ(data_, contents);
+}
+
+}  // namespace shaka
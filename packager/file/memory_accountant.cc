@@ -0,0 +1,276 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/memory_accountant.h"
+
+#include <algorithm>
+
+#include "packager/base/logging.h"
+#include "packager/base/strings/stringprintf.h"
+
+namespace shaka {
+
+using base::AutoLock;
+
+namespace {
+
+// The producer registered on the current thread.
+thread_local MemoryAccountant::ProducerId g_current_producer =
+    MemoryAccountant::kNoProducer;
+
+size_t ToIndex(MemoryComponent component) {
+  DCHECK_LT(static_cast<size_t>(component),
+            static_cast<size_t>(MemoryComponent::kNumComponents));
+  return static_cast<size_t>(component);
+}
+
+}  // namespace
+
+MemoryAccountant* MemoryAccountant::GetInstance() {
+  // Intentionally leaked: buffering objects may still release memory on
+  // worker threads during static destruction.
+  static MemoryAccountant* instance = new MemoryAccountant;
+  return instance;
+}
+
+MemoryAccountant::MemoryAccountant() : budget_cv_(&lock_) {}
+
+void MemoryAccountant::SetBudget(uint64_t budget) {
+  AutoLock lock(lock_);
+  budget_ = budget;
+  base::subtle::NoBarrier_Store(&has_budget_, budget > 0 ? 1 : 0);
+  budget_cv_.Broadcast();
+}
+
+uint64_t MemoryAccountant::budget() {
+  AutoLock lock(lock_);
+  return budget_;
+}
+
+bool MemoryAccountant::AddBudgetUser(uint64_t budget) {
+  DCHECK_GT(budget, 0u);
+  {
+    AutoLock lock(lock_);
+    if (num_budget_users_ > 0 && budget != budget_)
+      return false;
+    ++num_budget_users_;
+  }
+  SetBudget(budget);
+  return true;
+}
+
+void MemoryAccountant::RemoveBudgetUser() {
+  {
+    AutoLock lock(lock_);
+    DCHECK_GT(num_budget_users_, 0u);
+    if (--num_budget_users_ > 0)
+      return;
+  }
+  SetBudget(0);
+}
+
+bool MemoryAccountant::Charge(MemoryComponent component,
+                              uint64_t size,
+                              ProducerId producer) {
+  if (size == 0 || !base::subtle::NoBarrier_Load(&has_budget_))
+    return false;
+  const size_t index = ToIndex(component);
+  AutoLock lock(lock_);
+  if (component != MemoryComponent::kIoCache) {
+    auto iter = producers_.find(producer);
+    if (iter != producers_.end())
+      iter->second.charged_bytes += size;
+  }
+  current_bytes_[index] += size;
+  high_watermarks_[index] =
+      std::max(high_watermarks_[index], current_bytes_[index]);
+  total_bytes_ += size;
+  total_high_watermark_ = std::max(total_high_watermark_, total_bytes_);
+  return true;
+}
+
+void MemoryAccountant::Release(MemoryComponent component,
+                               uint64_t size,
+                               ProducerId producer) {
+  if (size == 0)
+    return;
+  const size_t index = ToIndex(component);
+  AutoLock lock(lock_);
+  DCHECK_GE(current_bytes_[index], size);
+  size = std::min(size, current_bytes_[index]);
+  if (component != MemoryComponent::kIoCache) {
+    // The producer may have been unregistered since.
+    auto iter = producers_.find(producer);
+    if (iter != producers_.end()) {
+      DCHECK_GE(iter->second.charged_bytes, size);
+      iter->second.charged_bytes -=
+          std::min(size, iter->second.charged_bytes);
+    }
+  }
+  current_bytes_[index] -= size;
+  total_bytes_ -= size;
+  if (num_waiting_producers_ > 0)
+    budget_cv_.Broadcast();
+}
+
+void MemoryAccountant::RegisterProducer() {
+  DCHECK_EQ(kNoProducer, g_current_producer);
+  AutoLock lock(lock_);
+  g_current_producer = next_producer_id_++;
+  producers_[g_current_producer] = ProducerInfo();
+}
+
+void MemoryAccountant::UnregisterProducer() {
+  DCHECK_NE(kNoProducer, g_current_producer);
+  AutoLock lock(lock_);
+  producers_.erase(g_current_producer);
+  g_current_producer = kNoProducer;
+  // Waiting producers may have been waiting for this one.
+  budget_cv_.Broadcast();
+}
+
+MemoryAccountant::ProducerId MemoryAccountant::CurrentProducer() {
+  return g_current_producer;
+}
+
+void MemoryAccountant::WaitForBudget(const bool* cancelled) {
+  DCHECK(cancelled);
+  if (!base::subtle::NoBarrier_Load(&has_budget_))
+    return;
+  const ProducerId producer = g_current_producer;
+  AutoLock lock(lock_);
+  if (budget_ == 0 || total_bytes_ <= budget_)
+    return;
+  auto iter = producers_.find(producer);
+  DCHECK(iter != producers_.end()) << "Not called by a producer.";
+  if (iter == producers_.end())
+    return;
+
+  ++num_waiting_producers_;
+  iter->second.waiting = true;
+  // Other waiting producers may need to re-evaluate now that one more
+  // producer is blocked.
+  budget_cv_.Broadcast();
+  if (!*cancelled && ShouldWaitInternal(producer)) {
+    VLOG(1) << "Memory budget exceeded (" << total_bytes_ << " > " << budget_
+            << " bytes). Throttling producer.";
+    do {
+      budget_cv_.Wait();
+    } while (!*cancelled && ShouldWaitInternal(producer));
+  }
+  iter->second.waiting = false;
+  --num_waiting_producers_;
+}
+
+void MemoryAccountant::CancelProducer(bool* cancelled) {
+  AutoLock lock(lock_);
+  *cancelled = true;
+  budget_cv_.Broadcast();
+}
+
+uint64_t MemoryAccountant::current_bytes(MemoryComponent component) {
+  AutoLock lock(lock_);
+  return current_bytes_[ToIndex(component)];
+}
+
+uint64_t MemoryAccountant::high_watermark(MemoryComponent component) {
+  AutoLock lock(lock_);
+  return high_watermarks_[ToIndex(component)];
+}
+
+uint64_t MemoryAccountant::total_bytes() {
+  AutoLock lock(lock_);
+  return total_bytes_;
+}
+
+uint64_t MemoryAccountant::total_high_watermark() {
+  AutoLock lock(lock_);
+  return total_high_watermark_;
+}
+
+void MemoryAccountant::ResetHighWatermarks() {
+  AutoLock lock(lock_);
+  for (size_t i = 0; i < arraysize(high_watermarks_); ++i)
+    high_watermarks_[i] = current_bytes_[i];
+  total_high_watermark_ = total_bytes_;
+}
+
+std::string MemoryAccountant::GetHighWatermarkReport() {
+  AutoLock lock(lock_);
+  std::string report = base::StringPrintf(
+      "total=%llu", static_cast<unsigned long long>(total_high_watermark_));
+  for (size_t i = 0; i < arraysize(high_watermarks_); ++i) {
+    base::StringAppendF(
+        &report, " %s=%llu",
+        ComponentName(static_cast<MemoryComponent>(i)),
+        static_cast<unsigned long long>(high_watermarks_[i]));
+  }
+  return report;
+}
+
+const char* MemoryAccountant::ComponentName(MemoryComponent component) {
+  switch (component) {
+    case MemoryComponent::kParserQueue:
+      return "parser_queue";
+    case MemoryComponent::kChunkingQueue:
+      return "chunking_queue";
+    case MemoryComponent::kFragmenter:
+      return "fragmenter";
+    case MemoryComponent::kPesPackets:
+      return "pes_packets";
+    case MemoryComponent::kIoCache:
+      return "io_cache";
+    case MemoryComponent::kNumComponents:
+      break;
+  }
+  NOTREACHED();
+  return "unknown";
+}
+
+bool MemoryAccountant::ShouldWaitInternal(ProducerId producer) {
+  lock_.AssertAcquired();
+  if (budget_ == 0 || total_bytes_ <= budget_)
+    return false;
+  // Only wait if enough memory can be released without this producer making
+  // progress. Memory charged to this producer, or to producers which are
+  // waiting themselves, is only released once they make progress; waiting
+  // for it would block the producers on each other forever.
+  uint64_t releasable_bytes =
+      current_bytes_[ToIndex(MemoryComponent::kIoCache)];
+  for (const auto& entry : producers_) {
+    if (entry.first != producer && !entry.second.waiting)
+      releasable_bytes += entry.second.charged_bytes;
+  }
+  return releasable_bytes > 0 && total_bytes_ - releasable_bytes <= budget_;
+}
+
+MemoryCharge::MemoryCharge(MemoryComponent component)
+    : component_(component) {}
+
+MemoryCharge::~MemoryCharge() {
+  ReleaseAll();
+}
+
+void MemoryCharge::Charge(uint64_t size) {
+  if (charged_bytes_ == 0)
+    producer_ = MemoryAccountant::CurrentProducer();
+  if (MemoryAccountant::GetInstance()->Charge(component_, size, producer_))
+    charged_bytes_ += size;
+}
+
+void MemoryCharge::Release(uint64_t size) {
+  size = std::min(size, charged_bytes_);
+  if (size == 0)
+    return;
+  charged_bytes_ -= size;
+  MemoryAccountant::GetInstance()->Release(component_, size, producer_);
+}
+
+void MemoryCharge::ReleaseAll() {
+  Release(charged_bytes_);
+}
+
+}  // namespace shaka
@@ -0,0 +1,184 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_MEMORY_ACCOUNTANT_H_
+#define PACKAGER_FILE_MEMORY_ACCOUNTANT_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+#include "packager/base/atomicops.h"
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+
+namespace shaka {
+
+/// Buffering components whose memory is tracked by MemoryAccountant.
+enum class MemoryComponent {
+  kParserQueue,
+  kChunkingQueue,
+  kFragmenter,
+  kPesPackets,
+  kIoCache,
+  // Not a component. Must be the last entry.
+  kNumComponents,
+};
+
+/// Process wide accountant of the memory held by buffering components.
+/// Components charge the bytes they buffer and release them once the data
+/// moves on. When a budget is set, producers (demuxers) call WaitForBudget()
+/// before reading more input, which throttles them while the total charged
+/// memory is over budget.
+/// The bytes charged on a producer thread are attributed to that producer,
+/// as they belong to its pipeline and are only released as the producer
+/// makes progress. A producer never waits for its own bytes.
+/// Memory is only tracked while a budget is set, so that charging costs
+/// nothing otherwise. The budget should be set before the components start
+/// buffering.
+class MemoryAccountant {
+ public:
+  /// Identifies a producer registered with RegisterProducer().
+  typedef int ProducerId;
+  /// Bytes not buffered on behalf of any producer.
+  static const ProducerId kNoProducer = 0;
+
+  /// @return the process wide instance.
+  static MemoryAccountant* GetInstance();
+
+  /// Set the memory budget shared by all components.
+  /// @param budget is the budget in bytes. 0 means unlimited.
+  void SetBudget(uint64_t budget);
+  /// @return the memory budget in bytes, 0 if unlimited.
+  uint64_t budget();
+
+  /// Set the memory budget on behalf of a user, e.g. a Packager instance.
+  /// Since the budget is process wide, all the users must use the same
+  /// budget.
+  /// @param budget is the budget in bytes, which should not be 0.
+  /// @return false if other users have set a different budget.
+  bool AddBudgetUser(uint64_t budget);
+  /// Remove a user added with AddBudgetUser(). The budget is lifted once the
+  /// last user is removed.
+  void RemoveBudgetUser();
+
+  /// Charge @a size bytes to @a component.
+  /// @param producer is the producer whose pipeline buffers the bytes. It is
+  ///        ignored for kIoCache, which is drained by writer threads.
+  /// @return true if the bytes are tracked, false if no budget is set.
+  bool Charge(MemoryComponent component,
+              uint64_t size,
+              ProducerId producer = kNoProducer);
+  /// Release @a size bytes previously charged, and tracked, to @a component.
+  /// @param producer is the producer the bytes were charged to.
+  void Release(MemoryComponent component,
+               uint64_t size,
+               ProducerId producer = kNoProducer);
+
+  /// Register the calling thread as a producer, i.e. a thread that calls
+  /// WaitForBudget().
+  void RegisterProducer();
+  /// Unregister the producer registered on the calling thread. The bytes
+  /// still charged to it are no longer attributed to any producer.
+  void UnregisterProducer();
+  /// @return the producer registered on the calling thread, or kNoProducer.
+  static ProducerId CurrentProducer();
+
+  /// Block the producer registered on the calling thread while the charged
+  /// memory is over budget and the memory that other parts of the graph can
+  /// release would bring it back under budget, i.e. the IoCaches being
+  /// drained by their writer threads and the memory buffered by the other
+  /// producers that are still running. Returns immediately if no budget is
+  /// set.
+  /// @param cancelled points to the cancellation flag of the producer, which
+  ///        is set with CancelProducer(). The producer stops waiting once it
+  ///        is set.
+  void WaitForBudget(const bool* cancelled);
+  /// Set @a cancelled, the cancellation flag of a producer, and wake up the
+  /// producer if it is blocked in WaitForBudget().
+  void CancelProducer(bool* cancelled);
+
+  /// @return the number of bytes currently charged to @a component.
+  uint64_t current_bytes(MemoryComponent component);
+  /// @return the highest number of bytes charged to @a component.
+  uint64_t high_watermark(MemoryComponent component);
+  /// @return the number of bytes currently charged to all components.
+  uint64_t total_bytes();
+  /// @return the highest number of bytes charged to all components.
+  uint64_t total_high_watermark();
+
+  /// Reset the high watermarks to the current usage.
+  void ResetHighWatermarks();
+
+  /// @return a human readable report of the high watermarks.
+  std::string GetHighWatermarkReport();
+
+  /// @return the name of @a component.
+  static const char* ComponentName(MemoryComponent component);
+
+ private:
+  friend class MemoryAccountantTest;
+
+  MemoryAccountant();
+
+  struct ProducerInfo {
+    uint64_t charged_bytes = 0;
+    bool waiting = false;
+  };
+
+  bool ShouldWaitInternal(ProducerId producer);
+
+  base::Lock lock_;
+  base::ConditionVariable budget_cv_;
+  uint64_t budget_ = 0;
+  // Non zero if a budget is set. Read without the lock by Charge().
+  base::subtle::Atomic32 has_budget_ = 0;
+  size_t num_budget_users_ = 0;
+  uint64_t total_bytes_ = 0;
+  uint64_t total_high_watermark_ = 0;
+  uint64_t current_bytes_[static_cast<size_t>(
+      MemoryComponent::kNumComponents)] = {};
+  uint64_t high_watermarks_[static_cast<size_t>(
+      MemoryComponent::kNumComponents)] = {};
+  ProducerId next_producer_id_ = kNoProducer + 1;
+  std::map<ProducerId, ProducerInfo> producers_;
+  size_t num_waiting_producers_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryAccountant);
+};
+
+/// Tracks the bytes charged by a single buffering object, so that whatever
+/// is still charged is released when the object goes away. The bytes are
+/// attributed to the producer registered on the thread that charges them
+/// while the object holds nothing.
+class MemoryCharge {
+ public:
+  explicit MemoryCharge(MemoryComponent component);
+  ~MemoryCharge();
+
+  /// Charge @a size bytes. Nothing is charged if no budget is set.
+  void Charge(uint64_t size);
+  /// Release @a size bytes. Releasing more than charged releases everything.
+  void Release(uint64_t size);
+  /// Release everything charged by this object.
+  void ReleaseAll();
+
+  /// @return the number of bytes charged, and tracked, by this object.
+  uint64_t charged_bytes() const { return charged_bytes_; }
+
+ private:
+  const MemoryComponent component_;
+  MemoryAccountant::ProducerId producer_ = MemoryAccountant::kNoProducer;
+  uint64_t charged_bytes_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryCharge);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_MEMORY_ACCOUNTANT_H_
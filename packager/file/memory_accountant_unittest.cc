@@ -0,0 +1,238 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/memory_accountant.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+
+#include "packager/base/threading/platform_thread.h"
+#include "packager/base/threading/simple_thread.h"
+
+namespace shaka {
+namespace {
+
+const uint64_t kBudget = 1000;
+const int kWaitTimeMs = 50;
+const int kMaxPolls = 100;
+
+// A producer on a separate thread, which charges |own_bytes| to its
+// pipeline and calls WaitForBudget().
+class BudgetWaiter : public base::DelegateSimpleThread::Delegate {
+ public:
+  BudgetWaiter(MemoryAccountant* accountant, uint64_t own_bytes)
+      : accountant_(accountant),
+        own_bytes_(own_bytes),
+        thread_(this, "BudgetWaiter") {}
+
+  void Start() { thread_.Start(); }
+  void Join() { thread_.Join(); }
+  bool done() const { return done_; }
+
+  void Cancel() { accountant_->CancelProducer(&cancelled_); }
+
+  void Run() override {
+    accountant_->RegisterProducer();
+    const MemoryAccountant::ProducerId producer =
+        MemoryAccountant::CurrentProducer();
+    accountant_->Charge(MemoryComponent::kChunkingQueue, own_bytes_,
+                        producer);
+    accountant_->WaitForBudget(&cancelled_);
+    done_ = true;
+    accountant_->Release(MemoryComponent::kChunkingQueue, own_bytes_,
+                         producer);
+    accountant_->UnregisterProducer();
+  }
+
+ private:
+  MemoryAccountant* accountant_;
+  const uint64_t own_bytes_;
+  base::DelegateSimpleThread thread_;
+  bool cancelled_ = false;
+  std::atomic<bool> done_{false};
+};
+
+}  // namespace
+
+class MemoryAccountantTest : public testing::Test {
+ protected:
+  void SetUp() override { accountant_.reset(new MemoryAccountant); }
+
+  std::unique_ptr<MemoryAccountant> accountant_;
+  bool cancelled_ = false;
+};
+
+TEST_F(MemoryAccountantTest, ChargeAndRelease) {
+  accountant_->SetBudget(kBudget);
+  accountant_->Charge(MemoryComponent::kParserQueue, 100);
+  accountant_->Charge(MemoryComponent::kFragmenter, 50);
+  accountant_->Charge(MemoryComponent::kParserQueue, 20);
+  EXPECT_EQ(120u, accountant_->current_bytes(MemoryComponent::kParserQueue));
+  EXPECT_EQ(50u, accountant_->current_bytes(MemoryComponent::kFragmenter));
+  EXPECT_EQ(170u, accountant_->total_bytes());
+
+  accountant_->Release(MemoryComponent::kParserQueue, 120);
+  accountant_->Charge(MemoryComponent::kFragmenter, 10);
+  EXPECT_EQ(0u, accountant_->current_bytes(MemoryComponent::kParserQueue));
+  EXPECT_EQ(120u, accountant_->high_watermark(MemoryComponent::kParserQueue));
+  EXPECT_EQ(60u, accountant_->high_watermark(MemoryComponent::kFragmenter));
+  EXPECT_EQ(60u, accountant_->total_bytes());
+  EXPECT_EQ(170u, accountant_->total_high_watermark());
+
+  accountant_->ResetHighWatermarks();
+  EXPECT_EQ(0u, accountant_->high_watermark(MemoryComponent::kParserQueue));
+  EXPECT_EQ(60u, accountant_->total_high_watermark());
+  EXPECT_EQ(
+      "total=60 parser_queue=0 chunking_queue=0 fragmenter=60 pes_packets=0 "
+      "io_cache=0",
+      accountant_->GetHighWatermarkReport());
+}
+
+TEST_F(MemoryAccountantTest, NotTrackedWithoutBudget) {
+  EXPECT_FALSE(accountant_->Charge(MemoryComponent::kIoCache, 10 * kBudget));
+  EXPECT_EQ(0u, accountant_->total_bytes());
+  accountant_->RegisterProducer();
+  accountant_->WaitForBudget(&cancelled_);
+  accountant_->UnregisterProducer();
+}
+
+TEST_F(MemoryAccountantTest, BudgetUsers) {
+  ASSERT_TRUE(accountant_->AddBudgetUser(kBudget));
+  ASSERT_TRUE(accountant_->AddBudgetUser(kBudget));
+  EXPECT_FALSE(accountant_->AddBudgetUser(2 * kBudget));
+  EXPECT_EQ(kBudget, accountant_->budget());
+
+  accountant_->RemoveBudgetUser();
+  EXPECT_EQ(kBudget, accountant_->budget());
+  accountant_->RemoveBudgetUser();
+  EXPECT_EQ(0u, accountant_->budget());
+  // The budget can be changed once all the users are gone.
+  ASSERT_TRUE(accountant_->AddBudgetUser(2 * kBudget));
+  EXPECT_EQ(2 * kBudget, accountant_->budget());
+  accountant_->RemoveBudgetUser();
+}
+
+TEST_F(MemoryAccountantTest, NoWaitUnderBudget) {
+  accountant_->SetBudget(kBudget);
+  accountant_->Charge(MemoryComponent::kIoCache, kBudget);
+  accountant_->RegisterProducer();
+  accountant_->WaitForBudget(&cancelled_);
+  accountant_->UnregisterProducer();
+}
+
+// A lone producer must not wait for memory that only it can release.
+TEST_F(MemoryAccountantTest, NoWaitIfNothingCanBeReleased) {
+  accountant_->SetBudget(kBudget);
+  accountant_->Charge(MemoryComponent::kChunkingQueue, 2 * kBudget);
+  accountant_->RegisterProducer();
+  accountant_->WaitForBudget(&cancelled_);
+  accountant_->UnregisterProducer();
+}
+
+TEST_F(MemoryAccountantTest, WaitUntilIoCacheDrained) {
+  accountant_->SetBudget(kBudget);
+  accountant_->Charge(MemoryComponent::kIoCache, kBudget);
+
+  BudgetWaiter waiter(accountant_.get(), kBudget / 2);
+  waiter.Start();
+  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(kWaitTimeMs));
+  EXPECT_FALSE(waiter.done());
+
+  accountant_->Release(MemoryComponent::kIoCache, kBudget);
+  waiter.Join();
+  EXPECT_TRUE(waiter.done());
+}
+
+TEST_F(MemoryAccountantTest, WaitWhileOtherProducerReleases) {
+  accountant_->SetBudget(kBudget);
+  // Two producers: the waiter and the test thread.
+  accountant_->RegisterProducer();
+  const MemoryAccountant::ProducerId producer =
+      MemoryAccountant::CurrentProducer();
+  accountant_->Charge(MemoryComponent::kParserQueue, kBudget, producer);
+
+  BudgetWaiter waiter(accountant_.get(), kBudget / 2);
+  waiter.Start();
+  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(kWaitTimeMs));
+  EXPECT_FALSE(waiter.done());
+
+  // The waiter is released once the test thread's pipeline moves on.
+  accountant_->Release(MemoryComponent::kParserQueue, kBudget, producer);
+  waiter.Join();
+  EXPECT_TRUE(waiter.done());
+  accountant_->UnregisterProducer();
+}
+
+// A producer over budget because of its own pipeline must not wait for the
+// other producers, which cannot release enough memory. Waiting could
+// deadlock, e.g. with two live inputs whose pipelines each hold samples.
+TEST_F(MemoryAccountantTest, NoWaitForOwnMemory) {
+  accountant_->SetBudget(kBudget);
+  // Two producers: the waiter and the test thread, which keeps running.
+  accountant_->RegisterProducer();
+  const MemoryAccountant::ProducerId producer =
+      MemoryAccountant::CurrentProducer();
+  accountant_->Charge(MemoryComponent::kChunkingQueue, kBudget / 2, producer);
+
+  BudgetWaiter waiter(accountant_.get(), 2 * kBudget);
+  waiter.Start();
+  for (int i = 0; i < kMaxPolls && !waiter.done(); ++i) {
+    base::PlatformThread::Sleep(
+        base::TimeDelta::FromMilliseconds(kWaitTimeMs));
+  }
+  EXPECT_TRUE(waiter.done());
+
+  // Unblocks the waiter if it is waiting nevertheless.
+  accountant_->Release(MemoryComponent::kChunkingQueue, kBudget / 2, producer);
+  waiter.Join();
+  accountant_->UnregisterProducer();
+}
+
+TEST_F(MemoryAccountantTest, CancelWait) {
+  accountant_->SetBudget(kBudget);
+  accountant_->Charge(MemoryComponent::kIoCache, 2 * kBudget);
+
+  BudgetWaiter waiter(accountant_.get(), kBudget / 2);
+  waiter.Start();
+  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(kWaitTimeMs));
+  EXPECT_FALSE(waiter.done());
+
+  waiter.Cancel();
+  waiter.Join();
+  EXPECT_TRUE(waiter.done());
+}
+
+TEST(MemoryChargeTest, ReleasedOnDestruction) {
+  MemoryAccountant* accountant = MemoryAccountant::GetInstance();
+  ASSERT_TRUE(accountant->AddBudgetUser(kBudget));
+  const uint64_t initial_bytes =
+      accountant->current_bytes(MemoryComponent::kPesPackets);
+  {
+    MemoryCharge charge(MemoryComponent::kPesPackets);
+    charge.Charge(100);
+    charge.Release(30);
+    EXPECT_EQ(70u, charge.charged_bytes());
+    EXPECT_EQ(initial_bytes + 70,
+              accountant->current_bytes(MemoryComponent::kPesPackets));
+    // Releasing more than charged releases everything charged.
+    charge.Release(100);
+    EXPECT_EQ(0u, charge.charged_bytes());
+    charge.Charge(10);
+  }
+  EXPECT_EQ(initial_bytes,
+            accountant->current_bytes(MemoryComponent::kPesPackets));
+  accountant->RemoveBudgetUser();
+}
+
+TEST(MemoryChargeTest, NotChargedWithoutBudget) {
+  MemoryCharge charge(MemoryComponent::kPesPackets);
+  charge.Charge(100);
+  EXPECT_EQ(0u, charge.charged_bytes());
+}
+
+}  // namespace shaka
@@ -11,69 +11,412 @@
 #include <algorithm>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "packager/base/logging.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/time/default_clock.h"
 
 namespace shaka {
 namespace {
 
+// Files are spread over the shards by name hash so that accesses to different
+// files rarely contend on the same lock.
+const size_t kNumShards = 16;
+
+// The chunks of a file grow from kMinChunkSize to kMaxChunkSize, doubling
+// every chunk, so that small files stay small and large files have few
+// chunks.
+const uint64_t kMinChunkSize = 4096;
+const size_t kNumGrowingChunks = 8;
+const uint64_t kMaxChunkSize = kMinChunkSize << kNumGrowingChunks;
+
+uint64_t GetChunkSize(size_t chunk_index) {
+  return chunk_index < kNumGrowingChunks ? kMinChunkSize << chunk_index
+                                         : kMaxChunkSize;
+}
+
+// Returns the index of the chunk containing |position|, and sets
+// |chunk_offset| to the offset of |position| in that chunk.
+size_t GetChunkIndex(uint64_t position, uint64_t* chunk_offset) {
+  size_t chunk_index = 0;
+  uint64_t chunk_start = 0;
+  while (chunk_index < kNumGrowingChunks &&
+         position >= chunk_start + GetChunkSize(chunk_index)) {
+    chunk_start += GetChunkSize(chunk_index);
+    ++chunk_index;
+  }
+  if (chunk_index == kNumGrowingChunks) {
+    const uint64_t num_chunks = (position - chunk_start) / kMaxChunkSize;
+    chunk_index += num_chunks;
+    chunk_start += num_chunks * kMaxChunkSize;
+  }
+  *chunk_offset = position - chunk_start;
+  return chunk_index;
+}
+
+}  // namespace
+
+// The content of a memory file, stored in chunks. Copies of MemoryFileData
+// share the chunks. A chunk is copied before bytes visible to another copy
+// are overwritten; appended bytes go past the end of the other copies, so
+// they can be written to a shared chunk in place.
+class MemoryFileData {
+ public:
+  MemoryFileData() {}
+
+  uint64_t size() const { return size_; }
+
+  // Copies up to |length| bytes at |position| to |buffer|.
+  // Returns the number of bytes copied.
+  uint64_t Read(uint64_t position, void* buffer, uint64_t length) const {
+    if (position >= size_)
+      return 0;
+    length = std::min(length, size_ - position);
+    uint8_t* output = reinterpret_cast<uint8_t*>(buffer);
+    uint64_t chunk_offset = 0;
+    size_t chunk_index = GetChunkIndex(position, &chunk_offset);
+    for (uint64_t bytes_left = length; bytes_left > 0; ++chunk_index) {
+      const uint64_t bytes_to_copy = std::min(
+          bytes_left, GetChunkSize(chunk_index) - chunk_offset);
+      memcpy(output, chunks_[chunk_index]->data() + chunk_offset,
+             bytes_to_copy);
+      output += bytes_to_copy;
+      bytes_left -= bytes_to_copy;
+      chunk_offset = 0;
+    }
+    return length;
+  }
+
+  void Write(uint64_t position, const void* buffer, uint64_t length) {
+    DCHECK_LE(position, size_);
+    const uint8_t* input = reinterpret_cast<const uint8_t*>(buffer);
+    uint64_t chunk_offset = 0;
+    size_t chunk_index = GetChunkIndex(position, &chunk_offset);
+    for (uint64_t bytes_left = length; bytes_left > 0; ++chunk_index) {
+      const uint64_t bytes_to_copy = std::min(
+          bytes_left, GetChunkSize(chunk_index) - chunk_offset);
+      if (chunk_index == chunks_.size()) {
+        chunks_.push_back(std::make_shared<std::vector<uint8_t>>(
+            GetChunkSize(chunk_index)));
+      } else if (position < size_ && chunks_[chunk_index].use_count() > 1) {
+        // Do not overwrite the bytes under another copy.
+        chunks_[chunk_index] =
+            std::make_shared<std::vector<uint8_t>>(*chunks_[chunk_index]);
+      }
+      memcpy(chunks_[chunk_index]->data() + chunk_offset, input,
+             bytes_to_copy);
+      input += bytes_to_copy;
+      position += bytes_to_copy;
+      bytes_left -= bytes_to_copy;
+      chunk_offset = 0;
+    }
+    size_ = std::max(size_, position);
+  }
+
+ private:
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> chunks_;
+  uint64_t size_ = 0;
+};
+
+namespace {
+
+struct Entry {
+  // Content of the file. Readers of a complete file take a reference to it,
+  // and readers of a file being written get a copy, which shares the chunks.
+  std::shared_ptr<MemoryFileData> data = std::make_shared<MemoryFileData>();
+  // Number of MemoryFile objects open for writing.
+  int num_writers = 0;
+  base::Time last_access_time;
+};
+
+struct Shard {
+  base::Lock lock;
+  // The members below are protected by |lock|.
+  std::map<std::string, Entry> files;
+  uint64_t num_bytes = 0;
+};
+
 // A helper filesystem object.  This holds the data for the memory files.
 class FileSystem {
  public:
-  ~FileSystem() {}
-
   static FileSystem* Instance() {
-    if (!g_file_system_)
-      g_file_system_.reset(new FileSystem());
+    // Leaked on purpose so the files can be accessed until the process exits.
+    static FileSystem* file_system = new FileSystem;
+    return file_system;
+  }
 
-    return g_file_system_.get();
+  bool OpenForRead(const std::string& file_name) {
+    Shard* shard = GetShard(file_name);
+    base::AutoLock auto_lock(shard->lock);
+    auto iter = shard->files.find(file_name);
+    if (iter == shard->files.end())
+      return false;
+    iter->second.last_access_time = Now();
+    return true;
   }
 
-  bool Exists(const std::string& file_name) const {
-    return files_.find(file_name) != files_.end();
+  void OpenForWrite(const std::string& file_name) {
+    Shard* shard = GetShard(file_name);
+    base::AutoLock auto_lock(shard->lock);
+    Entry& entry = shard->files[file_name];
+    // Readers of the previous content keep their own reference to it.
+    shard->num_bytes -= entry.data->size();
+    entry.data = std::make_shared<MemoryFileData>();
+    ++entry.num_writers;
+    entry.last_access_time = Now();
   }
 
-  std::vector<uint8_t>* GetFile(const std::string& file_name) {
-    return &files_[file_name];
+  void CloseWriter(const std::string& file_name) {
+    {
+      Shard* shard = GetShard(file_name);
+      base::AutoLock auto_lock(shard->lock);
+      auto iter = shard->files.find(file_name);
+      if (iter == shard->files.end() || iter->second.num_writers == 0)
+        return;
+      --iter->second.num_writers;
+    }
+    Notify(file_name, MemoryFileEvent::kWritten);
+    EnforceLimits();
   }
 
-  void Delete(const std::string& file_name) { files_.erase(file_name); }
+  // Returns the content of the file, or nullptr if it does not exist.
+  // |is_complete| is set to false if the file is still open for writing.
+  std::shared_ptr<const MemoryFileData> GetData(const std::string& file_name,
+                                                bool* is_complete) {
+    Shard* shard = GetShard(file_name);
+    base::AutoLock auto_lock(shard->lock);
+    auto iter = shard->files.find(file_name);
+    if (iter == shard->files.end())
+      return nullptr;
+    *is_complete = iter->second.num_writers == 0;
+    // A file being written is modified in place, so the reader gets a
+    // snapshot of it.
+    if (!*is_complete)
+      return std::make_shared<MemoryFileData>(*iter->second.data);
+    return iter->second.data;
+  }
+
+  uint64_t GetSize(const std::string& file_name) {
+    Shard* shard = GetShard(file_name);
+    base::AutoLock auto_lock(shard->lock);
+    auto iter = shard->files.find(file_name);
+    return iter == shard->files.end() ? 0 : iter->second.data->size();
+  }
 
-  void DeleteAll() { files_.clear(); }
+  void Write(const std::string& file_name,
+             uint64_t position,
+             const void* buffer,
+             uint64_t length) {
+    Shard* shard = GetShard(file_name);
+    base::AutoLock auto_lock(shard->lock);
+    Entry& entry = shard->files[file_name];
+    // Do not modify the data under a reader, which may have got it as a
+    // complete file, e.g. if the file was deleted while being written. Only
+    // the list of chunks is copied.
+    if (entry.data.use_count() > 1)
+      entry.data = std::make_shared<MemoryFileData>(*entry.data);
+
+    const uint64_t size = entry.data->size();
+    entry.data->Write(position, buffer, length);
+    shard->num_bytes += entry.data->size() - size;
+    entry.last_access_time = Now();
+  }
+
+  void WriteAtomically(const std::string& file_name,
+                       const std::string& contents) {
+    {
+      Shard* shard = GetShard(file_name);
+      base::AutoLock auto_lock(shard->lock);
+      Entry& entry = shard->files[file_name];
+      shard->num_bytes -= entry.data->size();
+      entry.data = std::make_shared<MemoryFileData>();
+      entry.data->Write(0, contents.data(), contents.size());
+      shard->num_bytes += entry.data->size();
+      entry.last_access_time = Now();
+    }
+    Notify(file_name, MemoryFileEvent::kWritten);
+    EnforceLimits();
+  }
+
+  void Delete(const std::string& file_name) {
+    {
+      Shard* shard = GetShard(file_name);
+      base::AutoLock auto_lock(shard->lock);
+      auto iter = shard->files.find(file_name);
+      if (iter == shard->files.end())
+        return;
+      shard->num_bytes -= iter->second.data->size();
+      shard->files.erase(iter);
+    }
+    Notify(file_name, MemoryFileEvent::kDeleted);
+  }
+
+  void DeleteAll() {
+    for (Shard& shard : shards_) {
+      base::AutoLock auto_lock(shard.lock);
+      shard.files.clear();
+      shard.num_bytes = 0;
+    }
+  }
+
+  uint64_t GetTotalBytes() {
+    uint64_t total_bytes = 0;
+    for (Shard& shard : shards_) {
+      base::AutoLock auto_lock(shard.lock);
+      total_bytes += shard.num_bytes;
+    }
+    return total_bytes;
+  }
+
+  void SetLimits(const MemoryFileLimits& limits) {
+    {
+      base::AutoLock auto_lock(lock_);
+      limits_ = limits;
+    }
+    EnforceLimits();
+  }
+
+  int AddListener(const MemoryFile::Listener& listener) {
+    base::AutoLock auto_lock(lock_);
+    const int listener_id = next_listener_id_++;
+    listeners_[listener_id] = listener;
+    return listener_id;
+  }
+
+  void RemoveListener(int listener_id) {
+    base::AutoLock auto_lock(lock_);
+    listeners_.erase(listener_id);
+  }
+
+  void SetClock(base::Clock* clock) {
+    base::AutoLock auto_lock(lock_);
+    clock_ = clock ? clock : &default_clock_;
+  }
 
  private:
-  FileSystem() {}
+  struct EvictionCandidate {
+    base::Time last_access_time;
+    std::string file_name;
+
+    bool operator<(const EvictionCandidate& other) const {
+      return last_access_time < other.last_access_time;
+    }
+  };
+
+  FileSystem() : clock_(&default_clock_) {}
+
+  Shard* GetShard(const std::string& file_name) {
+    return &shards_[std::hash<std::string>()(file_name) % kNumShards];
+  }
+
+  base::Time Now() {
+    base::AutoLock auto_lock(lock_);
+    return clock_->Now();
+  }
+
+  void Notify(const std::string& file_name, MemoryFileEvent event) {
+    std::map<int, MemoryFile::Listener> listeners;
+    {
+      base::AutoLock auto_lock(lock_);
+      if (listeners_.empty())
+        return;
+      listeners = listeners_;
+    }
+    for (const auto& listener : listeners)
+      listener.second(file_name, event);
+  }
+
+  // Evicts the files idle for longer than the maximum idle time, then the
+  // least recently used files until the total size is within the limit.
+  void EnforceLimits() {
+    MemoryFileLimits limits;
+    {
+      base::AutoLock auto_lock(lock_);
+      limits = limits_;
+    }
+    if (limits.max_total_bytes == 0 && limits.max_idle_time.is_zero())
+      return;
+
+    const base::Time now = Now();
+    uint64_t total_bytes = 0;
+    std::vector<EvictionCandidate> candidates;
+    for (Shard& shard : shards_) {
+      base::AutoLock auto_lock(shard.lock);
+      total_bytes += shard.num_bytes;
+      for (const auto& file : shard.files) {
+        if (file.second.num_writers == 0) {
+          candidates.push_back(
+              EvictionCandidate{file.second.last_access_time, file.first});
+        }
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const EvictionCandidate& candidate : candidates) {
+      const bool is_idle = !limits.max_idle_time.is_zero() &&
+                           now - candidate.last_access_time >
+                               limits.max_idle_time;
+      const bool is_over_budget =
+          limits.max_total_bytes != 0 && total_bytes > limits.max_total_bytes;
+      // Candidates are sorted by access time, so no other file is idle.
+      if (!is_idle && !is_over_budget)
+        break;
+
+      {
+        Shard* shard = GetShard(candidate.file_name);
+        base::AutoLock auto_lock(shard->lock);
+        auto iter = shard->files.find(candidate.file_name);
+        // Skip the files accessed since the candidates were collected.
+        if (iter == shard->files.end() || iter->second.num_writers > 0 ||
+            iter->second.last_access_time != candidate.last_access_time) {
+          continue;
+        }
+        const uint64_t file_size = iter->second.data->size();
+        shard->num_bytes -= file_size;
+        total_bytes -= std::min(total_bytes, file_size);
+        shard->files.erase(iter);
+      }
+      VLOG(1) << "Evicted memory file " << candidate.file_name;
+      Notify(candidate.file_name, MemoryFileEvent::kEvicted);
+    }
+  }
+
+  Shard shards_[kNumShards];
 
-  static std::unique_ptr<FileSystem> g_file_system_;
+  base::Lock lock_;
+  // The members below are protected by |lock_|.
+  MemoryFileLimits limits_;
+  std::map<int, MemoryFile::Listener> listeners_;
+  int next_listener_id_ = 0;
+  base::DefaultClock default_clock_;
+  base::Clock* clock_;
 
-  std::map<std::string, std::vector<uint8_t> > files_;
   DISALLOW_COPY_AND_ASSIGN(FileSystem);
 };
 
-std::unique_ptr<FileSystem> FileSystem::g_file_system_;
-
 }  // namespace
 
 MemoryFile::MemoryFile(const std::string& file_name, const std::string& mode)
-    : File(file_name), mode_(mode), file_(NULL), position_(0) {}
+    : File(file_name), mode_(mode), position_(0) {}
 
 MemoryFile::~MemoryFile() {}
 
 bool MemoryFile::Close() {
+  if (mode_ == "w")
+    FileSystem::Instance()->CloseWriter(file_name());
   delete this;
   return true;
 }
 
 int64_t MemoryFile::Read(void* buffer, uint64_t length) {
-  const uint64_t size = Size();
-  DCHECK_LE(position_, size);
-  if (position_ >= size)
-    return 0;
+  std::shared_ptr<const MemoryFileData> data = GetData();
+  if (!data)
+    return -1;
 
-  const uint64_t bytes_to_read = std::min(length, size - position_);
-  memcpy(buffer, &(*file_)[position_], bytes_to_read);
-  position_ += bytes_to_read;
-  return bytes_to_read;
+  const uint64_t bytes_read = data->Read(position_, buffer, length);
+  position_ += bytes_read;
+  return bytes_read;
 }
 
 int64_t MemoryFile::Write(const void* buffer, uint64_t length) {
@@ -84,19 +427,16 @@ int64_t MemoryFile::Write(const void* buffer, uint64_t length) {
     return 0;
   }
 
-  const uint64_t size = Size();
-  if (size < position_ + length) {
-    file_->resize(position_ + length);
-  }
-
-  memcpy(&(*file_)[position_], buffer, length);
+  FileSystem::Instance()->Write(file_name(), position_, buffer, length);
   position_ += length;
   return length;
 }
 
 int64_t MemoryFile::Size() {
-  DCHECK(file_);
-  return file_->size();
+  if (mode_ == "w")
+    return FileSystem::Instance()->GetSize(file_name());
+  std::shared_ptr<const MemoryFileData> data = GetData();
+  return data ? data->size() : 0;
 }
 
 bool MemoryFile::Flush() {
@@ -119,21 +459,33 @@ bool MemoryFile::Tell(uint64_t* position) {
 bool MemoryFile::Open() {
   FileSystem* file_system = FileSystem::Instance();
   if (mode_ == "r") {
-    if (!file_system->Exists(file_name()))
+    if (!file_system->OpenForRead(file_name()))
       return false;
   } else if (mode_ == "w") {
-    file_system->Delete(file_name());
+    file_system->OpenForWrite(file_name());
   } else {
     NOTIMPLEMENTED() << "File mode " << mode_ << " not supported by MemoryFile";
     return false;
   }
 
-  file_ = file_system->GetFile(file_name());
-  DCHECK(file_);
   position_ = 0;
   return true;
 }
 
+std::shared_ptr<const MemoryFileData> MemoryFile::GetData() {
+  if (complete_data_)
+    return complete_data_;
+
+  bool is_complete = false;
+  std::shared_ptr<const MemoryFileData> data =
+      FileSystem::Instance()->GetData(file_name(), &is_complete);
+  // A file still being written is looked up again on every access to pick up
+  // new writes.
+  if (data && is_complete)
+    complete_data_ = data;
+  return data;
+}
+
 void MemoryFile::DeleteAll() {
   FileSystem::Instance()->DeleteAll();
 }
@@ -142,4 +494,30 @@ void MemoryFile::Delete(const std::string& file_name) {
   FileSystem::Instance()->Delete(file_name);
 }
 
+bool MemoryFile::WriteFileAtomically(const std::string& file_name,
+                                     const std::string& contents) {
+  FileSystem::Instance()->WriteAtomically(file_name, contents);
+  return true;
+}
+
+void MemoryFile::SetLimits(const MemoryFileLimits& limits) {
+  FileSystem::Instance()->SetLimits(limits);
+}
+
+uint64_t MemoryFile::GetTotalBytes() {
+  return FileSystem::Instance()->GetTotalBytes();
+}
+
+int MemoryFile::AddListener(const Listener& listener) {
+  return FileSystem::Instance()->AddListener(listener);
+}
+
+void MemoryFile::RemoveListener(int listener_id) {
+  FileSystem::Instance()->RemoveListener(listener_id);
+}
+
+void MemoryFile::SetClockForTesting(base::Clock* clock) {
+  FileSystem::Instance()->SetClock(clock);
+}
+
 }  // namespace shaka
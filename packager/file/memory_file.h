@@ -9,17 +9,54 @@
 
 #include <stdint.h>
 
+#include <functional>
+#include <memory>
 #include <string>
-#include <vector>
 
+#include "packager/base/time/time.h"
 #include "packager/file/file.h"
 
+namespace base {
+class Clock;
+}  // namespace base
+
 namespace shaka {
 
-/// Implements a File that is stored in memory.  This should be only used for
-/// testing, since this does not support larger files.
+class MemoryFileData;
+
+/// Changes to memory files reported to listeners.
+enum class MemoryFileEvent {
+  /// The file is complete: it was closed after being written or it was
+  /// written atomically.
+  kWritten,
+  /// The file was deleted.
+  kDeleted,
+  /// The file was evicted to stay within the MemoryFileLimits.
+  kEvicted,
+};
+
+/// Limits of the memory file store. Files open for writing are never evicted.
+struct MemoryFileLimits {
+  /// Maximum total size of the memory files in bytes. The least recently used
+  /// files are evicted when it is exceeded. 0 means no limit.
+  uint64_t max_total_bytes = 0;
+  /// Files not accessed for longer than this are evicted. 0 means no limit.
+  base::TimeDelta max_idle_time;
+};
+
+/// Implements a File that is stored in memory. The files are kept in a thread
+/// safe store, sharded by file name, so that segments can be served from
+/// memory by another thread while the packager is writing them. Readers get a
+/// reference counted snapshot of the file, which stays valid even if the file
+/// is later written, replaced, deleted or evicted. The files are stored in
+/// chunks shared with the snapshots, so writing a file under a reader only
+/// copies the chunks which are overwritten.
 class MemoryFile : public File {
  public:
+  typedef std::function<void(const std::string& file_name,
+                             MemoryFileEvent event)>
+      Listener;
+
   MemoryFile(const std::string& file_name, const std::string& mode);
 
   /// @name File implementation overrides.
@@ -41,13 +78,39 @@ class MemoryFile : public File {
   /// with that file name will be in an undefined state.
   static void Delete(const std::string& file_name);
 
+  /// Replaces the content of a memory file in a single step, so that readers
+  /// never see a partially written file.
+  /// @return true on success.
+  static bool WriteFileAtomically(const std::string& file_name,
+                                  const std::string& contents);
+
+  /// Sets the limits of the memory file store and evicts files as needed.
+  static void SetLimits(const MemoryFileLimits& limits);
+
+  /// @return the total size of the memory files in bytes.
+  static uint64_t GetTotalBytes();
+
+  /// Registers a listener of memory file changes. The listener is called on
+  /// the thread making the change, without any lock held.
+  /// @return an id to be passed to RemoveListener().
+  static int AddListener(const Listener& listener);
+  static void RemoveListener(int listener_id);
+
+  /// Overrides the clock used to track file access times. Passing nullptr
+  /// restores the default clock. The clock must outlive its use.
+  static void SetClockForTesting(base::Clock* clock);
+
  protected:
   ~MemoryFile() override;
   bool Open() override;
 
  private:
+  // Returns the content of the file opened for reading. It is cached once the
+  // file is no longer being written.
+  std::shared_ptr<const MemoryFileData> GetData();
+
   std::string mode_;
-  std::vector<uint8_t>* file_;
+  std::shared_ptr<const MemoryFileData> complete_data_;
   uint64_t position_;
 
   DISALLOW_COPY_AND_ASSIGN(MemoryFile);
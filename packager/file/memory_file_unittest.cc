@@ -4,7 +4,10 @@
 
 #include "packager/file/memory_file.h"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <memory>
+#include <vector>
+#include "packager/base/time/clock.h"
 #include "packager/file/file.h"
 #include "packager/file/file_closer.h"
 
@@ -14,11 +17,35 @@ namespace {
 const uint8_t kWriteBuffer[] = {1, 2, 3, 4, 5, 6, 7, 8};
 const int64_t kWriteBufferSize = sizeof(kWriteBuffer);
 
+class FakeClock : public base::Clock {
+ public:
+  base::Time Now() override { return now_; }
+  void Advance(base::TimeDelta delta) { now_ += delta; }
+
+ private:
+  base::Time now_;
+};
+
+void WriteMemoryFile(const std::string& file_name) {
+  ASSERT_TRUE(File::WriteStringToFile(
+      file_name.c_str(),
+      std::string(std::begin(kWriteBuffer), std::end(kWriteBuffer))));
+}
+
+bool FileExists(const std::string& file_name) {
+  std::unique_ptr<File, FileCloser> file(File::Open(file_name.c_str(), "r"));
+  return !!file;
+}
+
 }  // namespace
 
 class MemoryFileTest : public testing::Test {
  protected:
-  void TearDown() override { MemoryFile::DeleteAll(); }
+  void TearDown() override {
+    MemoryFile::DeleteAll();
+    MemoryFile::SetLimits(MemoryFileLimits());
+    MemoryFile::SetClockForTesting(nullptr);
+  }
 };
 
 TEST_F(MemoryFileTest, ModifiesSameFile) {
@@ -92,6 +119,42 @@ TEST_F(MemoryFileTest, ExtendsSize) {
   EXPECT_EQ(2 * kWriteBufferSize, static_cast<int64_t>(size));
 }
 
+TEST_F(MemoryFileTest, ReadsFileBeingWritten) {
+  std::unique_ptr<File, FileCloser> writer(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(writer);
+  std::unique_ptr<File, FileCloser> reader(File::Open("memory://file1", "r"));
+  ASSERT_TRUE(reader);
+
+  // Large enough to span several chunks.
+  std::vector<uint8_t> data(3 * 1024 * 1024 + 10);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 7);
+  std::vector<uint8_t> read_data(data.size());
+  const size_t kWriteSize = 100000;
+  for (size_t offset = 0; offset < data.size(); offset += kWriteSize) {
+    const size_t size = std::min(kWriteSize, data.size() - offset);
+    ASSERT_EQ(static_cast<int64_t>(size),
+              writer->Write(data.data() + offset, size));
+    // The reader picks up the new data.
+    ASSERT_EQ(static_cast<int64_t>(size),
+              reader->Read(read_data.data() + offset, data.size()));
+  }
+  EXPECT_EQ(data, read_data);
+
+  // Overwrite data which has been read, across chunk boundaries.
+  const uint64_t kPosition = 4090;
+  ASSERT_TRUE(writer->Seek(kPosition));
+  ASSERT_EQ(kWriteBufferSize, writer->Write(kWriteBuffer, kWriteBufferSize));
+  ASSERT_TRUE(writer.release()->Close());
+  std::copy(std::begin(kWriteBuffer), std::end(kWriteBuffer),
+            data.begin() + kPosition);
+
+  std::string contents;
+  ASSERT_TRUE(File::ReadFileToString("memory://file1", &contents));
+  EXPECT_EQ(std::string(data.begin(), data.end()), contents);
+  EXPECT_EQ(data.size(), MemoryFile::GetTotalBytes());
+}
+
 TEST_F(MemoryFileTest, ReadMissingFileFails) {
   std::unique_ptr<File, FileCloser> file(File::Open("memory://file1", "r"));
   EXPECT_FALSE(file);
@@ -107,4 +170,122 @@ TEST_F(MemoryFileTest, WriteExistingFileDeletes) {
   EXPECT_EQ(0, file2->Size());
 }
 
+TEST_F(MemoryFileTest, ReaderKeepsDataOfDeletedFile) {
+  WriteMemoryFile("memory://file1");
+  std::unique_ptr<File, FileCloser> reader(File::Open("memory://file1", "r"));
+  ASSERT_TRUE(reader);
+  ASSERT_EQ(kWriteBufferSize, reader->Size());
+
+  File::Delete("memory://file1");
+  EXPECT_FALSE(FileExists("memory://file1"));
+
+  uint8_t read_buffer[kWriteBufferSize];
+  ASSERT_EQ(kWriteBufferSize, reader->Read(read_buffer, kWriteBufferSize));
+  EXPECT_EQ(0, memcmp(kWriteBuffer, read_buffer, kWriteBufferSize));
+}
+
+TEST_F(MemoryFileTest, ReaderKeepsDataOfReplacedFile) {
+  WriteMemoryFile("memory://file1");
+  std::unique_ptr<File, FileCloser> reader(File::Open("memory://file1", "r"));
+  ASSERT_TRUE(reader);
+  ASSERT_EQ(kWriteBufferSize, reader->Size());
+
+  ASSERT_TRUE(File::WriteFileAtomically("memory://file1", "replaced"));
+  uint8_t read_buffer[kWriteBufferSize];
+  ASSERT_EQ(kWriteBufferSize, reader->Read(read_buffer, kWriteBufferSize));
+  EXPECT_EQ(0, memcmp(kWriteBuffer, read_buffer, kWriteBufferSize));
+
+  std::string contents;
+  ASSERT_TRUE(File::ReadFileToString("memory://file1", &contents));
+  EXPECT_EQ("replaced", contents);
+}
+
+TEST_F(MemoryFileTest, Listener) {
+  std::vector<std::pair<std::string, MemoryFileEvent>> events;
+  const int listener_id = MemoryFile::AddListener(
+      [&events](const std::string& file_name, MemoryFileEvent event) {
+        events.push_back(std::make_pair(file_name, event));
+      });
+
+  std::unique_ptr<File, FileCloser> writer(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(kWriteBufferSize, writer->Write(kWriteBuffer, kWriteBufferSize));
+  // Not notified until the file is complete.
+  EXPECT_TRUE(events.empty());
+  writer.reset();
+  ASSERT_TRUE(File::WriteFileAtomically("memory://file2", "content"));
+  ASSERT_TRUE(File::Delete("memory://file1"));
+  MemoryFile::RemoveListener(listener_id);
+  ASSERT_TRUE(File::Delete("memory://file2"));
+
+  ASSERT_EQ(3u, events.size());
+  EXPECT_EQ(std::make_pair(std::string("file1"), MemoryFileEvent::kWritten),
+            events[0]);
+  EXPECT_EQ(std::make_pair(std::string("file2"), MemoryFileEvent::kWritten),
+            events[1]);
+  EXPECT_EQ(std::make_pair(std::string("file1"), MemoryFileEvent::kDeleted),
+            events[2]);
+}
+
+TEST_F(MemoryFileTest, EvictsLeastRecentlyUsedFiles) {
+  FakeClock clock;
+  MemoryFile::SetClockForTesting(&clock);
+  MemoryFileLimits limits;
+  limits.max_total_bytes = 3 * kWriteBufferSize;
+  MemoryFile::SetLimits(limits);
+
+  WriteMemoryFile("memory://file1");
+  clock.Advance(base::TimeDelta::FromSeconds(1));
+  WriteMemoryFile("memory://file2");
+  clock.Advance(base::TimeDelta::FromSeconds(1));
+  WriteMemoryFile("memory://file3");
+  clock.Advance(base::TimeDelta::FromSeconds(1));
+  // Opening file1 makes file2 the least recently used file.
+  EXPECT_TRUE(FileExists("memory://file1"));
+  clock.Advance(base::TimeDelta::FromSeconds(1));
+  WriteMemoryFile("memory://file4");
+
+  EXPECT_EQ(static_cast<uint64_t>(3 * kWriteBufferSize),
+            MemoryFile::GetTotalBytes());
+  EXPECT_TRUE(FileExists("memory://file1"));
+  EXPECT_FALSE(FileExists("memory://file2"));
+  EXPECT_TRUE(FileExists("memory://file3"));
+  EXPECT_TRUE(FileExists("memory://file4"));
+}
+
+TEST_F(MemoryFileTest, EvictsIdleFiles) {
+  FakeClock clock;
+  MemoryFile::SetClockForTesting(&clock);
+  MemoryFileLimits limits;
+  limits.max_idle_time = base::TimeDelta::FromSeconds(10);
+  MemoryFile::SetLimits(limits);
+
+  WriteMemoryFile("memory://file1");
+  clock.Advance(base::TimeDelta::FromSeconds(6));
+  WriteMemoryFile("memory://file2");
+  clock.Advance(base::TimeDelta::FromSeconds(6));
+  WriteMemoryFile("memory://file3");
+
+  EXPECT_FALSE(FileExists("memory://file1"));
+  EXPECT_TRUE(FileExists("memory://file2"));
+  EXPECT_TRUE(FileExists("memory://file3"));
+}
+
+TEST_F(MemoryFileTest, DoesNotEvictFilesBeingWritten) {
+  MemoryFileLimits limits;
+  limits.max_total_bytes = kWriteBufferSize;
+  MemoryFile::SetLimits(limits);
+
+  std::unique_ptr<File, FileCloser> writer(File::Open("memory://file1", "w"));
+  ASSERT_TRUE(writer);
+  ASSERT_EQ(kWriteBufferSize, writer->Write(kWriteBuffer, kWriteBufferSize));
+  ASSERT_EQ(kWriteBufferSize, writer->Write(kWriteBuffer, kWriteBufferSize));
+  WriteMemoryFile("memory://file2");
+
+  EXPECT_TRUE(FileExists("memory://file1"));
+  EXPECT_FALSE(FileExists("memory://file2"));
+  EXPECT_EQ(static_cast<uint64_t>(2 * kWriteBufferSize),
+            MemoryFile::GetTotalBytes());
+}
+
 }  // namespace shaka
@@ -7,7 +7,12 @@
 #ifndef PACKAGER_FILE_PUBLIC_BUFFER_CALLBACK_PARAMS_H_
 #define PACKAGER_FILE_PUBLIC_BUFFER_CALLBACK_PARAMS_H_
 
+#include <stdint.h>
+
 #include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace shaka {
 
@@ -28,6 +33,22 @@ struct BufferCallbackParams {
   std::function<
       int64_t(const std::string& name, const void* buffer, uint64_t size)>
       write_func;
+  /// If this function is specified, packager treats the output files as labels
+  /// as with @a write_func, but keeps the content of each output file in
+  /// memory and calls this function once the file is closed, i.e. when a
+  /// segment, a single file output or a manifest is complete. @a write_func
+  /// is not used in that case. The output files support seeking, which is
+  /// required by some single file outputs.
+  /// Packager does not keep any reference to @a buffer after the call, so the
+  /// function can hold on to it without copying.
+  /// The function is called on the thread closing the file, i.e. a packaging
+  /// thread for media files, and a packaging thread or the thread calling
+  /// Packager::Run for manifests. Files are closed by several threads, so
+  /// the function may be called concurrently for different files and should
+  /// be thread safe.
+  std::function<void(const std::string& name,
+                     std::shared_ptr<const std::vector<uint8_t>> buffer)>
+      file_ready_func;
 };
 
 }  // namespace shaka
@@ -23,7 +23,7 @@ ThreadedIoFile::ThreadedIoFile(std::unique_ptr<File, FileCloser> internal_file,
     : File(internal_file->file_name()),
       internal_file_(std::move(internal_file)),
       mode_(mode),
-      cache_(io_cache_size),
+      cache_(io_cache_size, mode == kOutputMode),
       io_buffer_(io_block_size),
       position_(0),
       size_(0),
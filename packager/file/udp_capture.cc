@@ -0,0 +1,317 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/udp_capture.h"
+
+#include <string.h>
+
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/time/time.h"
+#include "packager/file/udp_options.h"
+
+namespace shaka {
+
+namespace {
+
+const uint8_t kMagic[] = {'U', 'D', 'P', 'C'};
+const uint32_t kVersion = 1;
+const size_t kHeaderSize = sizeof(kMagic) + sizeof(uint32_t);
+const size_t kRecordHeaderSize = sizeof(int64_t) + sizeof(uint32_t);
+// Large enough for any UDP datagram.
+const size_t kMaxDatagramSize = 65535;
+const char kUdpPrefix[] = "udp://";
+
+void AppendUInt32(uint32_t value, std::vector<uint8_t>* buffer) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    buffer->push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void AppendInt64(int64_t value, std::vector<uint8_t>* buffer) {
+  const uint64_t unsigned_value = static_cast<uint64_t>(value);
+  for (int shift = 56; shift >= 0; shift -= 8)
+    buffer->push_back(static_cast<uint8_t>(unsigned_value >> shift));
+}
+
+uint64_t ReadBigEndian(const uint8_t* data, size_t size) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < size; ++i)
+    value = (value << 8) | data[i];
+  return value;
+}
+
+bool WriteFully(File* file, const std::vector<uint8_t>& buffer) {
+  size_t offset = 0;
+  while (offset < buffer.size()) {
+    const int64_t result =
+        file->Write(buffer.data() + offset, buffer.size() - offset);
+    if (result <= 0)
+      return false;
+    offset += result;
+  }
+  return true;
+}
+
+// Returns the number of bytes read, which is less than |size| only at the end
+// of the file, or -1 on error.
+int64_t ReadFully(File* file, uint8_t* buffer, size_t size) {
+  size_t offset = 0;
+  while (offset < size) {
+    const int64_t result = file->Read(buffer + offset, size - offset);
+    if (result < 0)
+      return -1;
+    if (result == 0)
+      break;
+    offset += result;
+  }
+  return offset;
+}
+
+}  // namespace
+
+UdpCaptureWriter::UdpCaptureWriter() {}
+
+UdpCaptureWriter::~UdpCaptureWriter() {}
+
+bool UdpCaptureWriter::Open(const std::string& file_name) {
+  DCHECK(!file_);
+  file_.reset(File::Open(file_name.c_str(), "w"));
+  if (!file_) {
+    LOG(ERROR) << "Failed to open capture file " << file_name;
+    return false;
+  }
+  std::vector<uint8_t> header(kMagic, kMagic + sizeof(kMagic));
+  AppendUInt32(kVersion, &header);
+  return WriteFully(file_.get(), header);
+}
+
+bool UdpCaptureWriter::AddDatagram(int64_t arrival_time,
+                                   const uint8_t* data,
+                                   size_t size) {
+  DCHECK(file_);
+  DCHECK_LE(size, kMaxDatagramSize);
+  std::vector<uint8_t> record;
+  record.reserve(kRecordHeaderSize + size);
+  AppendInt64(arrival_time, &record);
+  AppendUInt32(static_cast<uint32_t>(size), &record);
+  record.insert(record.end(), data, data + size);
+  return WriteFully(file_.get(), record);
+}
+
+bool UdpCaptureWriter::Close() {
+  if (!file_)
+    return true;
+  return file_.release()->Close();
+}
+
+UdpCaptureReader::UdpCaptureReader() {}
+
+UdpCaptureReader::~UdpCaptureReader() {}
+
+bool UdpCaptureReader::Open(const std::string& file_name) {
+  DCHECK(!file_);
+  file_.reset(File::Open(file_name.c_str(), "r"));
+  if (!file_) {
+    LOG(ERROR) << "Failed to open capture file " << file_name;
+    return false;
+  }
+  uint8_t header[kHeaderSize];
+  if (ReadFully(file_.get(), header, sizeof(header)) !=
+          static_cast<int64_t>(sizeof(header)) ||
+      memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+    LOG(ERROR) << file_name << " is not a UDP capture file.";
+    return false;
+  }
+  const uint32_t version = static_cast<uint32_t>(
+      ReadBigEndian(header + sizeof(kMagic), sizeof(uint32_t)));
+  if (version != kVersion) {
+    LOG(ERROR) << "Unsupported UDP capture file version " << version;
+    return false;
+  }
+  return true;
+}
+
+bool UdpCaptureReader::ReadDatagram(int64_t* arrival_time,
+                                    std::vector<uint8_t>* data) {
+  DCHECK(file_);
+  DCHECK(arrival_time);
+  DCHECK(data);
+  if (eof_)
+    return false;
+
+  uint8_t record_header[kRecordHeaderSize];
+  const int64_t result =
+      ReadFully(file_.get(), record_header, sizeof(record_header));
+  if (result == 0) {
+    eof_ = true;
+    return false;
+  }
+  if (result != static_cast<int64_t>(sizeof(record_header))) {
+    LOG(ERROR) << "Truncated UDP capture record.";
+    return false;
+  }
+  *arrival_time = static_cast<int64_t>(
+      ReadBigEndian(record_header, sizeof(int64_t)));
+  const size_t size = static_cast<size_t>(
+      ReadBigEndian(record_header + sizeof(int64_t), sizeof(uint32_t)));
+  if (size > kMaxDatagramSize) {
+    LOG(ERROR) << "Invalid UDP capture datagram size " << size;
+    return false;
+  }
+  data->resize(size);
+  if (ReadFully(file_.get(), data->data(), size) !=
+      static_cast<int64_t>(size)) {
+    LOG(ERROR) << "Truncated UDP capture datagram.";
+    return false;
+  }
+  return true;
+}
+
+int64_t CaptureUdp(const std::string& udp_url,
+                   const std::string& capture_file,
+                   int64_t duration) {
+  // The duration is only checked when a datagram arrives, so a receive
+  // timeout is needed for the capture to stop if the stream goes quiet.
+  if (duration > 0) {
+    if (!base::StartsWith(udp_url, kUdpPrefix, base::CompareCase::SENSITIVE)) {
+      LOG(ERROR) << "Invalid UDP url " << udp_url;
+      return -1;
+    }
+    std::unique_ptr<UdpOptions> options =
+        UdpOptions::ParseFromString(udp_url.substr(strlen(kUdpPrefix)));
+    if (!options)
+      return -1;
+    if (options->timeout_us() == 0) {
+      LOG(ERROR) << "A capture duration requires a timeout option in "
+                 << udp_url;
+      return -1;
+    }
+  }
+
+  std::unique_ptr<File, FileCloser> udp_file(
+      File::OpenWithNoBuffering(udp_url.c_str(), "r"));
+  if (!udp_file) {
+    LOG(ERROR) << "Failed to open " << udp_url;
+    return -1;
+  }
+  UdpCaptureWriter writer;
+  if (!writer.Open(capture_file))
+    return -1;
+
+  std::vector<uint8_t> buffer(kMaxDatagramSize);
+  int64_t num_datagrams = 0;
+  base::TimeTicks start_time;
+  while (true) {
+    const int64_t size = udp_file->Read(buffer.data(), buffer.size());
+    if (size < 0) {
+      // The receive timed out, or the socket failed.
+      break;
+    }
+    const base::TimeTicks now = base::TimeTicks::Now();
+    // The capture starts with the first datagram.
+    if (num_datagrams == 0)
+      start_time = now;
+    const int64_t arrival_time = (now - start_time).InMicroseconds();
+    if (duration > 0 && arrival_time > duration)
+      break;
+    if (!writer.AddDatagram(arrival_time, buffer.data(), size)) {
+      LOG(ERROR) << "Failed to write to capture file " << capture_file;
+      return -1;
+    }
+    ++num_datagrams;
+  }
+  if (!writer.Close()) {
+    LOG(ERROR) << "Failed to close capture file " << capture_file;
+    return -1;
+  }
+  return num_datagrams;
+}
+
+UdpReplayer::UdpReplayer(const std::string& capture_file,
+                         const std::string& destination,
+                         double speed)
+    : capture_file_(capture_file),
+      destination_(destination),
+      speed_(speed),
+      cancelled_(base::WaitableEvent::ResetPolicy::MANUAL,
+                 base::WaitableEvent::InitialState::NOT_SIGNALED) {
+  DCHECK_GE(speed, 0);
+}
+
+UdpReplayer::~UdpReplayer() {
+  if (thread_ && thread_->HasBeenStarted() && !thread_->HasBeenJoined()) {
+    Cancel();
+    thread_->Join();
+  }
+}
+
+bool UdpReplayer::Replay() {
+  UdpCaptureReader reader;
+  if (!reader.Open(capture_file_))
+    return false;
+  std::unique_ptr<File, FileCloser> udp_file(
+      File::OpenWithNoBuffering(destination_.c_str(), "w"));
+  if (!udp_file) {
+    LOG(ERROR) << "Failed to open " << destination_;
+    return false;
+  }
+
+  int64_t arrival_time = 0;
+  std::vector<uint8_t> data;
+  int64_t first_arrival_time = 0;
+  base::TimeTicks start_time;
+  while (reader.ReadDatagram(&arrival_time, &data)) {
+    if (num_datagrams_sent_ == 0) {
+      first_arrival_time = arrival_time;
+      start_time = base::TimeTicks::Now();
+    }
+    if (speed_ > 0) {
+      const base::TimeTicks send_time =
+          start_time + base::TimeDelta::FromMicroseconds(static_cast<int64_t>(
+                           (arrival_time - first_arrival_time) / speed_));
+      const base::TimeDelta delay = send_time - base::TimeTicks::Now();
+      if (delay > base::TimeDelta() && cancelled_.TimedWait(delay))
+        return true;
+    }
+    if (cancelled_.IsSignaled())
+      return true;
+
+    if (udp_file->Write(data.data(), data.size()) !=
+        static_cast<int64_t>(data.size())) {
+      LOG(ERROR) << "Failed to send datagram to " << destination_;
+      return false;
+    }
+    ++num_datagrams_sent_;
+    num_bytes_sent_ += data.size();
+  }
+  if (!reader.eof()) {
+    LOG(ERROR) << "Failed to read capture file " << capture_file_;
+    return false;
+  }
+  return true;
+}
+
+void UdpReplayer::Start() {
+  DCHECK(!thread_);
+  thread_.reset(new base::DelegateSimpleThread(this, "UdpReplayer"));
+  thread_->Start();
+}
+
+bool UdpReplayer::Join() {
+  DCHECK(thread_);
+  thread_->Join();
+  return result_;
+}
+
+void UdpReplayer::Cancel() {
+  cancelled_.Signal();
+}
+
+void UdpReplayer::Run() {
+  result_ = Replay();
+}
+
+}  // namespace shaka
@@ -0,0 +1,147 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_UDP_CAPTURE_H_
+#define PACKAGER_FILE_UDP_CAPTURE_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/simple_thread.h"
+#include "packager/file/file.h"
+#include "packager/file/file_closer.h"
+
+namespace shaka {
+
+/// Writes UDP datagrams and their arrival times to a capture file.
+///
+/// A capture file starts with a header made of the 4 byte magic "UDPC" and
+/// a 32 bit version, followed by one record per datagram made of the 64 bit
+/// arrival time in microseconds relative to the start of the capture, the
+/// 32 bit payload size and the payload. Integers are stored in big endian.
+class UdpCaptureWriter {
+ public:
+  UdpCaptureWriter();
+  ~UdpCaptureWriter();
+
+  /// Create the capture file and write its header.
+  /// @return true on success, false otherwise.
+  bool Open(const std::string& file_name);
+
+  /// Append a datagram to the capture file.
+  /// @param arrival_time is the arrival time of the datagram in microseconds
+  ///        relative to the start of the capture. It should not decrease.
+  /// @return true on success, false otherwise.
+  bool AddDatagram(int64_t arrival_time, const uint8_t* data, size_t size);
+
+  /// Close the capture file.
+  /// @return true on success, false otherwise.
+  bool Close();
+
+ private:
+  std::unique_ptr<File, FileCloser> file_;
+
+  DISALLOW_COPY_AND_ASSIGN(UdpCaptureWriter);
+};
+
+/// Reads the datagrams of a capture file written by UdpCaptureWriter.
+class UdpCaptureReader {
+ public:
+  UdpCaptureReader();
+  ~UdpCaptureReader();
+
+  /// Open the capture file and check its header.
+  /// @return true on success, false otherwise.
+  bool Open(const std::string& file_name);
+
+  /// Read the next datagram.
+  /// @param arrival_time receives the arrival time of the datagram in
+  ///        microseconds relative to the start of the capture.
+  /// @param data receives the payload of the datagram.
+  /// @return true on success, false on end of file or error, which can be
+  ///         told apart with eof().
+  bool ReadDatagram(int64_t* arrival_time, std::vector<uint8_t>* data);
+
+  /// @return true if all the datagrams have been read.
+  bool eof() const { return eof_; }
+
+ private:
+  std::unique_ptr<File, FileCloser> file_;
+  bool eof_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(UdpCaptureReader);
+};
+
+/// Capture the datagrams received from a UDP stream to a capture file. Stops
+/// when @a duration has elapsed, or when no datagram is received for the
+/// timeout set in @a udp_url, if any.
+/// @param udp_url is the stream to receive, i.e. udp://ip:port[?options].
+/// @param capture_file is the file to write the datagrams to.
+/// @param duration is the duration of the capture in microseconds. 0 means
+///        unlimited. A non zero duration requires a timeout option in
+///        @a udp_url, so that the capture stops if the stream goes quiet.
+/// @return the number of datagrams captured, or -1 on error.
+int64_t CaptureUdp(const std::string& udp_url,
+                   const std::string& capture_file,
+                   int64_t duration);
+
+/// Replays a capture file to a UDP destination, reproducing the pacing of the
+/// captured datagrams. Multiple replayers can run simultaneously on their own
+/// threads to replay several channels.
+class UdpReplayer : public base::DelegateSimpleThread::Delegate {
+ public:
+  /// @param capture_file is the capture file to replay.
+  /// @param destination is the destination of the datagrams, i.e.
+  ///        udp://ip:port[?interface=ip].
+  /// @param speed is the replay speed relative to the capture: 1 replays in
+  ///        real time, 2 twice as fast, etc. 0 replays as fast as possible.
+  UdpReplayer(const std::string& capture_file,
+              const std::string& destination,
+              double speed);
+  ~UdpReplayer() override;
+
+  /// Replay the capture file on the calling thread.
+  /// @return true on success, including if cancelled, false otherwise.
+  bool Replay();
+
+  /// Replay the capture file on a new thread.
+  void Start();
+  /// Wait for the replay started with Start() to finish.
+  /// @return the result of the replay.
+  bool Join();
+
+  /// Stop the replay as soon as possible. Can be called from any thread.
+  void Cancel();
+
+  /// @return the number of datagrams sent.
+  int64_t num_datagrams_sent() const { return num_datagrams_sent_; }
+  /// @return the number of payload bytes sent.
+  int64_t num_bytes_sent() const { return num_bytes_sent_; }
+
+ private:
+  // base::DelegateSimpleThread::Delegate implementation.
+  void Run() override;
+
+  const std::string capture_file_;
+  const std::string destination_;
+  const double speed_;
+  base::WaitableEvent cancelled_;
+  std::unique_ptr<base::DelegateSimpleThread> thread_;
+  bool result_ = false;
+  int64_t num_datagrams_sent_ = 0;
+  int64_t num_bytes_sent_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(UdpReplayer);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_UDP_CAPTURE_H_
@@ -0,0 +1,130 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/udp_capture.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/time/time.h"
+#include "packager/file/memory_file.h"
+#include "packager/file/udp_file.h"
+
+namespace shaka {
+namespace {
+
+const char kCaptureFile[] = "memory://capture.udpc";
+// Port 0 lets the system pick a free port.
+const char kLoopbackReceiveAddress[] = "udp://127.0.0.1:0?timeout=1000000";
+const uint8_t kDatagram1[] = {0x47, 1, 2, 3};
+const uint8_t kDatagram2[] = {0x47, 4, 5, 6, 7, 8};
+const int64_t kArrivalTime2 = 200000;
+
+}  // namespace
+
+class UdpCaptureTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    UdpCaptureWriter writer;
+    ASSERT_TRUE(writer.Open(kCaptureFile));
+    ASSERT_TRUE(writer.AddDatagram(0, kDatagram1, sizeof(kDatagram1)));
+    ASSERT_TRUE(
+        writer.AddDatagram(kArrivalTime2, kDatagram2, sizeof(kDatagram2)));
+    ASSERT_TRUE(writer.Close());
+
+    receiver_.reset(File::OpenWithNoBuffering(kLoopbackReceiveAddress, "r"));
+    ASSERT_TRUE(receiver_);
+    const uint16_t port =
+        static_cast<UdpFile*>(receiver_.get())->GetLocalPort();
+    ASSERT_NE(0u, port);
+    loopback_address_ = base::StringPrintf("udp://127.0.0.1:%u", port);
+  }
+
+  void TearDown() override { MemoryFile::DeleteAll(); }
+
+  std::unique_ptr<File, FileCloser> receiver_;
+  // The address |receiver_| receives on.
+  std::string loopback_address_;
+};
+
+TEST_F(UdpCaptureTest, ReadDatagrams) {
+  UdpCaptureReader reader;
+  ASSERT_TRUE(reader.Open(kCaptureFile));
+
+  int64_t arrival_time = -1;
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(reader.ReadDatagram(&arrival_time, &data));
+  EXPECT_EQ(0, arrival_time);
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kDatagram1), std::end(kDatagram1)),
+            data);
+  ASSERT_TRUE(reader.ReadDatagram(&arrival_time, &data));
+  EXPECT_EQ(kArrivalTime2, arrival_time);
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kDatagram2), std::end(kDatagram2)),
+            data);
+  EXPECT_FALSE(reader.ReadDatagram(&arrival_time, &data));
+  EXPECT_TRUE(reader.eof());
+}
+
+TEST_F(UdpCaptureTest, InvalidCaptureFile) {
+  const char kInvalidFile[] = "memory://invalid.udpc";
+  ASSERT_TRUE(File::WriteStringToFile(kInvalidFile, "not a capture"));
+  UdpCaptureReader reader;
+  EXPECT_FALSE(reader.Open(kInvalidFile));
+}
+
+TEST_F(UdpCaptureTest, TruncatedCaptureFile) {
+  std::string contents;
+  ASSERT_TRUE(File::ReadFileToString(kCaptureFile, &contents));
+  const char kTruncatedFile[] = "memory://truncated.udpc";
+  ASSERT_TRUE(File::WriteStringToFile(
+      kTruncatedFile, contents.substr(0, contents.size() - 1)));
+
+  UdpCaptureReader reader;
+  ASSERT_TRUE(reader.Open(kTruncatedFile));
+  int64_t arrival_time = -1;
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(reader.ReadDatagram(&arrival_time, &data));
+  EXPECT_FALSE(reader.ReadDatagram(&arrival_time, &data));
+  EXPECT_FALSE(reader.eof());
+}
+
+TEST_F(UdpCaptureTest, ReplayOverLoopback) {
+  // Replay at twice the captured pace.
+  UdpReplayer replayer(kCaptureFile, loopback_address_, 2);
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+  ASSERT_TRUE(replayer.Replay());
+  EXPECT_GE((base::TimeTicks::Now() - start_time).InMicroseconds(),
+            kArrivalTime2 / 2);
+  EXPECT_EQ(2, replayer.num_datagrams_sent());
+  EXPECT_EQ(static_cast<int64_t>(sizeof(kDatagram1) + sizeof(kDatagram2)),
+            replayer.num_bytes_sent());
+
+  std::vector<uint8_t> buffer(65535);
+  ASSERT_EQ(static_cast<int64_t>(sizeof(kDatagram1)),
+            receiver_->Read(buffer.data(), buffer.size()));
+  EXPECT_EQ(0, memcmp(kDatagram1, buffer.data(), sizeof(kDatagram1)));
+  ASSERT_EQ(static_cast<int64_t>(sizeof(kDatagram2)),
+            receiver_->Read(buffer.data(), buffer.size()));
+  EXPECT_EQ(0, memcmp(kDatagram2, buffer.data(), sizeof(kDatagram2)));
+}
+
+TEST_F(UdpCaptureTest, CancelReplay) {
+  // At this speed the second datagram would only be sent after 200 seconds.
+  UdpReplayer replayer(kCaptureFile, loopback_address_, 0.001);
+  replayer.Start();
+  replayer.Cancel();
+  EXPECT_TRUE(replayer.Join());
+  EXPECT_LE(replayer.num_datagrams_sent(), 1);
+}
+
+TEST_F(UdpCaptureTest, CaptureDurationRequiresTimeout) {
+  const char kCaptureOutput[] = "memory://output.udpc";
+  const int64_t kDuration = 1000000;
+  EXPECT_EQ(-1, CaptureUdp("udp://127.0.0.1:0", kCaptureOutput, kDuration));
+}
+
+}  // namespace shaka
@@ -44,8 +44,8 @@ bool IsIpv4MulticastAddress(const struct in_addr& addr) {
 
 }  // anonymous namespace
 
-UdpFile::UdpFile(const char* file_name)
-    : File(file_name), socket_(INVALID_SOCKET) {}
+UdpFile::UdpFile(const char* file_name, const char* mode)
+    : File(file_name), mode_(mode), socket_(INVALID_SOCKET) {}
 
 UdpFile::~UdpFile() {}
 
@@ -63,7 +63,7 @@ int64_t UdpFile::Read(void* buffer, uint64_t length) {
   DCHECK_GE(length, 65535u)
       << "Buffer may be too small to read entire datagram.";
 
-  if (socket_ == INVALID_SOCKET)
+  if (socket_ == INVALID_SOCKET || mode_ != "r")
     return -1;
 
   int64_t result;
@@ -76,8 +76,18 @@ int64_t UdpFile::Read(void* buffer, uint64_t length) {
 }
 
 int64_t UdpFile::Write(const void* buffer, uint64_t length) {
-  NOTIMPLEMENTED();
-  return -1;
+  DCHECK(buffer);
+  DCHECK_LE(length, 65507u) << "Datagram too large.";
+
+  if (socket_ == INVALID_SOCKET || mode_ != "w")
+    return -1;
+
+  int64_t result;
+  do {
+    result = send(socket_, reinterpret_cast<const char*>(buffer), length, 0);
+  } while ((result == -1) && (errno == EINTR));
+
+  return result;
 }
 
 int64_t UdpFile::Size() {
@@ -88,6 +98,9 @@ int64_t UdpFile::Size() {
 }
 
 bool UdpFile::Flush() {
+  // Datagrams are sent as soon as they are written.
+  if (mode_ == "w")
+    return socket_ != INVALID_SOCKET;
   NOTIMPLEMENTED();
   return false;
 }
@@ -102,6 +115,21 @@ bool UdpFile::Tell(uint64_t* position) {
   return false;
 }
 
+uint16_t UdpFile::GetLocalPort() {
+  if (socket_ == INVALID_SOCKET)
+    return 0;
+
+  struct sockaddr_in local_sock_addr = {0};
+  socklen_t addr_size = sizeof(local_sock_addr);
+  if (getsockname(socket_,
+                  reinterpret_cast<struct sockaddr*>(&local_sock_addr),
+                  &addr_size)) {
+    LOG(ERROR) << "Could not get the local address of the UDP socket";
+    return 0;
+  }
+  return ntohs(local_sock_addr.sin_port);
+}
+
 #if defined(OS_WIN)
 class LibWinsockInitializer {
  public:
@@ -157,6 +185,9 @@ bool UdpFile::Open() {
 
   DCHECK_EQ(INVALID_SOCKET, socket_);
 
+  if (mode_ == "w")
+    return OpenForSending();
+
   std::unique_ptr<UdpOptions> options =
       UdpOptions::ParseFromString(file_name());
   if (!options)
@@ -251,4 +282,57 @@ bool UdpFile::Open() {
   return true;
 }
 
+bool UdpFile::OpenForSending() {
+  std::unique_ptr<UdpOptions> options =
+      UdpOptions::ParseFromString(file_name());
+  if (!options)
+    return false;
+
+  ScopedSocket new_socket(socket(AF_INET, SOCK_DGRAM, 0));
+  if (new_socket.get() == INVALID_SOCKET) {
+    LOG(ERROR) << "Could not allocate socket.";
+    return false;
+  }
+
+  struct in_addr remote_in_addr = {0};
+  if (inet_pton(AF_INET, options->address().c_str(), &remote_in_addr) != 1) {
+    LOG(ERROR) << "Malformed IPv4 address " << options->address();
+    return false;
+  }
+
+  if (IsIpv4MulticastAddress(remote_in_addr)) {
+    struct in_addr interface_in_addr = {0};
+    if (inet_pton(AF_INET, options->interface_address().c_str(),
+                  &interface_in_addr) != 1) {
+      LOG(ERROR) << "Malformed IPv4 interface address "
+                 << options->interface_address();
+      return false;
+    }
+    // Send over the requested interface. Multicast loopback is enabled by
+    // default, so local receivers get the datagrams too.
+    if (interface_in_addr.s_addr != htonl(INADDR_ANY) &&
+        setsockopt(new_socket.get(), IPPROTO_IP, IP_MULTICAST_IF,
+                   reinterpret_cast<const char*>(&interface_in_addr),
+                   sizeof(interface_in_addr)) < 0) {
+      LOG(ERROR) << "Failed to set multicast interface.";
+      return false;
+    }
+  }
+
+  struct sockaddr_in remote_sock_addr = {0};
+  remote_sock_addr.sin_family = AF_INET;
+  remote_sock_addr.sin_port = htons(options->port());
+  remote_sock_addr.sin_addr = remote_in_addr;
+  if (connect(new_socket.get(),
+              reinterpret_cast<struct sockaddr*>(&remote_sock_addr),
+              sizeof(remote_sock_addr))) {
+    LOG(ERROR) << "Could not connect UDP socket to " << options->address()
+               << ":" << options->port();
+    return false;
+  }
+
+  socket_ = new_socket.release();
+  return true;
+}
+
 }  // namespace shaka
@@ -22,12 +22,15 @@ typedef int SOCKET;
 
 namespace shaka {
 
-/// Implements UdpFile, which receives UDP unicast and multicast streams.
+/// Implements UdpFile, which receives UDP unicast and multicast streams, or
+/// sends datagrams to a UDP destination in write mode.
 class UdpFile : public File {
  public:
-  /// @param file_name C string containing the address of the stream to receive.
-  ///        It should be of the form "<ip_address>:<port>".
-  explicit UdpFile(const char* address_and_port);
+  /// @param file_name C string containing the address of the stream to receive
+  ///        or send to. It should be of the form "<ip_address>:<port>".
+  /// @param mode C string containing the open mode: "r" to receive and "w" to
+  ///        send. In send mode each Write() sends a single datagram.
+  UdpFile(const char* address_and_port, const char* mode);
 
   /// @name File implementation overrides.
   /// @{
@@ -40,12 +43,19 @@ class UdpFile : public File {
   bool Tell(uint64_t* position) override;
   /// @}
 
+  /// @return the local port the socket is bound to, e.g. the port picked by
+  ///         the system when receiving on port 0, or 0 on error.
+  uint16_t GetLocalPort();
+
  protected:
   ~UdpFile() override;
 
   bool Open() override;
 
  private:
+  bool OpenForSending();
+
+  std::string mode_;
   SOCKET socket_;
 
   DISALLOW_COPY_AND_ASSIGN(UdpFile);
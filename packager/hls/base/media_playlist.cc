@@ -10,8 +10,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <memory>
+#include <vector>
 
+#include "packager/base/files/file_path.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/stringprintf.h"
@@ -63,7 +66,9 @@ std::string CreatePlaylistHeader(const MediaInfo& media_info,
                                  uint32_t target_duration,
                                  HlsPlaylistType type,
                                  int media_sequence_number,
-                                 int discontinuity_sequence_number) {
+                                 int discontinuity_sequence_number,
+                                 double can_skip_until,
+                                 bool is_delta_update) {
   const std::string version = GetPackagerVersion();
   std::string version_line;
   if (!version.empty()) {
@@ -72,13 +77,14 @@ std::string CreatePlaylistHeader(const MediaInfo& media_info,
                            GetPackagerProjectUrl().c_str(), version.c_str());
   }
 
-  // 6 is required for EXT-X-MAP without EXT-X-I-FRAMES-ONLY.
+  // 6 is required for EXT-X-MAP without EXT-X-I-FRAMES-ONLY. 9 is required
+  // for EXT-X-SKIP.
   std::string header = base::StringPrintf(
       "#EXTM3U\n"
-      "#EXT-X-VERSION:6\n"
+      "#EXT-X-VERSION:%d\n"
       "%s"
       "#EXT-X-TARGETDURATION:%d\n",
-      version_line.c_str(), target_duration);
+      is_delta_update ? 9 : 6, version_line.c_str(), target_duration);
 
   switch (type) {
     case HlsPlaylistType::kVod:
@@ -100,6 +106,10 @@ std::string CreatePlaylistHeader(const MediaInfo& media_info,
     default:
       NOTREACHED() << "Unexpected MediaPlaylistType " << static_cast<int>(type);
   }
+  if (can_skip_until > 0) {
+    base::StringAppendF(&header, "#EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL=%.3f\n",
+                        can_skip_until);
+  }
 
   // Put EXT-X-MAP at the end since the rest of the playlist is about the
   // segment and key info.
@@ -279,11 +289,16 @@ HlsEntry::~HlsEntry() {}
 
 MediaPlaylist::MediaPlaylist(HlsPlaylistType playlist_type,
                              double time_shift_buffer_depth,
+                             double can_skip_until,
                              const std::string& file_name,
                              const std::string& name,
                              const std::string& group_id)
     : playlist_type_(playlist_type),
       time_shift_buffer_depth_(time_shift_buffer_depth),
+      // Playlist Delta Updates do not apply to VOD playlists, which do not
+      // get reloaded.
+      can_skip_until_(playlist_type == HlsPlaylistType::kVod ? 0
+                                                             : can_skip_until),
       file_name_(file_name),
       name_(name),
       group_id_(group_id) {}
@@ -309,6 +324,9 @@ bool MediaPlaylist::SetMediaInfo(const MediaInfo& media_info) {
   if (media_info.has_video_info()) {
     stream_type_ = MediaPlaylistStreamType::kPlayListVideo;
     codec_ = media_info.video_info().codec();
+    // Audio multiplexed with the video, e.g. in a transport stream.
+    if (media_info.has_audio_info())
+      codec_ += "," + media_info.audio_info().codec();
   } else if (media_info.has_audio_info()) {
     stream_type_ = MediaPlaylistStreamType::kPlayListAudio;
     codec_ = media_info.audio_info().codec();
@@ -334,6 +352,7 @@ void MediaPlaylist::AddSegment(const std::string& file_name,
     entries_.emplace_back(new SegmentInfoEntry(
         file_name, 0.0, 0.0, !media_info_.has_segment_template(),
         start_byte_offset, size, previous_segment_end_offset_));
+    ++num_segments_;
     return;
   }
 
@@ -351,6 +370,7 @@ void MediaPlaylist::AddSegment(const std::string& file_name,
       file_name, start_time_seconds, segment_duration_seconds,
       !media_info_.has_segment_template(), start_byte_offset, size,
       previous_segment_end_offset_));
+  ++num_segments_;
   previous_segment_end_offset_ = start_byte_offset + size - 1;
   SlideWindow();
 }
@@ -377,9 +397,10 @@ bool MediaPlaylist::WriteToFile(const std::string& file_path) {
     SetTargetDuration(ceil(GetLongestSegmentDuration()));
   }
 
+  const bool kIsDeltaUpdate = true;
   std::string header = CreatePlaylistHeader(
       media_info_, target_duration_, playlist_type_, media_sequence_number_,
-      discontinuity_sequence_number_);
+      discontinuity_sequence_number_, can_skip_until_, !kIsDeltaUpdate);
 
   std::string body;
   for (const auto& entry : entries_)
@@ -395,9 +416,32 @@ bool MediaPlaylist::WriteToFile(const std::string& file_path) {
     LOG(ERROR) << "Failed to write playlist to: " << file_path;
     return false;
   }
+
+  if (can_skip_until_ <= 0)
+    return true;
+  const std::string delta_update_file_path = GetDeltaUpdateFilePath(file_path);
+  const std::string delta_update =
+      CreatePlaylistHeader(media_info_, target_duration_, playlist_type_,
+                           media_sequence_number_,
+                           discontinuity_sequence_number_, can_skip_until_,
+                           kIsDeltaUpdate) +
+      CreateDeltaUpdateBody();
+  if (!File::WriteFileAtomically(delta_update_file_path.c_str(),
+                                 delta_update)) {
+    LOG(ERROR) << "Failed to write playlist delta update to: "
+               << delta_update_file_path;
+    return false;
+  }
   return true;
 }
 
+std::string MediaPlaylist::GetDeltaUpdateFilePath(
+    const std::string& file_path) {
+  return base::FilePath::FromUTF8Unsafe(file_path)
+      .InsertBeforeExtensionASCII("_delta")
+      .AsUTF8Unsafe();
+}
+
 uint64_t MediaPlaylist::Bitrate() const {
   if (media_info_.has_bandwidth())
     return media_info_.bandwidth();
@@ -511,6 +555,54 @@ void MediaPlaylist::SlideWindow() {
   entries_.insert(entries_.begin(), std::make_move_iterator(ext_x_keys.begin()),
                   std::make_move_iterator(ext_x_keys.end()));
   media_sequence_number_ += num_segments_removed;
+  num_segments_ -= num_segments_removed;
+}
+
+std::string MediaPlaylist::CreateDeltaUpdateBody() {
+  // Walk back from the end of the playlist to the first entry that is kept,
+  // which is the entry after the last skipped segment.
+  auto first_kept = entries_.end();
+  size_t num_segments_kept = 0;
+  double duration_to_end = 0.0;
+  while (first_kept != entries_.begin()) {
+    auto previous = std::prev(first_kept);
+    if (previous->get()->type() == HlsEntry::EntryType::kExtInf) {
+      const SegmentInfoEntry* segment_info =
+          static_cast<SegmentInfoEntry*>(previous->get());
+      duration_to_end += segment_info->duration();
+      if (duration_to_end >= can_skip_until_)
+        break;
+      ++num_segments_kept;
+    }
+    first_kept = previous;
+  }
+
+  std::string body;
+  const size_t num_segments_skipped = num_segments_ - num_segments_kept;
+  if (num_segments_skipped > 0) {
+    body = "#EXT-X-SKIP:SKIPPED-SEGMENTS=" +
+           base::SizeTToString(num_segments_skipped) + "\n";
+
+    // Repeat the EXT-X-KEYs in effect for the remaining segments, unless new
+    // ones follow right away. Consecutive key entries are in effect together.
+    std::vector<HlsEntry*> ext_x_keys;
+    if (first_kept == entries_.end() ||
+        first_kept->get()->type() != HlsEntry::EntryType::kExtKey) {
+      for (auto iter = first_kept; iter != entries_.begin();) {
+        --iter;
+        if (iter->get()->type() == HlsEntry::EntryType::kExtKey)
+          ext_x_keys.push_back(iter->get());
+        else if (!ext_x_keys.empty())
+          break;
+      }
+    }
+    for (auto iter = ext_x_keys.rbegin(); iter != ext_x_keys.rend(); ++iter)
+      body.append((*iter)->ToString());
+  }
+
+  for (auto iter = first_kept; iter != entries_.end(); ++iter)
+    body.append(iter->get()->ToString());
+  return body;
 }
 
 }  // namespace hls
@@ -59,6 +59,9 @@ class MediaPlaylist {
   /// @param playlist_type is the type of this media playlist.
   /// @param time_shift_buffer_depth determines the duration of the time
   ///        shifting buffer, only for live HLS.
+  /// @param can_skip_until is the EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL value in
+  ///        seconds. If positive, WriteToFile() also writes a Playlist Delta
+  ///        Update for EVENT and LIVE playlists.
   /// @param file_name is the file name of this media playlist.
   /// @param name is the name of this playlist. In other words this is the
   ///        value of the NAME attribute for EXT-X-MEDIA. This is not
@@ -67,6 +70,7 @@ class MediaPlaylist {
   ///        GROUP-ID attribute for EXT-X-MEDIA.
   MediaPlaylist(HlsPlaylistType playlist_type,
                 double time_shift_buffer_depth,
+                double can_skip_until,
                 const std::string& file_name,
                 const std::string& name,
                 const std::string& group_id);
@@ -128,11 +132,18 @@ class MediaPlaylist {
   /// without explicitly setting the target duration and before adding any
   /// segments will end up setting the target duration to 0 and will always
   /// generate an invalid playlist.
+  /// If Playlist Delta Updates are enabled, the delta update is written to
+  /// |file_path| with "_delta" inserted before the extension, see
+  /// GetDeltaUpdateFilePath().
   /// @param file_path is the output file path accepted by the File
   ///        implementation.
   /// @return true on success, false otherwise.
   virtual bool WriteToFile(const std::string& file_path);
 
+  /// @return the path of the Playlist Delta Update for the playlist written to
+  ///         @a file_path.
+  static std::string GetDeltaUpdateFilePath(const std::string& file_path);
+
   /// If bitrate is specified in MediaInfo then it will use that value.
   /// Otherwise, returns the max bitrate.
   /// @return the bitrate (in bits per second) of this MediaPlaylist.
@@ -167,8 +178,14 @@ class MediaPlaylist {
   // |sequence_number_| by the number of segments removed.
   void SlideWindow();
 
+  // Returns the body of the Playlist Delta Update, which replaces the segments
+  // starting |can_skip_until_| or more before the end of the playlist with
+  // EXT-X-SKIP. Only the entries which are not skipped are visited.
+  std::string CreateDeltaUpdateBody();
+
   const HlsPlaylistType playlist_type_;
   const double time_shift_buffer_depth_;
+  const double can_skip_until_;
   // Mainly for MasterPlaylist to use these values.
   const std::string file_name_;
   const std::string name_;
@@ -195,6 +212,8 @@ class MediaPlaylist {
   uint32_t target_duration_ = 0;
 
   std::list<std::unique_ptr<HlsEntry>> entries_;
+  // Number of EXTINF entries in |entries_|.
+  size_t num_segments_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(MediaPlaylist);
 };
@@ -21,6 +21,8 @@ namespace {
 
 const char kDefaultPlaylistFileName[] = "default_playlist.m3u8";
 const double kTimeShiftBufferDepth = 20;
+const double kNoCanSkipUntil = 0;
+const double kTestCanSkipUntil = 25;
 const uint64_t kTimeScale = 90000;
 const uint64_t kMBytes = 1000000;
 const uint64_t kZeroByteOffset = 0;
@@ -39,11 +41,15 @@ class MediaPlaylistTest : public ::testing::Test {
   MediaPlaylistTest() : MediaPlaylistTest(HlsPlaylistType::kVod) {}
 
   MediaPlaylistTest(HlsPlaylistType type)
+      : MediaPlaylistTest(type, kNoCanSkipUntil) {}
+
+  MediaPlaylistTest(HlsPlaylistType type, double can_skip_until)
       : default_file_name_(kDefaultPlaylistFileName),
         default_name_("default_name"),
         default_group_id_("default_group_id"),
         media_playlist_(type,
                         kTimeShiftBufferDepth,
+                        can_skip_until,
                         default_file_name_,
                         default_name_,
                         default_group_id_) {}
@@ -78,6 +84,8 @@ class MediaPlaylistMultiSegmentTest : public MediaPlaylistTest {
   // This constructor is for Live and Event playlist tests.
   MediaPlaylistMultiSegmentTest(HlsPlaylistType type)
       : MediaPlaylistTest(type) {}
+  MediaPlaylistMultiSegmentTest(HlsPlaylistType type, double can_skip_until)
+      : MediaPlaylistTest(type, can_skip_until) {}
 
   void SetUp() override {
     MediaPlaylistTest::SetUp();
@@ -117,6 +125,17 @@ TEST_F(MediaPlaylistMultiSegmentTest, SetMediaInfo) {
   EXPECT_TRUE(media_playlist_.SetMediaInfo(media_info));
 }
 
+// The codecs of audio multiplexed with the video are listed after the video
+// codec.
+TEST_F(MediaPlaylistMultiSegmentTest, SetMediaInfoMultiplexed) {
+  MediaInfo media_info = valid_video_media_info_;
+  media_info.mutable_audio_info()->set_codec("mp4a.40.2");
+  ASSERT_TRUE(media_playlist_.SetMediaInfo(media_info));
+  EXPECT_EQ(MediaPlaylist::MediaPlaylistStreamType::kPlayListVideo,
+            media_playlist_.stream_type());
+  EXPECT_EQ("avc1,mp4a.40.2", media_playlist_.codec());
+}
+
 // Verify that AddSegment works (not crash).
 TEST_F(MediaPlaylistMultiSegmentTest, AddSegment) {
   ASSERT_TRUE(media_playlist_.SetMediaInfo(valid_video_media_info_));
@@ -712,6 +731,96 @@ TEST_F(LiveMediaPlaylistTest, TimeShiftedWithEncryptionInfoShifted) {
   ASSERT_FILE_STREQ(kMemoryFilePath, kExpectedOutput);
 }
 
+class DeltaUpdateMediaPlaylistTest : public MediaPlaylistMultiSegmentTest {
+ protected:
+  DeltaUpdateMediaPlaylistTest()
+      : MediaPlaylistMultiSegmentTest(HlsPlaylistType::kEvent,
+                                      kTestCanSkipUntil) {}
+};
+
+TEST_F(DeltaUpdateMediaPlaylistTest, GetDeltaUpdateFilePath) {
+  EXPECT_EQ("memory://dir/media_delta.m3u8",
+            MediaPlaylist::GetDeltaUpdateFilePath("memory://dir/media.m3u8"));
+}
+
+TEST_F(DeltaUpdateMediaPlaylistTest, SkipSegments) {
+  ASSERT_TRUE(media_playlist_.SetMediaInfo(valid_video_media_info_));
+
+  media_playlist_.AddEncryptionInfo(MediaPlaylist::EncryptionMethod::kSampleAes,
+                                    "http://example.com", "", "0x12345678",
+                                    "com.widevine", "1/2/4");
+  media_playlist_.AddSegment("file1.ts", 0, 10 * kTimeScale, kZeroByteOffset,
+                             kMBytes);
+  media_playlist_.AddSegment("file2.ts", 10 * kTimeScale, 20 * kTimeScale,
+                             kZeroByteOffset, kMBytes);
+  media_playlist_.AddSegment("file3.ts", 30 * kTimeScale, 10 * kTimeScale,
+                             kZeroByteOffset, kMBytes);
+  media_playlist_.AddSegment("file4.ts", 40 * kTimeScale, 10 * kTimeScale,
+                             kZeroByteOffset, kMBytes);
+  const char kExpectedOutput[] =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:6\n"
+      "## Generated with https://github.com/google/shaka-packager version "
+      "test\n"
+      "#EXT-X-TARGETDURATION:20\n"
+      "#EXT-X-PLAYLIST-TYPE:EVENT\n"
+      "#EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL=25.000\n"
+      "#EXT-X-KEY:METHOD=SAMPLE-AES,"
+      "URI=\"http://example.com\",IV=0x12345678,KEYFORMATVERSIONS=\"1/2/4\","
+      "KEYFORMAT=\"com.widevine\"\n"
+      "#EXTINF:10.000,\n"
+      "file1.ts\n"
+      "#EXTINF:20.000,\n"
+      "file2.ts\n"
+      "#EXTINF:10.000,\n"
+      "file3.ts\n"
+      "#EXTINF:10.000,\n"
+      "file4.ts\n";
+  // file1.ts and file2.ts start more than 25 seconds before the end of the
+  // playlist. The key in effect for the remaining segments is repeated.
+  const char kExpectedDeltaUpdate[] =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:9\n"
+      "## Generated with https://github.com/google/shaka-packager version "
+      "test\n"
+      "#EXT-X-TARGETDURATION:20\n"
+      "#EXT-X-PLAYLIST-TYPE:EVENT\n"
+      "#EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL=25.000\n"
+      "#EXT-X-SKIP:SKIPPED-SEGMENTS=2\n"
+      "#EXT-X-KEY:METHOD=SAMPLE-AES,"
+      "URI=\"http://example.com\",IV=0x12345678,KEYFORMATVERSIONS=\"1/2/4\","
+      "KEYFORMAT=\"com.widevine\"\n"
+      "#EXTINF:10.000,\n"
+      "file3.ts\n"
+      "#EXTINF:10.000,\n"
+      "file4.ts\n";
+
+  const char kMemoryFilePath[] = "memory://media.m3u8";
+  EXPECT_TRUE(media_playlist_.WriteToFile(kMemoryFilePath));
+  ASSERT_FILE_STREQ(kMemoryFilePath, kExpectedOutput);
+  ASSERT_FILE_STREQ("memory://media_delta.m3u8", kExpectedDeltaUpdate);
+}
+
+TEST_F(DeltaUpdateMediaPlaylistTest, NothingToSkip) {
+  ASSERT_TRUE(media_playlist_.SetMediaInfo(valid_video_media_info_));
+
+  media_playlist_.AddSegment("file1.ts", 0, 10 * kTimeScale, kZeroByteOffset,
+                             kMBytes);
+  const char kExpectedDeltaUpdate[] =
+      "#EXTM3U\n"
+      "#EXT-X-VERSION:9\n"
+      "## Generated with https://github.com/google/shaka-packager version "
+      "test\n"
+      "#EXT-X-TARGETDURATION:10\n"
+      "#EXT-X-PLAYLIST-TYPE:EVENT\n"
+      "#EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL=25.000\n"
+      "#EXTINF:10.000,\n"
+      "file1.ts\n";
+
+  EXPECT_TRUE(media_playlist_.WriteToFile("memory://media.m3u8"));
+  ASSERT_FILE_STREQ("memory://media_delta.m3u8", kExpectedDeltaUpdate);
+}
+
 class EventMediaPlaylistTest : public MediaPlaylistMultiSegmentTest {
  protected:
   EventMediaPlaylistTest()
@@ -13,7 +13,7 @@ MockMediaPlaylist::MockMediaPlaylist(HlsPlaylistType type,
                                      const std::string& file_name,
                                      const std::string& name,
                                      const std::string& group_id)
-    : MediaPlaylist(type, 0, file_name, name, group_id) {}
+    : MediaPlaylist(type, 0, 0, file_name, name, group_id) {}
 MockMediaPlaylist::~MockMediaPlaylist() {}
 
 }  // namespace hls
@@ -240,21 +240,25 @@ MediaPlaylistFactory::~MediaPlaylistFactory() {}
 std::unique_ptr<MediaPlaylist> MediaPlaylistFactory::Create(
     HlsPlaylistType type,
     double time_shift_buffer_depth,
+    double can_skip_until,
     const std::string& file_name,
     const std::string& name,
     const std::string& group_id) {
-  return std::unique_ptr<MediaPlaylist>(new MediaPlaylist(
-      type, time_shift_buffer_depth, file_name, name, group_id));
+  return std::unique_ptr<MediaPlaylist>(
+      new MediaPlaylist(type, time_shift_buffer_depth, can_skip_until,
+                        file_name, name, group_id));
 }
 
 SimpleHlsNotifier::SimpleHlsNotifier(HlsPlaylistType playlist_type,
                                      double time_shift_buffer_depth,
+                                     double can_skip_until,
                                      const std::string& prefix,
                                      const std::string& key_uri,
                                      const std::string& output_dir,
                                      const std::string& master_playlist_name)
     : HlsNotifier(playlist_type),
       time_shift_buffer_depth_(time_shift_buffer_depth),
+      can_skip_until_(can_skip_until),
       prefix_(prefix),
       key_uri_(key_uri),
       output_dir_(output_dir),
@@ -276,7 +280,8 @@ bool SimpleHlsNotifier::NotifyNewStream(const MediaInfo& media_info,
 
   std::unique_ptr<MediaPlaylist> media_playlist =
       media_playlist_factory_->Create(playlist_type(), time_shift_buffer_depth_,
-                                      playlist_name, name, group_id);
+                                      can_skip_until_, playlist_name, name,
+                                      group_id);
 
   // Update init_segment_name to be relative to playlist path if needed.
   MediaInfo media_info_copy = media_info;
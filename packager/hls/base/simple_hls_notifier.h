@@ -30,6 +30,7 @@ class MediaPlaylistFactory {
   virtual ~MediaPlaylistFactory();
   virtual std::unique_ptr<MediaPlaylist> Create(HlsPlaylistType type,
                                                 double time_shift_buffer_depth,
+                                                double can_skip_until,
                                                 const std::string& file_name,
                                                 const std::string& name,
                                                 const std::string& group_id);
@@ -43,6 +44,8 @@ class SimpleHlsNotifier : public HlsNotifier {
   /// @param playlist_type is the type of the playlists.
   /// @param time_shift_buffer_depth determines the duration of the time
   ///        shifting buffer, only for live HLS.
+  /// @param can_skip_until enables Playlist Delta Updates if positive, see
+  ///        HlsParams::can_skip_until.
   /// @param prefix is the used as the prefix for MediaPlaylist URIs. May be
   ///        empty for relative URI from the playlist.
   /// @param key_uri defines the key uri for "identity" and
@@ -53,6 +56,7 @@ class SimpleHlsNotifier : public HlsNotifier {
   /// @param master_playlist_name is the name of the master playlist.
   SimpleHlsNotifier(HlsPlaylistType playlist_type,
                     double time_shift_buffer_depth,
+                    double can_skip_until,
                     const std::string& prefix,
                     const std::string& key_uri,
                     const std::string& output_dir,
@@ -92,6 +96,7 @@ class SimpleHlsNotifier : public HlsNotifier {
   };
 
   const double time_shift_buffer_depth_ = 0;
+  const double can_skip_until_ = 0;
   const std::string prefix_;
   const std::string key_uri_;
   const std::string output_dir_;
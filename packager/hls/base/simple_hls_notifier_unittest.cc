@@ -48,24 +48,28 @@ class MockMasterPlaylist : public MasterPlaylist {
 
 class MockMediaPlaylistFactory : public MediaPlaylistFactory {
  public:
-  MOCK_METHOD5(CreateMock,
+  MOCK_METHOD6(CreateMock,
                MediaPlaylist*(HlsPlaylistType type,
                               double time_shift_buffer_depth,
+                              double can_skip_until,
                               const std::string& file_name,
                               const std::string& name,
                               const std::string& group_id));
 
   std::unique_ptr<MediaPlaylist> Create(HlsPlaylistType type,
                                         double time_shift_buffer_depth,
+                                        double can_skip_until,
                                         const std::string& file_name,
                                         const std::string& name,
                                         const std::string& group_id) override {
     return std::unique_ptr<MediaPlaylist>(
-        CreateMock(type, time_shift_buffer_depth, file_name, name, group_id));
+        CreateMock(type, time_shift_buffer_depth, can_skip_until, file_name,
+                   name, group_id));
   }
 };
 
 const double kTestTimeShiftBufferDepth = 1800.0;
+const double kTestCanSkipUntil = 0;
 const char kTestPrefix[] = "http://testprefix.com/";
 const char kEmptyPrefix[] = "";
 const char kAnyOutputDir[] = "anything/";
@@ -123,7 +127,7 @@ class SimpleHlsNotifierTest : public ::testing::Test {
         *mock_master_playlist,
         AddMediaPlaylist(static_cast<MediaPlaylist*>(mock_media_playlist)));
     EXPECT_CALL(*mock_media_playlist, SetMediaInfo(_)).WillOnce(Return(true));
-    EXPECT_CALL(*factory, CreateMock(_, _, _, _, _))
+    EXPECT_CALL(*factory, CreateMock(_, _, _, _, _, _))
         .WillOnce(Return(mock_media_playlist));
 
     InjectMasterPlaylist(std::move(mock_master_playlist), notifier);
@@ -142,8 +146,8 @@ class SimpleHlsNotifierTest : public ::testing::Test {
 
 TEST_F(SimpleHlsNotifierTest, Init) {
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   EXPECT_TRUE(notifier.Init());
 }
 
@@ -170,13 +174,14 @@ TEST_F(SimpleHlsNotifierTest, RebaseSegmentUrl) {
       *mock_media_playlist,
       AddSegment("http://testprefix.com/path/to/media1.ts", _, _, _, _));
   EXPECT_CALL(*factory, CreateMock(kVodPlaylist, Eq(kTestTimeShiftBufferDepth),
+                                   Eq(kTestCanSkipUntil),
                                    StrEq("video_playlist.m3u8"), StrEq("name"),
                                    StrEq("groupid")))
       .WillOnce(Return(mock_media_playlist));
 
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
 
   InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
   InjectMediaPlaylistFactory(std::move(factory), &notifier);
@@ -211,13 +216,14 @@ TEST_F(SimpleHlsNotifierTest, RebaseInitSegmentUrl) {
       .WillOnce(Return(true));
 
   EXPECT_CALL(*factory, CreateMock(kVodPlaylist, Eq(kTestTimeShiftBufferDepth),
+                                   Eq(kTestCanSkipUntil),
                                    StrEq("video_playlist.m3u8"), StrEq("name"),
                                    StrEq("groupid")))
       .WillOnce(Return(mock_media_playlist));
 
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
 
   InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
   InjectMediaPlaylistFactory(std::move(factory), &notifier);
@@ -251,13 +257,14 @@ TEST_F(SimpleHlsNotifierTest, RebaseSegmentUrlRelativeToPlaylist) {
   EXPECT_CALL(*mock_media_playlist,
               AddSegment(StrEq("path/to/media1.m4s"), _, _, _, _));
   EXPECT_CALL(*factory, CreateMock(kVodPlaylist, Eq(kTestTimeShiftBufferDepth),
+                                   Eq(kTestCanSkipUntil),
                                    StrEq("video/playlist.m3u8"), StrEq("name"),
                                    StrEq("groupid")))
       .WillOnce(Return(mock_media_playlist));
 
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kEmptyPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kEmptyPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
 
   InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
   InjectMediaPlaylistFactory(std::move(factory), &notifier);
@@ -278,8 +285,8 @@ TEST_F(SimpleHlsNotifierTest, RebaseSegmentUrlRelativeToPlaylist) {
 TEST_F(SimpleHlsNotifierTest, RebaseAbsoluteSegmentPrefixAndOutputDirMatch) {
   const char kAbsoluteOutputDir[] = "/tmp/something/";
   SimpleHlsNotifier test_notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                                  kTestPrefix, kEmptyKeyUri, kAbsoluteOutputDir,
-                                  kMasterPlaylistName);
+                                  kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                                  kAbsoluteOutputDir, kMasterPlaylistName);
 
   std::unique_ptr<MockMasterPlaylist> mock_master_playlist(
       new MockMasterPlaylist());
@@ -297,6 +304,7 @@ TEST_F(SimpleHlsNotifierTest, RebaseAbsoluteSegmentPrefixAndOutputDirMatch) {
   EXPECT_CALL(*mock_media_playlist,
               AddSegment("http://testprefix.com/media1.ts", _, _, _, _));
   EXPECT_CALL(*factory, CreateMock(kVodPlaylist, Eq(kTestTimeShiftBufferDepth),
+                                   Eq(kTestCanSkipUntil),
                                    StrEq("video_playlist.m3u8"), StrEq("name"),
                                    StrEq("groupid")))
       .WillOnce(Return(mock_media_playlist));
@@ -320,8 +328,8 @@ TEST_F(SimpleHlsNotifierTest,
        RebaseAbsoluteSegmentCompletelyDifferentDirectory) {
   const char kAbsoluteOutputDir[] = "/tmp/something/";
   SimpleHlsNotifier test_notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                                  kTestPrefix, kEmptyKeyUri, kAbsoluteOutputDir,
-                                  kMasterPlaylistName);
+                                  kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                                  kAbsoluteOutputDir, kMasterPlaylistName);
 
   std::unique_ptr<MockMasterPlaylist> mock_master_playlist(
       new MockMasterPlaylist());
@@ -338,6 +346,7 @@ TEST_F(SimpleHlsNotifierTest,
               AddSegment("http://testprefix.com//var/somewhereelse/media1.ts",
                          _, _, _, _));
   EXPECT_CALL(*factory, CreateMock(kVodPlaylist, Eq(kTestTimeShiftBufferDepth),
+                                   Eq(kTestCanSkipUntil),
                                    StrEq("video_playlist.m3u8"), StrEq("name"),
                                    StrEq("groupid")))
       .WillOnce(Return(mock_media_playlist));
@@ -357,8 +366,8 @@ TEST_F(SimpleHlsNotifierTest,
 
 TEST_F(SimpleHlsNotifierTest, Flush) {
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   std::unique_ptr<MockMasterPlaylist> mock_master_playlist(
       new MockMasterPlaylist());
   EXPECT_CALL(*mock_master_playlist,
@@ -382,13 +391,14 @@ TEST_F(SimpleHlsNotifierTest, NotifyNewStream) {
 
   EXPECT_CALL(*mock_media_playlist, SetMediaInfo(_)).WillOnce(Return(true));
   EXPECT_CALL(*factory, CreateMock(kVodPlaylist, Eq(kTestTimeShiftBufferDepth),
+                                   Eq(kTestCanSkipUntil),
                                    StrEq("video_playlist.m3u8"), StrEq("name"),
                                    StrEq("groupid")))
       .WillOnce(Return(mock_media_playlist));
 
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
 
   InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
   InjectMediaPlaylistFactory(std::move(factory), &notifier);
@@ -414,7 +424,7 @@ TEST_F(SimpleHlsNotifierTest, NotifyNewSegment) {
       *mock_master_playlist,
       AddMediaPlaylist(static_cast<MediaPlaylist*>(mock_media_playlist)));
   EXPECT_CALL(*mock_media_playlist, SetMediaInfo(_)).WillOnce(Return(true));
-  EXPECT_CALL(*factory, CreateMock(_, _, _, _, _))
+  EXPECT_CALL(*factory, CreateMock(_, _, _, _, _, _))
       .WillOnce(Return(mock_media_playlist));
 
   const uint64_t kStartTime = 1328;
@@ -431,8 +441,8 @@ TEST_F(SimpleHlsNotifierTest, NotifyNewSegment) {
       .WillOnce(Return(kLongestSegmentDuration));
 
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   MockMasterPlaylist* mock_master_playlist_ptr = mock_master_playlist.get();
   InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
   InjectMediaPlaylistFactory(std::move(factory), &notifier);
@@ -464,8 +474,8 @@ TEST_F(SimpleHlsNotifierTest, NotifyNewSegment) {
 
 TEST_F(SimpleHlsNotifierTest, NotifyNewSegmentWithoutStreamsRegistered) {
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   EXPECT_TRUE(notifier.Init());
   EXPECT_FALSE(notifier.NotifyNewSegment(1u, "anything", 0u, 0u, 0u, 0u));
 }
@@ -475,8 +485,8 @@ TEST_F(SimpleHlsNotifierTest, NotifyEncryptionUpdateWidevine) {
   MockMediaPlaylist* mock_media_playlist =
       new MockMediaPlaylist(kVodPlaylist, "playlist.m3u8", "", "");
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   const uint32_t stream_id =
       SetupStream(kSampleAesProtectionScheme, mock_media_playlist, &notifier);
 
@@ -538,8 +548,8 @@ TEST_F(SimpleHlsNotifierTest, NotifyEncryptionUpdateWidevineNoKeyidsInPssh) {
   MockMediaPlaylist* mock_media_playlist =
       new MockMediaPlaylist(kVodPlaylist, "playlist.m3u8", "", "");
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   const uint32_t stream_id =
       SetupStream(kSampleAesProtectionScheme, mock_media_playlist, &notifier);
 
@@ -597,8 +607,8 @@ TEST_F(SimpleHlsNotifierTest, NotifyEncryptionUpdateIdentityKey) {
   MockMediaPlaylist* mock_media_playlist =
       new MockMediaPlaylist(kVodPlaylist, "playlist.m3u8", "", "");
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   const uint32_t stream_id =
       SetupStream(kSampleAesProtectionScheme, mock_media_playlist, &notifier);
 
@@ -627,8 +637,8 @@ TEST_F(SimpleHlsNotifierTest, WidevineMultipleKeyIdsNoContentIdInPssh) {
   MockMediaPlaylist* mock_media_playlist =
       new MockMediaPlaylist(kVodPlaylist, "playlist.m3u8", "", "");
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   uint32_t stream_id =
       SetupStream(kSampleAesProtectionScheme, mock_media_playlist, &notifier);
 
@@ -705,8 +715,8 @@ TEST_F(SimpleHlsNotifierTest, EncryptionScheme) {
   MockMediaPlaylist* mock_media_playlist =
       new MockMediaPlaylist(kVodPlaylist, "playlist.m3u8", "", "");
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kIdentityKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kIdentityKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   const uint32_t stream_id =
       SetupStream(kCencProtectionScheme, mock_media_playlist, &notifier);
 
@@ -730,8 +740,8 @@ TEST_F(SimpleHlsNotifierTest, NotifyEncryptionUpdateFairplay) {
   MockMediaPlaylist* mock_media_playlist =
       new MockMediaPlaylist(kLivePlaylist, "playlist.m3u8", "", "");
   SimpleHlsNotifier notifier(kLivePlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kFairplayKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kFairplayKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   const uint32_t stream_id =
       SetupStream(kSampleAesProtectionScheme, mock_media_playlist, &notifier);
   const std::vector<uint8_t> key_id(16, 0x12);
@@ -753,8 +763,8 @@ TEST_F(SimpleHlsNotifierTest, WidevineCencEncryptionScheme) {
   MockMediaPlaylist* mock_media_playlist =
       new MockMediaPlaylist(kVodPlaylist, "playlist.m3u8", "", "");
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   const uint32_t stream_id =
       SetupStream(kCencProtectionScheme, mock_media_playlist, &notifier);
 
@@ -802,8 +812,8 @@ TEST_F(SimpleHlsNotifierTest, WidevineNotifyEncryptionUpdateEmptyIv) {
   MockMediaPlaylist* mock_media_playlist =
       new MockMediaPlaylist(kVodPlaylist, "playlist.m3u8", "", "");
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   const uint32_t stream_id =
       SetupStream(kSampleAesProtectionScheme, mock_media_playlist, &notifier);
 
@@ -870,8 +880,8 @@ TEST_F(SimpleHlsNotifierTest, NotifyEncryptionUpdateWithoutStreamsRegistered) {
   std::vector<uint8_t> pssh_data;
   std::vector<uint8_t> key_id;
   SimpleHlsNotifier notifier(kVodPlaylist, kTestTimeShiftBufferDepth,
-                             kTestPrefix, kEmptyKeyUri, kAnyOutputDir,
-                             kMasterPlaylistName);
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   EXPECT_TRUE(notifier.Init());
   EXPECT_FALSE(
       notifier.NotifyEncryptionUpdate(1238u, key_id, system_id, iv, pssh_data));
@@ -902,7 +912,7 @@ TEST_P(LiveOrEventSimpleHlsNotifierTest, NotifyNewSegment) {
       *mock_master_playlist,
       AddMediaPlaylist(static_cast<MediaPlaylist*>(mock_media_playlist)));
   EXPECT_CALL(*mock_media_playlist, SetMediaInfo(_)).WillOnce(Return(true));
-  EXPECT_CALL(*factory, CreateMock(expected_playlist_type_, _, _, _, _))
+  EXPECT_CALL(*factory, CreateMock(expected_playlist_type_, _, _, _, _, _))
       .WillOnce(Return(mock_media_playlist));
 
   const uint64_t kStartTime = 1328;
@@ -930,8 +940,9 @@ TEST_P(LiveOrEventSimpleHlsNotifierTest, NotifyNewSegment) {
                       .AsUTF8Unsafe())))
       .WillOnce(Return(true));
 
-  SimpleHlsNotifier notifier(GetParam(), kTestTimeShiftBufferDepth, kTestPrefix,
-                             kEmptyKeyUri, kAnyOutputDir, kMasterPlaylistName);
+  SimpleHlsNotifier notifier(GetParam(), kTestTimeShiftBufferDepth,
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
   InjectMediaPlaylistFactory(std::move(factory), &notifier);
   EXPECT_TRUE(notifier.Init());
@@ -962,21 +973,22 @@ TEST_P(LiveOrEventSimpleHlsNotifierTest, NotifyNewSegmentsWithMultipleStreams) {
   MockMediaPlaylist* mock_media_playlist2 =
       new MockMediaPlaylist(expected_playlist_type_, "playlist2.m3u8", "", "");
 
-  EXPECT_CALL(*factory, CreateMock(_, _, StrEq("playlist1.m3u8"), _, _))
+  EXPECT_CALL(*factory, CreateMock(_, _, _, StrEq("playlist1.m3u8"), _, _))
       .WillOnce(Return(mock_media_playlist1));
   EXPECT_CALL(*mock_media_playlist1, SetMediaInfo(_)).WillOnce(Return(true));
   EXPECT_CALL(
       *mock_master_playlist,
       AddMediaPlaylist(static_cast<MediaPlaylist*>(mock_media_playlist1)));
-  EXPECT_CALL(*factory, CreateMock(_, _, StrEq("playlist2.m3u8"), _, _))
+  EXPECT_CALL(*factory, CreateMock(_, _, _, StrEq("playlist2.m3u8"), _, _))
       .WillOnce(Return(mock_media_playlist2));
   EXPECT_CALL(*mock_media_playlist2, SetMediaInfo(_)).WillOnce(Return(true));
   EXPECT_CALL(
       *mock_master_playlist,
       AddMediaPlaylist(static_cast<MediaPlaylist*>(mock_media_playlist2)));
 
-  SimpleHlsNotifier notifier(GetParam(), kTestTimeShiftBufferDepth, kTestPrefix,
-                             kEmptyKeyUri, kAnyOutputDir, kMasterPlaylistName);
+  SimpleHlsNotifier notifier(GetParam(), kTestTimeShiftBufferDepth,
+                             kTestCanSkipUntil, kTestPrefix, kEmptyKeyUri,
+                             kAnyOutputDir, kMasterPlaylistName);
   MockMasterPlaylist* mock_master_playlist_ptr = mock_master_playlist.get();
   InjectMasterPlaylist(std::move(mock_master_playlist), &notifier);
   InjectMediaPlaylistFactory(std::move(factory), &notifier);
@@ -31,6 +31,15 @@ struct HlsParams {
   /// Defines the live window, or the guaranteed duration of the time shifting
   /// buffer for 'live' playlists.
   double time_shift_buffer_depth = 0;
+  /// For EVENT and LIVE playlists, if positive, adds
+  /// EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL with this value, in seconds, to the
+  /// Media Playlists and writes a Playlist Delta Update next to each of them,
+  /// with "_delta" inserted before the extension. The segments starting this
+  /// long or longer before the end of the playlist are replaced by
+  /// EXT-X-SKIP in the delta update. The server is expected to respond with
+  /// the delta update to playlist requests with the _HLS_skip=YES query
+  /// parameter. Should be at least six times the target duration.
+  double can_skip_until = 0;
   /// Defines the key uri for "identity" and "com.apple.streamingkeydelivery"
   /// key formats. Ignored if the playlist is not encrypted or not using the
   /// above key formats.
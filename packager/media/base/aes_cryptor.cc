@@ -64,6 +64,16 @@ bool AesCryptor::Crypt(const std::string& text, std::string* crypt_text) {
   return true;
 }
 
+bool AesCryptor::CryptBatch(const std::vector<BatchText>& texts) {
+  if (constant_iv_flag_ == kUseConstantIv && CryptBatchInternal(texts))
+    return true;
+  for (const BatchText& text : texts) {
+    if (!Crypt(text.text, text.text_size, text.crypt_text))
+      return false;
+  }
+  return true;
+}
+
 bool AesCryptor::SetIv(const std::vector<uint8_t>& iv) {
   if (!IsIvSizeValid(iv.size())) {
     LOG(ERROR) << "Invalid IV size: " << iv.size();
@@ -123,6 +133,28 @@ bool AesCryptor::GenerateRandomIv(FourCC protection_scheme,
   return true;
 }
 
+bool AesCryptor::CryptPatterns(const uint8_t* text,
+                               size_t num_patterns,
+                               size_t crypt_byte_block,
+                               size_t skip_byte_block,
+                               uint8_t* crypt_text) {
+  // Not supported by default.
+  return false;
+}
+
+bool AesCryptor::CryptBatchInternal(const std::vector<BatchText>& texts) {
+  // Not supported by default.
+  return false;
+}
+
+bool AesCryptor::CryptChains(const std::vector<BatchText>& texts,
+                             const std::vector<size_t>& num_crypt_blocks,
+                             size_t crypt_byte_block,
+                             size_t skip_byte_block) {
+  // Not supported by default.
+  return false;
+}
+
 size_t AesCryptor::NumPaddingBytes(size_t size) const {
   // No padding by default.
   return 0;
@@ -68,6 +68,21 @@ class AesCryptor {
   }
   /// @}
 
+  /// A text crypted by CryptBatch.
+  struct BatchText {
+    const uint8_t* text;
+    size_t text_size;
+    /// Should have at least @a text_size bytes. Can be the same address as
+    /// @a text for in place encryption/decryption.
+    uint8_t* crypt_text;
+  };
+
+  /// Crypts @a texts as if by calling Crypt on every text in order. With a
+  /// constant iv, the texts form independent chains, e.g. the subsamples of a
+  /// 'cbcs' sample, which cryptors may crypt directly.
+  /// @return true on success, false otherwise.
+  bool CryptBatch(const std::vector<BatchText>& texts);
+
   /// Set IV.
   /// @return true if successful, false if the input is invalid.
   bool SetIv(const std::vector<uint8_t>& iv);
@@ -113,6 +128,37 @@ class AesCryptor {
   // Internal implementation of SetIv, which setup internal iv.
   virtual void SetIvInternal() = 0;
 
+  // Crypts |num_patterns| consecutive patterns in one pass, which is faster
+  // than crypting the encrypted blocks of every pattern with a separate Crypt
+  // call. Each pattern consists of |crypt_byte_block| encrypted blocks
+  // followed by |skip_byte_block| clear blocks (16-byte). The clear blocks are
+  // copied to |crypt_text|, unless |text| and |crypt_text| point to the same
+  // address. Return false, without crypting anything, if the cryptor does not
+  // support it, in which case the caller falls back to Crypt.
+  virtual bool CryptPatterns(const uint8_t* text,
+                             size_t num_patterns,
+                             size_t crypt_byte_block,
+                             size_t skip_byte_block,
+                             uint8_t* crypt_text);
+
+  // Crypts |texts| as independent chains starting from the current iv. Called
+  // by CryptBatch if a constant iv is used. Return false, without crypting
+  // anything, if the cryptor does not support it, in which case CryptBatch
+  // falls back to Crypt.
+  virtual bool CryptBatchInternal(const std::vector<BatchText>& texts);
+
+  // Crypts |texts| as independent chains starting from the current iv,
+  // following the pattern of |crypt_byte_block| encrypted blocks and
+  // |skip_byte_block| clear blocks (16-byte). Only the first
+  // |num_crypt_blocks| encrypted blocks of each text are crypted, where
+  // |num_crypt_blocks| has an entry for every text; the remaining bytes are
+  // copied. Return false, without crypting anything, if the cryptor does not
+  // support it.
+  virtual bool CryptChains(const std::vector<BatchText>& texts,
+                           const std::vector<size_t>& num_crypt_blocks,
+                           size_t crypt_byte_block,
+                           size_t skip_byte_block);
+
   // |size| specifies the input text size.
   // Return the number of padding bytes needed.
   // Note: No paddings should be needed except for pkcs5-cbc encryptor.
@@ -131,6 +177,10 @@ class AesCryptor {
   // should iv advance in UpdateIv(). It will be reset to 0 after iv is updated.
   size_t num_crypt_bytes_;
 
+  // AesPatternCryptor calls CryptPatterns and CryptChains of the cryptor it
+  // wraps.
+  friend class AesPatternCryptor;
+
   DISALLOW_COPY_AND_ASSIGN(AesCryptor);
 };
 
@@ -529,6 +529,45 @@ TEST_F(AesCbcTest, NoPaddingChainAcrossCalls) {
   EXPECT_EQ(plaintext, decrypted);
 }
 
+TEST_F(AesCbcTest, NoPaddingCryptBatch) {
+  // More texts than the chains interleaved, of various sizes, including empty
+  // texts and texts with residual blocks.
+  std::vector<uint8_t> plaintext;
+  std::vector<size_t> text_sizes;
+  for (size_t i = 0; i < 20; ++i) {
+    text_sizes.push_back(i * 37 % 200);
+    for (size_t j = 0; j < text_sizes.back(); ++j)
+      plaintext.push_back(static_cast<uint8_t>(i + j * 13));
+  }
+
+  AesCbcEncryptor encryptor(kNoPadding, AesCryptor::kUseConstantIv);
+  ASSERT_TRUE(encryptor.InitializeWithIv(key_, iv_));
+  std::vector<uint8_t> expected_ciphertext(plaintext.size());
+  size_t offset = 0;
+  for (size_t text_size : text_sizes) {
+    ASSERT_TRUE(encryptor.Crypt(plaintext.data() + offset, text_size,
+                                expected_ciphertext.data() + offset));
+    offset += text_size;
+  }
+
+  std::vector<uint8_t> ciphertext(plaintext.size());
+  std::vector<uint8_t> buffer(plaintext);
+  std::vector<AesCryptor::BatchText> texts;
+  std::vector<AesCryptor::BatchText> in_place_texts;
+  offset = 0;
+  for (size_t text_size : text_sizes) {
+    texts.push_back(
+        {plaintext.data() + offset, text_size, ciphertext.data() + offset});
+    in_place_texts.push_back(
+        {buffer.data() + offset, text_size, buffer.data() + offset});
+    offset += text_size;
+  }
+  ASSERT_TRUE(encryptor.CryptBatch(texts));
+  EXPECT_EQ(expected_ciphertext, ciphertext);
+  ASSERT_TRUE(encryptor.CryptBatch(in_place_texts));
+  EXPECT_EQ(expected_ciphertext, buffer);
+}
+
 TEST_F(AesCbcTest, UnsupportedKeySize) {
   EXPECT_FALSE(encryptor_->InitializeWithIv(std::vector<uint8_t>(15, 0), iv_));
   EXPECT_FALSE(decryptor_->InitializeWithIv(std::vector<uint8_t>(15, 0), iv_));
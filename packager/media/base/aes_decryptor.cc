@@ -17,6 +17,37 @@ bool IsKeySizeValidForAes(size_t key_size) {
   return key_size == 16 || key_size == 24 || key_size == 32;
 }
 
+// Decrypts the encrypted blocks of |num_patterns| consecutive patterns in a
+// single cipher block chain starting from |iv|, which is updated to the last
+// ciphertext block. The pattern is fixed at compile time so the block loops
+// can be unrolled. Clear blocks are copied unless decrypting in place.
+template <size_t kCryptByteBlock, size_t kSkipByteBlock>
+void CbcDecryptPatterns(const AES_KEY* aes_key,
+                        const uint8_t* ciphertext,
+                        size_t num_patterns,
+                        uint8_t* iv,
+                        uint8_t* plaintext) {
+  const bool in_place = ciphertext == plaintext;
+  uint8_t block[AES_BLOCK_SIZE];
+  uint8_t next_iv[AES_BLOCK_SIZE];
+  for (size_t i = 0; i < num_patterns; ++i) {
+    for (size_t j = 0; j < kCryptByteBlock; ++j) {
+      // Save the ciphertext block, which may get overwritten, for chaining.
+      memcpy(next_iv, ciphertext, AES_BLOCK_SIZE);
+      AES_decrypt(ciphertext, block, aes_key);
+      for (size_t k = 0; k < AES_BLOCK_SIZE; ++k)
+        plaintext[k] = block[k] ^ iv[k];
+      memcpy(iv, next_iv, AES_BLOCK_SIZE);
+      ciphertext += AES_BLOCK_SIZE;
+      plaintext += AES_BLOCK_SIZE;
+    }
+    if (!in_place)
+      memcpy(plaintext, ciphertext, kSkipByteBlock * AES_BLOCK_SIZE);
+    ciphertext += kSkipByteBlock * AES_BLOCK_SIZE;
+    plaintext += kSkipByteBlock * AES_BLOCK_SIZE;
+  }
+}
+
 }  // namespace
 
 namespace shaka {
@@ -153,6 +184,43 @@ bool AesCbcDecryptor::CryptInternal(const uint8_t* ciphertext,
   return true;
 }
 
+bool AesCbcDecryptor::CryptPatterns(const uint8_t* ciphertext,
+                                    size_t num_patterns,
+                                    size_t crypt_byte_block,
+                                    size_t skip_byte_block,
+                                    uint8_t* plaintext) {
+  DCHECK(aes_key());
+  if (padding_scheme_ != kNoPadding)
+    return false;
+
+  if (crypt_byte_block == 1 && skip_byte_block == 9) {
+    // The pattern used by HLS SAMPLE-AES and recommended for 'cbcs'.
+    CbcDecryptPatterns<1, 9>(aes_key(), ciphertext, num_patterns,
+                             internal_iv_.data(), plaintext);
+    return true;
+  }
+  const size_t crypt_byte_size = crypt_byte_block * AES_BLOCK_SIZE;
+  if (skip_byte_block == 0) {
+    // Without clear blocks, the patterns form one contiguous chain, e.g. for
+    // full sample encryption.
+    AES_cbc_encrypt(ciphertext, plaintext, num_patterns * crypt_byte_size,
+                    aes_key(), internal_iv_.data(), AES_DECRYPT);
+    return true;
+  }
+  const size_t skip_byte_size = skip_byte_block * AES_BLOCK_SIZE;
+  for (size_t i = 0; i < num_patterns; ++i) {
+    AES_cbc_encrypt(ciphertext, plaintext, crypt_byte_size, aes_key(),
+                    internal_iv_.data(), AES_DECRYPT);
+    ciphertext += crypt_byte_size;
+    plaintext += crypt_byte_size;
+    if (ciphertext != plaintext)
+      memcpy(plaintext, ciphertext, skip_byte_size);
+    ciphertext += skip_byte_size;
+    plaintext += skip_byte_size;
+  }
+  return true;
+}
+
 void AesCbcDecryptor::SetIvInternal() {
   internal_iv_ = iv();
   internal_iv_.resize(AES_BLOCK_SIZE, 0);
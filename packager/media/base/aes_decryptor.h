@@ -54,6 +54,11 @@ class AesCbcDecryptor : public AesCryptor {
                      uint8_t* plaintext,
                      size_t* plaintext_size) override;
   void SetIvInternal() override;
+  bool CryptPatterns(const uint8_t* ciphertext,
+                     size_t num_patterns,
+                     size_t crypt_byte_block,
+                     size_t skip_byte_block,
+                     uint8_t* plaintext) override;
 
   const CbcPaddingScheme padding_scheme_;
   // 16-byte internal iv for crypto operations.
@@ -27,6 +27,37 @@ bool IsKeySizeValidForAes(size_t key_size) {
   return key_size == 16 || key_size == 24 || key_size == 32;
 }
 
+// Encrypts the encrypted blocks of |num_patterns| consecutive patterns in a
+// single cipher block chain starting from |iv|, which is updated to the last
+// ciphertext block. The pattern is fixed at compile time so the block loops
+// can be unrolled. Clear blocks are copied unless encrypting in place.
+template <size_t kCryptByteBlock, size_t kSkipByteBlock>
+void CbcEncryptPatterns(const AES_KEY* aes_key,
+                        const uint8_t* plaintext,
+                        size_t num_patterns,
+                        uint8_t* iv,
+                        uint8_t* ciphertext) {
+  const bool in_place = plaintext == ciphertext;
+  const uint8_t* previous_block = iv;
+  uint8_t block[AES_BLOCK_SIZE];
+  for (size_t i = 0; i < num_patterns; ++i) {
+    for (size_t j = 0; j < kCryptByteBlock; ++j) {
+      for (size_t k = 0; k < AES_BLOCK_SIZE; ++k)
+        block[k] = plaintext[k] ^ previous_block[k];
+      AES_encrypt(block, ciphertext, aes_key);
+      previous_block = ciphertext;
+      plaintext += AES_BLOCK_SIZE;
+      ciphertext += AES_BLOCK_SIZE;
+    }
+    if (!in_place)
+      memcpy(ciphertext, plaintext, kSkipByteBlock * AES_BLOCK_SIZE);
+    plaintext += kSkipByteBlock * AES_BLOCK_SIZE;
+    ciphertext += kSkipByteBlock * AES_BLOCK_SIZE;
+  }
+  if (previous_block != iv)
+    memcpy(iv, previous_block, AES_BLOCK_SIZE);
+}
+
 }  // namespace
 
 namespace shaka {
@@ -184,6 +215,84 @@ bool AesCbcEncryptor::CryptInternal(const uint8_t* plaintext,
   return true;
 }
 
+bool AesCbcEncryptor::CryptPatterns(const uint8_t* plaintext,
+                                    size_t num_patterns,
+                                    size_t crypt_byte_block,
+                                    size_t skip_byte_block,
+                                    uint8_t* ciphertext) {
+  DCHECK(aes_key());
+  if (padding_scheme_ != kNoPadding)
+    return false;
+
+  if (crypt_byte_block == 1 && skip_byte_block == 9) {
+    // The pattern used by HLS SAMPLE-AES and recommended for 'cbcs'.
+    CbcEncryptPatterns<1, 9>(aes_key(), plaintext, num_patterns,
+                             internal_iv_.data(), ciphertext);
+    return true;
+  }
+  const size_t crypt_byte_size = crypt_byte_block * AES_BLOCK_SIZE;
+  if (skip_byte_block == 0) {
+    // Without clear blocks, the patterns form one contiguous chain, e.g. for
+    // full sample encryption.
+    AES_cbc_encrypt(plaintext, ciphertext, num_patterns * crypt_byte_size,
+                    aes_key(), internal_iv_.data(), AES_ENCRYPT);
+    return true;
+  }
+  const size_t skip_byte_size = skip_byte_block * AES_BLOCK_SIZE;
+  for (size_t i = 0; i < num_patterns; ++i) {
+    AES_cbc_encrypt(plaintext, ciphertext, crypt_byte_size, aes_key(),
+                    internal_iv_.data(), AES_ENCRYPT);
+    plaintext += crypt_byte_size;
+    ciphertext += crypt_byte_size;
+    if (plaintext != ciphertext)
+      memcpy(ciphertext, plaintext, skip_byte_size);
+    plaintext += skip_byte_size;
+    ciphertext += skip_byte_size;
+  }
+  return true;
+}
+
+bool AesCbcEncryptor::CryptBatchInternal(const std::vector<BatchText>& texts) {
+  if (padding_scheme_ != kNoPadding)
+    return false;
+  // The residual block of every text is left unencrypted.
+  std::vector<size_t> num_crypt_blocks;
+  num_crypt_blocks.reserve(texts.size());
+  for (const BatchText& text : texts)
+    num_crypt_blocks.push_back(text.text_size / AES_BLOCK_SIZE);
+  return CryptChains(texts, num_crypt_blocks, 1, 0);
+}
+
+bool AesCbcEncryptor::CryptChains(const std::vector<BatchText>& texts,
+                                  const std::vector<size_t>& num_crypt_blocks,
+                                  size_t crypt_byte_block,
+                                  size_t skip_byte_block) {
+  DCHECK(aes_key());
+  DCHECK_EQ(texts.size(), num_crypt_blocks.size());
+  if (padding_scheme_ != kNoPadding)
+    return false;
+
+  // The chains are encrypted one after the other. Interleaving the blocks of
+  // several chains with per-block AES_encrypt calls was measured to be up to
+  // 2.5x slower than AES_cbc_encrypt on whole chains, and no faster with
+  // patterns.
+  for (size_t i = 0; i < texts.size(); ++i) {
+    const BatchText& text = texts[i];
+    // This also copies the clear bytes.
+    if (text.text != text.crypt_text)
+      memcpy(text.crypt_text, text.text, text.text_size);
+    DCHECK_EQ(0u, num_crypt_blocks[i] % crypt_byte_block);
+    // Every chain starts from the constant iv.
+    SetIvInternal();
+    if (!CryptPatterns(text.crypt_text, num_crypt_blocks[i] / crypt_byte_block,
+                       crypt_byte_block, skip_byte_block, text.crypt_text)) {
+      return false;
+    }
+  }
+  SetIvInternal();
+  return true;
+}
+
 void AesCbcEncryptor::SetIvInternal() {
   internal_iv_ = iv();
   internal_iv_.resize(AES_BLOCK_SIZE, 0);
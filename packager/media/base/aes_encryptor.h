@@ -100,6 +100,16 @@ class AesCbcEncryptor : public AesEncryptor {
                      uint8_t* ciphertext,
                      size_t* ciphertext_size) override;
   void SetIvInternal() override;
+  bool CryptPatterns(const uint8_t* plaintext,
+                     size_t num_patterns,
+                     size_t crypt_byte_block,
+                     size_t skip_byte_block,
+                     uint8_t* ciphertext) override;
+  bool CryptBatchInternal(const std::vector<BatchText>& texts) override;
+  bool CryptChains(const std::vector<BatchText>& texts,
+                   const std::vector<size_t>& num_crypt_blocks,
+                   size_t crypt_byte_block,
+                   size_t skip_byte_block) override;
   size_t NumPaddingBytes(size_t size) const override;
 
   const CbcPaddingScheme padding_scheme_;
@@ -49,26 +49,48 @@ bool AesPatternCryptor::CryptInternal(const uint8_t* text,
   }
   *crypt_text_size = text_size;
 
+  const size_t crypt_byte_size = crypt_byte_block_ * AES_BLOCK_SIZE;
+  const size_t skip_byte_size = skip_byte_block_ * AES_BLOCK_SIZE;
+  const size_t pattern_size = crypt_byte_size + skip_byte_size;
+
+  // Crypt the complete patterns in one pass if |cryptor_| supports it. The
+  // encrypted blocks of the last pattern are left in clear if they are at the
+  // end of the text and not to be encrypted.
+  size_t num_patterns = text_size / pattern_size;
+  if (num_patterns > 0 &&
+      !NeedEncrypt(text_size - (num_patterns - 1) * pattern_size,
+                   crypt_byte_size)) {
+    --num_patterns;
+  }
+  if (num_patterns > 0 &&
+      cryptor_->CryptPatterns(text, num_patterns, crypt_byte_block_,
+                              skip_byte_block_, crypt_text)) {
+    const size_t crypted_size = num_patterns * pattern_size;
+    text += crypted_size;
+    text_size -= crypted_size;
+    crypt_text += crypted_size;
+  }
+
   while (text_size > 0) {
-    const size_t crypt_byte_size = crypt_byte_block_ * AES_BLOCK_SIZE;
     if (NeedEncrypt(text_size, crypt_byte_size)) {
       if (!cryptor_->Crypt(text, crypt_byte_size, crypt_text))
         return false;
     } else {
       // If there is not enough data, just keep it in clear.
-      memcpy(crypt_text, text, text_size);
+      if (text != crypt_text)
+        memcpy(crypt_text, text, text_size);
       return true;
     }
     text += crypt_byte_size;
     text_size -= crypt_byte_size;
     crypt_text += crypt_byte_size;
 
-    const size_t skip_byte_size = std::min(
-        static_cast<size_t>(skip_byte_block_ * AES_BLOCK_SIZE), text_size);
-    memcpy(crypt_text, text, skip_byte_size);
-    text += skip_byte_size;
-    text_size -= skip_byte_size;
-    crypt_text += skip_byte_size;
+    const size_t clear_size = std::min(skip_byte_size, text_size);
+    if (text != crypt_text)
+      memcpy(crypt_text, text, clear_size);
+    text += clear_size;
+    text_size -= clear_size;
+    crypt_text += clear_size;
   }
   return true;
 }
@@ -77,6 +99,16 @@ void AesPatternCryptor::SetIvInternal() {
   CHECK(cryptor_->SetIv(iv()));
 }
 
+bool AesPatternCryptor::CryptBatchInternal(
+    const std::vector<BatchText>& texts) {
+  std::vector<size_t> num_crypt_blocks;
+  num_crypt_blocks.reserve(texts.size());
+  for (const BatchText& text : texts)
+    num_crypt_blocks.push_back(NumCryptBlocks(text.text_size));
+  return cryptor_->CryptChains(texts, num_crypt_blocks, crypt_byte_block_,
+                               skip_byte_block_);
+}
+
 bool AesPatternCryptor::NeedEncrypt(size_t input_size,
                                     size_t target_data_size) {
   if (encryption_mode_ == kSkipIfCryptByteBlockRemaining)
@@ -84,5 +116,19 @@ bool AesPatternCryptor::NeedEncrypt(size_t input_size,
   return input_size >= target_data_size;
 }
 
+size_t AesPatternCryptor::NumCryptBlocks(size_t text_size) {
+  // The encrypted blocks of a pattern are encrypted if NeedEncrypt() returns
+  // true for the bytes remaining from the start of the pattern.
+  const size_t crypt_byte_size = crypt_byte_block_ * AES_BLOCK_SIZE;
+  const size_t pattern_size =
+      crypt_byte_size + skip_byte_block_ * AES_BLOCK_SIZE;
+  const size_t min_text_size =
+      encryption_mode_ == kSkipIfCryptByteBlockRemaining ? crypt_byte_size + 1
+                                                         : crypt_byte_size;
+  if (text_size < min_text_size)
+    return 0;
+  return ((text_size - min_text_size) / pattern_size + 1) * crypt_byte_block_;
+}
+
 }  // namespace media
 }  // namespace shaka
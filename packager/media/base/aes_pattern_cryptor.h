@@ -69,8 +69,12 @@ class AesPatternCryptor : public AesCryptor {
                      uint8_t* crypt_text,
                      size_t* crypt_text_size) override;
   void SetIvInternal() override;
+  bool CryptBatchInternal(const std::vector<BatchText>& texts) override;
 
   bool NeedEncrypt(size_t input_size, size_t target_data_size);
+  // Returns the number of encrypted blocks (16-byte) in a text of |text_size|
+  // bytes.
+  size_t NumCryptBlocks(size_t text_size);
 
   uint8_t crypt_byte_block_;
   const uint8_t skip_byte_block_;
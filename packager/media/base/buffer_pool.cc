@@ -0,0 +1,133 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/buffer_pool.h"
+
+#include <algorithm>
+#include <new>
+
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+// Buffers from 2^kMinSizeClassBits to 2^kMaxSizeClassBits bytes are pooled.
+// Larger buffers are rare and are allocated directly.
+const size_t kMinSizeClassBits = 8;
+const size_t kMaxSizeClassBits = 22;
+// Upper bound of the released bytes kept for re-use in each size class. At
+// least kMinFreeBlocksPerSizeClass blocks are kept regardless.
+const size_t kMaxFreeBytesPerSizeClass = 1 << 20;
+const size_t kMinFreeBlocksPerSizeClass = 2;
+
+size_t GetSizeClassIndex(size_t size) {
+  size_t bits = kMinSizeClassBits;
+  while ((static_cast<size_t>(1) << bits) < size)
+    ++bits;
+  return bits - kMinSizeClassBits;
+}
+
+}  // namespace
+
+BlockRecycler::BlockRecycler(size_t block_size, size_t max_free_blocks)
+    : block_size_(block_size), max_free_blocks_(max_free_blocks) {
+  free_blocks_.reserve(max_free_blocks_);
+}
+
+BlockRecycler::~BlockRecycler() {
+  for (void* block : free_blocks_)
+    ::operator delete(block);
+}
+
+void* BlockRecycler::Allocate() {
+  {
+    base::AutoLock auto_lock(lock_);
+    if (!free_blocks_.empty()) {
+      void* block = free_blocks_.back();
+      free_blocks_.pop_back();
+      ++stats_.num_recycled_allocations;
+      return block;
+    }
+    ++stats_.num_system_allocations;
+  }
+  return ::operator new(block_size_);
+}
+
+void BlockRecycler::Release(void* block) {
+  if (!block)
+    return;
+  {
+    base::AutoLock auto_lock(lock_);
+    if (free_blocks_.size() < max_free_blocks_) {
+      free_blocks_.push_back(block);
+      return;
+    }
+  }
+  ::operator delete(block);
+}
+
+AllocationStats BlockRecycler::stats() const {
+  base::AutoLock auto_lock(lock_);
+  return stats_;
+}
+
+struct BufferPool::SizeClasses {
+  SizeClasses() {
+    for (size_t bits = kMinSizeClassBits; bits <= kMaxSizeClassBits; ++bits) {
+      const size_t block_size = static_cast<size_t>(1) << bits;
+      recyclers.emplace_back(new BlockRecycler(
+          block_size, std::max(kMinFreeBlocksPerSizeClass,
+                               kMaxFreeBytesPerSizeClass / block_size)));
+    }
+  }
+
+  std::vector<std::unique_ptr<BlockRecycler>> recyclers;
+
+  base::Lock lock;
+  // Allocations larger than the largest size class. Protected by |lock|.
+  uint64_t num_oversized_allocations = 0;
+};
+
+BufferPool::BufferPool() : size_classes_(new SizeClasses) {}
+
+BufferPool::~BufferPool() {}
+
+std::shared_ptr<uint8_t> BufferPool::Allocate(size_t size) {
+  const size_t index = GetSizeClassIndex(size);
+  if (index >= size_classes_->recyclers.size()) {
+    {
+      base::AutoLock auto_lock(size_classes_->lock);
+      ++size_classes_->num_oversized_allocations;
+    }
+    return std::shared_ptr<uint8_t>(new uint8_t[size],
+                                    std::default_delete<uint8_t[]>());
+  }
+
+  // The deleter holds a reference to the size classes, so buffers can outlive
+  // the pool.
+  std::shared_ptr<SizeClasses> size_classes = size_classes_;
+  return std::shared_ptr<uint8_t>(
+      static_cast<uint8_t*>(size_classes->recyclers[index]->Allocate()),
+      [size_classes, index](uint8_t* buffer) {
+        size_classes->recyclers[index]->Release(buffer);
+      });
+}
+
+AllocationStats BufferPool::stats() const {
+  AllocationStats stats;
+  for (const auto& recycler : size_classes_->recyclers) {
+    const AllocationStats recycler_stats = recycler->stats();
+    stats.num_system_allocations += recycler_stats.num_system_allocations;
+    stats.num_recycled_allocations += recycler_stats.num_recycled_allocations;
+  }
+  base::AutoLock auto_lock(size_classes_->lock);
+  stats.num_system_allocations += size_classes_->num_oversized_allocations;
+  return stats;
+}
+
+}  // namespace media
+}  // namespace shaka
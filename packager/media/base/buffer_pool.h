@@ -0,0 +1,92 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_BUFFER_POOL_H_
+#define PACKAGER_MEDIA_BASE_BUFFER_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/lock.h"
+
+namespace shaka {
+namespace media {
+
+/// Allocation counters of a BlockRecycler or BufferPool.
+struct AllocationStats {
+  /// Number of allocations served by the system allocator.
+  uint64_t num_system_allocations = 0;
+  /// Number of allocations served with a recycled block.
+  uint64_t num_recycled_allocations = 0;
+};
+
+/// A thread safe free list of memory blocks of a fixed size. Released blocks
+/// are kept for re-use, up to a limit. It can back class specific operator new
+/// and operator delete, to recycle the memory of frequently created objects.
+class BlockRecycler {
+ public:
+  /// @param block_size is the size of the blocks in bytes.
+  /// @param max_free_blocks is the maximum number of released blocks kept for
+  ///        re-use. Blocks released beyond that are freed.
+  BlockRecycler(size_t block_size, size_t max_free_blocks);
+  ~BlockRecycler();
+
+  /// @return a block of block_size() bytes.
+  void* Allocate();
+  /// Release a block obtained from Allocate().
+  void Release(void* block);
+
+  /// @return the allocation counters.
+  AllocationStats stats() const;
+
+  size_t block_size() const { return block_size_; }
+
+ private:
+  const size_t block_size_;
+  const size_t max_free_blocks_;
+
+  mutable base::Lock lock_;
+  // Protected by |lock_|.
+  std::vector<void*> free_blocks_;
+  AllocationStats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockRecycler);
+};
+
+/// A thread safe pool of sample payload buffers, organized in power of two
+/// size classes. Buffers are handed out as shared pointers, which return the
+/// buffer to the pool when the last reference goes away. Buffers remain valid
+/// after the pool itself is destroyed.
+class BufferPool {
+ public:
+  BufferPool();
+  ~BufferPool();
+
+  /// Allocate a buffer.
+  /// @param size is the minimum size of the buffer in bytes.
+  /// @return the buffer.
+  std::shared_ptr<uint8_t> Allocate(size_t size);
+
+  /// @return the allocation counters of all size classes.
+  AllocationStats stats() const;
+
+ private:
+  struct SizeClasses;
+
+  // Shared with the buffers handed out, which return to it on release.
+  std::shared_ptr<SizeClasses> size_classes_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferPool);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_BUFFER_POOL_H_
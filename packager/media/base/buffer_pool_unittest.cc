@@ -0,0 +1,120 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/media/base/buffer_pool.h"
+#include "packager/media/base/media_handler.h"
+#include "packager/media/base/media_sample.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+const uint8_t kData[] = {1, 2, 3, 4, 5, 6, 7, 8};
+}  // namespace
+
+TEST(BlockRecyclerTest, RecyclesUpToMaxFreeBlocks) {
+  const size_t kMaxFreeBlocks = 2;
+  BlockRecycler recycler(64, kMaxFreeBlocks);
+
+  void* blocks[3];
+  for (void*& block : blocks)
+    block = recycler.Allocate();
+  for (void* block : blocks)
+    recycler.Release(block);
+  EXPECT_EQ(3u, recycler.stats().num_system_allocations);
+  EXPECT_EQ(0u, recycler.stats().num_recycled_allocations);
+
+  for (void*& block : blocks)
+    block = recycler.Allocate();
+  // Only two blocks were kept.
+  EXPECT_EQ(4u, recycler.stats().num_system_allocations);
+  EXPECT_EQ(2u, recycler.stats().num_recycled_allocations);
+  for (void* block : blocks)
+    recycler.Release(block);
+}
+
+TEST(BufferPoolTest, RecyclesBuffers) {
+  BufferPool buffer_pool;
+  const size_t kNumBuffers = 100;
+  for (size_t i = 0; i < kNumBuffers; ++i) {
+    std::shared_ptr<uint8_t> buffer = buffer_pool.Allocate(1000 + i);
+    memcpy(buffer.get(), kData, sizeof(kData));
+  }
+  // All the buffers fall into the same size class and the same buffer is
+  // re-used.
+  EXPECT_EQ(1u, buffer_pool.stats().num_system_allocations);
+  EXPECT_EQ(kNumBuffers - 1, buffer_pool.stats().num_recycled_allocations);
+}
+
+TEST(BufferPoolTest, DifferentSizeClasses) {
+  BufferPool buffer_pool;
+  std::shared_ptr<uint8_t> small_buffer = buffer_pool.Allocate(100);
+  std::shared_ptr<uint8_t> large_buffer = buffer_pool.Allocate(100000);
+  small_buffer.reset();
+  // A small buffer cannot be recycled for a large allocation.
+  large_buffer = buffer_pool.Allocate(100000);
+  EXPECT_EQ(3u, buffer_pool.stats().num_system_allocations);
+  small_buffer = buffer_pool.Allocate(200);
+  EXPECT_EQ(1u, buffer_pool.stats().num_recycled_allocations);
+}
+
+TEST(BufferPoolTest, OversizedBuffer) {
+  BufferPool buffer_pool;
+  const size_t kOversizedBufferSize = 16 << 20;
+  std::shared_ptr<uint8_t> buffer = buffer_pool.Allocate(kOversizedBufferSize);
+  buffer.get()[kOversizedBufferSize - 1] = 1;
+  buffer = buffer_pool.Allocate(kOversizedBufferSize);
+  EXPECT_EQ(2u, buffer_pool.stats().num_system_allocations);
+}
+
+TEST(BufferPoolTest, BufferOutlivesPool) {
+  std::shared_ptr<uint8_t> buffer;
+  {
+    BufferPool buffer_pool;
+    buffer = buffer_pool.Allocate(sizeof(kData));
+  }
+  memcpy(buffer.get(), kData, sizeof(kData));
+  buffer.reset();
+}
+
+TEST(BufferPoolTest, MediaSampleSetData) {
+  BufferPool buffer_pool;
+  std::shared_ptr<MediaSample> sample = MediaSample::CreateEmptyMediaSample();
+  sample->SetData(kData, sizeof(kData), &buffer_pool);
+  ASSERT_EQ(sizeof(kData), sample->data_size());
+  EXPECT_EQ(0, memcmp(kData, sample->data(), sizeof(kData)));
+  EXPECT_EQ(1u, buffer_pool.stats().num_system_allocations);
+}
+
+TEST(ObjectRecyclingTest, MediaSample) {
+  // Warm up the free list.
+  MediaSample::CreateEmptyMediaSample();
+  const AllocationStats before = MediaSample::GetAllocationStats();
+  for (int i = 0; i < 10; ++i)
+    MediaSample::CopyFrom(kData, sizeof(kData), true);
+  const AllocationStats after = MediaSample::GetAllocationStats();
+  EXPECT_EQ(before.num_system_allocations, after.num_system_allocations);
+  EXPECT_EQ(before.num_recycled_allocations + 10,
+            after.num_recycled_allocations);
+}
+
+TEST(ObjectRecyclingTest, StreamData) {
+  std::shared_ptr<MediaSample> sample =
+      MediaSample::CopyFrom(kData, sizeof(kData), true);
+  StreamData::FromMediaSample(0, sample);
+  const AllocationStats before = StreamData::GetAllocationStats();
+  for (int i = 0; i < 10; ++i)
+    StreamData::FromMediaSample(0, sample);
+  const AllocationStats after = StreamData::GetAllocationStats();
+  EXPECT_EQ(before.num_system_allocations, after.num_system_allocations);
+  EXPECT_EQ(before.num_recycled_allocations + 10,
+            after.num_recycled_allocations);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -16,14 +16,15 @@ ByteQueue::ByteQueue()
     : buffer_(new uint8_t[kDefaultQueueSize]),
       size_(kDefaultQueueSize),
       offset_(0),
-      used_(0) {
-}
+      used_(0),
+      memory_charge_(MemoryComponent::kParserQueue) {}
 
 ByteQueue::~ByteQueue() {}
 
 void ByteQueue::Reset() {
   offset_ = 0;
   used_ = 0;
+  memory_charge_.ReleaseAll();
 }
 
 void ByteQueue::Push(const uint8_t* data, int size) {
@@ -58,6 +59,7 @@ void ByteQueue::Push(const uint8_t* data, int size) {
 
   memcpy(front() + used_, data, size);
   used_ += size;
+  memory_charge_.Charge(size);
 }
 
 void ByteQueue::Peek(const uint8_t** data, int* size) const {
@@ -72,6 +74,7 @@ void ByteQueue::Pop(int count) {
 
   offset_ += count;
   used_ -= count;
+  memory_charge_.Release(count);
 
   // Move the offset back to 0 if we have reached the end of the buffer.
   if (offset_ == size_) {
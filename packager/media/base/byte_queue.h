@@ -10,6 +10,7 @@
 #include <memory>
 
 #include "packager/base/macros.h"
+#include "packager/file/memory_accountant.h"
 
 namespace shaka {
 namespace media {
@@ -53,6 +54,9 @@ class ByteQueue {
   // Number of bytes stored in the queue.
   int used_;
 
+  // Memory held by the bytes stored in the queue.
+  MemoryCharge memory_charge_;
+
   DISALLOW_COPY_AND_ASSIGN(ByteQueue);
 };
 
@@ -1736,6 +1736,12 @@ MediaContainerName DetermineContainerFromFormatName(
   } else if (base::EqualsCaseInsensitiveASCII(format_name, "ts") ||
              base::EqualsCaseInsensitiveASCII(format_name, "mpeg2ts")) {
     return CONTAINER_MPEG2TS;
+  } else if (base::EqualsCaseInsensitiveASCII(format_name, "aac")) {
+    return CONTAINER_AAC;
+  } else if (base::EqualsCaseInsensitiveASCII(format_name, "ac3")) {
+    return CONTAINER_AC3;
+  } else if (base::EqualsCaseInsensitiveASCII(format_name, "ec3")) {
+    return CONTAINER_EAC3;
   }
   return CONTAINER_UNKNOWN;
 }
@@ -1755,6 +1761,15 @@ MediaContainerName DetermineContainerFromFileName(
   } else if (base::EndsWith(file_name, ".ts",
                             base::CompareCase::INSENSITIVE_ASCII)) {
     return CONTAINER_MPEG2TS;
+  } else if (base::EndsWith(file_name, ".aac",
+                            base::CompareCase::INSENSITIVE_ASCII)) {
+    return CONTAINER_AAC;
+  } else if (base::EndsWith(file_name, ".ac3",
+                            base::CompareCase::INSENSITIVE_ASCII)) {
+    return CONTAINER_AC3;
+  } else if (base::EndsWith(file_name, ".ec3",
+                            base::CompareCase::INSENSITIVE_ASCII)) {
+    return CONTAINER_EAC3;
   } else if (base::EndsWith(file_name, ".vtt",
                             base::CompareCase::INSENSITIVE_ASCII)) {
     return CONTAINER_WEBVTT;
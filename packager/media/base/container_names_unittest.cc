@@ -93,6 +93,9 @@ TEST(ContainerNamesTest, FromFormatName) {
   EXPECT_EQ(CONTAINER_MOV, DetermineContainerFromFormatName("Mp4"));
   EXPECT_EQ(CONTAINER_MPEG2TS, DetermineContainerFromFormatName("ts"));
   EXPECT_EQ(CONTAINER_MPEG2TS, DetermineContainerFromFormatName("mpeg2ts"));
+  EXPECT_EQ(CONTAINER_AAC, DetermineContainerFromFormatName("aac"));
+  EXPECT_EQ(CONTAINER_AC3, DetermineContainerFromFormatName("AC3"));
+  EXPECT_EQ(CONTAINER_EAC3, DetermineContainerFromFormatName("ec3"));
   EXPECT_EQ(CONTAINER_UNKNOWN, DetermineContainerFromFormatName("cat"));
   EXPECT_EQ(CONTAINER_UNKNOWN, DetermineContainerFromFormatName("amp4"));
   EXPECT_EQ(CONTAINER_UNKNOWN, DetermineContainerFromFormatName(" mp4"));
@@ -109,6 +112,9 @@ TEST(ContainerNamesTest, FromFileName) {
   EXPECT_EQ(CONTAINER_MOV, DetermineContainerFromFileName("foo.bar.MP4"));
   EXPECT_EQ(CONTAINER_MPEG2TS, DetermineContainerFromFileName("a.ts"));
   EXPECT_EQ(CONTAINER_MPEG2TS, DetermineContainerFromFileName("a.TS"));
+  EXPECT_EQ(CONTAINER_AAC, DetermineContainerFromFileName("a_$Number$.aac"));
+  EXPECT_EQ(CONTAINER_AC3, DetermineContainerFromFileName("a.ac3"));
+  EXPECT_EQ(CONTAINER_EAC3, DetermineContainerFromFileName("a.EC3"));
   EXPECT_EQ(CONTAINER_UNKNOWN, DetermineContainerFromFileName("a_bad.gif"));
   EXPECT_EQ(CONTAINER_UNKNOWN, DetermineContainerFromFileName("a bad.m4v-"));
   EXPECT_EQ(CONTAINER_UNKNOWN, DetermineContainerFromFileName("a.m4v."));
@@ -21,22 +21,6 @@ const char kSoapActionHeader[] =
     "AcquirePackagingData\"";
 const char kXmlContentTypeHeader[] = "Content-Type: text/xml; charset=UTF-8";
 
-// Scoped CURL implementation which cleans up itself when goes out of scope.
-class ScopedCurl {
- public:
-  ScopedCurl() { ptr_ = curl_easy_init(); }
-  ~ScopedCurl() {
-    if (ptr_)
-      curl_easy_cleanup(ptr_);
-  }
-
-  CURL* get() { return ptr_; }
-
- private:
-  CURL* ptr_;
-  DISALLOW_COPY_AND_ASSIGN(ScopedCurl);
-};
-
 size_t AppendToString(char* ptr, size_t size, size_t nmemb, std::string* response) {
   DCHECK(ptr);
   DCHECK(response);
@@ -79,7 +63,10 @@ HttpKeyFetcher::HttpKeyFetcher() : timeout_in_seconds_(0) {}
 HttpKeyFetcher::HttpKeyFetcher(uint32_t timeout_in_seconds)
     : timeout_in_seconds_(timeout_in_seconds) {}
 
-HttpKeyFetcher::~HttpKeyFetcher() {}
+HttpKeyFetcher::~HttpKeyFetcher() {
+  if (curl_)
+    curl_easy_cleanup(curl_);
+}
 
 Status HttpKeyFetcher::FetchKeys(const std::string& url,
                                  const std::string& request,
@@ -104,12 +91,19 @@ Status HttpKeyFetcher::FetchInternal(HttpMethod method,
   DCHECK(method == GET || method == POST);
   static LibCurlInitializer lib_curl_initializer;
 
-  ScopedCurl scoped_curl;
-  CURL* curl = scoped_curl.get();
-  if (!curl) {
-    LOG(ERROR) << "curl_easy_init() failed.";
-    return Status(error::HTTP_FAILURE, "curl_easy_init() failed.");
+  base::AutoLock auto_lock(lock_);
+  if (curl_) {
+    // Resetting the options keeps the connection cache, so the connection is
+    // re-used if the server allows it.
+    curl_easy_reset(curl_);
+  } else {
+    curl_ = curl_easy_init();
+    if (!curl_) {
+      LOG(ERROR) << "curl_easy_init() failed.";
+      return Status(error::HTTP_FAILURE, "curl_easy_init() failed.");
+    }
   }
+  CURL* curl = curl_;
   response->clear();
 
   curl_easy_setopt(curl, CURLOPT_URL, path.c_str());
@@ -138,18 +132,19 @@ Status HttpKeyFetcher::FetchInternal(HttpMethod method,
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
     curl_easy_setopt(curl, CURLOPT_CAINFO, ca_file_.data());
   }
+  struct curl_slist* headers = NULL;
   if (method == POST) {
     curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
     curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, data.size());
     if (data.find("soap:Envelope") > 0) {
       // Adds Http headers for SOAP requests.
-      struct curl_slist *chunk = NULL;
-      chunk = curl_slist_append(chunk, kXmlContentTypeHeader);
-      chunk = curl_slist_append(chunk, kSoapActionHeader);
-      curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
+      headers = curl_slist_append(headers, kXmlContentTypeHeader);
+      headers = curl_slist_append(headers, kSoapActionHeader);
+      curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     }
   }
   CURLcode res = curl_easy_perform(curl);
+  curl_slist_free_all(headers);
   if (res != CURLE_OK) {
     std::string error_message = base::StringPrintf(
         "curl_easy_perform() failed: %s.", curl_easy_strerror(res));
@@ -12,13 +12,18 @@
 #define PACKAGER_MEDIA_BASE_HTTP_KEY_FETCHER_H_
 
 #include "packager/base/compiler_specific.h"
+#include "packager/base/synchronization/lock.h"
 #include "packager/media/base/key_fetcher.h"
 #include "packager/status.h"
 
+typedef void CURL;
+
 namespace shaka {
 namespace media {
 
 /// A KeyFetcher implementation that retrieves keys over HTTP(s).
+/// The connection to the server is kept alive and re-used by subsequent
+/// requests from the same fetcher, e.g. key rotation requests.
 /// This class is not fully thread safe. It can be used in multi-thread
 /// environment once constructed, but it may not be safe to create a
 /// HttpKeyFetcher object when any other thread is running due to use of
@@ -88,6 +93,10 @@ class HttpKeyFetcher : public KeyFetcher {
   std::string client_cert_private_key_file_;
   std::string client_cert_private_key_password_;
 
+  // Requests are serialized on the handle, which owns the live connection.
+  base::Lock lock_;
+  CURL* curl_ = nullptr;
+
   DISALLOW_COPY_AND_ASSIGN(HttpKeyFetcher);
 };
 
@@ -0,0 +1,72 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/id3_tag.h"
+
+#include "packager/base/logging.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/base/fourccs.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint8_t kID3v2Identifier[] = {'I', 'D', '3'};
+const uint16_t kID3v2Version = 0x0400;  // id3v2.4.0
+// Sizes in ID3v2.4 are "synchsafe" integers, i.e. 28 bits spread over 4 bytes
+// with the most significant bit of each byte cleared.
+const uint32_t kMaxSynchsafeSize = 0x0FFFFFFF;
+
+void WriteSynchsafeInteger(uint32_t size, BufferWriter* buffer_writer) {
+  DCHECK_LE(size, kMaxSynchsafeSize);
+  buffer_writer->AppendInt(static_cast<uint8_t>((size >> 21) & 0x7F));
+  buffer_writer->AppendInt(static_cast<uint8_t>((size >> 14) & 0x7F));
+  buffer_writer->AppendInt(static_cast<uint8_t>((size >> 7) & 0x7F));
+  buffer_writer->AppendInt(static_cast<uint8_t>(size & 0x7F));
+}
+
+void WritePrivateFrame(const std::string& owner,
+                       const std::string& data,
+                       BufferWriter* buffer_writer) {
+  buffer_writer->AppendInt(static_cast<uint32_t>(FOURCC_PRIV));
+
+  // Owner identifier is a null terminated string.
+  const uint32_t frame_size = owner.size() + 1 + data.size();
+  WriteSynchsafeInteger(frame_size, buffer_writer);
+  buffer_writer->AppendInt(static_cast<uint16_t>(0));  // frame flags.
+
+  buffer_writer->AppendArray(reinterpret_cast<const uint8_t*>(owner.data()),
+                             owner.size() + 1);
+  buffer_writer->AppendArray(reinterpret_cast<const uint8_t*>(data.data()),
+                             data.size());
+}
+
+}  // namespace
+
+void Id3Tag::AddPrivateFrame(const std::string& owner,
+                             const std::string& data) {
+  private_frames_.push_back({owner, data});
+}
+
+bool Id3Tag::WriteToBuffer(BufferWriter* buffer_writer) {
+  BufferWriter frames;
+  for (const PrivateFrame& private_frame : private_frames_)
+    WritePrivateFrame(private_frame.owner, private_frame.data, &frames);
+  if (frames.Size() > kMaxSynchsafeSize) {
+    LOG(ERROR) << "ID3 tag of size " << frames.Size() << " is too large.";
+    return false;
+  }
+
+  buffer_writer->AppendArray(kID3v2Identifier, sizeof(kID3v2Identifier));
+  buffer_writer->AppendInt(kID3v2Version);
+  buffer_writer->AppendInt(static_cast<uint8_t>(0));  // flags.
+  WriteSynchsafeInteger(frames.Size(), buffer_writer);
+  buffer_writer->AppendBuffer(frames);
+  return true;
+}
+
+}  // namespace media
+}  // namespace shaka
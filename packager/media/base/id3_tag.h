@@ -0,0 +1,52 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_ID3_TAG_H_
+#define PACKAGER_MEDIA_BASE_ID3_TAG_H_
+
+#include <string>
+#include <vector>
+
+#include "packager/base/macros.h"
+
+namespace shaka {
+namespace media {
+
+class BufferWriter;
+
+/// Implements ID3 tag defined in: http://id3.org/.
+/// Only PRIV frames are supported for now.
+class Id3Tag {
+ public:
+  Id3Tag() = default;
+  virtual ~Id3Tag() = default;
+
+  /// Add a "Private Frame".
+  /// See http://id3.org/id3v2.4.0-frames 4.27.
+  /// @param owner contains the owner identifier.
+  /// @param data contains the private data.
+  virtual void AddPrivateFrame(const std::string& owner,
+                               const std::string& data);
+
+  /// Write the ID3 tag to a buffer.
+  /// @param buffer_writer points to the @a BufferWriter to write to.
+  /// @return true on success.
+  virtual bool WriteToBuffer(BufferWriter* buffer_writer);
+
+ private:
+  struct PrivateFrame {
+    std::string owner;
+    std::string data;
+  };
+  std::vector<PrivateFrame> private_frames_;
+
+  DISALLOW_COPY_AND_ASSIGN(Id3Tag);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_ID3_TAG_H_
@@ -0,0 +1,60 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/id3_tag.h"
+
+#include <gtest/gtest.h>
+
+#include "packager/media/base/buffer_writer.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+std::vector<uint8_t> ToVector(const BufferWriter& buffer) {
+  return std::vector<uint8_t>(buffer.Buffer(), buffer.Buffer() + buffer.Size());
+}
+
+}  // namespace
+
+TEST(Id3TagTest, WriteEmptyTag) {
+  Id3Tag id3_tag;
+  BufferWriter buffer_writer;
+  ASSERT_TRUE(id3_tag.WriteToBuffer(&buffer_writer));
+
+  const uint8_t kExpectedOutput[] = {
+      'I', 'D', '3', 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  };
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kExpectedOutput),
+                                 std::end(kExpectedOutput)),
+            ToVector(buffer_writer));
+}
+
+TEST(Id3TagTest, WritePrivateFrames) {
+  Id3Tag id3_tag;
+  id3_tag.AddPrivateFrame("testing.owner", "data");
+  id3_tag.AddPrivateFrame("x", std::string(128, 'y'));
+  BufferWriter buffer_writer;
+  ASSERT_TRUE(id3_tag.WriteToBuffer(&buffer_writer));
+
+  std::vector<uint8_t> expected_output = {
+      'I', 'D', '3', 0x04, 0x00, 0x00,
+      // Synchsafe size: 28 + 140 = 168 = 0x01 << 7 | 0x28.
+      0x00, 0x00, 0x01, 0x28,
+      // First frame.
+      'P', 'R', 'I', 'V', 0x00, 0x00, 0x00, 0x12, 0x00, 0x00,
+      't', 'e', 's', 't', 'i', 'n', 'g', '.', 'o', 'w', 'n', 'e', 'r', 0x00,
+      'd', 'a', 't', 'a',
+      // Second frame, with a synchsafe size of 130 = 0x01 << 7 | 0x02.
+      'P', 'R', 'I', 'V', 0x00, 0x00, 0x01, 0x02, 0x00, 0x00,
+      'x', 0x00,
+  };
+  expected_output.insert(expected_output.end(), 128, 'y');
+  EXPECT_EQ(expected_output, ToVector(buffer_writer));
+}
+
+}  // namespace media
+}  // namespace shaka
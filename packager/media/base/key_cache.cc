@@ -0,0 +1,168 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/key_cache.h"
+
+#include <openssl/sha.h>
+
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/file/file.h"
+#include "packager/media/base/aes_decryptor.h"
+#include "packager/media/base/aes_encryptor.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kEntryFileExtension[] = ".keycache";
+const size_t kEntryIvSize = 16;
+
+std::string ComputeDigest(const std::string& key) {
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const uint8_t*>(key.data()), key.size(), digest);
+  return std::string(digest, digest + sizeof(digest));
+}
+
+bool IsEncryptionKeySizeValid(size_t size) {
+  return size == 16 || size == 32;
+}
+
+// Shared caches, indexed by directory. Leaked on purpose so the caches
+// survive until the process exits.
+struct SharedCaches {
+  base::Lock lock;
+  std::map<std::string, std::shared_ptr<KeyCache>> caches;
+  std::map<std::string, std::vector<uint8_t>> encryption_keys;
+};
+
+SharedCaches* GetSharedCaches() {
+  static SharedCaches* shared_caches = new SharedCaches;
+  return shared_caches;
+}
+
+}  // namespace
+
+KeyCache::KeyCache(const std::string& directory,
+                   const std::vector<uint8_t>& encryption_key)
+    : directory_(directory), encryption_key_(encryption_key) {
+  DCHECK(directory_.empty() ||
+         IsEncryptionKeySizeValid(encryption_key_.size()));
+}
+
+KeyCache::~KeyCache() {}
+
+std::shared_ptr<KeyCache> KeyCache::GetSharedCache(
+    const std::string& directory,
+    const std::vector<uint8_t>& encryption_key) {
+  if (!directory.empty() && !IsEncryptionKeySizeValid(encryption_key.size())) {
+    LOG(ERROR) << "Invalid key cache encryption key size "
+               << encryption_key.size() << ". Expecting 16 or 32 bytes.";
+    return nullptr;
+  }
+
+  SharedCaches* shared_caches = GetSharedCaches();
+  base::AutoLock auto_lock(shared_caches->lock);
+  std::shared_ptr<KeyCache>& cache = shared_caches->caches[directory];
+  if (!cache) {
+    cache.reset(new KeyCache(directory, encryption_key));
+    shared_caches->encryption_keys[directory] = encryption_key;
+  } else if (!directory.empty() &&
+             shared_caches->encryption_keys[directory] != encryption_key) {
+    LOG(ERROR) << "Key cache directory '" << directory
+               << "' is already in use with a different encryption key.";
+    return nullptr;
+  }
+  return cache;
+}
+
+bool KeyCache::Get(const std::string& key, std::string* value) {
+  DCHECK(value);
+  const std::string digest = ComputeDigest(key);
+  {
+    base::AutoLock auto_lock(lock_);
+    auto iter = entries_.find(digest);
+    if (iter != entries_.end()) {
+      *value = iter->second;
+      return true;
+    }
+  }
+  if (directory_.empty() || !ReadEntry(digest, value))
+    return false;
+
+  base::AutoLock auto_lock(lock_);
+  entries_[digest] = *value;
+  return true;
+}
+
+void KeyCache::Put(const std::string& key, const std::string& value) {
+  const std::string digest = ComputeDigest(key);
+  {
+    base::AutoLock auto_lock(lock_);
+    entries_[digest] = value;
+  }
+  // A failure to persist the entry is not fatal. It is fetched from the key
+  // server again next time.
+  if (!directory_.empty() && !WriteEntry(digest, value))
+    LOG(WARNING) << "Failed to write key cache entry to " << directory_;
+}
+
+std::string KeyCache::GetEntryPath(const std::string& digest) const {
+  std::string path = directory_;
+  if (path.back() != '/')
+    path += '/';
+  return path + base::HexEncode(digest.data(), digest.size()) +
+         kEntryFileExtension;
+}
+
+bool KeyCache::ReadEntry(const std::string& digest, std::string* value) const {
+  std::string entry;
+  if (!File::ReadFileToString(GetEntryPath(digest).c_str(), &entry))
+    return false;
+  if (entry.size() < kEntryIvSize) {
+    LOG(WARNING) << "Ignoring truncated key cache entry.";
+    return false;
+  }
+
+  // An entry is made of the IV followed by the encrypted digest and value.
+  const std::vector<uint8_t> iv(entry.begin(), entry.begin() + kEntryIvSize);
+  AesCbcDecryptor decryptor(kPkcs5Padding, AesCryptor::kUseConstantIv);
+  std::string decrypted;
+  if (!decryptor.InitializeWithIv(encryption_key_, iv) ||
+      !decryptor.Crypt(entry.substr(kEntryIvSize), &decrypted)) {
+    LOG(WARNING) << "Failed to decrypt key cache entry.";
+    return false;
+  }
+  // The digest guards against a wrong encryption key or a corrupted entry.
+  if (decrypted.compare(0, digest.size(), digest) != 0) {
+    LOG(WARNING) << "Ignoring key cache entry with mismatched digest.";
+    return false;
+  }
+  value->assign(decrypted, digest.size(), std::string::npos);
+  return true;
+}
+
+bool KeyCache::WriteEntry(const std::string& digest,
+                          const std::string& value) const {
+  // cbc1 IVs are 16 bytes.
+  std::vector<uint8_t> iv;
+  if (!AesCryptor::GenerateRandomIv(FOURCC_cbc1, &iv))
+    return false;
+  DCHECK_EQ(kEntryIvSize, iv.size());
+
+  AesCbcEncryptor encryptor(kPkcs5Padding, AesCryptor::kUseConstantIv);
+  std::string encrypted;
+  if (!encryptor.InitializeWithIv(encryption_key_, iv) ||
+      !encryptor.Crypt(digest + value, &encrypted)) {
+    return false;
+  }
+  return File::WriteFileAtomically(GetEntryPath(digest).c_str(),
+                                   std::string(iv.begin(), iv.end()) +
+                                       encrypted);
+}
+
+}  // namespace media
+}  // namespace shaka
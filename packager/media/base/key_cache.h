@@ -0,0 +1,76 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_KEY_CACHE_H_
+#define PACKAGER_MEDIA_BASE_KEY_CACHE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/lock.h"
+
+namespace shaka {
+namespace media {
+
+/// KeyCache caches key server responses, so packaging the same content again
+/// does not need another round trip to the key server. Entries are kept in
+/// memory and can optionally be persisted to a directory, in which case they
+/// are encrypted with AES-CBC so keys are never stored in the clear.
+/// This class is thread safe.
+class KeyCache {
+ public:
+  /// @param directory is where the entries are persisted. Any File path prefix
+  ///        is supported. Entries are only kept in memory if it is empty.
+  /// @param encryption_key is the 16 or 32 byte AES key used to encrypt the
+  ///        persisted entries. Ignored if @a directory is empty.
+  KeyCache(const std::string& directory,
+           const std::vector<uint8_t>& encryption_key);
+  ~KeyCache();
+
+  /// Get the cache shared by all key sources in this process for
+  /// @a directory. The cache lives until the process exits.
+  /// @return the shared cache, or nullptr if the parameters are invalid or
+  ///         conflict with the existing cache for @a directory.
+  static std::shared_ptr<KeyCache> GetSharedCache(
+      const std::string& directory,
+      const std::vector<uint8_t>& encryption_key);
+
+  /// Look up an entry, first in memory, then in the cache directory.
+  /// @param key identifies the entry, e.g. the key server url and request.
+  /// @param[out] value will contain the cached value on success.
+  /// @return true if found, false otherwise.
+  bool Get(const std::string& key, std::string* value);
+
+  /// Add or replace an entry.
+  /// @param key identifies the entry.
+  /// @param value is the value to be cached.
+  void Put(const std::string& key, const std::string& value);
+
+ private:
+  // Returns the path of the persisted entry for |digest|.
+  std::string GetEntryPath(const std::string& digest) const;
+  bool ReadEntry(const std::string& digest, std::string* value) const;
+  bool WriteEntry(const std::string& digest, const std::string& value) const;
+
+  const std::string directory_;
+  const std::vector<uint8_t> encryption_key_;
+
+  base::Lock lock_;
+  // Entries indexed by the SHA-256 digest of the key. Protected by |lock_|.
+  std::map<std::string, std::string> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(KeyCache);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_KEY_CACHE_H_
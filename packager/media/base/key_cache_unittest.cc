@@ -0,0 +1,81 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/media/base/key_cache.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+const char kCacheDirectory[] = "memory://key_cache/";
+const char kKey[] = "https://license.test\n{\"content_id\":\"Y29udGVudA==\"}";
+const char kValue[] = "{\"status\":\"OK\",\"tracks\":[]}";
+const uint8_t kEncryptionKey[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+                                  0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+                                  0x0c, 0x0d, 0x0e, 0x0f};
+const uint8_t kAnotherEncryptionKey[] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15,
+                                         0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b,
+                                         0x1c, 0x1d, 0x1e, 0x1f};
+}  // namespace
+
+class KeyCacheTest : public testing::Test {
+ public:
+  KeyCacheTest()
+      : encryption_key_(std::begin(kEncryptionKey), std::end(kEncryptionKey)),
+        another_encryption_key_(std::begin(kAnotherEncryptionKey),
+                                std::end(kAnotherEncryptionKey)) {}
+
+ protected:
+  std::vector<uint8_t> encryption_key_;
+  std::vector<uint8_t> another_encryption_key_;
+};
+
+TEST_F(KeyCacheTest, InMemory) {
+  KeyCache key_cache("", std::vector<uint8_t>());
+  std::string value;
+  EXPECT_FALSE(key_cache.Get(kKey, &value));
+  key_cache.Put(kKey, kValue);
+  ASSERT_TRUE(key_cache.Get(kKey, &value));
+  EXPECT_EQ(kValue, value);
+  EXPECT_FALSE(key_cache.Get(std::string(kKey) + "2", &value));
+}
+
+TEST_F(KeyCacheTest, PersistedAcrossInstances) {
+  KeyCache(kCacheDirectory, encryption_key_).Put(kKey, kValue);
+
+  KeyCache key_cache(kCacheDirectory, encryption_key_);
+  std::string value;
+  ASSERT_TRUE(key_cache.Get(kKey, &value));
+  EXPECT_EQ(kValue, value);
+}
+
+TEST_F(KeyCacheTest, PersistedEntryWithWrongEncryptionKey) {
+  KeyCache(kCacheDirectory, encryption_key_).Put(kKey, kValue);
+
+  KeyCache wrong_key_cache(kCacheDirectory, another_encryption_key_);
+  std::string value;
+  EXPECT_FALSE(wrong_key_cache.Get(kKey, &value));
+}
+
+TEST_F(KeyCacheTest, SharedCache) {
+  std::shared_ptr<KeyCache> key_cache =
+      KeyCache::GetSharedCache("", std::vector<uint8_t>());
+  ASSERT_TRUE(key_cache);
+  EXPECT_EQ(key_cache, KeyCache::GetSharedCache("", std::vector<uint8_t>()));
+
+  EXPECT_TRUE(KeyCache::GetSharedCache(kCacheDirectory, encryption_key_));
+  // Conflicting encryption key.
+  EXPECT_FALSE(
+      KeyCache::GetSharedCache(kCacheDirectory, another_encryption_key_));
+  // Invalid encryption key.
+  EXPECT_FALSE(KeyCache::GetSharedCache("memory://another_key_cache/",
+                                        std::vector<uint8_t>(15)));
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,173 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/latency_tracer.h"
+
+#include <algorithm>
+
+#include "packager/base/json/json_writer.h"
+#include "packager/base/logging.h"
+#include "packager/base/values.h"
+#include "packager/file/file.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+
+const int64_t kMicrosecondsPerMillisecond = 1000;
+
+double ToMilliseconds(int64_t microseconds) {
+  return static_cast<double>(microseconds) / kMicrosecondsPerMillisecond;
+}
+
+const char* IntervalName(LatencyTracer::Interval interval) {
+  switch (interval) {
+    case LatencyTracer::Interval::kIngestToClosed:
+      return "ingest_to_closed";
+    case LatencyTracer::Interval::kClosedToFlushed:
+      return "closed_to_flushed";
+    case LatencyTracer::Interval::kFlushedToPublished:
+      return "flushed_to_published";
+    case LatencyTracer::Interval::kIngestToPublished:
+      return "ingest_to_published";
+    case LatencyTracer::Interval::kNumIntervals:
+      break;
+  }
+  NOTREACHED();
+  return "unknown";
+}
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : bucket_counts_(BucketUpperBounds().size() + 1) {}
+
+LatencyHistogram::~LatencyHistogram() {}
+
+void LatencyHistogram::Add(int64_t latency) {
+  latency = std::max(latency, static_cast<int64_t>(0));
+  min_ = count_ == 0 ? latency : std::min(min_, latency);
+  max_ = std::max(max_, latency);
+  sum_ += latency;
+  ++count_;
+
+  const std::vector<int64_t>& upper_bounds = BucketUpperBounds();
+  const size_t bucket =
+      std::lower_bound(upper_bounds.begin(), upper_bounds.end(), latency) -
+      upper_bounds.begin();
+  ++bucket_counts_[bucket];
+}
+
+const std::vector<int64_t>& LatencyHistogram::BucketUpperBounds() {
+  // In microseconds. Intentionally leaked.
+  static const std::vector<int64_t>* upper_bounds = new std::vector<int64_t>{
+      10000,   20000,   50000,   100000,   200000,   500000,
+      1000000, 2000000, 5000000, 10000000, 20000000, 60000000};
+  return *upper_bounds;
+}
+
+base::DictionaryValue* LatencyHistogram::ToValue() const {
+  base::DictionaryValue* value = new base::DictionaryValue;
+  value->SetInteger("count", static_cast<int>(count_));
+  value->SetDouble("min_ms", ToMilliseconds(min_));
+  value->SetDouble("max_ms", ToMilliseconds(max_));
+  value->SetDouble("mean_ms",
+                   count_ == 0 ? 0 : ToMilliseconds(sum_) / count_);
+
+  const std::vector<int64_t>& upper_bounds = BucketUpperBounds();
+  base::ListValue* buckets = new base::ListValue;
+  for (size_t i = 0; i < bucket_counts_.size(); ++i) {
+    base::DictionaryValue* bucket = new base::DictionaryValue;
+    // The last bucket has no upper bound.
+    if (i < upper_bounds.size())
+      bucket->SetDouble("upper_bound_ms", ToMilliseconds(upper_bounds[i]));
+    bucket->SetInteger("count", static_cast<int>(bucket_counts_[i]));
+    buckets->Append(bucket);
+  }
+  value->Set("buckets", buckets);
+  return value;
+}
+
+LatencyTracer::LatencyTracer(const std::string& output_file,
+                             int64_t flush_interval)
+    : output_file_(output_file), flush_interval_(flush_interval) {}
+
+LatencyTracer::~LatencyTracer() {}
+
+int64_t LatencyTracer::Now() {
+  return (base::Time::Now() - base::Time::UnixEpoch()).InMicroseconds();
+}
+
+void LatencyTracer::AddSegment(const SegmentTimes& times) {
+  DCHECK_GT(times.ingest_time, 0);
+  base::AutoLock auto_lock(lock_);
+  histograms_[static_cast<size_t>(Interval::kIngestToClosed)].Add(
+      times.closed_time - times.ingest_time);
+  histograms_[static_cast<size_t>(Interval::kClosedToFlushed)].Add(
+      times.flushed_time - times.closed_time);
+  if (times.published_time == 0)
+    return;
+  histograms_[static_cast<size_t>(Interval::kFlushedToPublished)].Add(
+      times.published_time - times.flushed_time);
+  histograms_[static_cast<size_t>(Interval::kIngestToPublished)].Add(
+      times.published_time - times.ingest_time);
+}
+
+LatencyHistogram LatencyTracer::GetHistogram(Interval interval) {
+  DCHECK_LT(static_cast<size_t>(interval),
+            static_cast<size_t>(Interval::kNumIntervals));
+  base::AutoLock auto_lock(lock_);
+  return histograms_[static_cast<size_t>(interval)];
+}
+
+std::string LatencyTracer::ToJson() {
+  base::DictionaryValue root;
+  {
+    base::AutoLock auto_lock(lock_);
+    for (size_t i = 0; i < arraysize(histograms_); ++i) {
+      root.Set(IntervalName(static_cast<Interval>(i)),
+               histograms_[i].ToValue());
+    }
+  }
+  std::string json;
+  if (!base::JSONWriter::Write(root, &json))
+    LOG(ERROR) << "Failed to write latency histograms to JSON.";
+  return json;
+}
+
+bool LatencyTracer::Flush() {
+  if (output_file_.empty())
+    return true;
+  // Serialize the writes, which may come from different muxer threads, so
+  // that a newer trace is never overwritten by an older one.
+  base::AutoLock auto_lock(write_lock_);
+  const std::string json = ToJson();
+  if (!File::WriteFileAtomically(output_file_.c_str(), json)) {
+    LOG(ERROR) << "Failed to write latency trace to " << output_file_;
+    return false;
+  }
+  return true;
+}
+
+bool LatencyTracer::MaybeFlush() {
+  if (output_file_.empty())
+    return true;
+  {
+    base::AutoLock auto_lock(lock_);
+    const base::TimeTicks now = base::TimeTicks::Now();
+    if (!last_flush_time_.is_null() &&
+        (now - last_flush_time_).InMicroseconds() < flush_interval_) {
+      return true;
+    }
+    // Other threads skip the write until the next interval.
+    last_flush_time_ = now;
+  }
+  return Flush();
+}
+
+}  // namespace media
+}  // namespace shaka
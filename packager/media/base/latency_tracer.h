@@ -0,0 +1,139 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_LATENCY_TRACER_H_
+#define PACKAGER_MEDIA_BASE_LATENCY_TRACER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/time/time.h"
+
+namespace base {
+class DictionaryValue;
+}  // namespace base
+
+namespace shaka {
+namespace media {
+
+/// Histogram of latencies with fixed buckets, from 10ms up to one minute.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+  ~LatencyHistogram();
+
+  /// Add a sample.
+  /// @param latency is the latency in microseconds. Negative latencies, which
+  ///        can be caused by wall clock adjustments, are counted as 0.
+  void Add(int64_t latency);
+
+  /// @return the number of samples.
+  uint64_t count() const { return count_; }
+  /// @return the minimum latency in microseconds, 0 if there are no samples.
+  int64_t min() const { return min_; }
+  /// @return the maximum latency in microseconds, 0 if there are no samples.
+  int64_t max() const { return max_; }
+  /// @return the sum of the latencies in microseconds.
+  int64_t sum() const { return sum_; }
+  /// @return the number of samples in each bucket. The i-th bucket counts the
+  ///         latencies not above the i-th upper bound (and above the previous
+  ///         one). The last bucket counts the latencies above all the bounds.
+  const std::vector<uint64_t>& bucket_counts() const { return bucket_counts_; }
+
+  /// @return the upper bounds of the buckets in microseconds.
+  static const std::vector<int64_t>& BucketUpperBounds();
+
+  /// @return the histogram as a dictionary, with latencies in milliseconds.
+  ///         The caller owns the returned value.
+  base::DictionaryValue* ToValue() const;
+
+ private:
+  uint64_t count_ = 0;
+  int64_t min_ = 0;
+  int64_t max_ = 0;
+  int64_t sum_ = 0;
+  std::vector<uint64_t> bucket_counts_;
+};
+
+/// Collects end to end latencies of live segments, from the ingest of their
+/// first sample to the publication of the manifests that reference them.
+/// Thread safe.
+class LatencyTracer {
+ public:
+  /// Intervals between the stages of a segment.
+  enum class Interval {
+    kIngestToClosed,
+    kClosedToFlushed,
+    kFlushedToPublished,
+    kIngestToPublished,
+    // Not an interval. Must be the last entry.
+    kNumIntervals,
+  };
+
+  /// Wall clock times of the stages of a segment, in microseconds since the
+  /// Unix epoch.
+  struct SegmentTimes {
+    /// Ingest time of the first sample of the segment.
+    int64_t ingest_time = 0;
+    /// Time the segment was closed by the chunker.
+    int64_t closed_time = 0;
+    /// Time the segment file was written.
+    int64_t flushed_time = 0;
+    /// Time the manifests were updated with the segment, 0 if the segment is
+    /// not published in a manifest.
+    int64_t published_time = 0;
+  };
+
+  /// @param output_file is the file the histograms are written to by Flush().
+  ///        Can be empty, in which case Flush() is a no-op.
+  /// @param flush_interval is the minimum interval between the writes of
+  ///        MaybeFlush(), in microseconds.
+  LatencyTracer(const std::string& output_file, int64_t flush_interval);
+  ~LatencyTracer();
+
+  /// @return the current wall clock time in microseconds since the Unix epoch.
+  static int64_t Now();
+
+  /// Record the stage times of a segment.
+  void AddSegment(const SegmentTimes& times);
+
+  /// @return a copy of the histogram of @a interval.
+  LatencyHistogram GetHistogram(Interval interval);
+
+  /// @return the histograms of all intervals in JSON.
+  std::string ToJson();
+
+  /// Write the histograms in JSON to the output file. The file is replaced
+  /// atomically, so it can be polled while packaging.
+  /// @return true on success, false otherwise.
+  bool Flush();
+
+  /// Same as Flush(), but only writes the output file if it has not been
+  /// written by MaybeFlush() in the last flush interval, so that it can be
+  /// called for every segment.
+  /// @return true on success or if nothing is written, false otherwise.
+  bool MaybeFlush();
+
+ private:
+  const std::string output_file_;
+  const int64_t flush_interval_;
+  base::Lock lock_;
+  LatencyHistogram histograms_[static_cast<size_t>(Interval::kNumIntervals)];
+  base::TimeTicks last_flush_time_;
+  // Serializes Flush().
+  base::Lock write_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(LatencyTracer);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_LATENCY_TRACER_H_
@@ -0,0 +1,163 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "packager/base/json/json_reader.h"
+#include "packager/base/values.h"
+#include "packager/file/file.h"
+#include "packager/file/memory_file.h"
+#include "packager/media/base/latency_tracer.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+const int64_t kMs = 1000;
+const int64_t kIngestTime = 1500000000000000;
+const char kNoOutputFile[] = "";
+const char kOutputFile[] = "memory://latency_trace.json";
+const int64_t kNoFlushInterval = 0;
+const int64_t kLongFlushInterval = 3600 * 1000 * kMs;
+
+std::string ReadOutputFile() {
+  std::string contents;
+  EXPECT_TRUE(File::ReadFileToString(kOutputFile, &contents));
+  return contents;
+}
+}  // namespace
+
+TEST(LatencyHistogramTest, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0u, histogram.count());
+  EXPECT_EQ(0, histogram.min());
+  EXPECT_EQ(0, histogram.max());
+  EXPECT_EQ(LatencyHistogram::BucketUpperBounds().size() + 1,
+            histogram.bucket_counts().size());
+}
+
+TEST(LatencyHistogramTest, Buckets) {
+  LatencyHistogram histogram;
+  histogram.Add(5 * kMs);
+  // Bucket upper bounds are inclusive.
+  histogram.Add(10 * kMs);
+  histogram.Add(15 * kMs);
+  histogram.Add(90 * 1000 * kMs);
+  // Negative latencies are counted as 0.
+  histogram.Add(-kMs);
+
+  EXPECT_EQ(5u, histogram.count());
+  EXPECT_EQ(0, histogram.min());
+  EXPECT_EQ(90 * 1000 * kMs, histogram.max());
+  EXPECT_EQ((5 + 10 + 15 + 90 * 1000) * kMs, histogram.sum());
+
+  const std::vector<uint64_t>& counts = histogram.bucket_counts();
+  EXPECT_EQ(3u, counts[0]);
+  EXPECT_EQ(1u, counts[1]);
+  // Latencies above all the bounds.
+  EXPECT_EQ(1u, counts.back());
+}
+
+TEST(LatencyTracerTest, AddSegment) {
+  LatencyTracer tracer(kNoOutputFile, kNoFlushInterval);
+
+  LatencyTracer::SegmentTimes times;
+  times.ingest_time = kIngestTime;
+  times.closed_time = kIngestTime + 100 * kMs;
+  times.flushed_time = kIngestTime + 150 * kMs;
+  times.published_time = kIngestTime + 160 * kMs;
+  tracer.AddSegment(times);
+
+  // Not published in a manifest.
+  times.published_time = 0;
+  tracer.AddSegment(times);
+
+  LatencyHistogram histogram =
+      tracer.GetHistogram(LatencyTracer::Interval::kIngestToClosed);
+  EXPECT_EQ(2u, histogram.count());
+  EXPECT_EQ(100 * kMs, histogram.max());
+
+  histogram = tracer.GetHistogram(LatencyTracer::Interval::kClosedToFlushed);
+  EXPECT_EQ(2u, histogram.count());
+  EXPECT_EQ(50 * kMs, histogram.max());
+
+  histogram = tracer.GetHistogram(LatencyTracer::Interval::kFlushedToPublished);
+  EXPECT_EQ(1u, histogram.count());
+  EXPECT_EQ(10 * kMs, histogram.max());
+
+  histogram = tracer.GetHistogram(LatencyTracer::Interval::kIngestToPublished);
+  EXPECT_EQ(1u, histogram.count());
+  EXPECT_EQ(160 * kMs, histogram.max());
+}
+
+TEST(LatencyTracerTest, ToJson) {
+  LatencyTracer tracer(kNoOutputFile, kNoFlushInterval);
+  LatencyTracer::SegmentTimes times;
+  times.ingest_time = kIngestTime;
+  times.closed_time = kIngestTime + 30 * kMs;
+  times.flushed_time = kIngestTime + 40 * kMs;
+  times.published_time = kIngestTime + 45 * kMs;
+  tracer.AddSegment(times);
+
+  std::unique_ptr<base::Value> root(base::JSONReader::Read(tracer.ToJson()));
+  ASSERT_TRUE(root);
+  const base::DictionaryValue* dict = nullptr;
+  ASSERT_TRUE(root->GetAsDictionary(&dict));
+
+  const base::DictionaryValue* ingest_to_closed = nullptr;
+  ASSERT_TRUE(dict->GetDictionary("ingest_to_closed", &ingest_to_closed));
+  int count = 0;
+  EXPECT_TRUE(ingest_to_closed->GetInteger("count", &count));
+  EXPECT_EQ(1, count);
+  double max_ms = 0;
+  EXPECT_TRUE(ingest_to_closed->GetDouble("max_ms", &max_ms));
+  EXPECT_DOUBLE_EQ(30, max_ms);
+
+  const base::ListValue* buckets = nullptr;
+  ASSERT_TRUE(ingest_to_closed->GetList("buckets", &buckets));
+  EXPECT_EQ(LatencyHistogram::BucketUpperBounds().size() + 1,
+            buckets->GetSize());
+  // 30ms falls in the (20ms, 50ms] bucket.
+  const base::DictionaryValue* bucket = nullptr;
+  ASSERT_TRUE(buckets->GetDictionary(2, &bucket));
+  double upper_bound_ms = 0;
+  EXPECT_TRUE(bucket->GetDouble("upper_bound_ms", &upper_bound_ms));
+  EXPECT_DOUBLE_EQ(50, upper_bound_ms);
+  EXPECT_TRUE(bucket->GetInteger("count", &count));
+  EXPECT_EQ(1, count);
+
+  EXPECT_TRUE(dict->HasKey("closed_to_flushed"));
+  EXPECT_TRUE(dict->HasKey("flushed_to_published"));
+  EXPECT_TRUE(dict->HasKey("ingest_to_published"));
+}
+
+// MaybeFlush() writes the trace at most once per flush interval.
+TEST(LatencyTracerTest, MaybeFlush) {
+  LatencyTracer tracer(kOutputFile, kLongFlushInterval);
+  LatencyTracer::SegmentTimes times;
+  times.ingest_time = kIngestTime;
+  times.closed_time = kIngestTime + 30 * kMs;
+  times.flushed_time = kIngestTime + 40 * kMs;
+  tracer.AddSegment(times);
+  ASSERT_TRUE(tracer.MaybeFlush());
+  const std::string first_trace = ReadOutputFile();
+  EXPECT_EQ(tracer.ToJson(), first_trace);
+
+  tracer.AddSegment(times);
+  ASSERT_TRUE(tracer.MaybeFlush());
+  EXPECT_EQ(first_trace, ReadOutputFile());
+
+  // Flush() always writes.
+  ASSERT_TRUE(tracer.Flush());
+  EXPECT_NE(first_trace, ReadOutputFile());
+  EXPECT_EQ(tracer.ToJson(), ReadOutputFile());
+  MemoryFile::DeleteAll();
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -29,6 +29,8 @@
         'bit_reader.h',
         'bit_writer.cc',
         'bit_writer.h',
+        'buffer_pool.cc',
+        'buffer_pool.h',
         'buffer_reader.cc',
         'buffer_reader.h',
         'buffer_writer.cc',
@@ -47,12 +49,18 @@
         'fourccs.h',
         'http_key_fetcher.cc',
         'http_key_fetcher.h',
+        'id3_tag.cc',
+        'id3_tag.h',
+        'key_cache.cc',
+        'key_cache.h',
         'key_fetcher.cc',
         'key_fetcher.h',
         'key_source.cc',
         'key_source.h',
         'language_utils.cc',
         'language_utils.h',
+        'latency_tracer.cc',
+        'latency_tracer.h',
         'limits.h',
         'macros.h',
         'media_handler.cc',
@@ -101,6 +109,7 @@
       'dependencies': [
         'widevine_pssh_data_proto',
         '../../base/base.gyp:base',
+        '../../file/file.gyp:file',
         '../../packager.gyp:status',
         '../../third_party/boringssl/boringssl.gyp:boringssl',
         '../../third_party/curl/curl.gyp:libcurl',
@@ -141,11 +150,16 @@
         'audio_timestamp_helper_unittest.cc',
         'bit_reader_unittest.cc',
         'bit_writer_unittest.cc',
+        'buffer_pool_unittest.cc',
         'buffer_writer_unittest.cc',
         'closure_thread_unittest.cc',
         'container_names_unittest.cc',
         'decryptor_source_unittest.cc',
         'http_key_fetcher_unittest.cc',
+        'id3_tag_unittest.cc',
+        'key_cache_unittest.cc',
+        'latency_tracer_unittest.cc',
+        'muxer_unittest.cc',
         'muxer_util_unittest.cc',
         'offset_byte_queue_unittest.cc',
         'producer_consumer_queue_unittest.cc',
@@ -164,8 +178,10 @@
         '../../testing/gmock.gyp:gmock',
         '../../testing/gtest.gyp:gtest',
         '../../third_party/boringssl/boringssl.gyp:boringssl',
+        '../event/media_event.gyp:mock_muxer_listener',
         '../test/media_test.gyp:media_test_support',
         'media_base',
+        'media_handler_test_base',
       ],
     },
   ],
@@ -8,6 +8,33 @@
 
 namespace shaka {
 namespace media {
+namespace {
+
+// Maximum number of released StreamData objects kept for re-use.
+const size_t kMaxFreeStreamData = 1024;
+
+BlockRecycler* GetStreamDataRecycler() {
+  static BlockRecycler* recycler =
+      new BlockRecycler(sizeof(StreamData), kMaxFreeStreamData);
+  return recycler;
+}
+
+}  // namespace
+
+void* StreamData::operator new(size_t size) {
+  DCHECK_EQ(sizeof(StreamData), size);
+  return GetStreamDataRecycler()->Allocate();
+}
+
+void StreamData::operator delete(void* ptr, size_t size) {
+  DCHECK_EQ(sizeof(StreamData), size);
+  GetStreamDataRecycler()->Release(ptr);
+}
+
+// static
+AllocationStats StreamData::GetAllocationStats() {
+  return GetStreamDataRecycler()->stats();
+}
 
 Status MediaHandler::SetHandler(size_t output_stream_index,
                                 std::shared_ptr<MediaHandler> handler) {
@@ -11,6 +11,7 @@
 #include <memory>
 #include <utility>
 
+#include "packager/media/base/buffer_pool.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/stream_info.h"
 #include "packager/media/base/text_sample.h"
@@ -59,6 +60,12 @@ struct SegmentInfo {
   // a |key_rotation_encryption_config| even if the segment is not encrypted,
   // which is the case for clear lead.
   std::shared_ptr<EncryptionConfig> key_rotation_encryption_config;
+  // Wall clock times in microseconds since the Unix epoch, used for latency
+  // tracing. |ingest_time| is the ingest time of the first sample in the
+  // segment and |closed_time| is the time the segment was closed. Both are 0
+  // if ingest times are not recorded.
+  int64_t ingest_time = 0;
+  int64_t closed_time = 0;
 };
 
 // TODO(kqyang): Should we use protobuf?
@@ -73,6 +80,13 @@ struct StreamData {
   std::shared_ptr<const Scte35Event> scte35_event;
   std::shared_ptr<const CueEvent> cue_event;
 
+  /// StreamData objects are recycled to reduce the allocation overhead.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
+  /// @return the allocation counters of StreamData objects.
+  static AllocationStats GetAllocationStats();
+
   static std::unique_ptr<StreamData> FromStreamInfo(
       size_t stream_index, std::shared_ptr<const StreamInfo> stream_info) {
     std::unique_ptr<StreamData> stream_data(new StreamData);
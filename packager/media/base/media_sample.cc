@@ -13,6 +13,18 @@
 
 namespace shaka {
 namespace media {
+namespace {
+
+// Maximum number of released MediaSample objects kept for re-use.
+const size_t kMaxFreeMediaSamples = 1024;
+
+BlockRecycler* GetMediaSampleRecycler() {
+  static BlockRecycler* recycler =
+      new BlockRecycler(sizeof(MediaSample), kMaxFreeMediaSamples);
+  return recycler;
+}
+
+}  // namespace
 
 MediaSample::MediaSample(const uint8_t* data,
                          size_t data_size,
@@ -38,6 +50,26 @@ MediaSample::MediaSample() {}
 
 MediaSample::~MediaSample() {}
 
+void* MediaSample::operator new(size_t size) {
+  // Derived classes are not recycled.
+  if (size != sizeof(MediaSample))
+    return ::operator new(size);
+  return GetMediaSampleRecycler()->Allocate();
+}
+
+void MediaSample::operator delete(void* ptr, size_t size) {
+  if (size != sizeof(MediaSample)) {
+    ::operator delete(ptr);
+    return;
+  }
+  GetMediaSampleRecycler()->Release(ptr);
+}
+
+// static
+AllocationStats MediaSample::GetAllocationStats() {
+  return GetMediaSampleRecycler()->stats();
+}
+
 // static
 std::shared_ptr<MediaSample> MediaSample::CopyFrom(const uint8_t* data,
                                                    size_t data_size,
@@ -90,6 +122,7 @@ std::shared_ptr<MediaSample> MediaSample::Clone() const {
   new_media_sample->side_data_ = side_data_;
   new_media_sample->side_data_size_ = side_data_size_;
   new_media_sample->config_id_ = config_id_;
+  new_media_sample->ingest_time_ = ingest_time_;
   if (decrypt_config_) {
     new_media_sample->decrypt_config_.reset(new DecryptConfig(
         decrypt_config_->key_id(), decrypt_config_->iv(),
@@ -106,6 +139,14 @@ void MediaSample::TransferData(std::shared_ptr<uint8_t> data,
   data_size_ = data_size;
 }
 
+uint8_t* MediaSample::writable_data() {
+  DCHECK(!end_of_stream());
+  if (data_.use_count() != 1)
+    return nullptr;
+  // The buffer is allocated non-const by its only owner, this sample.
+  return const_cast<uint8_t*>(data_.get());
+}
+
 void MediaSample::SetData(const uint8_t* data, size_t data_size) {
   std::shared_ptr<uint8_t> shared_data(new uint8_t[data_size],
                                        std::default_delete<uint8_t[]>());
@@ -113,6 +154,15 @@ void MediaSample::SetData(const uint8_t* data, size_t data_size) {
   TransferData(std::move(shared_data), data_size);
 }
 
+void MediaSample::SetData(const uint8_t* data,
+                          size_t data_size,
+                          BufferPool* buffer_pool) {
+  DCHECK(buffer_pool);
+  std::shared_ptr<uint8_t> shared_data = buffer_pool->Allocate(data_size);
+  memcpy(shared_data.get(), data, data_size);
+  TransferData(std::move(shared_data), data_size);
+}
+
 std::string MediaSample::ToString() const {
   if (end_of_stream())
     return "End of stream sample\n";
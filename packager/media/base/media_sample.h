@@ -13,6 +13,7 @@
 #include <vector>
 
 #include "packager/base/logging.h"
+#include "packager/media/base/buffer_pool.h"
 #include "packager/media/base/decrypt_config.h"
 
 namespace shaka {
@@ -64,6 +65,13 @@ class MediaSample {
 
   virtual ~MediaSample();
 
+  /// MediaSample objects are recycled to reduce the allocation overhead.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
+  /// @return the allocation counters of MediaSample objects.
+  static AllocationStats GetAllocationStats();
+
   /// Clone the object and return a new MediaSample.
   std::shared_ptr<MediaSample> Clone() const;
 
@@ -78,6 +86,13 @@ class MediaSample {
   /// @param data_size is the size of the data to be copied.
   void SetData(const uint8_t* data, size_t data_size);
 
+  /// Set the data in this media sample. The data is copied to a buffer from
+  /// @a buffer_pool.
+  /// @param data points to the data to be copied.
+  /// @param data_size is the size of the data to be copied.
+  /// @param buffer_pool is the pool to allocate the buffer from.
+  void SetData(const uint8_t* data, size_t data_size, BufferPool* buffer_pool);
+
   /// @return a human-readable string describing |*this|.
   std::string ToString() const;
 
@@ -124,6 +139,10 @@ class MediaSample {
     return data_size_;
   }
 
+  /// @return a pointer to the sample data that can be modified in place, or
+  ///         nullptr if the data buffer is shared, e.g. with a cloned sample.
+  uint8_t* writable_data();
+
   const uint8_t* side_data() const { return side_data_.get(); }
 
   size_t side_data_size() const { return side_data_size_; }
@@ -150,6 +169,12 @@ class MediaSample {
     config_id_ = config_id;
   }
 
+  /// @return the wall clock time, in microseconds since the Unix epoch, at
+  ///         which the sample data was read from the input, or 0 if it was
+  ///         not recorded. Used for latency tracing.
+  int64_t ingest_time() const { return ingest_time_; }
+  void set_ingest_time(int64_t ingest_time) { ingest_time_ = ingest_time; }
+
  protected:
   // Made it protected to disallow the constructor to be called directly.
   // Create a MediaSample. Buffer will be padded and aligned as necessary.
@@ -187,6 +212,9 @@ class MediaSample {
   // Decrypt configuration.
   std::unique_ptr<DecryptConfig> decrypt_config_;
 
+  // Wall clock ingest time in microseconds, 0 if not recorded.
+  int64_t ingest_time_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(MediaSample);
 };
 
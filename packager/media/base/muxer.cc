@@ -39,13 +39,28 @@ Status Muxer::Process(std::unique_ptr<StreamData> stream_data) {
   switch (stream_data->stream_data_type) {
     case StreamDataType::kStreamInfo:
       streams_.push_back(std::move(stream_data->stream_info));
-      if (muxer_listener_ && streams_.back()->is_encrypted()) {
+      if (streams_.back()->stream_type() == kStreamVideo &&
+          streams_[main_stream_index_]->stream_type() != kStreamVideo) {
+        main_stream_index_ = streams_.size() - 1;
+      }
+      if (streams_.back()->is_encrypted()) {
         const EncryptionConfig& encryption_config =
             streams_.back()->encryption_config();
-        muxer_listener_->OnEncryptionInfoReady(
-            kInitialEncryptionInfo, encryption_config.protection_scheme,
-            encryption_config.key_id, encryption_config.constant_iv,
-            encryption_config.key_system_info);
+        // Streams multiplexed in the output should share the key, since the
+        // listeners describe a single key per output.
+        if (!current_key_id_.empty()) {
+          if (encryption_config.key_id != current_key_id_) {
+            return Status(error::MUXER_FAILURE,
+                          "Streams multiplexed into " +
+                              options_.segment_template +
+                              " are encrypted with different keys.");
+          }
+        } else if (muxer_listener_) {
+          muxer_listener_->OnEncryptionInfoReady(
+              kInitialEncryptionInfo, encryption_config.protection_scheme,
+              encryption_config.key_id, encryption_config.constant_iv,
+              encryption_config.key_system_info);
+        }
         current_key_id_ = encryption_config.key_id;
       }
       return InitializeMuxer();
@@ -54,8 +69,11 @@ Status Muxer::Process(std::unique_ptr<StreamData> stream_data) {
       if (muxer_listener_ && segment_info.is_encrypted) {
         const EncryptionConfig* encryption_config =
             segment_info.key_rotation_encryption_config.get();
-        // Only call OnEncryptionInfoReady again when key updates.
-        if (encryption_config && encryption_config->key_id != current_key_id_) {
+        // Only call OnEncryptionInfoReady again when key updates. The streams
+        // multiplexed in the output rotate their keys together, so only the
+        // main stream is checked.
+        if (encryption_config && encryption_config->key_id != current_key_id_ &&
+            stream_data->stream_index == main_stream_index_) {
           muxer_listener_->OnEncryptionInfoReady(
               !kInitialEncryptionInfo, encryption_config->protection_scheme,
               encryption_config->key_id, encryption_config->constant_iv,
@@ -67,13 +85,20 @@ Status Muxer::Process(std::unique_ptr<StreamData> stream_data) {
           muxer_listener_->OnEncryptionStart();
         }
       }
+      if (muxer_listener_ && !segment_info.is_subsegment &&
+          segment_info.ingest_time > 0 &&
+          stream_data->stream_index == main_stream_index_) {
+        muxer_listener_->OnSegmentClosed(segment_info.ingest_time,
+                                         segment_info.closed_time);
+      }
       return FinalizeSegment(stream_data->stream_index, segment_info);
     }
     case StreamDataType::kMediaSample:
       return AddSample(stream_data->stream_index,
                        *stream_data->media_sample);
     case StreamDataType::kCueEvent:
-      if (muxer_listener_) {
+      if (muxer_listener_ &&
+          stream_data->stream_index == main_stream_index_) {
         muxer_listener_->OnCueEvent(stream_data->cue_event->timestamp,
                                     stream_data->cue_event->cue_data);
       }
@@ -27,6 +27,10 @@ class MediaSample;
 /// Muxer is responsible for taking elementary stream samples and producing
 /// media containers. An optional KeySource can be provided to Muxer
 /// to generate encrypted outputs.
+/// If several streams are multiplexed, the listener events which describe the
+/// whole output, i.e. cue events and closed segments, are fired for the main
+/// stream only. The main stream is the video stream if there is one, and the
+/// first stream otherwise. The encryption info is fired once per key.
 class Muxer : public MediaHandler {
  public:
   explicit Muxer(const MuxerOptions& options);
@@ -90,6 +94,7 @@ class Muxer : public MediaHandler {
 
   MuxerOptions options_;
   std::vector<std::shared_ptr<const StreamInfo>> streams_;
+  size_t main_stream_index_ = 0;
   std::vector<uint8_t> current_key_id_;
   bool encryption_started_ = false;
   bool cancelled_;
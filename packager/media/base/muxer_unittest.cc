@@ -0,0 +1,171 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/muxer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "packager/media/base/media_handler_test_base.h"
+#include "packager/media/event/mock_muxer_listener.h"
+#include "packager/status_test_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+using ::testing::_;
+
+const size_t kInputCount = 2;
+const size_t kOutputCount = 0;
+// The audio input comes first, so the video stream is not stream 0.
+const size_t kAudioInputIndex = 0;
+const size_t kVideoInputIndex = 1;
+// Each input has a single output stream.
+const size_t kStreamIndex = 0;
+const bool kIsSubsegment = true;
+const uint32_t kTimeScale = 1000;
+const int64_t kSegmentDuration = 1000;
+const int64_t kIngestTime = 1500000000000000;
+const int64_t kClosedTime = kIngestTime + 1000;
+const int64_t kCueTimestamp = 1000;
+const bool kInitialEncryptionInfo = true;
+const uint8_t kKeyId[] = {0x01, 0x02, 0x03, 0x04};
+const uint8_t kRotatedKeyId[] = {0x05, 0x06, 0x07, 0x08};
+const uint8_t kOtherKeyId[] = {0x09, 0x0a, 0x0b, 0x0c};
+
+class FakeMuxer : public Muxer {
+ public:
+  explicit FakeMuxer(const MuxerOptions& options) : Muxer(options) {}
+
+ private:
+  Status InitializeMuxer() override { return Status::OK; }
+  Status Finalize() override { return Status::OK; }
+  Status AddSample(size_t stream_id, const MediaSample& sample) override {
+    return Status::OK;
+  }
+  Status FinalizeSegment(size_t stream_id,
+                         const SegmentInfo& segment_info) override {
+    return Status::OK;
+  }
+};
+
+}  // namespace
+
+class MuxerTest : public MediaHandlerTestBase {
+ protected:
+  void SetUp() override {
+    std::unique_ptr<MockMuxerListener> muxer_listener(new MockMuxerListener);
+    muxer_listener_ = muxer_listener.get();
+    std::shared_ptr<Muxer> muxer = std::make_shared<FakeMuxer>(MuxerOptions());
+    muxer->SetMuxerListener(std::move(muxer_listener));
+    ASSERT_OK(SetUpAndInitializeGraph(muxer, kInputCount, kOutputCount));
+  }
+
+  // Dispatches the audio, then the video stream info. The streams are
+  // encrypted with the given keys, or clear if the key is empty.
+  Status DispatchStreamInfos(const std::vector<uint8_t>& audio_key_id,
+                             const std::vector<uint8_t>& video_key_id) {
+    std::unique_ptr<StreamInfo> audio_info = GetAudioStreamInfo(kTimeScale);
+    SetKeyId(audio_key_id, audio_info.get());
+    Status status = Input(kAudioInputIndex)
+                        ->Dispatch(StreamData::FromStreamInfo(
+                            kStreamIndex, std::move(audio_info)));
+    if (!status.ok())
+      return status;
+    std::unique_ptr<StreamInfo> video_info = GetVideoStreamInfo(kTimeScale);
+    SetKeyId(video_key_id, video_info.get());
+    return Input(kVideoInputIndex)
+        ->Dispatch(StreamData::FromStreamInfo(kStreamIndex,
+                                              std::move(video_info)));
+  }
+
+  // Dispatches an encrypted segment of |input_index| with a rotated key.
+  Status DispatchRotatedSegment(size_t input_index,
+                                const std::vector<uint8_t>& key_id) {
+    std::unique_ptr<SegmentInfo> segment_info =
+        GetSegmentInfo(0, kSegmentDuration, !kIsSubsegment);
+    segment_info->is_encrypted = true;
+    segment_info->key_rotation_encryption_config.reset(new EncryptionConfig);
+    segment_info->key_rotation_encryption_config->key_id = key_id;
+    return Input(input_index)
+        ->Dispatch(StreamData::FromSegmentInfo(kStreamIndex,
+                                               std::move(segment_info)));
+  }
+
+  MockMuxerListener* muxer_listener_ = nullptr;
+
+ private:
+  void SetKeyId(const std::vector<uint8_t>& key_id, StreamInfo* stream_info) {
+    if (key_id.empty())
+      return;
+    EncryptionConfig encryption_config;
+    encryption_config.key_id = key_id;
+    stream_info->set_is_encrypted(true);
+    stream_info->set_encryption_config(encryption_config);
+  }
+};
+
+// The events describing the whole output are reported once, for the video
+// stream, when the streams are multiplexed.
+TEST_F(MuxerTest, MultiplexedStreamsReportedOnce) {
+  ASSERT_OK(DispatchStreamInfos(std::vector<uint8_t>(),
+                                std::vector<uint8_t>()));
+
+  EXPECT_CALL(*muxer_listener_, OnSegmentClosed(kIngestTime, kClosedTime));
+  EXPECT_CALL(*muxer_listener_, OnCueEvent(kCueTimestamp, _));
+
+  for (size_t input_index : {kAudioInputIndex, kVideoInputIndex}) {
+    std::unique_ptr<SegmentInfo> segment_info =
+        GetSegmentInfo(0, kSegmentDuration, !kIsSubsegment);
+    segment_info->ingest_time = kIngestTime;
+    // The close time of the audio stream is not reported.
+    segment_info->closed_time =
+        input_index == kVideoInputIndex ? kClosedTime : kClosedTime + 1;
+    ASSERT_OK(Input(input_index)
+                  ->Dispatch(StreamData::FromSegmentInfo(
+                      kStreamIndex, std::move(segment_info))));
+
+    std::shared_ptr<CueEvent> cue_event = std::make_shared<CueEvent>();
+    cue_event->timestamp = kCueTimestamp;
+    ASSERT_OK(Input(input_index)
+                  ->Dispatch(StreamData::FromCueEvent(kStreamIndex,
+                                                      std::move(cue_event))));
+  }
+}
+
+// The multiplexed streams share the key, which is reported once. The rotated
+// keys are reported for the main stream.
+TEST_F(MuxerTest, MultiplexedStreamsShareKey) {
+  const std::vector<uint8_t> key_id(std::begin(kKeyId), std::end(kKeyId));
+  const std::vector<uint8_t> rotated_key_id(std::begin(kRotatedKeyId),
+                                            std::end(kRotatedKeyId));
+  const std::vector<uint8_t> other_key_id(std::begin(kOtherKeyId),
+                                          std::end(kOtherKeyId));
+  EXPECT_CALL(*muxer_listener_,
+              OnEncryptionInfoReady(kInitialEncryptionInfo, _, key_id, _, _));
+  EXPECT_CALL(*muxer_listener_, OnEncryptionInfoReady(!kInitialEncryptionInfo,
+                                                      _, rotated_key_id, _, _));
+  EXPECT_CALL(*muxer_listener_, OnEncryptionStart());
+  ASSERT_OK(DispatchStreamInfos(key_id, key_id));
+
+  ASSERT_OK(DispatchRotatedSegment(kAudioInputIndex, other_key_id));
+  ASSERT_OK(DispatchRotatedSegment(kVideoInputIndex, rotated_key_id));
+  ASSERT_OK(DispatchRotatedSegment(kAudioInputIndex, other_key_id));
+}
+
+TEST_F(MuxerTest, MultiplexedStreamsWithDifferentKeys) {
+  const std::vector<uint8_t> key_id(std::begin(kKeyId), std::end(kKeyId));
+  const std::vector<uint8_t> other_key_id(std::begin(kOtherKeyId),
+                                          std::end(kOtherKeyId));
+  EXPECT_CALL(*muxer_listener_,
+              OnEncryptionInfoReady(kInitialEncryptionInfo, _, key_id, _, _));
+  EXPECT_EQ(error::MUXER_FAILURE,
+            DispatchStreamInfos(key_id, other_key_id).error_code());
+}
+
+}  // namespace media
+}  // namespace shaka
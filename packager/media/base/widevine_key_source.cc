@@ -6,6 +6,7 @@
 
 #include "packager/media/base/widevine_key_source.h"
 
+#include <algorithm>
 #include <set>
 
 #include "packager/base/base64.h"
@@ -13,7 +14,9 @@
 #include "packager/base/json/json_reader.h"
 #include "packager/base/json/json_writer.h"
 #include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/time/default_clock.h"
 #include "packager/media/base/http_key_fetcher.h"
+#include "packager/media/base/key_cache.h"
 #include "packager/media/base/network_util.h"
 #include "packager/media/base/producer_consumer_queue.h"
 #include "packager/media/base/protection_system_specific_info.h"
@@ -43,6 +46,17 @@ const int kFirstRetryDelayMilliseconds = 1000;
 const int kDefaultCryptoPeriodCount = 10;
 const int kGetKeyTimeoutInSeconds = 5 * 60;  // 5 minutes.
 const int kKeyFetchTimeoutInSeconds = 60;  // 1 minute.
+// Maximum number of crypto periods fetched ahead with a key prefetch horizon.
+const int64_t kMaxCryptoPeriodsAhead = 60;
+
+// Exponentially weighted moving average of |sample|. Returns |sample| if
+// |average| is not initialized yet.
+base::TimeDelta UpdateMovingAverage(base::TimeDelta average,
+                                    base::TimeDelta sample) {
+  if (average.is_zero())
+    return sample;
+  return (average * 3 + sample) / 4;
+}
 
 std::vector<uint8_t> StringToBytes(const std::string& string) {
   return std::vector<uint8_t>(string.begin(), string.end());
@@ -140,13 +154,27 @@ WidevineKeySource::WidevineKeySource(const std::string& server_url,
       key_production_started_(false),
       start_key_production_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                             base::WaitableEvent::InitialState::NOT_SIGNALED),
-      first_crypto_period_index_(0) {
+      first_crypto_period_index_(0),
+      clock_(new base::DefaultClock()),
+      prefetch_cv_(&prefetch_lock_) {
   key_production_thread_.Start();
 }
 
 WidevineKeySource::~WidevineKeySource() {
   if (key_pool_)
     key_pool_->Stop();
+  {
+    base::AutoLock auto_lock(prefetch_lock_);
+    prefetch_stopped_ = true;
+    prefetch_cv_.Broadcast();
+    if (key_rotation_stats_.num_blocked_requests > 0) {
+      LOG(WARNING) << key_rotation_stats_.num_blocked_requests
+                   << " key requests waited for the keys to be fetched for a "
+                      "total of "
+                   << key_rotation_stats_.blocked_time.InSecondsF()
+                   << " seconds.";
+    }
+  }
   if (key_production_thread_.HasBeenStarted()) {
     // Signal the production thread to start key production if it is not
     // signaled yet so the thread can be joined.
@@ -273,16 +301,27 @@ Status WidevineKeySource::GetCryptoPeriodKey(uint32_t crypto_period_index,
       // index. Set the initial value to account for that.
       first_crypto_period_index_ =
           crypto_period_index ? crypto_period_index - 1 : 0;
+      // With a prefetch horizon, the key pool keeps as many crypto periods
+      // behind the requested crypto period as ahead of it.
+      const size_t key_pool_capacity = key_prefetch_horizon_.is_zero()
+                                           ? crypto_period_count_
+                                           : 2 * kMaxCryptoPeriodsAhead;
       DCHECK(!key_pool_);
-      key_pool_.reset(new EncryptionKeyQueue(crypto_period_count_,
+      key_pool_.reset(new EncryptionKeyQueue(key_pool_capacity,
                                              first_crypto_period_index_));
       start_key_production_.Signal();
       key_production_started_ = true;
     }
   }
+  UpdateKeyConsumption(crypto_period_index);
   return GetKeyInternal(crypto_period_index, stream_label, key);
 }
 
+WidevineKeySource::KeyRotationStats WidevineKeySource::GetKeyRotationStats() {
+  base::AutoLock auto_lock(prefetch_lock_);
+  return key_rotation_stats_;
+}
+
 void WidevineKeySource::set_signer(std::unique_ptr<RequestSigner> signer) {
   signer_ = std::move(signer);
 }
@@ -296,6 +335,10 @@ void WidevineKeySource::set_group_id(const std::vector<uint8_t>& group_id) {
   group_id_ = group_id;
 }
 
+void WidevineKeySource::set_key_cache(std::shared_ptr<KeyCache> key_cache) {
+  key_cache_ = std::move(key_cache);
+}
+
 Status WidevineKeySource::GetKeyInternal(uint32_t crypto_period_index,
                                          const std::string& stream_label,
                                          EncryptionKey* key) {
@@ -303,8 +346,18 @@ Status WidevineKeySource::GetKeyInternal(uint32_t crypto_period_index,
   DCHECK(key);
 
   std::shared_ptr<EncryptionKeyMap> encryption_key_map;
-  Status status = key_pool_->Peek(crypto_period_index, &encryption_key_map,
-                                  kGetKeyTimeoutInSeconds * 1000);
+  Status status = key_pool_->Peek(crypto_period_index, &encryption_key_map, 0);
+  if (status.error_code() == error::TIME_OUT) {
+    LOG(WARNING) << "Waiting for the keys of crypto period "
+                 << crypto_period_index
+                 << ". Consider increasing the key prefetch horizon.";
+    const base::Time start_time = clock_->Now();
+    status = key_pool_->Peek(crypto_period_index, &encryption_key_map,
+                             kGetKeyTimeoutInSeconds * 1000);
+    base::AutoLock auto_lock(prefetch_lock_);
+    ++key_rotation_stats_.num_blocked_requests;
+    key_rotation_stats_.blocked_time += clock_->Now() - start_time;
+  }
   if (!status.ok()) {
     if (status.error_code() == error::STOPPED) {
       CHECK(!common_encryption_request_status_.ok());
@@ -327,19 +380,69 @@ void WidevineKeySource::FetchKeysTask() {
   if (!key_pool_ || key_pool_->Stopped())
     return;
 
-  Status status = FetchKeysInternal(kEnableKeyRotation,
-                                    first_crypto_period_index_,
-                                    false);
-  while (status.ok()) {
-    first_crypto_period_index_ += crypto_period_count_;
+  Status status;
+  while (WaitForKeyPrefetch()) {
     status = FetchKeysInternal(kEnableKeyRotation,
                                first_crypto_period_index_,
                                false);
+    if (!status.ok())
+      break;
+    first_crypto_period_index_ += crypto_period_count_;
   }
   common_encryption_request_status_ = status;
   key_pool_->Stop();
 }
 
+void WidevineKeySource::UpdateKeyConsumption(uint32_t crypto_period_index) {
+  base::AutoLock auto_lock(prefetch_lock_);
+  // The same crypto period is requested for every stream.
+  if (crypto_period_index <= latest_crypto_period_index_)
+    return;
+  const base::Time now = clock_->Now();
+  if (latest_crypto_period_index_ >= 0) {
+    const base::TimeDelta interval =
+        (now - latest_crypto_period_time_) /
+        (crypto_period_index - latest_crypto_period_index_);
+    key_rotation_stats_.crypto_period_interval = UpdateMovingAverage(
+        key_rotation_stats_.crypto_period_interval, interval);
+  }
+  latest_crypto_period_index_ = crypto_period_index;
+  latest_crypto_period_time_ = now;
+  prefetch_cv_.Signal();
+}
+
+bool WidevineKeySource::WaitForKeyPrefetch() {
+  base::AutoLock auto_lock(prefetch_lock_);
+  // Without a horizon, the keys are fetched as fast as the key pool accepts
+  // them.
+  if (key_prefetch_horizon_.is_zero())
+    return !prefetch_stopped_;
+  // |first_crypto_period_index_| is the first crypto period not fetched yet.
+  while (!prefetch_stopped_ &&
+         static_cast<int64_t>(first_crypto_period_index_) -
+                 latest_crypto_period_index_ >=
+             GetNumCryptoPeriodsToPrefetch()) {
+    prefetch_cv_.Wait();
+  }
+  return !prefetch_stopped_;
+}
+
+int64_t WidevineKeySource::GetNumCryptoPeriodsToPrefetch() const {
+  DCHECK(!key_prefetch_horizon_.is_zero());
+  int64_t num_crypto_periods = crypto_period_count_ / 2;
+  const base::TimeDelta interval = key_rotation_stats_.crypto_period_interval;
+  if (!interval.is_zero()) {
+    // Keys should be available for the horizon once a fetch started now
+    // completes.
+    const base::TimeDelta lead_time =
+        key_prefetch_horizon_ + key_rotation_stats_.fetch_latency;
+    num_crypto_periods =
+        std::max(num_crypto_periods,
+                 lead_time.InMicroseconds() / interval.InMicroseconds() + 1);
+  }
+  return std::min(num_crypto_periods, kMaxCryptoPeriodsAhead);
+}
+
 Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
                                             uint32_t first_crypto_period_index,
                                             bool widevine_classic) {
@@ -348,6 +451,20 @@ Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
               first_crypto_period_index,
               &request);
 
+  // The request identifies the content, policy and crypto periods, so the
+  // response to an identical request can be reused.
+  const std::string cache_key = server_url_ + "\n" + request;
+  std::string cached_response;
+  if (key_cache_ && key_cache_->Get(cache_key, &cached_response)) {
+    VLOG(1) << "Using cached response: " << cached_response;
+    bool transient_error = false;
+    if (ExtractEncryptionKey(enable_key_rotation, widevine_classic,
+                             cached_response, &transient_error)) {
+      return Status::OK;
+    }
+    LOG(WARNING) << "Ignoring invalid cached key response.";
+  }
+
   std::string message;
   Status status = GenerateKeyMessage(request, &message);
   if (!status.ok())
@@ -356,6 +473,7 @@ Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
 
   std::string raw_response;
   int64_t sleep_duration = kFirstRetryDelayMilliseconds;
+  const base::Time start_time = clock_->Now();
 
   // Perform client side retries if seeing server transient error to workaround
   // server limitation.
@@ -363,6 +481,13 @@ Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
     status = key_fetcher_->FetchKeys(server_url_, message, &raw_response);
     if (status.ok()) {
       VLOG(1) << "Retry [" << i << "] Response:" << raw_response;
+      if (enable_key_rotation) {
+        // Retries are included, as they delay the keys too.
+        base::AutoLock auto_lock(prefetch_lock_);
+        key_rotation_stats_.fetch_latency =
+            UpdateMovingAverage(key_rotation_stats_.fetch_latency,
+                                clock_->Now() - start_time);
+      }
 
       std::string response;
       if (!DecodeResponse(raw_response, &response)) {
@@ -374,8 +499,11 @@ Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
       if (ExtractEncryptionKey(enable_key_rotation,
                                widevine_classic,
                                response,
-                               &transient_error))
+                               &transient_error)) {
+        if (key_cache_)
+          key_cache_->Put(cache_key, response);
         return Status::OK;
+      }
 
       if (!transient_error) {
         return Status(
@@ -9,7 +9,10 @@
 
 #include <map>
 #include <memory>
+#include "packager/base/synchronization/condition_variable.h"
 #include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/time/clock.h"
+#include "packager/base/time/time.h"
 #include "packager/base/values.h"
 #include "packager/media/base/closure_thread.h"
 #include "packager/media/base/fourccs.h"
@@ -22,6 +25,7 @@ const uint8_t kWidevineSystemId[] = {0xed, 0xef, 0x8b, 0xa9, 0x79, 0xd6,
                                      0x4a, 0xce, 0xa3, 0xc8, 0x27, 0xdc,
                                      0xd5, 0x1d, 0x21, 0xed};
 
+class KeyCache;
 class KeyFetcher;
 class RequestSigner;
 template <class T> class ProducerConsumerQueue;
@@ -30,6 +34,19 @@ template <class T> class ProducerConsumerQueue;
 /// acquire the encryption keys.
 class WidevineKeySource : public KeySource {
  public:
+  /// Key rotation statistics.
+  struct KeyRotationStats {
+    /// Number of GetCryptoPeriodKey calls which had to wait for the keys to
+    /// be fetched.
+    int64_t num_blocked_requests = 0;
+    /// Total time spent by GetCryptoPeriodKey calls waiting for the keys.
+    base::TimeDelta blocked_time;
+    /// Estimated time for the key server to respond to a request.
+    base::TimeDelta fetch_latency;
+    /// Estimated time between two consecutive crypto periods being requested.
+    base::TimeDelta crypto_period_interval;
+  };
+
   /// @param server_url is the Widevine common encryption server url.
   WidevineKeySource(const std::string& server_url, bool add_common_pssh);
 
@@ -71,6 +88,31 @@ class WidevineKeySource : public KeySource {
   // @param group_id group identifier
   void set_group_id(const std::vector<uint8_t>& group_id);
 
+  /// Set how far ahead keys are prefetched with key rotation. The number of
+  /// crypto periods to prefetch is derived from the rate the crypto periods
+  /// are requested and the key server latency, so the keys needed in
+  /// @a horizon plus the time to fetch them are always available. If zero,
+  /// the default, requests are sent back to back, as fast as a key pool of
+  /// one request worth of crypto periods takes the keys. Should be called
+  /// before key rotation starts.
+  void set_key_prefetch_horizon(base::TimeDelta horizon) {
+    key_prefetch_horizon_ = horizon;
+  }
+
+  /// @return the key rotation statistics.
+  KeyRotationStats GetKeyRotationStats();
+
+  /// Inject a @a clock used to estimate the key server latency and the rate
+  /// crypto periods are requested. For testing only.
+  void InjectClockForTesting(std::unique_ptr<base::Clock> clock) {
+    clock_ = std::move(clock);
+  }
+
+  /// Set the cache for key server responses. Keys found in the cache are used
+  /// without contacting the key server.
+  /// @param key_cache is the cache, usually shared with other key sources.
+  void set_key_cache(std::shared_ptr<KeyCache> key_cache);
+
  private:
   typedef std::map<std::string, std::unique_ptr<EncryptionKey>>
       EncryptionKeyMap;
@@ -85,6 +127,16 @@ class WidevineKeySource : public KeySource {
   // The closure task to fetch keys repeatedly.
   void FetchKeysTask();
 
+  // Record that |crypto_period_index| is requested, to track the rate the
+  // crypto periods are consumed, and wake up the prefetcher.
+  void UpdateKeyConsumption(uint32_t crypto_period_index);
+  // Wait until more keys need to be prefetched.
+  // @return false if stopped, true otherwise.
+  bool WaitForKeyPrefetch();
+  // @return the number of crypto periods to keep fetched ahead of the latest
+  //         requested crypto period. |prefetch_lock_| should be held.
+  int64_t GetNumCryptoPeriodsToPrefetch() const;
+
   // Fetch keys from server.
   Status FetchKeysInternal(bool enable_key_rotation,
                            uint32_t first_crypto_period_index,
@@ -119,6 +171,7 @@ class WidevineKeySource : public KeySource {
   std::unique_ptr<KeyFetcher> key_fetcher_;
   std::string server_url_;
   std::unique_ptr<RequestSigner> signer_;
+  std::shared_ptr<KeyCache> key_cache_;
   base::DictionaryValue request_dict_;
 
   const uint32_t crypto_period_count_;
@@ -133,6 +186,17 @@ class WidevineKeySource : public KeySource {
   EncryptionKeyMap encryption_key_map_;  // For non key rotation request.
   Status common_encryption_request_status_;
 
+  base::TimeDelta key_prefetch_horizon_;
+  std::unique_ptr<base::Clock> clock_;
+  // Key rotation prefetch states.
+  base::Lock prefetch_lock_;
+  base::ConditionVariable prefetch_cv_;
+  // Protected by |prefetch_lock_|.
+  bool prefetch_stopped_ = false;
+  int64_t latest_crypto_period_index_ = -1;
+  base::Time latest_crypto_period_time_;
+  KeyRotationStats key_rotation_stats_;
+
   DISALLOW_COPY_AND_ASSIGN(WidevineKeySource);
 };
 
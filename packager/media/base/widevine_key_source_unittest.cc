@@ -12,6 +12,10 @@
 #include "packager/base/base64.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/stringprintf.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/time/clock.h"
+#include "packager/media/base/key_cache.h"
 #include "packager/media/base/key_fetcher.h"
 #include "packager/media/base/raw_key_source.h"
 #include "packager/media/base/request_signer.h"
@@ -23,6 +27,7 @@ using ::testing::Bool;
 using ::testing::Combine;
 using ::testing::DoAll;
 using ::testing::InSequence;
+using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::SetArgPointee;
 using ::testing::StrEq;
@@ -168,6 +173,30 @@ class MockKeyFetcher : public KeyFetcher {
   DISALLOW_COPY_AND_ASSIGN(MockKeyFetcher);
 };
 
+// A clock which only moves forward when advanced. It is accessed from the key
+// production thread too.
+class FakeClock : public base::Clock {
+ public:
+  FakeClock() {}
+  ~FakeClock() override {}
+
+  base::Time Now() override {
+    base::AutoLock auto_lock(lock_);
+    return now_;
+  }
+
+  void Advance(base::TimeDelta delta) {
+    base::AutoLock auto_lock(lock_);
+    now_ += delta;
+  }
+
+ private:
+  base::Lock lock_;
+  base::Time now_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeClock);
+};
+
 class WidevineKeySourceTest : public Test {
  public:
   WidevineKeySourceTest()
@@ -298,6 +327,28 @@ TEST_F(WidevineKeySourceTest, NoRetryOnUnknownError) {
             widevine_key_source_->FetchKeys(content_id_, kPolicy).error_code());
 }
 
+TEST_F(WidevineKeySourceTest, KeyCache) {
+  std::string mock_response = base::StringPrintf(
+      kHttpResponseFormat, Base64Encode(GenerateMockLicenseResponse()).c_str());
+  // The key server is only contacted once.
+  EXPECT_CALL(*mock_key_fetcher_, FetchKeys(_, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(mock_response), Return(Status::OK)));
+
+  std::shared_ptr<KeyCache> key_cache(
+      new KeyCache("", std::vector<uint8_t>()));
+  CreateWidevineKeySource();
+  widevine_key_source_->set_key_cache(key_cache);
+  ASSERT_OK(widevine_key_source_->FetchKeys(content_id_, kPolicy));
+  VerifyKeys(false);
+
+  mock_key_fetcher_.reset(new MockKeyFetcher());
+  EXPECT_CALL(*mock_key_fetcher_, FetchKeys(_, _, _)).Times(0);
+  CreateWidevineKeySource();
+  widevine_key_source_->set_key_cache(key_cache);
+  ASSERT_OK(widevine_key_source_->FetchKeys(content_id_, kPolicy));
+  VerifyKeys(false);
+}
+
 class WidevineKeySourceParameterizedTest
     : public WidevineKeySourceTest,
       public WithParamInterface<std::tr1::tuple<bool, FourCC>> {
@@ -529,6 +580,132 @@ TEST_P(WidevineKeySourceParameterizedTest, KeyRotationTest) {
   EXPECT_EQ(error::INVALID_ARGUMENT, status.error_code());
 }
 
+// Without a prefetch horizon, the next keys are requested as soon as the
+// previous ones are fetched, without waiting for them to be consumed.
+TEST_F(WidevineKeySourceTest, KeyRotationNoPrefetchHorizon) {
+  const uint32_t kFirstCryptoPeriodIndex = 8;
+  const uint32_t kCryptoPeriodCount = 10;
+  const int kTimeoutInSeconds = 10;
+
+  base::WaitableEvent second_fetch(
+      base::WaitableEvent::ResetPolicy::MANUAL,
+      base::WaitableEvent::InitialState::NOT_SIGNALED);
+
+  InSequence dummy;
+  std::string mock_response = base::StringPrintf(
+      kHttpResponseFormat, Base64Encode(GenerateMockLicenseResponse()).c_str());
+  EXPECT_CALL(*mock_key_fetcher_, FetchKeys(_, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(mock_response), Return(Status::OK)));
+  const std::string first_response = base::StringPrintf(
+      kHttpResponseFormat,
+      Base64Encode(GenerateMockKeyRotationLicenseResponse(
+                       kFirstCryptoPeriodIndex - 1, kCryptoPeriodCount))
+          .c_str());
+  EXPECT_CALL(*mock_key_fetcher_, FetchKeys(_, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(first_response), Return(Status::OK)));
+  const std::string second_response = base::StringPrintf(
+      kHttpResponseFormat,
+      Base64Encode(GenerateMockKeyRotationLicenseResponse(
+                       kFirstCryptoPeriodIndex - 1 + kCryptoPeriodCount,
+                       kCryptoPeriodCount))
+          .c_str());
+  EXPECT_CALL(*mock_key_fetcher_, FetchKeys(_, _, _))
+      .WillOnce(Invoke([&second_fetch, &second_response](
+                           const std::string&, const std::string&,
+                           std::string* response) {
+        second_fetch.Signal();
+        *response = second_response;
+        return Status::OK;
+      }));
+
+  CreateWidevineKeySource();
+  ASSERT_OK(widevine_key_source_->FetchKeys(content_id_, kPolicy));
+
+  EncryptionKey encryption_key;
+  ASSERT_OK(widevine_key_source_->GetCryptoPeriodKey(kFirstCryptoPeriodIndex,
+                                                     "SD", &encryption_key));
+  EXPECT_TRUE(second_fetch.TimedWait(
+      base::TimeDelta::FromSeconds(kTimeoutInSeconds)));
+}
+
+TEST_F(WidevineKeySourceTest, KeyRotationPrefetchHorizon) {
+  const uint32_t kFirstCryptoPeriodIndex = 8;
+  const uint32_t kCryptoPeriodCount = 10;
+  const base::TimeDelta kFetchLatency = base::TimeDelta::FromMilliseconds(100);
+  const base::TimeDelta kCryptoPeriodInterval = base::TimeDelta::FromSeconds(2);
+  const base::TimeDelta kPrefetchHorizon = base::TimeDelta::FromSeconds(30);
+  const int kTimeoutInSeconds = 10;
+
+  FakeClock* clock = new FakeClock;
+  base::WaitableEvent second_fetch(
+      base::WaitableEvent::ResetPolicy::MANUAL,
+      base::WaitableEvent::InitialState::NOT_SIGNALED);
+
+  InSequence dummy;
+  std::string mock_response = base::StringPrintf(
+      kHttpResponseFormat, Base64Encode(GenerateMockLicenseResponse()).c_str());
+  EXPECT_CALL(*mock_key_fetcher_, FetchKeys(_, _, _))
+      .WillOnce(DoAll(SetArgPointee<2>(mock_response), Return(Status::OK)));
+  const std::string first_response = base::StringPrintf(
+      kHttpResponseFormat,
+      Base64Encode(GenerateMockKeyRotationLicenseResponse(
+                       kFirstCryptoPeriodIndex - 1, kCryptoPeriodCount))
+          .c_str());
+  EXPECT_CALL(*mock_key_fetcher_, FetchKeys(_, _, _))
+      .WillOnce(Invoke([clock, &first_response, kFetchLatency](
+                           const std::string&, const std::string&,
+                           std::string* response) {
+        clock->Advance(kFetchLatency);
+        *response = first_response;
+        return Status::OK;
+      }));
+  const std::string second_response = base::StringPrintf(
+      kHttpResponseFormat,
+      Base64Encode(GenerateMockKeyRotationLicenseResponse(
+                       kFirstCryptoPeriodIndex - 1 + kCryptoPeriodCount,
+                       kCryptoPeriodCount))
+          .c_str());
+  EXPECT_CALL(*mock_key_fetcher_, FetchKeys(_, _, _))
+      .WillOnce(Invoke([&second_fetch, &second_response](
+                           const std::string&, const std::string&,
+                           std::string* response) {
+        second_fetch.Signal();
+        *response = second_response;
+        return Status::OK;
+      }));
+
+  CreateWidevineKeySource();
+  widevine_key_source_->InjectClockForTesting(
+      std::unique_ptr<base::Clock>(clock));
+  widevine_key_source_->set_key_prefetch_horizon(kPrefetchHorizon);
+  ASSERT_OK(widevine_key_source_->FetchKeys(content_id_, kPolicy));
+
+  EncryptionKey encryption_key;
+  ASSERT_OK(widevine_key_source_->GetCryptoPeriodKey(kFirstCryptoPeriodIndex,
+                                                     "SD", &encryption_key));
+  WidevineKeySource::KeyRotationStats stats =
+      widevine_key_source_->GetKeyRotationStats();
+  EXPECT_EQ(kFetchLatency, stats.fetch_latency);
+  // Half a request worth of crypto periods is ahead until the rate crypto
+  // periods are requested is known.
+  EXPECT_FALSE(second_fetch.IsSignaled());
+
+  // Keys for the horizon plus the fetch latency, i.e. 15 or more crypto
+  // periods, should now be ahead of the requested crypto period, which
+  // triggers the next fetch.
+  clock->Advance(kCryptoPeriodInterval);
+  ASSERT_OK(widevine_key_source_->GetCryptoPeriodKey(
+      kFirstCryptoPeriodIndex + 1, "SD", &encryption_key));
+  // The first crypto period may have been requested before or after the
+  // first fetch advanced the clock.
+  const base::TimeDelta interval =
+      widevine_key_source_->GetKeyRotationStats().crypto_period_interval;
+  EXPECT_LE(kCryptoPeriodInterval, interval);
+  EXPECT_GE(kCryptoPeriodInterval + kFetchLatency, interval);
+  EXPECT_TRUE(second_fetch.TimedWait(
+      base::TimeDelta::FromSeconds(kTimeoutInSeconds)));
+}
+
 INSTANTIATE_TEST_CASE_P(WidevineKeySourceInstance,
                         WidevineKeySourceParameterizedTest,
                         Combine(Bool(),
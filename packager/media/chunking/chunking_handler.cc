@@ -6,8 +6,11 @@
 
 #include "packager/media/chunking/chunking_handler.h"
 
+#include <algorithm>
+
 #include "packager/base/logging.h"
 #include "packager/base/threading/platform_thread.h"
+#include "packager/media/base/latency_tracer.h"
 #include "packager/media/base/media_sample.h"
 
 namespace {
@@ -19,7 +22,9 @@ namespace shaka {
 namespace media {
 
 ChunkingHandler::ChunkingHandler(const ChunkingParams& chunking_params)
-    : chunking_params_(chunking_params), thread_id_(kThreadIdUnset) {
+    : chunking_params_(chunking_params),
+      thread_id_(kThreadIdUnset),
+      non_main_samples_memory_(MemoryComponent::kChunkingQueue) {
   CHECK_NE(chunking_params.segment_duration_in_seconds, 0u);
 }
 
@@ -64,6 +69,8 @@ Status ChunkingHandler::Process(std::unique_ptr<StreamData> stream_data) {
                       "Only one video stream is allowed per chunking handler.");
       }
       time_scales_[stream_data->stream_index] = time_scale;
+      if (num_input_streams() > 1)
+        return HoldStreamInfo(std::move(stream_data));
       break;
     }
     case StreamDataType::kScte35Event: {
@@ -84,6 +91,11 @@ Status ChunkingHandler::Process(std::unique_ptr<StreamData> stream_data) {
       const size_t stream_index = stream_data->stream_index;
       DCHECK_NE(time_scales_[stream_index], 0u)
           << "kStreamInfo should arrive before kMediaSample";
+      if (!pending_stream_infos_.empty()) {
+        return Status(error::CHUNKING_ERROR,
+                      "All the inputs should have a stream info before the "
+                      "first sample.");
+      }
       if (stream_index != main_stream_index_) {
         if (!stream_data->media_sample->is_key_frame()) {
           return Status(error::CHUNKING_ERROR,
@@ -91,6 +103,8 @@ Status ChunkingHandler::Process(std::unique_ptr<StreamData> stream_data) {
         }
         // Cache non main stream samples, since we don't know yet whether these
         // samples belong to the current or next segment.
+        non_main_samples_memory_.Charge(
+            stream_data->media_sample->data_size());
         non_main_samples_.push_back(std::move(stream_data));
         // The streams are expected to be synchronized, so we don't expect to
         // see a lot of samples before seeing video samples.
@@ -122,6 +136,26 @@ Status ChunkingHandler::Process(std::unique_ptr<StreamData> stream_data) {
   return Dispatch(std::move(stream_data));
 }
 
+Status ChunkingHandler::HoldStreamInfo(
+    std::unique_ptr<StreamData> stream_data) {
+  pending_stream_infos_.push_back(std::move(stream_data));
+  if (pending_stream_infos_.size() < num_input_streams())
+    return Status::OK;
+
+  std::stable_partition(pending_stream_infos_.begin(),
+                        pending_stream_infos_.end(),
+                        [this](const std::unique_ptr<StreamData>& data) {
+                          return data->stream_index == main_stream_index_;
+                        });
+  for (std::unique_ptr<StreamData>& data : pending_stream_infos_) {
+    Status status = Dispatch(std::move(data));
+    if (!status.ok())
+      return status;
+  }
+  pending_stream_infos_.clear();
+  return Status::OK;
+}
+
 Status ChunkingHandler::OnFlushRequest(size_t input_stream_index) {
   if (segment_info_[input_stream_index]) {
     Status status;
@@ -134,6 +168,8 @@ Status ChunkingHandler::OnFlushRequest(size_t input_stream_index) {
     if (segment_info->start_timestamp != -1) {
       segment_info->duration = last_sample_end_timestamps_[input_stream_index] -
                                segment_info->start_timestamp;
+      if (segment_info->ingest_time > 0)
+        segment_info->closed_time = LatencyTracer::Now();
       status = DispatchSegmentInfo(input_stream_index, std::move(segment_info));
       if (!status.ok())
         return status;
@@ -196,6 +232,7 @@ Status ChunkingHandler::ProcessMediaSample(const MediaSample* sample) {
   if (new_segment) {
     status.Update(DispatchSegmentInfoForAllStreams());
     segment_info_[main_stream_index_]->start_timestamp = timestamp;
+    segment_info_[main_stream_index_]->ingest_time = sample->ingest_time();
 
     if (cue_event)
       status.Update(DispatchCueEventForAllStreams(std::move(cue_event)));
@@ -218,6 +255,7 @@ Status ChunkingHandler::DispatchNonMainSamples(int64_t timestamp_threshold) {
               StreamDataType::kMediaSample);
     const size_t stream_index = non_main_samples_.front()->stream_index;
     const MediaSample* sample = non_main_samples_.front()->media_sample.get();
+    const size_t sample_size = sample->data_size();
     // If the portion of the sample before |timestamp_threshold| is bigger than
     // the other portion, we consider it part of the current segment.
     const int64_t timestamp = sample->dts() + sample->duration() / 2;
@@ -239,8 +277,10 @@ Status ChunkingHandler::DispatchNonMainSamples(int64_t timestamp_threshold) {
     // Only dispatch samples if the segment has started, otherwise discard
     // them.
     if (segment_info_[stream_index]) {
-      if (segment_info_[stream_index]->start_timestamp == -1)
+      if (segment_info_[stream_index]->start_timestamp == -1) {
         segment_info_[stream_index]->start_timestamp = sample->dts();
+        segment_info_[stream_index]->ingest_time = sample->ingest_time();
+      }
       if (subsegment_info_[stream_index] &&
           subsegment_info_[stream_index]->start_timestamp == -1) {
         subsegment_info_[stream_index]->start_timestamp = sample->dts();
@@ -250,6 +290,7 @@ Status ChunkingHandler::DispatchNonMainSamples(int64_t timestamp_threshold) {
       status.Update(Dispatch(std::move(non_main_samples_.front())));
     }
     non_main_samples_.pop_front();
+    non_main_samples_memory_.Release(sample_size);
   }
   return status;
 }
@@ -260,6 +301,8 @@ Status ChunkingHandler::DispatchSegmentInfoForAllStreams() {
     if (segment_info_[i] && segment_info_[i]->start_timestamp != -1) {
       segment_info_[i]->duration =
           last_sample_end_timestamps_[i] - segment_info_[i]->start_timestamp;
+      if (segment_info_[i]->ingest_time > 0)
+        segment_info_[i]->closed_time = LatencyTracer::Now();
       status.Update(DispatchSegmentInfo(i, std::move(segment_info_[i])));
     }
     segment_info_[i].reset(new SegmentInfo);
@@ -11,6 +11,7 @@
 #include <queue>
 
 #include "packager/base/logging.h"
+#include "packager/file/memory_accountant.h"
 #include "packager/media/base/media_handler.h"
 #include "packager/media/public/chunking_params.h"
 
@@ -21,7 +22,8 @@ namespace media {
 /// specified chunking params.
 /// This handler is a multi-in multi-out handler. If more than one input is
 /// provided, there should be one and only one video stream; also, all inputs
-/// should come from the same thread and are synchronized.
+/// should come from the same thread and are synchronized. The stream infos are
+/// then dispatched once all the inputs have one, the main stream first.
 /// There can be multiple chunking handler running in different threads or even
 /// different processes, we use the "consistent chunking algorithm" to make sure
 /// the chunks in different streams are aligned without explicit communcating
@@ -62,6 +64,11 @@ class ChunkingHandler : public MediaHandler {
   ChunkingHandler(const ChunkingHandler&) = delete;
   ChunkingHandler& operator=(const ChunkingHandler&) = delete;
 
+  // Holds the stream info of an input until all the inputs have one, then
+  // dispatches them, the main stream first, so that the handlers downstream
+  // can follow the main stream, e.g. to share its encryption key.
+  Status HoldStreamInfo(std::unique_ptr<StreamData> stream_data);
+
   // Processes media sample and apply chunking if needed.
   Status ProcessMediaSample(const MediaSample* sample);
 
@@ -82,6 +89,8 @@ class ChunkingHandler : public MediaHandler {
   // main stream. The chunking is based on the main stream.
   const size_t kInvalidStreamIndex = static_cast<size_t>(-1);
   size_t main_stream_index_ = kInvalidStreamIndex;
+  // Stream infos held until all the inputs have one.
+  std::vector<std::unique_ptr<StreamData>> pending_stream_infos_;
   // Segment and subsegment duration in main stream's time scale.
   int64_t segment_duration_ = 0;
   int64_t subsegment_duration_ = 0;
@@ -91,6 +100,8 @@ class ChunkingHandler : public MediaHandler {
   // samples. The samples will be dispatched after seeing the next main stream
   // sample.
   std::deque<std::unique_ptr<StreamData>> non_main_samples_;
+  // Memory held by |non_main_samples_|.
+  MemoryCharge non_main_samples_memory_;
 
   // Current segment index, useful to determine where to do chunking.
   int64_t current_segment_index_ = -1;
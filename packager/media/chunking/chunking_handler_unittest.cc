@@ -169,12 +169,15 @@ TEST_F(ChunkingHandlerTest, AudioAndVideo) {
 
   ASSERT_OK(Process(StreamData::FromStreamInfo(
       kStreamIndex0, GetAudioStreamInfo(kTimeScale0))));
+  // The stream infos are held until all the inputs have one.
+  EXPECT_THAT(GetOutputStreamDataVector(), IsEmpty());
   ASSERT_OK(Process(StreamData::FromStreamInfo(
       kStreamIndex1, GetVideoStreamInfo(kTimeScale1))));
+  // The main stream, i.e. the video stream, is dispatched first.
   EXPECT_THAT(
       GetOutputStreamDataVector(),
-      ElementsAre(IsStreamInfo(kStreamIndex0, kTimeScale0, !kEncrypted),
-                  IsStreamInfo(kStreamIndex1, kTimeScale1, !kEncrypted)));
+      ElementsAre(IsStreamInfo(kStreamIndex1, kTimeScale1, !kEncrypted),
+                  IsStreamInfo(kStreamIndex0, kTimeScale0, !kEncrypted)));
   ClearOutputStreamDataVector();
 
   // Equivalent to 12345 in video timescale.
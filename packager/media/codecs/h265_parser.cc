@@ -6,7 +6,6 @@
 
 #include "packager/media/codecs/h265_parser.h"
 
-#include <math.h>
 #include <algorithm>
 
 #include "packager/base/logging.h"
@@ -32,6 +31,15 @@ namespace shaka {
 namespace media {
 
 namespace {
+// Integer equivalent of ceil(log2(value)), avoiding floating point math on
+// every slice header.
+int CeilLog2(int value) {
+  int log2 = 0;
+  while ((1 << log2) < value)
+    ++log2;
+  return log2;
+}
+
 int GetNumPicTotalCurr(const H265SliceHeader& slice_header,
                        const H265Sps& sps) {
   int num_pic_total_curr = 0;
@@ -207,7 +215,7 @@ H265Parser::Result H265Parser::ParseSliceHeader(const Nalu& nalu,
     if (pps->dependent_slice_segments_enabled_flag) {
       TRUE_OR_RETURN(br->ReadBool(&slice_header->dependent_slice_segment_flag));
     }
-    const int bit_length = ceil(log2(sps->GetPicSizeInCtbsY()));
+    const int bit_length = CeilLog2(sps->GetPicSizeInCtbsY());
     TRUE_OR_RETURN(br->ReadBits(bit_length, &slice_header->segment_address));
   }
 
@@ -234,7 +242,7 @@ H265Parser::Result H265Parser::ParseSliceHeader(const Nalu& nalu,
             sps->st_ref_pic_sets, br, &slice_header->st_ref_pic_set));
       } else if (sps->num_short_term_ref_pic_sets > 1) {
         TRUE_OR_RETURN(
-            br->ReadBits(ceil(log2(sps->num_short_term_ref_pic_sets)),
+            br->ReadBits(CeilLog2(sps->num_short_term_ref_pic_sets),
                          &slice_header->short_term_ref_pic_set_idx));
       }
 
@@ -252,7 +260,7 @@ H265Parser::Result H265Parser::ParseSliceHeader(const Nalu& nalu,
             int lt_idx_sps = 0;
             if (sps->num_long_term_ref_pics > 1) {
               TRUE_OR_RETURN(br->ReadBits(
-                  ceil(log2(sps->num_long_term_ref_pics)), &lt_idx_sps));
+                  CeilLog2(sps->num_long_term_ref_pics), &lt_idx_sps));
             }
             if (sps->used_by_curr_pic_lt_flag[lt_idx_sps])
               slice_header->used_by_curr_pic_lt++;
@@ -871,7 +879,7 @@ H265Parser::Result H265Parser::SkipReferencePictureListModification(
   TRUE_OR_RETURN(br->ReadBool(&ref_pic_list_modification_flag_l0));
   if (ref_pic_list_modification_flag_l0) {
     for (int i = 0; i <= pps.num_ref_idx_l0_default_active_minus1; i++) {
-      TRUE_OR_RETURN(br->SkipBits(ceil(log2(num_pic_total_curr))));
+      TRUE_OR_RETURN(br->SkipBits(CeilLog2(num_pic_total_curr)));
     }
   }
 
@@ -880,7 +888,7 @@ H265Parser::Result H265Parser::SkipReferencePictureListModification(
     TRUE_OR_RETURN(br->ReadBool(&ref_pic_list_modification_flag_l1));
     if (ref_pic_list_modification_flag_l1) {
       for (int i = 0; i <= pps.num_ref_idx_l1_default_active_minus1; i++) {
-        TRUE_OR_RETURN(br->SkipBits(ceil(log2(num_pic_total_curr))));
+        TRUE_OR_RETURN(br->SkipBits(CeilLog2(num_pic_total_curr)));
       }
     }
   }
@@ -5,16 +5,53 @@
 #include "packager/base/logging.h"
 #include "packager/media/codecs/h26x_bit_reader.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace shaka {
 namespace media {
+namespace {
+
+const int kCacheSizeInBits = 64;
+
+// Returns the number of leading zero bits in |value|, which must not be 0.
+int CountLeadingZeros(uint64_t value) {
+  DCHECK_NE(value, 0u);
+#if defined(_MSC_VER)
+  unsigned long index;
+  if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+    return 31 - index;
+  _BitScanReverse(&index, static_cast<unsigned long>(value));
+  return 63 - index;
+#else
+  return __builtin_clzll(value);
+#endif
+}
+
+// Returns true if any of the eight bytes in |value| is zero.
+bool HasZeroByte(uint64_t value) {
+  return ((value - 0x0101010101010101ULL) & ~value & 0x8080808080808080ULL) !=
+         0;
+}
+
+uint64_t LoadBigEndian64(const uint8_t* data) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i)
+    value = (value << 8) | data[i];
+  return value;
+}
+
+}  // namespace
 
 H26xBitReader::H26xBitReader()
     : data_(NULL),
       bytes_left_(0),
-      curr_byte_(0),
-      num_remaining_bits_in_curr_byte_(0),
+      cache_(0),
+      num_cached_bits_(0),
       prev_two_bytes_(0),
-      emulation_prevention_bytes_(0) {}
+      emulation_prevention_bytes_(0),
+      num_bits_loaded_(0) {}
 
 H26xBitReader::~H26xBitReader() {}
 
@@ -26,79 +63,135 @@ bool H26xBitReader::Initialize(const uint8_t* data, off_t size) {
 
   data_ = data;
   bytes_left_ = size;
-  num_remaining_bits_in_curr_byte_ = 0;
+  cache_ = 0;
+  num_cached_bits_ = 0;
   // Initially set to 0xffff to accept all initial two-byte sequences.
   prev_two_bytes_ = 0xffff;
   emulation_prevention_bytes_ = 0;
+  num_bits_loaded_ = 0;
+  emulation_prevention_positions_.clear();
 
   return true;
 }
 
-bool H26xBitReader::UpdateCurrByte() {
-  if (bytes_left_ < 1)
-    return false;
-
-  // Emulation prevention three-byte detection.
-  // If a sequence of 0x000003 is found, skip (ignore) the last byte (0x03).
-  if (*data_ == 0x03 && (prev_two_bytes_ & 0xffff) == 0) {
-    // Detected 0x000003, skip last byte.
-    ++data_;
-    --bytes_left_;
-    ++emulation_prevention_bytes_;
-    // Need another full three bytes before we can detect the sequence again.
-    prev_two_bytes_ = 0xffff;
-
-    if (bytes_left_ < 1)
-      return false;
+void H26xBitReader::Refill() {
+  // Forget the emulation prevention bytes the reader has moved past.
+  const uint64_t position = num_bits_loaded_ - num_cached_bits_;
+  while (!emulation_prevention_positions_.empty() &&
+         emulation_prevention_positions_.front() < position) {
+    emulation_prevention_positions_.erase(
+        emulation_prevention_positions_.begin());
   }
 
-  // Load a new byte and advance pointers.
-  curr_byte_ = *data_++ & 0xff;
-  --bytes_left_;
-  num_remaining_bits_in_curr_byte_ = 8;
+  const int num_bytes = (kCacheSizeInBits - num_cached_bits_) / 8;
+  if (num_bytes == 0)
+    return;
+
+  // Fast path: without any zero byte, there cannot be an emulation prevention
+  // byte in the next eight bytes unless the previous two bytes are zero.
+  if (bytes_left_ >= 8 && (prev_two_bytes_ & 0xffff) != 0) {
+    const uint64_t next_bytes = LoadBigEndian64(data_);
+    if (!HasZeroByte(next_bytes)) {
+      const int num_bits = num_bytes * 8;
+      const uint64_t bits = next_bytes >> (kCacheSizeInBits - num_bits);
+      cache_ |= bits << (kCacheSizeInBits - num_cached_bits_ - num_bits);
+      num_cached_bits_ += num_bits;
+      num_bits_loaded_ += num_bits;
+      data_ += num_bytes;
+      bytes_left_ -= num_bytes;
+      prev_two_bytes_ = num_bytes >= 2
+                            ? static_cast<int>(bits & 0xffff)
+                            : ((prev_two_bytes_ << 8) | static_cast<int>(bits)) &
+                                  0xffff;
+      return;
+    }
+  }
 
-  prev_two_bytes_ = (prev_two_bytes_ << 8) | curr_byte_;
+  while (num_cached_bits_ <= kCacheSizeInBits - 8 && bytes_left_ > 0) {
+    // Emulation prevention three-byte detection.
+    // If a sequence of 0x000003 is found, skip (ignore) the last byte (0x03).
+    if (*data_ == 0x03 && (prev_two_bytes_ & 0xffff) == 0) {
+      // Detected 0x000003, skip last byte.
+      ++data_;
+      --bytes_left_;
+      ++emulation_prevention_bytes_;
+      emulation_prevention_positions_.push_back(num_bits_loaded_);
+      // Need another full three bytes before we can detect the sequence again.
+      prev_two_bytes_ = 0xffff;
+      continue;
+    }
+
+    const uint8_t byte = *data_++;
+    --bytes_left_;
+    cache_ |= static_cast<uint64_t>(byte)
+              << (kCacheSizeInBits - 8 - num_cached_bits_);
+    num_cached_bits_ += 8;
+    num_bits_loaded_ += 8;
+    prev_two_bytes_ = ((prev_two_bytes_ << 8) | byte) & 0xffff;
+  }
+}
 
-  return true;
+void H26xBitReader::Consume(int num_bits) {
+  DCHECK_GE(num_bits, 0);
+  DCHECK_LE(num_bits, num_cached_bits_);
+  cache_ = num_bits < kCacheSizeInBits ? cache_ << num_bits : 0;
+  num_cached_bits_ -= num_bits;
 }
 
 // Read |num_bits| (1 to 31 inclusive) from the stream and return them
 // in |out|, with first bit in the stream as MSB in |out| at position
 // (|num_bits| - 1).
 bool H26xBitReader::ReadBits(int num_bits, int* out) {
-  int bits_left = num_bits;
-  *out = 0;
   DCHECK(num_bits <= 31);
+  if (num_bits <= 0) {
+    *out = 0;
+    return true;
+  }
 
-  while (num_remaining_bits_in_curr_byte_ < bits_left) {
-    // Take all that's left in current byte, shift to make space for the rest.
-    *out |= (curr_byte_ << (bits_left - num_remaining_bits_in_curr_byte_));
-    bits_left -= num_remaining_bits_in_curr_byte_;
-
-    if (!UpdateCurrByte())
+  if (num_cached_bits_ < num_bits) {
+    Refill();
+    if (num_cached_bits_ < num_bits)
       return false;
   }
 
-  *out |= (curr_byte_ >> (num_remaining_bits_in_curr_byte_ - bits_left));
-  *out &= ((1 << num_bits) - 1);
-  num_remaining_bits_in_curr_byte_ -= bits_left;
-
+  *out = static_cast<int>(cache_ >> (kCacheSizeInBits - num_bits));
+  Consume(num_bits);
   return true;
 }
 
 bool H26xBitReader::SkipBits(int num_bits) {
   int bits_left = num_bits;
-  while (num_remaining_bits_in_curr_byte_ < bits_left) {
-    bits_left -= num_remaining_bits_in_curr_byte_;
-    if (!UpdateCurrByte())
+  while (num_cached_bits_ < bits_left) {
+    bits_left -= num_cached_bits_;
+    Consume(num_cached_bits_);
+    Refill();
+    if (num_cached_bits_ == 0)
       return false;
   }
 
-  num_remaining_bits_in_curr_byte_ -= bits_left;
+  Consume(bits_left);
   return true;
 }
 
 bool H26xBitReader::ReadUE(int* val) {
+  if (num_cached_bits_ < 32)
+    Refill();
+
+  // The code is made of |num_bits| zero bits followed by a |num_bits| + 1 bits
+  // value. Decode it straight from the cache if it is all there.
+  if (cache_ != 0) {
+    const int num_bits = CountLeadingZeros(cache_);
+    const int code_size = 2 * num_bits + 1;
+    if (code_size <= num_cached_bits_) {
+      *val = static_cast<int>((cache_ >> (kCacheSizeInBits - code_size)) - 1);
+      Consume(code_size);
+      return true;
+    }
+  }
+  return ReadUESlow(val);
+}
+
+bool H26xBitReader::ReadUESlow(int* val) {
   int num_bits = -1;
   int bit;
   int rest;
@@ -141,28 +234,42 @@ bool H26xBitReader::ReadSE(int* val) {
 }
 
 off_t H26xBitReader::NumBitsLeft() {
-  return (num_remaining_bits_in_curr_byte_ + bytes_left_ * 8);
+  return num_cached_bits_ + bytes_left_ * 8 +
+         NumPendingEmulationPreventionBytes() * 8;
 }
 
 bool H26xBitReader::HasMoreRBSPData() {
   // Make sure we have more bits, if we are at 0 bits in current byte
   // and updating current byte fails, we don't have more data anyway.
-  if (num_remaining_bits_in_curr_byte_ == 0 && !UpdateCurrByte())
-    return false;
+  if (num_cached_bits_ == 0) {
+    Refill();
+    if (num_cached_bits_ == 0)
+      return false;
+  }
 
-  // On last byte?
-  if (bytes_left_)
+  // On last byte? The cache always ends on a byte boundary.
+  if (bytes_left_ || num_cached_bits_ > 8)
     return true;
 
   // Last byte, look for stop bit;
   // We have more RBSP data if the last non-zero bit we find is not the
   // first available bit.
-  return (curr_byte_ &
-          ((1 << (num_remaining_bits_in_curr_byte_ - 1)) - 1)) != 0;
+  return (cache_ << 1) != 0;
 }
 
 size_t H26xBitReader::NumEmulationPreventionBytesRead() {
-  return emulation_prevention_bytes_;
+  return emulation_prevention_bytes_ - NumPendingEmulationPreventionBytes();
+}
+
+size_t H26xBitReader::NumPendingEmulationPreventionBytes() const {
+  const uint64_t position = num_bits_loaded_ - num_cached_bits_;
+  size_t num_pending = 0;
+  for (uint64_t emulation_prevention_position :
+       emulation_prevention_positions_) {
+    if (emulation_prevention_position >= position)
+      ++num_pending;
+  }
+  return num_pending;
 }
 
 }  // namespace media
@@ -10,6 +10,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <vector>
+
 #include "packager/base/macros.h"
 
 namespace shaka {
@@ -19,6 +21,8 @@ namespace media {
 // This is not a generic bit reader class, as it takes into account
 // H.264 stream-specific constraints, such as skipping emulation-prevention
 // bytes and stop bits. See spec for more details.
+// Bits are read from a 64-bit cache which is refilled several bytes at a time,
+// as slice header parsing is on the hot path of sample encryption.
 class H26xBitReader {
  public:
   H26xBitReader();
@@ -68,30 +72,53 @@ class H26xBitReader {
   size_t NumEmulationPreventionBytesRead();
 
  private:
-  // Advance to the next byte, loading it into curr_byte_.
-  // Return false on end of stream.
-  bool UpdateCurrByte();
+  // Load as many whole bytes as fit into cache_, skipping emulation prevention
+  // bytes. Leaves the cache untouched on end of stream.
+  void Refill();
+
+  // Drop the next |num_bits| bits, 0 to num_cached_bits_ inclusive, from
+  // cache_.
+  void Consume(int num_bits);
+
+  // Exp-Golomb parsing one bit at a time, for the rare codes that do not fit
+  // in the cache.
+  bool ReadUESlow(int* val);
 
-  // Pointer to the next unread (not in curr_byte_) byte in the stream.
+  // Number of emulation prevention bytes skipped by Refill() but not reached
+  // by the reader yet.
+  size_t NumPendingEmulationPreventionBytes() const;
+
+  // Pointer to the next byte in the stream that is not loaded into cache_.
   const uint8_t* data_;
 
-  // Bytes left in the stream (without the curr_byte_).
+  // Bytes left in the stream (without the bytes in cache_).
   off_t bytes_left_;
 
-  // Contents of the current byte; first unread bit starting at position
-  // 8 - num_remaining_bits_in_curr_byte_ from MSB.
-  int curr_byte_;
+  // Loaded bits, first unread bit at the MSB. The bits below the
+  // num_cached_bits_ loaded bits are always zero.
+  uint64_t cache_;
 
-  // Number of bits remaining in curr_byte_
-  int num_remaining_bits_in_curr_byte_;
+  // Number of bits loaded in cache_. Always a whole number of bytes until the
+  // reader consumes bits.
+  int num_cached_bits_;
 
   // Used in emulation prevention three byte detection (see spec).
   // Initially set to 0xffff to accept all initial two-byte sequences.
   int prev_two_bytes_;
 
-  // Number of emulation preventation bytes (0x000003) we met.
+  // Number of emulation preventation bytes (0x000003) skipped by Refill().
   size_t emulation_prevention_bytes_;
 
+  // Number of bits, excluding emulation prevention bytes, loaded into cache_
+  // since Initialize().
+  uint64_t num_bits_loaded_;
+
+  // Positions, in bits loaded, of the bytes which follow a skipped emulation
+  // prevention byte. An emulation prevention byte only counts as read when
+  // the reader moves past the start of the following byte, which keeps
+  // NumBitsLeft() and NumEmulationPreventionBytesRead() in stream terms.
+  std::vector<uint64_t> emulation_prevention_positions_;
+
   DISALLOW_COPY_AND_ASSIGN(H26xBitReader);
 };
 
@@ -112,5 +112,63 @@ TEST(H26xBitReaderTest, StopBitOccupyFullByte) {
   EXPECT_FALSE(reader.HasMoreRBSPData());
 }
 
+TEST(H26xBitReaderTest, ReadUE) {
+  H26xBitReader reader;
+  // Exp-Golomb codes 1, 010, 011, 00100, 0001000 followed by a stop bit.
+  const unsigned char rbsp[] = {0xa6, 0x41, 0x10};
+  int value = 0;
+
+  EXPECT_TRUE(reader.Initialize(rbsp, sizeof(rbsp)));
+  const int kExpectedValues[] = {0, 1, 2, 3, 7};
+  for (int expected_value : kExpectedValues) {
+    EXPECT_TRUE(reader.ReadUE(&value));
+    EXPECT_EQ(expected_value, value);
+  }
+  EXPECT_EQ(5, reader.NumBitsLeft());
+  EXPECT_FALSE(reader.HasMoreRBSPData());
+}
+
+TEST(H26xBitReaderTest, ReadUEAcrossRefill) {
+  H26xBitReader reader;
+  const unsigned char rbsp[] = {0xff, 0xff, 0xff, 0xff, 0xff,
+                                0xff, 0xff, 0xf0, 0x88};
+  int dummy = 0;
+
+  EXPECT_TRUE(reader.Initialize(rbsp, sizeof(rbsp)));
+  EXPECT_TRUE(reader.ReadBits(31, &dummy));
+  EXPECT_TRUE(reader.ReadBits(29, &dummy));
+  EXPECT_EQ(0x1fffffff, dummy);
+  EXPECT_EQ(12, reader.NumBitsLeft());
+
+  // 0000 1 0001.
+  EXPECT_TRUE(reader.ReadUE(&dummy));
+  EXPECT_EQ(16, dummy);
+  EXPECT_EQ(3, reader.NumBitsLeft());
+  EXPECT_FALSE(reader.ReadUE(&dummy));
+}
+
+TEST(H26xBitReaderTest, EmulationPreventionBytes) {
+  H26xBitReader reader;
+  const unsigned char rbsp[] = {0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x03};
+  int dummy = 0;
+
+  EXPECT_TRUE(reader.Initialize(rbsp, sizeof(rbsp)));
+  EXPECT_TRUE(reader.ReadBits(16, &dummy));
+  EXPECT_EQ(0, dummy);
+  // The emulation prevention byte is only skipped when the reader gets to the
+  // next byte.
+  EXPECT_EQ(40, reader.NumBitsLeft());
+  EXPECT_EQ(0u, reader.NumEmulationPreventionBytesRead());
+
+  EXPECT_TRUE(reader.ReadBits(8, &dummy));
+  EXPECT_EQ(0x01, dummy);
+  EXPECT_EQ(24, reader.NumBitsLeft());
+  EXPECT_EQ(1u, reader.NumEmulationPreventionBytesRead());
+
+  EXPECT_TRUE(reader.SkipBits(16));
+  EXPECT_EQ(8, reader.NumBitsLeft());
+  EXPECT_FALSE(reader.ReadBits(1, &dummy));
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -52,6 +52,13 @@ void AddSubsample(uint64_t clear_bytes,
     decrypt_config->AddSubsample(clear_bytes, cipher_bytes);
 }
 
+// Copies |size| clear bytes from |source| to |dest|. Nothing needs to be
+// copied when encrypting in place.
+void CopyClearBytes(const uint8_t* source, size_t size, uint8_t* dest) {
+  if (source != dest)
+    memcpy(dest, source, size);
+}
+
 uint8_t GetNaluLengthSize(const StreamInfo& stream_info) {
   if (stream_info.stream_type() != kStreamVideo)
     return 0;
@@ -255,53 +262,59 @@ Status EncryptionHandler::ProcessMediaSample(
       crypt_byte_block_,
       skip_byte_block_));
 
-  // Now that we know that this sample must be encrypted, make a copy of
-  // the sample first so that all the encryption operations can be done
-  // in-place.
-  std::shared_ptr<MediaSample> cipher_sample(clear_sample->Clone());
-  // |cipher_sample| above still contains the old clear sample data. We will
-  // use |cipher_sample_data| to hold cipher sample data then transfer it to
-  // |cipher_sample| after encryption.
-  std::shared_ptr<uint8_t> cipher_sample_data(
-      new uint8_t[clear_sample->data_size()], std::default_delete<uint8_t[]>());
+  // Encrypt in place if nothing else references the sample or its data,
+  // which is the common case as samples are passed down the pipeline by move.
+  // Otherwise, encrypt into a copy so the clear sample is left untouched.
+  std::shared_ptr<MediaSample> cipher_sample;
+  uint8_t* dest = nullptr;
+  if (clear_sample.use_count() == 1) {
+    cipher_sample = std::const_pointer_cast<MediaSample>(clear_sample);
+    dest = cipher_sample->writable_data();
+  }
+  if (!dest) {
+    cipher_sample = clear_sample->Clone();
+    std::shared_ptr<uint8_t> cipher_sample_data(
+        new uint8_t[clear_sample->data_size()],
+        std::default_delete<uint8_t[]>());
+    dest = cipher_sample_data.get();
+    cipher_sample->TransferData(std::move(cipher_sample_data),
+                                clear_sample->data_size());
+  }
+  const uint8_t* source = clear_sample->data();
+  const size_t source_size = clear_sample->data_size();
 
   if (vpx_parser_) {
-    if (!EncryptVpxFrame(vpx_frames, clear_sample->data(),
-                         clear_sample->data_size(),
-                         &cipher_sample_data.get()[0], decrypt_config.get())) {
+    if (!EncryptVpxFrame(vpx_frames, source, source_size, dest,
+                         decrypt_config.get())) {
       return Status(error::ENCRYPTION_FAILURE, "Failed to encrypt VPX frame.");
     }
-    DCHECK_EQ(decrypt_config->GetTotalSizeOfSubsamples(),
-              clear_sample->data_size());
+    DCHECK_EQ(decrypt_config->GetTotalSizeOfSubsamples(), source_size);
   } else if (header_parser_) {
-    if (!EncryptNalFrame(clear_sample->data(), clear_sample->data_size(),
-                         &cipher_sample_data.get()[0], decrypt_config.get())) {
+    if (!EncryptNalFrame(source, source_size, dest, decrypt_config.get())) {
       return Status(error::ENCRYPTION_FAILURE, "Failed to encrypt NAL frame.");
     }
-    DCHECK_EQ(decrypt_config->GetTotalSizeOfSubsamples(),
-              clear_sample->data_size());
+    DCHECK_EQ(decrypt_config->GetTotalSizeOfSubsamples(), source_size);
   } else if (codec_ == kCodecEAC3 &&
              protection_scheme_ == kAppleSampleAesProtectionScheme) {
-    if (!SampleAesEncryptEac3Frame(clear_sample->data(),
-                                   clear_sample->data_size(),
-                                   &cipher_sample_data.get()[0])) {
+    if (!SampleAesEncryptEac3Frame(source, source_size, dest)) {
       return Status(error::ENCRYPTION_FAILURE,
                     "Failed to encrypt E-AC3 frame.");
     }
   } else {
-    memcpy(&cipher_sample_data.get()[0], clear_sample->data(),
-           std::min(clear_sample->data_size(), leading_clear_bytes_size_));
-    if (clear_sample->data_size() > leading_clear_bytes_size_) {
+    CopyClearBytes(source, std::min(source_size, leading_clear_bytes_size_),
+                   dest);
+    if (source_size > leading_clear_bytes_size_) {
       // The residual block is left unecrypted (copied without encryption). No
       // need to do special handling here.
-      EncryptBytes(clear_sample->data() + leading_clear_bytes_size_,
-                   clear_sample->data_size() - leading_clear_bytes_size_,
-                   &cipher_sample_data.get()[leading_clear_bytes_size_]);
+      EncryptBytes(source + leading_clear_bytes_size_,
+                   source_size - leading_clear_bytes_size_,
+                   dest + leading_clear_bytes_size_);
     }
   }
 
-  cipher_sample->TransferData(std::move(cipher_sample_data),
-                              clear_sample->data_size());
+  if (!EncryptQueuedBytes())
+    return Status(error::ENCRYPTION_FAILURE, "Failed to encrypt sample.");
+
   // Finish initializing the sample before sending it downstream. We must
   // wait until now to finish the initialization as we will lose access to
   // |decrypt_config| once we set it.
@@ -476,7 +489,7 @@ bool EncryptionHandler::EncryptVpxFrame(
     cipher_bytes -= misalign_bytes;
 
     decrypt_config->AddSubsample(clear_bytes, cipher_bytes);
-    memcpy(dest, data, clear_bytes);
+    CopyClearBytes(data, clear_bytes, dest);
     if (cipher_bytes > 0)
       EncryptBytes(data + clear_bytes, cipher_bytes, dest + clear_bytes);
     data += frame.frame_size;
@@ -491,7 +504,7 @@ bool EncryptionHandler::EncryptVpxFrame(
     uint16_t clear_bytes = static_cast<uint16_t>(index_size);
     uint32_t cipher_bytes = 0;
     decrypt_config->AddSubsample(clear_bytes, cipher_bytes);
-    memcpy(dest, data, clear_bytes);
+    CopyClearBytes(data, clear_bytes, dest);
   }
   return true;
 }
@@ -545,7 +558,7 @@ bool EncryptionHandler::EncryptNalFrame(const uint8_t* source,
 
       accumulated_clear_bytes += nalu_length_size_ + current_clear_bytes;
       AddSubsample(accumulated_clear_bytes, cipher_bytes, decrypt_config);
-      memcpy(dest, source, accumulated_clear_bytes);
+      CopyClearBytes(source, accumulated_clear_bytes, dest);
       source += accumulated_clear_bytes;
       dest += accumulated_clear_bytes;
       accumulated_clear_bytes = 0;
@@ -564,7 +577,7 @@ bool EncryptionHandler::EncryptNalFrame(const uint8_t* source,
     return false;
   }
   AddSubsample(accumulated_clear_bytes, 0, decrypt_config);
-  memcpy(dest, source, accumulated_clear_bytes);
+  CopyClearBytes(source, accumulated_clear_bytes, dest);
   return true;
 }
 
@@ -583,7 +596,8 @@ bool EncryptionHandler::SampleAesEncryptEac3Frame(const uint8_t* source,
   encryptor_->SetIv(encryptor_->iv());
 
   for (size_t syncframe_size : syncframe_sizes) {
-    memcpy(dest, source, std::min(syncframe_size, leading_clear_bytes_size_));
+    CopyClearBytes(source, std::min(syncframe_size, leading_clear_bytes_size_),
+                   dest);
     if (syncframe_size > leading_clear_bytes_size_) {
       // The residual block is left unecrypted (copied without encryption). No
       // need to do special handling here.
@@ -602,8 +616,17 @@ void EncryptionHandler::EncryptBytes(const uint8_t* source,
                                      uint8_t* dest) {
   DCHECK(source);
   DCHECK(dest);
+  queued_bytes_.push_back({source, source_size, dest});
+}
+
+bool EncryptionHandler::EncryptQueuedBytes() {
   DCHECK(encryptor_);
-  CHECK(encryptor_->Crypt(source, source_size, dest));
+  // With a constant iv, e.g. 'cbcs' and SAMPLE-AES, every array starts a new
+  // cipher block chain, so the arrays of a sample can be encrypted in an
+  // interleaved fashion. Otherwise they are encrypted in order.
+  const bool success = encryptor_->CryptBatch(queued_bytes_);
+  queued_bytes_.clear();
+  return success;
 }
 
 bool EncryptionHandler::ExtractEac3SyncframeSizes(
@@ -7,6 +7,9 @@
 #ifndef PACKAGER_MEDIA_CRYPTO_ENCRYPTION_HANDLER_H_
 #define PACKAGER_MEDIA_CRYPTO_ENCRYPTION_HANDLER_H_
 
+#include <vector>
+
+#include "packager/media/base/aes_cryptor.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/media_handler.h"
 #include "packager/media/public/crypto_params.h"
@@ -14,7 +17,6 @@
 namespace shaka {
 namespace media {
 
-class AesCryptor;
 class VideoSliceHeaderParser;
 class VPxParser;
 struct EncryptionKey;
@@ -66,8 +68,12 @@ class EncryptionHandler : public MediaHandler {
                                  size_t source_size,
                                  uint8_t* dest);
   // Encrypt an array with size |source_size|. |dest| should have at
-  // least |source_size| bytes.
+  // least |source_size| bytes. The array is only queued for encryption, which
+  // happens in EncryptQueuedBytes.
   void EncryptBytes(const uint8_t* source, size_t source_size, uint8_t* dest);
+  // Encrypt the arrays queued by EncryptBytes as one batch, which allows the
+  // encryptor to interleave independent cipher block chains.
+  bool EncryptQueuedBytes();
 
   // An E-AC3 frame comprises of one or more syncframes. This function extracts
   // the syncframe sizes from the source bytes.
@@ -88,6 +94,8 @@ class EncryptionHandler : public MediaHandler {
   // Current encryption config and encryptor.
   std::shared_ptr<EncryptionConfig> encryption_config_;
   std::unique_ptr<AesCryptor> encryptor_;
+  // Arrays queued by EncryptBytes for the current sample.
+  std::vector<AesCryptor::BatchText> queued_bytes_;
   Codec codec_ = kUnknownCodec;
   // Specifies the size of NAL unit length in bytes. Can be 1, 2 or 4 bytes. 0
   // if it is not a NAL structured video.
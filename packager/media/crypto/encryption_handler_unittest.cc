@@ -644,6 +644,61 @@ TEST_P(EncryptionHandlerEncryptionTest, Encrypt) {
   EXPECT_EQ(expected, actual);
 }
 
+// Verify that a sample not referenced elsewhere is encrypted in place, while a
+// shared sample is encrypted into a copy and left untouched.
+TEST_P(EncryptionHandlerEncryptionTest, EncryptInPlaceIfNotShared) {
+  EncryptionParams encryption_params;
+  encryption_params.protection_scheme = protection_scheme_;
+  encryption_params.vp9_subsample_encryption = vp9_subsample_encryption_;
+  SetUpEncryptionHandler(encryption_params);
+
+  const EncryptionKey mock_encryption_key = GetMockEncryptionKey();
+  EXPECT_CALL(mock_key_source_, GetKey(_, _))
+      .WillOnce(
+          DoAll(SetArgPointee<1>(mock_encryption_key), Return(Status::OK)));
+
+  if (IsVideoCodec(codec_)) {
+    ASSERT_OK(Process(StreamData::FromStreamInfo(
+        kStreamIndex, GetVideoStreamInfo(kTimeScale, codec_))));
+  } else {
+    ASSERT_OK(Process(StreamData::FromStreamInfo(
+        kStreamIndex, GetAudioStreamInfo(kTimeScale, codec_))));
+  }
+  InjectCodecParser();
+
+  std::shared_ptr<MediaSample> sample =
+      GetMediaSample(0, kSampleDuration, kIsKeyFrame, kData, kDataSize);
+  const uint8_t* sample_data = sample->data();
+  ASSERT_OK(Process(StreamData::FromMediaSample(kStreamIndex,
+                                                std::move(sample))));
+  ASSERT_EQ(2u, GetOutputStreamDataVector().size());
+  const MediaSample* in_place_sample =
+      GetOutputStreamDataVector().back()->media_sample.get();
+  EXPECT_TRUE(in_place_sample->is_encrypted());
+  EXPECT_EQ(sample_data, in_place_sample->data());
+
+  // Reset the mock codec parser expectations for the second sample.
+  InjectCodecParser();
+  std::shared_ptr<MediaSample> shared_sample =
+      GetMediaSample(0, kSampleDuration, kIsKeyFrame, kData, kDataSize);
+  ASSERT_OK(Process(StreamData::FromMediaSample(kStreamIndex, shared_sample)));
+  ASSERT_EQ(3u, GetOutputStreamDataVector().size());
+  const MediaSample* copied_sample =
+      GetOutputStreamDataVector().back()->media_sample.get();
+  EXPECT_TRUE(copied_sample->is_encrypted());
+  EXPECT_NE(shared_sample->data(), copied_sample->data());
+  EXPECT_FALSE(shared_sample->is_encrypted());
+  EXPECT_EQ(std::vector<uint8_t>(kData, kData + kDataSize),
+            std::vector<uint8_t>(shared_sample->data(),
+                                 shared_sample->data() + kDataSize));
+
+  std::vector<uint8_t> actual(copied_sample->data(),
+                              copied_sample->data() + kDataSize);
+  ASSERT_TRUE(
+      Decrypt(*copied_sample->decrypt_config(), actual.data(), actual.size()));
+  EXPECT_EQ(std::vector<uint8_t>(kData, kData + kDataSize), actual);
+}
+
 // Verify that the data in short audio (less than leading clear bytes) is left
 // unencrypted.
 TEST_P(EncryptionHandlerEncryptionTest, SampleAesEncryptShortAudio) {
@@ -12,8 +12,10 @@
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/file/file.h"
+#include "packager/file/memory_accountant.h"
 #include "packager/media/base/decryptor_source.h"
 #include "packager/media/base/key_source.h"
+#include "packager/media/base/latency_tracer.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/stream_info.h"
 #include "packager/media/formats/mp2t/mp2t_media_parser.h"
@@ -109,8 +111,15 @@ Status Demuxer::Run() {
     }
   }
 
-  while (!cancelled_ && status.ok())
+  // Throttle reading while the buffering components downstream are over the
+  // memory budget.
+  MemoryAccountant* memory_accountant = MemoryAccountant::GetInstance();
+  memory_accountant->RegisterProducer();
+  while (!cancelled_ && status.ok()) {
+    memory_accountant->WaitForBudget(&cancelled_);
     status.Update(Parse());
+  }
+  memory_accountant->UnregisterProducer();
   if (cancelled_ && status.ok())
     return Status(error::CANCELLED, "Demuxer run cancelled");
 
@@ -126,7 +135,8 @@ Status Demuxer::Run() {
 }
 
 void Demuxer::Cancel() {
-  cancelled_ = true;
+  // The demuxer may be waiting for memory to be released.
+  MemoryAccountant::GetInstance()->CancelProducer(&cancelled_);
 }
 
 Status Demuxer::SetHandler(const std::string& stream_label,
@@ -279,6 +289,8 @@ void Demuxer::ParserInitEvent(
 
 bool Demuxer::NewSampleEvent(uint32_t track_id,
                              const std::shared_ptr<MediaSample>& sample) {
+  if (record_ingest_time_)
+    sample->set_ingest_time(last_read_time_);
   if (!all_streams_ready_) {
     if (queued_samples_.size() >= kQueuedSamplesLimit) {
       LOG(ERROR) << "Queued samples limit reached: " << kQueuedSamplesLimit;
@@ -330,6 +342,8 @@ Status Demuxer::Parse() {
   } else if (bytes_read < 0) {
     return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
   }
+  if (record_ingest_time_)
+    last_read_time_ = LatencyTracer::Now();
 
   return parser_->Parse(buffer_.get(), bytes_read)
              ? Status::OK
@@ -75,6 +75,12 @@ class Demuxer : public OriginHandler {
     dump_stream_info_ = dump_stream_info;
   }
 
+  /// Stamp the samples with the wall clock time at which their data was read,
+  /// for latency tracing.
+  void set_record_ingest_time(bool record_ingest_time) {
+    record_ingest_time_ = record_ingest_time;
+  }
+
  protected:
   /// @name MediaHandler implementation overrides.
   /// @{
@@ -141,6 +147,10 @@ class Demuxer : public OriginHandler {
   bool cancelled_ = false;
   // Whether to dump stream info when it is received.
   bool dump_stream_info_ = false;
+  // Whether to stamp the samples with their ingest time.
+  bool record_ingest_time_ = false;
+  // Wall clock time of the last read from the source, in microseconds.
+  int64_t last_read_time_ = 0;
   Status init_event_status_;
 };
 
@@ -43,6 +43,17 @@ void CombinedMuxerListener::OnMediaStart(const MuxerOptions& muxer_options,
   }
 }
 
+void CombinedMuxerListener::OnMultiplexedMediaStart(
+    const MuxerOptions& muxer_options,
+    const std::vector<std::shared_ptr<const StreamInfo>>& stream_infos,
+    uint32_t time_scale,
+    ContainerType container_type) {
+  for (auto& listener : muxer_listeners_) {
+    listener->OnMultiplexedMediaStart(muxer_options, stream_infos, time_scale,
+                                      container_type);
+  }
+}
+
 void CombinedMuxerListener::OnSampleDurationReady(uint32_t sample_duration) {
   for (auto& listener : muxer_listeners_) {
     listener->OnSampleDurationReady(sample_duration);
@@ -65,6 +76,13 @@ void CombinedMuxerListener::OnNewSegment(const std::string& file_name,
   }
 }
 
+void CombinedMuxerListener::OnSegmentClosed(int64_t ingest_time,
+                                            int64_t closed_time) {
+  for (auto& listener : muxer_listeners_) {
+    listener->OnSegmentClosed(ingest_time, closed_time);
+  }
+}
+
 void CombinedMuxerListener::OnCueEvent(uint64_t timestamp,
                                        const std::string& cue_data) {
   for (auto& listener : muxer_listeners_) {
@@ -32,6 +32,11 @@ class CombinedMuxerListener : public MuxerListener {
                     const StreamInfo& stream_info,
                     uint32_t time_scale,
                     ContainerType container_type) override;
+  void OnMultiplexedMediaStart(
+      const MuxerOptions& muxer_options,
+      const std::vector<std::shared_ptr<const StreamInfo>>& stream_infos,
+      uint32_t time_scale,
+      ContainerType container_type) override;
   void OnSampleDurationReady(uint32_t sample_duration) override;
   void OnMediaEnd(const MediaRanges& media_ranges,
                   float duration_seconds) override;
@@ -39,6 +44,7 @@ class CombinedMuxerListener : public MuxerListener {
                     uint64_t start_time,
                     uint64_t duration,
                     uint64_t segment_file_size) override;
+  void OnSegmentClosed(int64_t ingest_time, int64_t closed_time) override;
   void OnCueEvent(uint64_t timestamp, const std::string& cue_data) override;
 
  private:
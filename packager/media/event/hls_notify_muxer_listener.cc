@@ -89,28 +89,21 @@ void HlsNotifyMuxerListener::OnMediaStart(const MuxerOptions& muxer_options,
     LOG(ERROR) << "Failed to generate MediaInfo from input.";
     return;
   }
-  if (protection_scheme_ != FOURCC_NULL) {
-    internal::SetContentProtectionFields(protection_scheme_, next_key_id_,
-                                         next_key_system_infos_, &media_info);
-  }
-
-  media_info_ = media_info;
-  if (!media_info_.has_segment_template()) {
-    return;
-  }
+  StartMedia(media_info);
+}
 
-  const bool result = hls_notifier_->NotifyNewStream(
-      media_info, playlist_name_, ext_x_media_name_, ext_x_media_group_id_,
-      &stream_id_);
-  if (!result) {
-    LOG(WARNING) << "Failed to notify new stream.";
+void HlsNotifyMuxerListener::OnMultiplexedMediaStart(
+    const MuxerOptions& muxer_options,
+    const std::vector<std::shared_ptr<const StreamInfo>>& stream_infos,
+    uint32_t time_scale,
+    ContainerType container_type) {
+  MediaInfo media_info;
+  if (!internal::GenerateMediaInfo(muxer_options, stream_infos, time_scale,
+                                   container_type, &media_info)) {
+    LOG(ERROR) << "Failed to generate MediaInfo from input.";
     return;
   }
-
-  media_started_ = true;
-  if (must_notify_encryption_start_) {
-    OnEncryptionStart();
-  }
+  StartMedia(media_info);
 }
 
 void HlsNotifyMuxerListener::OnSampleDurationReady(uint32_t sample_duration) {}
@@ -194,6 +187,31 @@ void HlsNotifyMuxerListener::OnNewSegment(const std::string& file_name,
   LOG_IF(WARNING, !result) << "Failed to add new segment.";
 }
 
+void HlsNotifyMuxerListener::StartMedia(MediaInfo media_info) {
+  if (protection_scheme_ != FOURCC_NULL) {
+    internal::SetContentProtectionFields(protection_scheme_, next_key_id_,
+                                         next_key_system_infos_, &media_info);
+  }
+
+  media_info_ = media_info;
+  if (!media_info_.has_segment_template()) {
+    return;
+  }
+
+  const bool result = hls_notifier_->NotifyNewStream(
+      media_info_, playlist_name_, ext_x_media_name_, ext_x_media_group_id_,
+      &stream_id_);
+  if (!result) {
+    LOG(WARNING) << "Failed to notify new stream.";
+    return;
+  }
+
+  media_started_ = true;
+  if (must_notify_encryption_start_) {
+    OnEncryptionStart();
+  }
+}
+
 void HlsNotifyMuxerListener::OnCueEvent(uint64_t timestamp,
                                         const std::string& cue_data) {
   if (!media_info_.has_segment_template()) {
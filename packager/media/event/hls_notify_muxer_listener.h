@@ -51,6 +51,11 @@ class HlsNotifyMuxerListener : public MuxerListener {
                     const StreamInfo& stream_info,
                     uint32_t time_scale,
                     ContainerType container_type) override;
+  void OnMultiplexedMediaStart(
+      const MuxerOptions& muxer_options,
+      const std::vector<std::shared_ptr<const StreamInfo>>& stream_infos,
+      uint32_t time_scale,
+      ContainerType container_type) override;
   void OnSampleDurationReady(uint32_t sample_duration) override;
   void OnMediaEnd(const MediaRanges& media_ranges,
                   float duration_seconds) override;
@@ -70,6 +75,9 @@ class HlsNotifyMuxerListener : public MuxerListener {
     bool cue_break;
   };
 
+  // Notifies the new stream described by |media_info|.
+  void StartMedia(MediaInfo media_info);
+
   const std::string playlist_name_;
   const std::string ext_x_media_name_;
   const std::string ext_x_media_group_id_;
@@ -0,0 +1,55 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/event/latency_tracing_muxer_listener.h"
+
+#include "packager/base/logging.h"
+#include "packager/media/base/latency_tracer.h"
+
+namespace shaka {
+namespace media {
+
+LatencyTracingMuxerListener::LatencyTracingMuxerListener(
+    LatencyTracer* tracer,
+    bool publishes_manifest)
+    : tracer_(tracer), publishes_manifest_(publishes_manifest) {
+  DCHECK(tracer_);
+}
+
+void LatencyTracingMuxerListener::OnNewSegment(const std::string& file_name,
+                                               uint64_t start_time,
+                                               uint64_t duration,
+                                               uint64_t segment_file_size) {
+  if (pending_ingest_time_ == 0) {
+    CombinedMuxerListener::OnNewSegment(file_name, start_time, duration,
+                                        segment_file_size);
+    return;
+  }
+
+  LatencyTracer::SegmentTimes times;
+  times.ingest_time = pending_ingest_time_;
+  times.closed_time = pending_closed_time_;
+  times.flushed_time = LatencyTracer::Now();
+  CombinedMuxerListener::OnNewSegment(file_name, start_time, duration,
+                                      segment_file_size);
+  if (publishes_manifest_)
+    times.published_time = LatencyTracer::Now();
+  pending_ingest_time_ = 0;
+  pending_closed_time_ = 0;
+
+  tracer_->AddSegment(times);
+  tracer_->MaybeFlush();
+}
+
+void LatencyTracingMuxerListener::OnSegmentClosed(int64_t ingest_time,
+                                                  int64_t closed_time) {
+  CombinedMuxerListener::OnSegmentClosed(ingest_time, closed_time);
+  pending_ingest_time_ = ingest_time;
+  pending_closed_time_ = closed_time;
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,55 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_EVENT_LATENCY_TRACING_MUXER_LISTENER_H_
+#define PACKAGER_MEDIA_EVENT_LATENCY_TRACING_MUXER_LISTENER_H_
+
+#include "packager/base/macros.h"
+#include "packager/media/event/combined_muxer_listener.h"
+
+namespace shaka {
+namespace media {
+
+class LatencyTracer;
+
+/// A CombinedMuxerListener that times the segments flowing through it. A
+/// segment is considered flushed when OnNewSegment() is called for it, and
+/// published once the combined listeners have processed it.
+/// This assumes that the MPD and HLS notifiers write the live manifests
+/// before their listeners' OnNewSegment() returns, which is the case for
+/// SimpleMpdNotifier with dynamic MPDs and SimpleHlsNotifier with live and
+/// event playlists. A notifier which writes asynchronously would have to
+/// report the publication time itself.
+class LatencyTracingMuxerListener : public CombinedMuxerListener {
+ public:
+  /// @param tracer is where the segment times are recorded. It must outlive
+  ///        this listener.
+  /// @param publishes_manifest indicates whether the combined listeners
+  ///        publish the segments in manifests.
+  LatencyTracingMuxerListener(LatencyTracer* tracer, bool publishes_manifest);
+
+  void OnNewSegment(const std::string& file_name,
+                    uint64_t start_time,
+                    uint64_t duration,
+                    uint64_t segment_file_size) override;
+  void OnSegmentClosed(int64_t ingest_time, int64_t closed_time) override;
+
+ private:
+  LatencyTracer* const tracer_;
+  const bool publishes_manifest_;
+
+  // Times of the segment closed but not yet flushed. 0 if there is no such
+  // segment.
+  int64_t pending_ingest_time_ = 0;
+  int64_t pending_closed_time_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(LatencyTracingMuxerListener);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_EVENT_LATENCY_TRACING_MUXER_LISTENER_H_
@@ -0,0 +1,137 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/event/latency_tracing_muxer_listener.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "packager/media/base/latency_tracer.h"
+#include "packager/media/event/mock_muxer_listener.h"
+
+using ::testing::_;
+
+namespace shaka {
+namespace media {
+
+namespace {
+const int64_t kIngestTime = 1500000000000000;
+const int64_t kClosedTime = kIngestTime + 2000000;
+const char kSegmentName[] = "segment1.m4s";
+const uint64_t kStartTime = 0;
+const uint64_t kDuration = 90000;
+const uint64_t kSegmentFileSize = 1000;
+const char kNoOutputFile[] = "";
+const int64_t kNoFlushInterval = 0;
+}  // namespace
+
+class LatencyTracingMuxerListenerTest : public ::testing::Test {
+ protected:
+  LatencyTracingMuxerListenerTest()
+      : tracer_(kNoOutputFile, kNoFlushInterval) {}
+
+  void CreateListener(bool publishes_manifest) {
+    listener_.reset(
+        new LatencyTracingMuxerListener(&tracer_, publishes_manifest));
+    std::unique_ptr<MockMuxerListener> mock_listener(new MockMuxerListener);
+    mock_listener_ = mock_listener.get();
+    listener_->AddListener(std::move(mock_listener));
+  }
+
+  uint64_t NumSegments(LatencyTracer::Interval interval) {
+    return tracer_.GetHistogram(interval).count();
+  }
+
+  LatencyTracer tracer_;
+  std::unique_ptr<LatencyTracingMuxerListener> listener_;
+  MockMuxerListener* mock_listener_ = nullptr;
+};
+
+TEST_F(LatencyTracingMuxerListenerTest, RecordsSegment) {
+  CreateListener(true);
+  EXPECT_CALL(*mock_listener_, OnSegmentClosed(kIngestTime, kClosedTime));
+  EXPECT_CALL(*mock_listener_, OnNewSegment(kSegmentName, kStartTime,
+                                            kDuration, kSegmentFileSize));
+  listener_->OnSegmentClosed(kIngestTime, kClosedTime);
+  listener_->OnNewSegment(kSegmentName, kStartTime, kDuration,
+                          kSegmentFileSize);
+
+  EXPECT_EQ(1u, NumSegments(LatencyTracer::Interval::kIngestToClosed));
+  EXPECT_EQ(2000000,
+            tracer_.GetHistogram(LatencyTracer::Interval::kIngestToClosed)
+                .max());
+  EXPECT_EQ(1u, NumSegments(LatencyTracer::Interval::kClosedToFlushed));
+  EXPECT_EQ(1u, NumSegments(LatencyTracer::Interval::kIngestToPublished));
+}
+
+TEST_F(LatencyTracingMuxerListenerTest, NotPublished) {
+  CreateListener(false);
+  EXPECT_CALL(*mock_listener_, OnSegmentClosed(_, _));
+  EXPECT_CALL(*mock_listener_, OnNewSegment(_, _, _, _));
+  listener_->OnSegmentClosed(kIngestTime, kClosedTime);
+  listener_->OnNewSegment(kSegmentName, kStartTime, kDuration,
+                          kSegmentFileSize);
+
+  EXPECT_EQ(1u, NumSegments(LatencyTracer::Interval::kClosedToFlushed));
+  EXPECT_EQ(0u, NumSegments(LatencyTracer::Interval::kIngestToPublished));
+}
+
+TEST_F(LatencyTracingMuxerListenerTest, SegmentWithoutTimes) {
+  CreateListener(true);
+  EXPECT_CALL(*mock_listener_, OnNewSegment(_, _, _, _));
+  listener_->OnNewSegment(kSegmentName, kStartTime, kDuration,
+                          kSegmentFileSize);
+
+  EXPECT_EQ(0u, NumSegments(LatencyTracer::Interval::kIngestToClosed));
+}
+
+// A muxer multiplexing several streams reports the closed segment once, for
+// its main stream, so the segment is timed once.
+TEST_F(LatencyTracingMuxerListenerTest, MultiplexedStreams) {
+  CreateListener(true);
+  EXPECT_CALL(*mock_listener_, OnSegmentClosed(kIngestTime, kClosedTime));
+  EXPECT_CALL(*mock_listener_, OnNewSegment(_, _, _, _));
+  listener_->OnSegmentClosed(kIngestTime, kClosedTime);
+  listener_->OnNewSegment(kSegmentName, kStartTime, kDuration,
+                          kSegmentFileSize);
+
+  const LatencyHistogram histogram =
+      tracer_.GetHistogram(LatencyTracer::Interval::kIngestToClosed);
+  EXPECT_EQ(1u, histogram.count());
+  EXPECT_EQ(kClosedTime - kIngestTime, histogram.max());
+  EXPECT_EQ(1u, NumSegments(LatencyTracer::Interval::kIngestToPublished));
+}
+
+// The listeners of several streams share the tracer. Each of them times its
+// own segments.
+TEST_F(LatencyTracingMuxerListenerTest, MultipleStreams) {
+  CreateListener(true);
+  LatencyTracingMuxerListener audio_listener(&tracer_, true);
+  std::unique_ptr<MockMuxerListener> audio_mock_listener(new MockMuxerListener);
+  EXPECT_CALL(*audio_mock_listener, OnSegmentClosed(_, _));
+  EXPECT_CALL(*audio_mock_listener, OnNewSegment(_, _, _, _));
+  audio_listener.AddListener(std::move(audio_mock_listener));
+  EXPECT_CALL(*mock_listener_, OnSegmentClosed(_, _));
+  EXPECT_CALL(*mock_listener_, OnNewSegment(_, _, _, _));
+
+  const int64_t kAudioClosedTime = kClosedTime + 1000000;
+  listener_->OnSegmentClosed(kIngestTime, kClosedTime);
+  audio_listener.OnSegmentClosed(kIngestTime, kAudioClosedTime);
+  listener_->OnNewSegment(kSegmentName, kStartTime, kDuration,
+                          kSegmentFileSize);
+  audio_listener.OnNewSegment(kSegmentName, kStartTime, kDuration,
+                              kSegmentFileSize);
+
+  const LatencyHistogram histogram =
+      tracer_.GetHistogram(LatencyTracer::Interval::kIngestToClosed);
+  EXPECT_EQ(2u, histogram.count());
+  EXPECT_EQ(kClosedTime - kIngestTime, histogram.min());
+  EXPECT_EQ(kAudioClosedTime - kIngestTime, histogram.max());
+  EXPECT_EQ(2u, NumSegments(LatencyTracer::Interval::kIngestToPublished));
+}
+
+}  // namespace media
+}  // namespace shaka
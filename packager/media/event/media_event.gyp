@@ -17,6 +17,8 @@
         'combined_muxer_listener.h',
         'hls_notify_muxer_listener.cc',
         'hls_notify_muxer_listener.h',
+        'latency_tracing_muxer_listener.cc',
+        'latency_tracing_muxer_listener.h',
         'mpd_notify_muxer_listener.cc',
         'mpd_notify_muxer_listener.h',
         'muxer_listener.h',
@@ -24,6 +26,8 @@
         'muxer_listener_factory.h',
         'muxer_listener_internal.cc',
         'muxer_listener_internal.h',
+        'progress_tracking_muxer_listener.cc',
+        'progress_tracking_muxer_listener.h',
         'vod_media_info_dump_muxer_listener.cc',
         'vod_media_info_dump_muxer_listener.h',
       ],
@@ -53,9 +57,11 @@
       'type': '<(gtest_target_type)',
       'sources': [
         'hls_notify_muxer_listener_unittest.cc',
+        'latency_tracing_muxer_listener_unittest.cc',
         'mpd_notify_muxer_listener_unittest.cc',
         'muxer_listener_test_helper.cc',
         'muxer_listener_test_helper.h',
+        'progress_tracking_muxer_listener_unittest.cc',
         'vod_media_info_dump_muxer_listener_unittest.cc',
       ],
       'dependencies': [
@@ -68,6 +74,7 @@
         '../../third_party/protobuf/protobuf.gyp:protobuf_full_do_not_use',
         '../test/media_test.gyp:run_tests_with_atexit_manager',
         'media_event',
+        'mock_muxer_listener',
       ],
     },
   ],
@@ -62,6 +62,8 @@ class MockMuxerListener : public MuxerListener {
                     uint64_t duration,
                     uint64_t segment_file_size));
 
+  MOCK_METHOD2(OnSegmentClosed, void(int64_t ingest_time, int64_t closed_time));
+
   MOCK_METHOD2(OnCueEvent,
                void(uint64_t timestamp, const std::string& cue_data));
 };
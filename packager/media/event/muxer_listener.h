@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -28,7 +29,8 @@ class StreamInfo;
 /// MuxerListener is an event handler that can be registered to a muxer.
 /// A MuxerListener cannot be shared amongst muxer instances, in other words,
 /// every muxer instance either owns a unique MuxerListener instance.
-/// This also assumes that there is one media stream per muxer.
+/// This also assumes that there is one media stream per muxer, except for
+/// OnMultiplexedMediaStart().
 class MuxerListener {
  public:
   enum ContainerType {
@@ -36,7 +38,8 @@ class MuxerListener {
     kContainerMp4,
     kContainerMpeg2ts,
     kContainerWebM,
-    kContainerText
+    kContainerText,
+    kContainerPackedAudio
   };
 
   /// Structure for specifying ranges within a media file. This is mainly for
@@ -99,6 +102,25 @@ class MuxerListener {
                             uint32_t time_scale,
                             ContainerType container_type) = 0;
 
+  /// Called instead of OnMediaStart() when several streams are multiplexed in
+  /// the output, e.g. the video and audio streams of an MPEG2-TS output. The
+  /// other events are fired once for the output and refer to the main stream.
+  /// The default implementation calls OnMediaStart() with the main stream.
+  /// @param muxer_options is the options for Muxer.
+  /// @param stream_infos are the information of the multiplexed media. The
+  ///        first one is the main stream.
+  /// @param time_scale is a reference time scale that overrides the time scale
+  ///         specified in @a stream_infos.
+  /// @param container_type is the container of this media.
+  virtual void OnMultiplexedMediaStart(
+      const MuxerOptions& muxer_options,
+      const std::vector<std::shared_ptr<const StreamInfo>>& stream_infos,
+      uint32_t time_scale,
+      ContainerType container_type) {
+    OnMediaStart(muxer_options, *stream_infos.front(), time_scale,
+                 container_type);
+  }
+
   /// Called when the average sample duration of the media is determined.
   /// @param sample_duration in timescale of the media.
   virtual void OnSampleDurationReady(uint32_t sample_duration) = 0;
@@ -128,6 +150,14 @@ class MuxerListener {
                             uint64_t duration,
                             uint64_t segment_file_size) = 0;
 
+  /// Called when a segment that carries latency tracing timestamps is closed,
+  /// before the segment is written and OnNewSegment() is called for it.
+  /// @param ingest_time is the wall clock ingest time of the first sample in
+  ///        the segment, in microseconds since the Unix epoch.
+  /// @param closed_time is the wall clock time the segment was closed, in
+  ///        microseconds since the Unix epoch.
+  virtual void OnSegmentClosed(int64_t ingest_time, int64_t closed_time) {}
+
   /// Called when there is a new Ad Cue, which should align with (sub)segments.
   /// @param timestamp indicate the cue timestamp.
   /// @param cue_data is the data of the cue.
@@ -10,8 +10,10 @@
 #include "packager/hls/base/hls_notifier.h"
 #include "packager/media/event/combined_muxer_listener.h"
 #include "packager/media/event/hls_notify_muxer_listener.h"
+#include "packager/media/event/latency_tracing_muxer_listener.h"
 #include "packager/media/event/mpd_notify_muxer_listener.h"
 #include "packager/media/event/muxer_listener.h"
+#include "packager/media/event/progress_tracking_muxer_listener.h"
 #include "packager/media/event/vod_media_info_dump_muxer_listener.h"
 #include "packager/mpd/base/mpd_notifier.h"
 
@@ -70,17 +72,27 @@ std::unique_ptr<MuxerListener> CreateHlsListenerInternal(
 
 MuxerListenerFactory::MuxerListenerFactory(bool output_media_info,
                                            MpdNotifier* mpd_notifier,
-                                           hls::HlsNotifier* hls_notifier)
+                                           hls::HlsNotifier* hls_notifier,
+                                           LatencyTracer* latency_tracer,
+                                           OutputProgress* output_progress)
     : output_media_info_(output_media_info),
       mpd_notifier_(mpd_notifier),
-      hls_notifier_(hls_notifier) {}
+      hls_notifier_(hls_notifier),
+      latency_tracer_(latency_tracer),
+      output_progress_(output_progress) {}
 
 std::unique_ptr<MuxerListener> MuxerListenerFactory::CreateListener(
     const StreamData& stream) {
   const int stream_index = stream_index_++;
 
-  std::unique_ptr<CombinedMuxerListener> combined_listener(
-      new CombinedMuxerListener);
+  std::unique_ptr<CombinedMuxerListener> combined_listener;
+  if (latency_tracer_) {
+    const bool publishes_manifest = mpd_notifier_ || hls_notifier_;
+    combined_listener.reset(
+        new LatencyTracingMuxerListener(latency_tracer_, publishes_manifest));
+  } else {
+    combined_listener.reset(new CombinedMuxerListener);
+  }
 
   if (output_media_info_) {
     combined_listener->AddListener(
@@ -93,6 +105,10 @@ std::unique_ptr<MuxerListener> MuxerListenerFactory::CreateListener(
     combined_listener->AddListener(
         CreateHlsListenerInternal(stream, stream_index, hls_notifier_));
   }
+  if (output_progress_) {
+    combined_listener->AddListener(std::unique_ptr<MuxerListener>(
+        new ProgressTrackingMuxerListener(output_progress_)));
+  }
 
   return std::move(combined_listener);
 }
@@ -18,7 +18,9 @@ class HlsNotifier;
 }
 
 namespace media {
+class LatencyTracer;
 class MuxerListener;
+class OutputProgress;
 
 /// Factory class for creating MuxerListeners. Will produce a single muxer
 /// listener that will wrap the various muxer listeners that the factory
@@ -26,6 +28,8 @@ class MuxerListener;
 ///    - Media Info Dump
 ///    - HLS
 ///    - MPD
+///    - Latency tracing
+///    - Progress tracking
 ///
 /// The listeners that will be combined will be based on the parameters given
 /// when constructing the factory.
@@ -52,9 +56,15 @@ class MuxerListenerFactory {
   ///        mpd listener.
   /// @param hls_notifier must be non-null for the combined listener to include
   ///        an HLS listener.
+  /// @param latency_tracer must be non-null for the combined listener to
+  ///        record segment latencies in it.
+  /// @param output_progress must be non-null for the combined listener to
+  ///        record the segments written in it.
   MuxerListenerFactory(bool output_media_info,
                        MpdNotifier* mpd_notifier,
-                       hls::HlsNotifier* hls_notifier);
+                       hls::HlsNotifier* hls_notifier,
+                       LatencyTracer* latency_tracer,
+                       OutputProgress* output_progress);
 
   /// Create a listener for a stream.
   std::unique_ptr<MuxerListener> CreateListener(const StreamData& stream);
@@ -70,6 +80,8 @@ class MuxerListenerFactory {
   bool output_media_info_;
   MpdNotifier* mpd_notifier_;
   hls::HlsNotifier* hls_notifier_;
+  LatencyTracer* latency_tracer_;
+  OutputProgress* output_progress_;
 
   // A counter to track which stream we are on.
   int stream_index_ = 0;
@@ -63,6 +63,9 @@ void SetMediaInfoContainerType(MuxerListener::ContainerType container_type,
     case MuxerListener::kContainerText:
       media_info->set_container_type(MediaInfo::CONTAINER_TEXT);
       break;
+    case MuxerListener::kContainerPackedAudio:
+      media_info->set_container_type(MediaInfo::CONTAINER_PACKED_AUDIO);
+      break;
     default:
       NOTREACHED() << "Unknown container type " << container_type;
   }
@@ -193,6 +196,34 @@ bool GenerateMediaInfo(const MuxerOptions& muxer_options,
   return true;
 }
 
+bool GenerateMediaInfo(
+    const MuxerOptions& muxer_options,
+    const std::vector<std::shared_ptr<const StreamInfo>>& stream_infos,
+    uint32_t reference_time_scale,
+    MuxerListener::ContainerType container_type,
+    MediaInfo* media_info) {
+  DCHECK(media_info);
+
+  SetMediaInfoMuxerOptions(muxer_options, media_info);
+  for (const std::shared_ptr<const StreamInfo>& stream_info : stream_infos) {
+    const StreamType stream_type = stream_info->stream_type();
+    if ((stream_type == kStreamVideo && media_info->has_video_info()) ||
+        (stream_type == kStreamAudio && media_info->has_audio_info()) ||
+        (stream_type == kStreamText && media_info->has_text_info())) {
+      LOG(WARNING) << "Only the first stream of each type is described for "
+                      "the multiplexed output.";
+      continue;
+    }
+    SetMediaInfoStreamInfo(*stream_info, media_info);
+  }
+  media_info->set_reference_time_scale(reference_time_scale);
+  SetMediaInfoContainerType(container_type, media_info);
+  if (muxer_options.bandwidth > 0)
+    media_info->set_bandwidth(muxer_options.bandwidth);
+
+  return true;
+}
+
 bool SetVodInformation(const MuxerListener::MediaRanges& media_ranges,
                        float duration_seconds,
                        MediaInfo* media_info) {
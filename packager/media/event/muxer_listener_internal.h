@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -33,6 +34,17 @@ bool GenerateMediaInfo(const MuxerOptions& muxer_options,
                        MuxerListener::ContainerType container_type,
                        MediaInfo* media_info);
 
+/// Same as above, for an output multiplexing several streams. At most one
+/// stream of each type is described.
+/// @param[out] media_info points to the MediaInfo object to be filled.
+/// @return true on success, false otherwise.
+bool GenerateMediaInfo(
+    const MuxerOptions& muxer_options,
+    const std::vector<std::shared_ptr<const StreamInfo>>& stream_infos,
+    uint32_t reference_time_scale_,
+    MuxerListener::ContainerType container_type,
+    MediaInfo* media_info);
+
 /// @param[in,out] media_info points to the MediaInfo object to be filled.
 /// @return true on success, false otherwise.
 bool SetVodInformation(const MuxerListener::MediaRanges& media_ranges,
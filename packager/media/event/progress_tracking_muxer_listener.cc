@@ -0,0 +1,42 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/event/progress_tracking_muxer_listener.h"
+
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace media {
+
+void OutputProgress::AddSegment(uint64_t size) {
+  base::AutoLock auto_lock(lock_);
+  ++num_segments_;
+  num_bytes_ += size;
+}
+
+void OutputProgress::Get(uint64_t* num_segments, uint64_t* num_bytes) const {
+  DCHECK(num_segments);
+  DCHECK(num_bytes);
+  base::AutoLock auto_lock(lock_);
+  *num_segments = num_segments_;
+  *num_bytes = num_bytes_;
+}
+
+ProgressTrackingMuxerListener::ProgressTrackingMuxerListener(
+    OutputProgress* progress)
+    : progress_(progress) {
+  DCHECK(progress_);
+}
+
+void ProgressTrackingMuxerListener::OnNewSegment(const std::string& file_name,
+                                                 uint64_t start_time,
+                                                 uint64_t duration,
+                                                 uint64_t segment_file_size) {
+  progress_->AddSegment(segment_file_size);
+}
+
+}  // namespace media
+}  // namespace shaka
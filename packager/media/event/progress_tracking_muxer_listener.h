@@ -0,0 +1,80 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_EVENT_PROGRESS_TRACKING_MUXER_LISTENER_H_
+#define PACKAGER_MEDIA_EVENT_PROGRESS_TRACKING_MUXER_LISTENER_H_
+
+#include <stdint.h>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/media/event/muxer_listener.h"
+
+namespace shaka {
+namespace media {
+
+/// The output written so far by the muxers of a packaging job. It is updated
+/// by the muxer threads and can be read from any thread.
+class OutputProgress {
+ public:
+  OutputProgress() = default;
+
+  /// Record a segment, or a subsegment, of @a size bytes.
+  void AddSegment(uint64_t size);
+
+  /// @param num_segments receives the number of (sub)segments written.
+  /// @param num_bytes receives the number of bytes in these segments.
+  void Get(uint64_t* num_segments, uint64_t* num_bytes) const;
+
+ private:
+  mutable base::Lock lock_;
+  uint64_t num_segments_ = 0;
+  uint64_t num_bytes_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(OutputProgress);
+};
+
+/// A MuxerListener that records the segments of a stream in an
+/// OutputProgress.
+class ProgressTrackingMuxerListener : public MuxerListener {
+ public:
+  /// @param progress is where the segments are recorded. It must outlive this
+  ///        listener.
+  explicit ProgressTrackingMuxerListener(OutputProgress* progress);
+
+  /// @name MuxerListener implementation overrides.
+  /// @{
+  void OnEncryptionInfoReady(bool is_initial_encryption_info,
+                             FourCC protection_scheme,
+                             const std::vector<uint8_t>& key_id,
+                             const std::vector<uint8_t>& iv,
+                             const std::vector<ProtectionSystemSpecificInfo>&
+                                 key_system_info) override {}
+  void OnEncryptionStart() override {}
+  void OnMediaStart(const MuxerOptions& muxer_options,
+                    const StreamInfo& stream_info,
+                    uint32_t time_scale,
+                    ContainerType container_type) override {}
+  void OnSampleDurationReady(uint32_t sample_duration) override {}
+  void OnMediaEnd(const MediaRanges& media_ranges,
+                  float duration_seconds) override {}
+  void OnNewSegment(const std::string& file_name,
+                    uint64_t start_time,
+                    uint64_t duration,
+                    uint64_t segment_file_size) override;
+  void OnCueEvent(uint64_t timestamp, const std::string& cue_data) override {}
+  /// @}
+
+ private:
+  OutputProgress* const progress_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProgressTrackingMuxerListener);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_EVENT_PROGRESS_TRACKING_MUXER_LISTENER_H_
@@ -0,0 +1,50 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/event/progress_tracking_muxer_listener.h"
+
+#include <gtest/gtest.h>
+
+namespace shaka {
+namespace media {
+
+namespace {
+const uint64_t kStartTime = 0;
+const uint64_t kDuration = 90000;
+const uint64_t kSegmentFileSize1 = 1000;
+const uint64_t kSegmentFileSize2 = 2500;
+}  // namespace
+
+TEST(ProgressTrackingMuxerListenerTest, NoSegment) {
+  OutputProgress progress;
+  uint64_t num_segments = 1;
+  uint64_t num_bytes = 1;
+  progress.Get(&num_segments, &num_bytes);
+  EXPECT_EQ(0u, num_segments);
+  EXPECT_EQ(0u, num_bytes);
+}
+
+// The listeners of all the streams of a job record into the same progress.
+TEST(ProgressTrackingMuxerListenerTest, SharedByStreams) {
+  OutputProgress progress;
+  ProgressTrackingMuxerListener video_listener(&progress);
+  ProgressTrackingMuxerListener audio_listener(&progress);
+  video_listener.OnNewSegment("video1.m4s", kStartTime, kDuration,
+                              kSegmentFileSize1);
+  audio_listener.OnNewSegment("audio1.m4s", kStartTime, kDuration,
+                              kSegmentFileSize2);
+  video_listener.OnNewSegment("video2.m4s", kStartTime + kDuration, kDuration,
+                              kSegmentFileSize1);
+
+  uint64_t num_segments = 0;
+  uint64_t num_bytes = 0;
+  progress.Get(&num_segments, &num_bytes);
+  EXPECT_EQ(3u, num_segments);
+  EXPECT_EQ(2 * kSegmentFileSize1 + kSegmentFileSize2, num_bytes);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -30,11 +30,13 @@ const uint8_t kAc3AudioStreamId = 0xBD;  // AC3 uses private stream 1 id.
 const double kTsTimescale = 90000.0;
 }  // namespace
 
-PesPacketGenerator::PesPacketGenerator() {}
+PesPacketGenerator::PesPacketGenerator()
+    : pes_packets_memory_(MemoryComponent::kPesPackets) {}
 PesPacketGenerator::~PesPacketGenerator() {}
 
 bool PesPacketGenerator::Initialize(const StreamInfo& stream_info) {
   pes_packets_.clear();
+  pes_packets_memory_.ReleaseAll();
   stream_type_ = stream_info.stream_type();
 
   if (stream_type_ == kStreamVideo) {
@@ -94,6 +96,7 @@ bool PesPacketGenerator::PushSample(const MediaSample& sample) {
 
     current_processing_pes_->mutable_data()->swap(byte_stream);
     current_processing_pes_->set_stream_id(kVideoStreamId);
+    pes_packets_memory_.Charge(current_processing_pes_->data().size());
     pes_packets_.push_back(std::move(current_processing_pes_));
     return true;
   }
@@ -116,6 +119,7 @@ bool PesPacketGenerator::PushSample(const MediaSample& sample) {
   // packets.
   current_processing_pes_->mutable_data()->swap(audio_frame);
   current_processing_pes_->set_stream_id(audio_stream_id_);
+  pes_packets_memory_.Charge(current_processing_pes_->data().size());
   pes_packets_.push_back(std::move(current_processing_pes_));
   return true;
 }
@@ -128,6 +132,7 @@ std::unique_ptr<PesPacket> PesPacketGenerator::GetNextPesPacket() {
   DCHECK(!pes_packets_.empty());
   std::unique_ptr<PesPacket> pes = std::move(pes_packets_.front());
   pes_packets_.pop_front();
+  pes_packets_memory_.Release(pes->data().size());
   return pes;
 }
 
@@ -10,6 +10,7 @@
 #include <list>
 #include <memory>
 
+#include "packager/file/memory_accountant.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/stream_info.h"
 
@@ -76,6 +77,8 @@ class PesPacketGenerator {
   // Audio stream id PES packet is codec dependent.
   uint8_t audio_stream_id_ = 0;
   std::list<std::unique_ptr<PesPacket>> pes_packets_;
+  // Memory held by |pes_packets_|.
+  MemoryCharge pes_packets_memory_;
 
   DISALLOW_COPY_AND_ASSIGN(PesPacketGenerator);
 };
@@ -215,11 +215,9 @@ bool WriteRegistrationDescriptorForEncryptedAudio(Codec codec,
   return true;
 }
 
-void WritePmtWithParameters(uint8_t stream_type,
+void WritePmtWithParameters(const BufferWriter& elementary_streams,
                             int version,
                             int current_next_indicator,
-                            const uint8_t* descriptors,
-                            size_t descriptors_size,
                             BufferWriter* pmt) {
   DCHECK(current_next_indicator == kCurrent || current_next_indicator == kNext);
   // Body starting from program number.
@@ -235,24 +233,15 @@ void WritePmtWithParameters(uint8_t stream_type,
   pmt_body.AppendInt(static_cast<uint8_t>(0x00));
   // last section number.
   pmt_body.AppendInt(static_cast<uint8_t>(0x00));
-  // first 3 bits reserved. Rest is unused bits for PCR PID.
+  // first 3 bits reserved. Rest is unused bits for PCR PID. The PCR is carried
+  // by the first elementary stream.
   pmt_body.AppendInt(static_cast<uint8_t>(0xE0));
-  pmt_body.AppendInt(ProgramMapTableWriter::kElementaryPid);
+  pmt_body.AppendInt(ProgramMapTableWriter::ElementaryPid(0));
   // First 4 bits are reserved. Next 12 bits is program_info_length which is 0.
   pmt_body.AppendInt(static_cast<uint8_t>(0xF0));
   pmt_body.AppendInt(static_cast<uint8_t>(0x00));
 
-  pmt_body.AppendInt(stream_type);
-  // 3 reserved bits followed by 13 bit elementary_PID.
-  pmt_body.AppendInt(static_cast<uint8_t>(0xE0));
-  pmt_body.AppendInt(ProgramMapTableWriter::kElementaryPid);
-
-  // 4 reserved bits followed by ES_info_length.
-  pmt_body.AppendInt(static_cast<uint16_t>(0xF000 | descriptors_size));
-  if (descriptors_size > 0) {
-    DCHECK(descriptors);
-    pmt_body.AppendArray(descriptors, descriptors_size);
-  }
+  pmt_body.AppendBuffer(elementary_streams);
 
   pmt->Clear();
   // Pointer field is not really part of the PMT but it's there so that an extra
@@ -275,33 +264,14 @@ ProgramMapTableWriter::ProgramMapTableWriter(Codec codec) : codec_(codec) {}
 
 bool ProgramMapTableWriter::EncryptedSegmentPmt(BufferWriter* writer) {
   if (encrypted_pmt_.Size() == 0) {
-    TsStreamType stream_type;
-    switch (codec_) {
-      case kCodecH264:
-        stream_type = TsStreamType::kEncryptedAvc;
-        break;
-      case kCodecAAC:
-        stream_type = TsStreamType::kEncryptedAdtsAac;
-        break;
-      case kCodecAC3:
-        stream_type = TsStreamType::kEncryptedAc3;
-        break;
-      case kCodecEAC3:
-        stream_type = TsStreamType::kEncryptedEac3;
-        break;
-      default:
-        LOG(ERROR) << "Codec " << codec_ << " is not supported in TS yet.";
-        return false;
-    }
-
-    BufferWriter descriptors;
-    if (!WriteDescriptors(&descriptors))
+    const bool kEncrypted = true;
+    BufferWriter elementary_streams;
+    if (!WriteElementaryStreams(kEncrypted, &elementary_streams))
       return false;
 
     const bool has_clear_lead = clear_pmt_.Size() > 0;
-    WritePmtWithParameters(static_cast<uint8_t>(stream_type),
+    WritePmtWithParameters(elementary_streams,
                            has_clear_lead ? kVersion1 : kVersion0, kCurrent,
-                           descriptors.Buffer(), descriptors.Size(),
                            &encrypted_pmt_);
     DCHECK_NE(encrypted_pmt_.Size(), 0u);
   }
@@ -312,27 +282,13 @@ bool ProgramMapTableWriter::EncryptedSegmentPmt(BufferWriter* writer) {
 
 bool ProgramMapTableWriter::ClearSegmentPmt(BufferWriter* writer) {
   if (clear_pmt_.Size() == 0) {
-    TsStreamType stream_type;
-    switch (codec_) {
-      case kCodecH264:
-        stream_type = TsStreamType::kAvc;
-        break;
-      case kCodecAAC:
-        stream_type = TsStreamType::kAdtsAac;
-        break;
-      case kCodecAC3:
-        stream_type = TsStreamType::kAc3;
-        break;
-      case kCodecEAC3:
-        stream_type = TsStreamType::kEac3;
-        break;
-      default:
-        LOG(ERROR) << "Codec " << codec_ << " is not supported in TS yet.";
-        return false;
-    }
+    const bool kEncrypted = true;
+    BufferWriter elementary_streams;
+    if (!WriteElementaryStreams(!kEncrypted, &elementary_streams))
+      return false;
 
-    WritePmtWithParameters(static_cast<uint8_t>(stream_type), kVersion0,
-                           kCurrent, nullptr, 0, &clear_pmt_);
+    WritePmtWithParameters(elementary_streams, kVersion0, kCurrent,
+                           &clear_pmt_);
     DCHECK_NE(clear_pmt_.Size(), 0u);
   }
   WritePmtToBuffer(clear_pmt_.Buffer(), clear_pmt_.Size(), &continuity_counter_,
@@ -340,6 +296,53 @@ bool ProgramMapTableWriter::ClearSegmentPmt(BufferWriter* writer) {
   return true;
 }
 
+bool ProgramMapTableWriter::WriteElementaryStreamInfo(
+    bool encrypted,
+    uint8_t elementary_pid,
+    BufferWriter* writer) const {
+  TsStreamType stream_type;
+  switch (codec_) {
+    case kCodecH264:
+      stream_type =
+          encrypted ? TsStreamType::kEncryptedAvc : TsStreamType::kAvc;
+      break;
+    case kCodecAAC:
+      stream_type =
+          encrypted ? TsStreamType::kEncryptedAdtsAac : TsStreamType::kAdtsAac;
+      break;
+    case kCodecAC3:
+      stream_type =
+          encrypted ? TsStreamType::kEncryptedAc3 : TsStreamType::kAc3;
+      break;
+    case kCodecEAC3:
+      stream_type =
+          encrypted ? TsStreamType::kEncryptedEac3 : TsStreamType::kEac3;
+      break;
+    default:
+      LOG(ERROR) << "Codec " << codec_ << " is not supported in TS yet.";
+      return false;
+  }
+
+  // Descriptors are only needed for encrypted segments.
+  BufferWriter descriptors;
+  if (encrypted && !WriteDescriptors(&descriptors))
+    return false;
+
+  writer->AppendInt(static_cast<uint8_t>(stream_type));
+  // 3 reserved bits followed by 13 bit elementary_PID.
+  writer->AppendInt(static_cast<uint8_t>(0xE0));
+  writer->AppendInt(elementary_pid);
+  // 4 reserved bits followed by ES_info_length.
+  writer->AppendInt(static_cast<uint16_t>(0xF000 | descriptors.Size()));
+  writer->AppendBuffer(descriptors);
+  return true;
+}
+
+bool ProgramMapTableWriter::WriteElementaryStreams(bool encrypted,
+                                                   BufferWriter* writer) const {
+  return WriteElementaryStreamInfo(encrypted, ElementaryPid(0), writer);
+}
+
 VideoProgramMapTableWriter::VideoProgramMapTableWriter(Codec codec)
     : ProgramMapTableWriter(codec) {}
 
@@ -407,6 +410,33 @@ bool AudioProgramMapTableWriter::WriteDescriptors(
       descriptors);
 }
 
+// The codec of the program is not used as each elementary stream is described
+// by its own writer.
+MultiStreamProgramMapTableWriter::MultiStreamProgramMapTableWriter(
+    std::vector<std::unique_ptr<ProgramMapTableWriter>> stream_writers)
+    : ProgramMapTableWriter(kUnknownCodec),
+      stream_writers_(std::move(stream_writers)) {
+  DCHECK(!stream_writers_.empty());
+}
+
+bool MultiStreamProgramMapTableWriter::WriteElementaryStreams(
+    bool encrypted,
+    BufferWriter* writer) const {
+  for (size_t i = 0; i < stream_writers_.size(); ++i) {
+    if (!stream_writers_[i]->WriteElementaryStreamInfo(
+            encrypted, ElementaryPid(i), writer)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MultiStreamProgramMapTableWriter::WriteDescriptors(
+    BufferWriter* writer) const {
+  NOTREACHED();
+  return false;
+}
+
 }  // namespace mp2t
 }  // namespace media
 }  // namespace shaka
@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <vector>
 
 #include "packager/media/base/buffer_writer.h"
@@ -37,6 +38,22 @@ class ProgramMapTableWriter {
   // Virtual for testing.
   virtual bool ClearSegmentPmt(BufferWriter* writer);
 
+  /// Writes the entry of the elementary stream in the PMT, i.e. its
+  /// stream_type, elementary_PID and descriptors.
+  /// @param encrypted specifies whether the entry is for encrypted segments.
+  /// @param elementary_pid is the PID carrying the elementary stream.
+  /// @param writer is where the entry is written to.
+  /// @return true on success, false otherwise.
+  bool WriteElementaryStreamInfo(bool encrypted,
+                                 uint8_t elementary_pid,
+                                 BufferWriter* writer) const;
+
+  /// @return the PID of the elementary stream at @a stream_index in the
+  ///         program. The first elementary stream carries the PCR.
+  static uint8_t ElementaryPid(size_t stream_index) {
+    return kElementaryPid + static_cast<uint8_t>(stream_index);
+  }
+
   // The pid can be 13 bits long but 8 bits is sufficient for this library.
   // This is the minimum PID that can be used for PMT.
   static const uint8_t kPmtPid = 0x20;
@@ -52,6 +69,10 @@ class ProgramMapTableWriter {
   ProgramMapTableWriter(const ProgramMapTableWriter&) = delete;
   ProgramMapTableWriter& operator=(const ProgramMapTableWriter&) = delete;
 
+  // Writes the entries of all the elementary streams in the program.
+  virtual bool WriteElementaryStreams(bool encrypted,
+                                      BufferWriter* writer) const;
+
   // Writes descriptors for PMT (only needed for encrypted PMT).
   virtual bool WriteDescriptors(BufferWriter* writer) const = 0;
 
@@ -93,6 +114,33 @@ class AudioProgramMapTableWriter : public ProgramMapTableWriter {
   const std::vector<uint8_t> audio_specific_config_;
 };
 
+/// ProgramMapTableWriter for a program with more than one elementary stream,
+/// e.g. a video stream and its audio streams multiplexed in one transport
+/// stream. The elementary streams are carried on consecutive PIDs in the order
+/// of the writers, see ElementaryPid().
+class MultiStreamProgramMapTableWriter : public ProgramMapTableWriter {
+ public:
+  /// @param stream_writers are the writers of the individual elementary
+  ///        streams. The first one should be the video stream, which carries
+  ///        the PCR.
+  explicit MultiStreamProgramMapTableWriter(
+      std::vector<std::unique_ptr<ProgramMapTableWriter>> stream_writers);
+  ~MultiStreamProgramMapTableWriter() override = default;
+
+ private:
+  MultiStreamProgramMapTableWriter(const MultiStreamProgramMapTableWriter&) =
+      delete;
+  MultiStreamProgramMapTableWriter& operator=(
+      const MultiStreamProgramMapTableWriter&) = delete;
+
+  bool WriteElementaryStreams(bool encrypted,
+                              BufferWriter* writer) const override;
+  // The descriptors are written by |stream_writers_|.
+  bool WriteDescriptors(BufferWriter* writer) const override;
+
+  const std::vector<std::unique_ptr<ProgramMapTableWriter>> stream_writers_;
+};
+
 }  // namespace mp2t
 }  // namespace media
 }  // namespace shaka
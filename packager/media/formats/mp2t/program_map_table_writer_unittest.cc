@@ -424,6 +424,116 @@ TEST_F(ProgramMapTableWriterTest, EncryptedSegmentsAc3Pmt) {
       kPmtEncryptedAc3, arraysize(kPmtEncryptedAc3), buffer.Buffer()));
 }
 
+TEST_F(ProgramMapTableWriterTest, ClearMultiStream) {
+  std::vector<std::unique_ptr<ProgramMapTableWriter>> stream_writers;
+  stream_writers.emplace_back(new VideoProgramMapTableWriter(kCodecH264));
+  stream_writers.emplace_back(new AudioProgramMapTableWriter(
+      kCodecAAC, std::vector<uint8_t>(std::begin(kAacBasicProfileExtraData),
+                                      std::end(kAacBasicProfileExtraData))));
+  MultiStreamProgramMapTableWriter writer(std::move(stream_writers));
+  BufferWriter buffer;
+  writer.ClearSegmentPmt(&buffer);
+
+  const uint8_t kExpectedPmtPrefix[] = {
+      0x47,  // Sync byte.
+      0x40,  // payload_unit_start_indicator set.
+      0x20,  // pid.
+      0x30,  // Adaptation field and payload are both present. counter = 0.
+      0x9C,  // Adaptation Field length.
+      0x00,  // All adaptation field flags 0.
+  };
+  const int kExpectedPmtPrefixSize = arraysize(kExpectedPmtPrefix);
+  const uint8_t kPmtH264Aac[] = {
+      0x00,  // pointer field
+      0x02,
+      0xB0,  // assumes length is <= 256 bytes.
+      0x17,  // length of the rest of this array.
+      0x00, 0x01,
+      0xC1,              // version 0, current next indicator 1.
+      0x00,              // section number
+      0x00,              // last section number.
+      0xE0,              // first 3 bits reserved.
+      0x50,              // PCR PID is the video elementary stream's PID.
+      0xF0,              // first 4 bits reserved.
+      0x00,              // No descriptor at this level.
+      0x1B, 0xE0, 0x50,  // stream_type -> PID.
+      0xF0, 0x00,        // Es_info_length is 0.
+      0x0F, 0xE0, 0x51,  // stream_type -> PID.
+      0xF0, 0x00,        // Es_info_length is 0.
+      // CRC32.
+      0x5A, 0x21, 0x57, 0xEE,
+  };
+
+  ASSERT_EQ(kTsPacketSize, buffer.Size());
+  EXPECT_NO_FATAL_FAILURE(
+      ExpectTsPacketEqual(kExpectedPmtPrefix, kExpectedPmtPrefixSize, 155,
+                          kPmtH264Aac, arraysize(kPmtH264Aac),
+                          buffer.Buffer()));
+}
+
+TEST_F(ProgramMapTableWriterTest, EncryptedMultiStream) {
+  std::vector<std::unique_ptr<ProgramMapTableWriter>> stream_writers;
+  stream_writers.emplace_back(new VideoProgramMapTableWriter(kCodecH264));
+  stream_writers.emplace_back(new AudioProgramMapTableWriter(
+      kCodecAAC, std::vector<uint8_t>(std::begin(kAacBasicProfileExtraData),
+                                      std::end(kAacBasicProfileExtraData))));
+  MultiStreamProgramMapTableWriter writer(std::move(stream_writers));
+  BufferWriter buffer;
+  writer.EncryptedSegmentPmt(&buffer);
+
+  const uint8_t kExpectedPmtPrefix[] = {
+      0x47,  // Sync byte.
+      0x40,  // payload_unit_start_indicator set.
+      0x20,  // pid.
+      0x30,  // Adaptation field and payload are both present. counter = 0.
+      0x80,  // Adaptation Field length.
+      0x00,  // All adaptation field flags 0.
+  };
+  const int kExpectedPmtPrefixSize = arraysize(kExpectedPmtPrefix);
+  const uint8_t kPmtEncryptedH264Aac[] = {
+      0x00,              // pointer field
+      0x02,              // Table id.
+      0xB0,              // The first 4 bits must be '1011'.
+      0x33,              // length of the rest of this array.
+      0x00, 0x01,        // program number.
+      0xC1,              // version 0, current next indicator 1.
+      0x00,              // section number
+      0x00,              // last section number.
+      0xE0,              // first 3 bits reserved.
+      0x50,              // PCR PID is the video elementary stream's PID.
+      0xF0,              // first 4 bits reserved.
+      0x00,              // No descriptor at this level.
+      0xDB, 0xE0, 0x50,  // stream_type -> PID.
+      0xF0, 0x06,        // Es_info_length is 6 for private_data_indicator
+      0x0F,              // descriptor_tag.
+      0x04,              // Length of the rest of this descriptor
+      0x7A, 0x61, 0x76, 0x63,  // 'zavc'.
+      0xCF, 0xE0, 0x51,        // stream_type -> PID.
+      0xF0, 0x16,              // Es_info_length is 22.
+      0x0F,                    // private_data_indicator descriptor_tag.
+      0x04,                    // Length of the rest of this descriptor
+      0x61, 0x61, 0x63, 0x64,  // 'aacd'.
+      0x05,                    // registration_descriptor tag.
+      // space for 'zaac' + priming (0x0000) + version (0x01)
+      // + setup_data_length size + size of kAacBasicProfileExtraData + space
+      // for 'apad'. Which is 14.
+      0x0E,
+      0x61, 0x70, 0x61, 0x64,  // 'apad'.
+      0x7A, 0x61, 0x61, 0x63,  // 'zaac'.
+      0x00, 0x00,              // priming.
+      0x01,                    // version.
+      0x02,                    // setup_data_length == extra data length
+      0x12, 0x10,              // setup_data == extra data.
+      // CRC32.
+      0x0C, 0x65, 0xA9, 0x65,
+  };
+
+  ASSERT_EQ(kTsPacketSize, buffer.Size());
+  EXPECT_NO_FATAL_FAILURE(ExpectTsPacketEqual(
+      kExpectedPmtPrefix, kExpectedPmtPrefixSize, 127, kPmtEncryptedH264Aac,
+      arraysize(kPmtEncryptedH264Aac), buffer.Buffer()));
+}
+
 }  // namespace mp2t
 }  // namespace media
 }  // namespace shaka
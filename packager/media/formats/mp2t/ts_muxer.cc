@@ -18,39 +18,72 @@ TsMuxer::TsMuxer(const MuxerOptions& muxer_options) : Muxer(muxer_options) {}
 TsMuxer::~TsMuxer() {}
 
 Status TsMuxer::InitializeMuxer() {
-  if (streams().size() > 1u)
-    return Status(error::MUXER_FAILURE, "Cannot handle more than one streams.");
+  // Called for each stream. Wait for all of them.
+  if (streams().size() < num_input_streams())
+    return Status::OK;
+
+  // The video stream goes first in the segmenter as it carries the PCR.
+  std::vector<std::shared_ptr<const StreamInfo>> segmenter_streams;
+  segmenter_stream_indices_.resize(streams().size());
+  for (const bool video : {true, false}) {
+    for (size_t i = 0; i < streams().size(); ++i) {
+      if ((streams()[i]->stream_type() == kStreamVideo) != video)
+        continue;
+      segmenter_stream_indices_[i] = segmenter_streams.size();
+      segmenter_streams.push_back(streams()[i]);
+    }
+  }
 
   segmenter_.reset(new TsSegmenter(options(), muxer_listener()));
-  Status status = segmenter_->Initialize(*streams()[0]);
-  FireOnMediaStartEvent();
+  Status status = segmenter_->Initialize(segmenter_streams);
+  FireOnMediaStartEvent(segmenter_streams);
   return status;
 }
 
 Status TsMuxer::Finalize() {
+  if (++num_flushed_streams_ < streams().size())
+    return Status::OK;
   FireOnMediaEndEvent();
   return segmenter_->Finalize();
 }
 
 Status TsMuxer::AddSample(size_t stream_id, const MediaSample& sample) {
-  DCHECK_EQ(stream_id, 0u);
-  return segmenter_->AddSample(sample);
+  DCHECK_LT(stream_id, streams().size());
+  return segmenter_->AddSample(segmenter_stream_indices_[stream_id], sample);
 }
 
 Status TsMuxer::FinalizeSegment(size_t stream_id,
                                 const SegmentInfo& segment_info) {
-  DCHECK_EQ(stream_id, 0u);
-  return segment_info.is_subsegment
-             ? Status::OK
-             : segmenter_->FinalizeSegment(segment_info.start_timestamp,
-                                           segment_info.duration);
+  DCHECK_LT(stream_id, streams().size());
+  if (segment_info.is_subsegment)
+    return Status::OK;
+  // The segments of the streams are aligned by the ChunkingHandler, which
+  // dispatches the segment infos of all the streams together. The segment
+  // boundary of the video stream, which is the main stream of the
+  // ChunkingHandler, is used.
+  if (segmenter_stream_indices_[stream_id] == 0) {
+    segment_start_timestamp_ = segment_info.start_timestamp;
+    segment_duration_ = segment_info.duration;
+  }
+  if (++num_finalized_streams_in_segment_ < streams().size())
+    return Status::OK;
+  num_finalized_streams_in_segment_ = 0;
+  return segmenter_->FinalizeSegment(segment_start_timestamp_,
+                                     segment_duration_);
 }
 
-void TsMuxer::FireOnMediaStartEvent() {
+void TsMuxer::FireOnMediaStartEvent(
+    const std::vector<std::shared_ptr<const StreamInfo>>& stream_infos) {
   if (!muxer_listener())
     return;
-  muxer_listener()->OnMediaStart(options(), *streams().front(), kTsTimescale,
-                                 MuxerListener::kContainerWebM);
+  if (stream_infos.size() > 1) {
+    muxer_listener()->OnMultiplexedMediaStart(options(), stream_infos,
+                                              kTsTimescale,
+                                              MuxerListener::kContainerWebM);
+    return;
+  }
+  muxer_listener()->OnMediaStart(options(), *stream_infos.front(),
+                                 kTsTimescale, MuxerListener::kContainerWebM);
 }
 
 void TsMuxer::FireOnMediaEndEvent() {
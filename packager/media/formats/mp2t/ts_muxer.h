@@ -16,7 +16,10 @@ namespace media {
 namespace mp2t {
 
 /// MPEG2 TS muxer.
-/// This is a single program, single elementary stream TS muxer.
+/// This is a single program TS muxer. If there is more than one stream, e.g. a
+/// video stream and its audio streams, they are multiplexed in the program.
+/// The streams should come from the same ChunkingHandler so that their
+/// segments are aligned.
 class TsMuxer : public Muxer {
  public:
   explicit TsMuxer(const MuxerOptions& muxer_options);
@@ -31,10 +34,22 @@ class TsMuxer : public Muxer {
   Status FinalizeSegment(size_t stream_id,
                          const SegmentInfo& sample) override;
 
-  void FireOnMediaStartEvent();
+  // All the multiplexed streams, video first, are reported to the listener.
+  void FireOnMediaStartEvent(
+      const std::vector<std::shared_ptr<const StreamInfo>>& stream_infos);
   void FireOnMediaEndEvent();
 
   std::unique_ptr<TsSegmenter> segmenter_;
+  // Index of each stream in the segmenter, where the video stream comes first
+  // as it carries the PCR.
+  std::vector<size_t> segmenter_stream_indices_;
+  // The segment is finalized after the segment info of every stream arrives.
+  size_t num_finalized_streams_in_segment_ = 0;
+  // Segment boundary of the video stream, in its time scale.
+  uint64_t segment_start_timestamp_ = 0;
+  uint64_t segment_duration_ = 0;
+  // Finalize() is called once the last stream is flushed.
+  size_t num_flushed_streams_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(TsMuxer);
 };
@@ -31,35 +31,47 @@ bool IsVideoCodec(Codec codec) {
   return codec >= kCodecVideo && codec < kCodecVideoMaxPlusOne;
 }
 
+int64_t GetDts(const PesPacket& pes_packet) {
+  return pes_packet.has_dts() ? pes_packet.dts() : pes_packet.pts();
+}
+
 }  // namespace
 
 TsSegmenter::TsSegmenter(const MuxerOptions& options, MuxerListener* listener)
-    : muxer_options_(options),
-      listener_(listener),
-      pes_packet_generator_(new PesPacketGenerator()) {}
+    : muxer_options_(options), listener_(listener) {}
 TsSegmenter::~TsSegmenter() {}
 
-Status TsSegmenter::Initialize(const StreamInfo& stream_info) {
+Status TsSegmenter::Initialize(
+    const std::vector<std::shared_ptr<const StreamInfo>>& streams) {
   if (muxer_options_.segment_template.empty())
     return Status(error::MUXER_FAILURE, "Segment template not specified.");
-  if (!pes_packet_generator_->Initialize(stream_info)) {
-    return Status(error::MUXER_FAILURE,
-                  "Failed to initialize PesPacketGenerator.");
-  }
+  DCHECK(!streams.empty());
 
-  const StreamType stream_type = stream_info.stream_type();
-  if (stream_type != StreamType::kStreamVideo &&
-      stream_type != StreamType::kStreamAudio) {
-    LOG(ERROR) << "TsWriter cannot handle stream type " << stream_type
-               << " yet.";
-    return Status(error::MUXER_FAILURE, "Unsupported stream type.");
-  }
+  streams_.resize(streams.size());
+  for (size_t i = 0; i < streams.size(); ++i) {
+    const StreamInfo& stream_info = *streams[i];
+    Stream& stream = streams_[i];
+    if (!stream.pes_packet_generator)
+      stream.pes_packet_generator.reset(new PesPacketGenerator());
+    if (!stream.pes_packet_generator->Initialize(stream_info)) {
+      return Status(error::MUXER_FAILURE,
+                    "Failed to initialize PesPacketGenerator.");
+    }
 
-  codec_ = stream_info.codec();
-  if (stream_type == StreamType::kStreamAudio)
-    audio_codec_config_ = stream_info.codec_config();
+    const StreamType stream_type = stream_info.stream_type();
+    if (stream_type != StreamType::kStreamVideo &&
+        stream_type != StreamType::kStreamAudio) {
+      LOG(ERROR) << "TsWriter cannot handle stream type " << stream_type
+                 << " yet.";
+      return Status(error::MUXER_FAILURE, "Unsupported stream type.");
+    }
+
+    stream.codec = stream_info.codec();
+    if (stream_type == StreamType::kStreamAudio)
+      stream.audio_codec_config = stream_info.codec_config();
 
-  timescale_scale_ = kTsTimescale / stream_info.time_scale();
+    stream.timescale_scale = kTsTimescale / stream_info.time_scale();
+  }
   return Status::OK;
 }
 
@@ -67,45 +79,37 @@ Status TsSegmenter::Finalize() {
   return Status::OK;
 }
 
-Status TsSegmenter::AddSample(const MediaSample& sample) {
+Status TsSegmenter::AddSample(size_t stream_index, const MediaSample& sample) {
+  DCHECK_LT(stream_index, streams_.size());
+  Stream& stream = streams_[stream_index];
+
   if (!ts_writer_) {
-    std::unique_ptr<ProgramMapTableWriter> pmt_writer;
-    if (codec_ == kCodecAC3) {
-      // https://goo.gl/N7Tvqi MPEG-2 Stream Encryption Format for HTTP Live
-      // Streaming 2.3.2.2 AC-3 Setup: For AC-3, the setup_data in the
-      // audio_setup_information is the first 10 bytes of the audio data (the
-      // syncframe()).
-      // For unencrypted AC3, the setup_data is not used, so what is in there
-      // does not matter.
-      const size_t kSetupDataSize = 10u;
-      if (sample.data_size() < kSetupDataSize) {
-        LOG(ERROR) << "Sample is too small for AC3: " << sample.data_size();
-        return Status(error::MUXER_FAILURE, "Sample is too small for AC3.");
-      }
-      const std::vector<uint8_t> setup_data(sample.data(),
-                                            sample.data() + kSetupDataSize);
-      pmt_writer.reset(new AudioProgramMapTableWriter(codec_, setup_data));
-    } else if (IsAudioCodec(codec_)) {
-      pmt_writer.reset(
-          new AudioProgramMapTableWriter(codec_, audio_codec_config_));
-    } else {
-      DCHECK(IsVideoCodec(codec_));
-      pmt_writer.reset(new VideoProgramMapTableWriter(codec_));
+    if (!stream.pmt_writer) {
+      Status status = CreatePmtWriter(&sample, &stream);
+      if (!status.ok())
+        return status;
     }
-    ts_writer_.reset(new TsWriter(std::move(pmt_writer)));
+    const bool kForce = true;
+    Status status = CreateTsWriterIfReady(!kForce);
+    if (!status.ok())
+      return status;
   }
 
-  if (sample.is_encrypted())
-    ts_writer_->SignalEncrypted();
+  if (sample.is_encrypted()) {
+    encrypted_ = true;
+    if (ts_writer_)
+      ts_writer_->SignalEncrypted();
+  }
 
   if (!ts_writer_file_opened_ && !sample.is_key_frame())
     LOG(WARNING) << "A segment will start with a non key frame.";
 
-  if (!pes_packet_generator_->PushSample(sample)) {
+  if (!stream.pes_packet_generator->PushSample(sample)) {
     return Status(error::MUXER_FAILURE,
                   "Failed to add sample to PesPacketGenerator.");
   }
-  return WritePesPacketsToFile();
+  const bool kFlush = true;
+  return WritePesPacketsToFile(!kFlush);
 }
 
 void TsSegmenter::InjectTsWriterForTesting(std::unique_ptr<TsWriter> writer) {
@@ -114,13 +118,77 @@ void TsSegmenter::InjectTsWriterForTesting(std::unique_ptr<TsWriter> writer) {
 
 void TsSegmenter::InjectPesPacketGeneratorForTesting(
     std::unique_ptr<PesPacketGenerator> generator) {
-  pes_packet_generator_ = std::move(generator);
+  if (streams_.empty())
+    streams_.resize(1);
+  streams_[0].pes_packet_generator = std::move(generator);
 }
 
 void TsSegmenter::SetTsWriterFileOpenedForTesting(bool value) {
   ts_writer_file_opened_ = value;
 }
 
+Status TsSegmenter::CreatePmtWriter(const MediaSample* first_sample,
+                                    Stream* stream) {
+  if (stream->codec == kCodecAC3) {
+    // https://goo.gl/N7Tvqi MPEG-2 Stream Encryption Format for HTTP Live
+    // Streaming 2.3.2.2 AC-3 Setup: For AC-3, the setup_data in the
+    // audio_setup_information is the first 10 bytes of the audio data (the
+    // syncframe()).
+    // For unencrypted AC3, the setup_data is not used, so what is in there
+    // does not matter.
+    const size_t kSetupDataSize = 10u;
+    if (!first_sample) {
+      return Status(error::MUXER_FAILURE,
+                    "Cannot set up AC3 stream without samples.");
+    }
+    if (first_sample->data_size() < kSetupDataSize) {
+      LOG(ERROR) << "Sample is too small for AC3: "
+                 << first_sample->data_size();
+      return Status(error::MUXER_FAILURE, "Sample is too small for AC3.");
+    }
+    const std::vector<uint8_t> setup_data(
+        first_sample->data(), first_sample->data() + kSetupDataSize);
+    stream->pmt_writer.reset(
+        new AudioProgramMapTableWriter(stream->codec, setup_data));
+  } else if (IsAudioCodec(stream->codec)) {
+    stream->pmt_writer.reset(new AudioProgramMapTableWriter(
+        stream->codec, stream->audio_codec_config));
+  } else {
+    DCHECK(IsVideoCodec(stream->codec));
+    stream->pmt_writer.reset(new VideoProgramMapTableWriter(stream->codec));
+  }
+  return Status::OK;
+}
+
+Status TsSegmenter::CreateTsWriterIfReady(bool force) {
+  if (ts_writer_)
+    return Status::OK;
+  for (Stream& stream : streams_) {
+    if (stream.pmt_writer)
+      continue;
+    if (!force)
+      return Status::OK;
+    Status status = CreatePmtWriter(nullptr, &stream);
+    if (!status.ok())
+      return status;
+  }
+
+  std::unique_ptr<ProgramMapTableWriter> pmt_writer;
+  if (streams_.size() == 1) {
+    pmt_writer = std::move(streams_[0].pmt_writer);
+  } else {
+    std::vector<std::unique_ptr<ProgramMapTableWriter>> stream_writers;
+    for (Stream& stream : streams_)
+      stream_writers.push_back(std::move(stream.pmt_writer));
+    pmt_writer.reset(
+        new MultiStreamProgramMapTableWriter(std::move(stream_writers)));
+  }
+  ts_writer_.reset(new TsWriter(std::move(pmt_writer)));
+  if (encrypted_)
+    ts_writer_->SignalEncrypted();
+  return Status::OK;
+}
+
 Status TsSegmenter::OpenNewSegmentIfClosed(uint32_t next_pts) {
   if (ts_writer_file_opened_)
     return Status::OK;
@@ -134,28 +202,65 @@ Status TsSegmenter::OpenNewSegmentIfClosed(uint32_t next_pts) {
   return Status::OK;
 }
 
-Status TsSegmenter::WritePesPacketsToFile() {
-  while (pes_packet_generator_->NumberOfReadyPesPackets() > 0u) {
-    std::unique_ptr<PesPacket> pes_packet =
-        pes_packet_generator_->GetNextPesPacket();
+Status TsSegmenter::WritePesPacketsToFile(bool flush) {
+  for (Stream& stream : streams_) {
+    while (stream.pes_packet_generator->NumberOfReadyPesPackets() > 0u) {
+      stream.pes_packets.push_back(
+          stream.pes_packet_generator->GetNextPesPacket());
+    }
+  }
+
+  while (true) {
+    // Pick the PES packet with the smallest DTS. Without |flush|, every stream
+    // needs a PES packet, otherwise the next one of the stream could have a
+    // smaller DTS.
+    size_t next_stream_index = streams_.size();
+    for (size_t i = 0; i < streams_.size(); ++i) {
+      const std::list<std::unique_ptr<PesPacket>>& pes_packets =
+          streams_[i].pes_packets;
+      if (pes_packets.empty()) {
+        if (flush)
+          continue;
+        return Status::OK;
+      }
+      if (next_stream_index == streams_.size() ||
+          GetDts(*pes_packets.front()) <
+              GetDts(*streams_[next_stream_index].pes_packets.front())) {
+        next_stream_index = i;
+      }
+    }
+    if (next_stream_index == streams_.size())
+      return Status::OK;
+
+    std::list<std::unique_ptr<PesPacket>>& pes_packets =
+        streams_[next_stream_index].pes_packets;
+    std::unique_ptr<PesPacket> pes_packet = std::move(pes_packets.front());
+    pes_packets.pop_front();
 
-    Status status = OpenNewSegmentIfClosed(pes_packet->pts());
+    const bool kForce = true;
+    Status status = CreateTsWriterIfReady(kForce);
     if (!status.ok())
       return status;
 
-    if (!ts_writer_->AddPesPacket(std::move(pes_packet)))
+    status = OpenNewSegmentIfClosed(pes_packet->pts());
+    if (!status.ok())
+      return status;
+
+    if (!ts_writer_->AddPesPacket(next_stream_index, std::move(pes_packet)))
       return Status(error::MUXER_FAILURE, "Failed to add PES packet.");
   }
-  return Status::OK;
 }
 
 Status TsSegmenter::FinalizeSegment(uint64_t start_timestamp,
                                     uint64_t duration) {
-  if (!pes_packet_generator_->Flush()) {
-    return Status(error::MUXER_FAILURE,
-                  "Failed to flush PesPacketGenerator.");
+  for (Stream& stream : streams_) {
+    if (!stream.pes_packet_generator->Flush()) {
+      return Status(error::MUXER_FAILURE,
+                    "Failed to flush PesPacketGenerator.");
+    }
   }
-  Status status = WritePesPacketsToFile();
+  const bool kFlush = true;
+  Status status = WritePesPacketsToFile(kFlush);
   if (!status.ok())
     return status;
 
@@ -168,9 +273,10 @@ Status TsSegmenter::FinalizeSegment(uint64_t start_timestamp,
     if (listener_) {
       const int64_t file_size =
           File::GetFileSize(current_segment_path_.c_str());
+      const double timescale_scale = streams_[0].timescale_scale;
       listener_->OnNewSegment(current_segment_path_,
-                              start_timestamp * timescale_scale_,
-                              duration * timescale_scale_, file_size);
+                              start_timestamp * timescale_scale,
+                              duration * timescale_scale, file_size);
     }
     ts_writer_file_opened_ = false;
   }
@@ -7,10 +7,15 @@
 #ifndef PACKAGER_MEDIA_FORMATS_MP2T_TS_SEGMENTER_H_
 #define PACKAGER_MEDIA_FORMATS_MP2T_TS_SEGMENTER_H_
 
+#include <list>
 #include <memory>
+#include <vector>
+
 #include "packager/file/file.h"
 #include "packager/media/base/muxer_options.h"
+#include "packager/media/formats/mp2t/pes_packet.h"
 #include "packager/media/formats/mp2t/pes_packet_generator.h"
+#include "packager/media/formats/mp2t/program_map_table_writer.h"
 #include "packager/media/formats/mp2t/ts_writer.h"
 #include "packager/status.h"
 
@@ -25,6 +30,9 @@ namespace mp2t {
 // TODO(rkuroiwa): For now, this implements multifile segmenter. Like other
 // make this an abstract super class and implement multifile and single file
 // segmenters.
+/// Segments one or more elementary streams into a single program TS. Multiple
+/// streams, e.g. a video stream and its audio streams, are multiplexed with
+/// their PES packets interleaved in DTS order.
 class TsSegmenter {
  public:
   // TODO(rkuroiwa): Add progress listener?
@@ -36,25 +44,30 @@ class TsSegmenter {
   ~TsSegmenter();
 
   /// Initialize the object.
-  /// @param stream_info is the stream info for the segmenter.
+  /// @param streams are the streams multiplexed in the segments. The first
+  ///        stream carries the PCR, so it should be the video stream if there
+  ///        is one.
   /// @return OK on success.
-  Status Initialize(const StreamInfo& stream_info);
+  Status Initialize(
+      const std::vector<std::shared_ptr<const StreamInfo>>& streams);
 
   /// Finalize the segmenter.
   /// @return OK on success.
   Status Finalize();
 
+  /// @param stream_index is the index of the stream of the sample in the
+  ///        streams passed to Initialize().
   /// @param sample gets added to this object.
   /// @return OK on success.
-  Status AddSample(const MediaSample& sample);
+  Status AddSample(size_t stream_index, const MediaSample& sample);
 
   /// Flush all the samples that are (possibly) buffered and write them to the
   /// current segment, this will close the file. If a file is not already opened
   /// before calling this, this will open one and write them to file.
-  /// @param start_timestamp is the segment's start timestamp in the input
-  ///        stream's time scale.
-  /// @param duration is the segment's duration in the input stream's time
-  ///        scale.
+  /// @param start_timestamp is the segment's start timestamp in the first
+  ///        input stream's time scale.
+  /// @param duration is the segment's duration in the first input stream's
+  ///        time scale.
   // TODO(kqyang): Remove the usage of segment start timestamp and duration in
   // xx_segmenter, which could cause confusions on which is the source of truth
   // as the segment start timestamp and duration could be tracked locally.
@@ -63,7 +76,7 @@ class TsSegmenter {
   /// Only for testing.
   void InjectTsWriterForTesting(std::unique_ptr<TsWriter> writer);
 
-  /// Only for testing.
+  /// Only for testing. The generator is used for the first stream.
   void InjectPesPacketGeneratorForTesting(
       std::unique_ptr<PesPacketGenerator> generator);
 
@@ -71,22 +84,41 @@ class TsSegmenter {
   void SetTsWriterFileOpenedForTesting(bool value);
 
  private:
+  struct Stream {
+    // Codec for the stream.
+    Codec codec = kUnknownCodec;
+    std::vector<uint8_t> audio_codec_config;
+    // Scale used to scale the input stream to TS's timesccale (which is
+    // 90000).
+    double timescale_scale = 1.0;
+    std::unique_ptr<PesPacketGenerator> pes_packet_generator;
+    // Set from the first sample of the stream. Owned by |ts_writer_| once it
+    // is created.
+    std::unique_ptr<ProgramMapTableWriter> pmt_writer;
+    // PES packets that are not written yet as they may need to be interleaved
+    // with the PES packets of the other streams.
+    std::list<std::unique_ptr<PesPacket>> pes_packets;
+  };
+
+  Status CreatePmtWriter(const MediaSample* first_sample, Stream* stream);
+  // Creates |ts_writer_| if all the streams have a PMT writer or if |force| is
+  // true.
+  Status CreateTsWriterIfReady(bool force);
+
   Status OpenNewSegmentIfClosed(uint32_t next_pts);
 
   // Writes PES packets (carried in TsPackets) to a file. If a file is not open,
-  // it will open one. This will not close the file.
-  Status WritePesPacketsToFile();
+  // it will open one. This will not close the file. PES packets are only
+  // written once every stream has one, so they can be written in DTS order,
+  // unless |flush| is true.
+  Status WritePesPacketsToFile(bool flush);
 
   const MuxerOptions& muxer_options_;
   MuxerListener* const listener_;
 
-  // Codec for the stream.
-  Codec codec_ = kUnknownCodec;
-  std::vector<uint8_t> audio_codec_config_;
-
-  // Scale used to scale the input stream to TS's timesccale (which is 90000).
-  // Used for calculating the duration in seconds fo the current segment.
-  double timescale_scale_ = 1.0;
+  std::vector<Stream> streams_;
+  // Set to true once an encrypted sample is seen.
+  bool encrypted_ = false;
 
   // Used for segment template.
   uint64_t segment_number_ = 0;
@@ -95,7 +127,6 @@ class TsSegmenter {
   // Set to true if TsWriter::NewFile() succeeds, set to false after
   // TsWriter::FinalizeFile() succeeds.
   bool ts_writer_file_opened_ = false;
-  std::unique_ptr<PesPacketGenerator> pes_packet_generator_;
 
   // For OnNewSegment().
   // Path of the current segment so that File::GetFileSize() can be used after
@@ -20,6 +20,7 @@ namespace media {
 namespace mp2t {
 
 using ::testing::InSequence;
+using ::testing::Property;
 using ::testing::Return;
 using ::testing::Sequence;
 using ::testing::StrEq;
@@ -51,6 +52,17 @@ const uint8_t kAnyData[] = {
     0x01, 0x0F, 0x3C,
 };
 
+const Codec kAacCodec = Codec::kCodecAAC;
+const uint8_t kAacExtraData[] = {0x12, 0x10};
+const char kAacCodecString[] = "mp4a.40.2";
+const uint8_t kSampleBits = 16;
+const uint8_t kNumChannels = 2;
+const uint32_t kSamplingFrequency = 44100;
+const uint64_t kSeekPreroll = 0;
+const uint64_t kCodecDelay = 0;
+const uint32_t kMaxBitrate = 320000;
+const uint32_t kAverageBitrate = 256000;
+
 class MockPesPacketGenerator : public PesPacketGenerator {
  public:
   MOCK_METHOD1(Initialize, bool(const StreamInfo& info));
@@ -81,10 +93,12 @@ class MockTsWriter : public TsWriter {
   MOCK_METHOD0(FinalizeSegment, bool());
 
   // Similar to the hack above but takes a std::unique_ptr.
-  MOCK_METHOD1(AddPesPacketMock, bool(PesPacket* pes_packet));
-  bool AddPesPacket(std::unique_ptr<PesPacket> pes_packet) override {
+  MOCK_METHOD2(AddPesPacketMock,
+               bool(size_t stream_index, PesPacket* pes_packet));
+  bool AddPesPacket(size_t stream_index,
+                    std::unique_ptr<PesPacket> pes_packet) override {
     // No need to keep the pes packet around for the current tests.
-    return AddPesPacketMock(pes_packet.get());
+    return AddPesPacketMock(stream_index, pes_packet.get());
   }
 };
 
@@ -117,7 +131,7 @@ TEST_F(TsSegmenterTest, Initialize) {
   segmenter.InjectPesPacketGeneratorForTesting(
       std::move(mock_pes_packet_generator_));
 
-  EXPECT_OK(segmenter.Initialize(*stream_info));
+  EXPECT_OK(segmenter.Initialize({stream_info}));
 }
 
 TEST_F(TsSegmenterTest, AddSample) {
@@ -152,7 +166,7 @@ TEST_F(TsSegmenterTest, AddSample) {
       .InSequence(ready_pes_sequence)
       .WillOnce(Return(0u));
 
-  EXPECT_CALL(*mock_ts_writer_, AddPesPacketMock(_))
+  EXPECT_CALL(*mock_ts_writer_, AddPesPacketMock(_, _))
       .WillOnce(Return(true));
 
   // The pointer is released inside the segmenter.
@@ -162,9 +176,9 @@ TEST_F(TsSegmenterTest, AddSample) {
   segmenter.InjectPesPacketGeneratorForTesting(
       std::move(mock_pes_packet_generator_));
 
-  EXPECT_OK(segmenter.Initialize(*stream_info));
+  EXPECT_OK(segmenter.Initialize({stream_info}));
   segmenter.InjectTsWriterForTesting(std::move(mock_ts_writer_));
-  EXPECT_OK(segmenter.AddSample(*sample));
+  EXPECT_OK(segmenter.AddSample(0, *sample));
 }
 
 // This will add one sample then finalize segment then add another sample.
@@ -242,7 +256,7 @@ TEST_F(TsSegmenterTest, PassedSegmentDuration) {
       .InSequence(writer_sequence)
       .WillOnce(Return(true));
 
-  EXPECT_CALL(*mock_ts_writer_, AddPesPacketMock(_))
+  EXPECT_CALL(*mock_ts_writer_, AddPesPacketMock(_, _))
       .Times(2)
       .WillRepeatedly(Return(true));
 
@@ -257,11 +271,11 @@ TEST_F(TsSegmenterTest, PassedSegmentDuration) {
 
   segmenter.InjectPesPacketGeneratorForTesting(
       std::move(mock_pes_packet_generator_));
-  EXPECT_OK(segmenter.Initialize(*stream_info));
+  EXPECT_OK(segmenter.Initialize({stream_info}));
   segmenter.InjectTsWriterForTesting(std::move(mock_ts_writer_));
-  EXPECT_OK(segmenter.AddSample(*sample1));
+  EXPECT_OK(segmenter.AddSample(0, *sample1));
   EXPECT_OK(segmenter.FinalizeSegment(kFirstPts, sample1->duration()));
-  EXPECT_OK(segmenter.AddSample(*sample2));
+  EXPECT_OK(segmenter.AddSample(0, *sample2));
 }
 
 // Finalize right after Initialize(). The writer will not be initialized.
@@ -284,7 +298,7 @@ TEST_F(TsSegmenterTest, InitializeThenFinalize) {
 
   segmenter.InjectPesPacketGeneratorForTesting(
       std::move(mock_pes_packet_generator_));
-  EXPECT_OK(segmenter.Initialize(*stream_info));
+  EXPECT_OK(segmenter.Initialize({stream_info}));
   EXPECT_OK(segmenter.Finalize());
 }
 
@@ -313,7 +327,7 @@ TEST_F(TsSegmenterTest, FinalizeSegment) {
 
   segmenter.InjectPesPacketGeneratorForTesting(
       std::move(mock_pes_packet_generator_));
-  EXPECT_OK(segmenter.Initialize(*stream_info));
+  EXPECT_OK(segmenter.Initialize({stream_info}));
   segmenter.InjectTsWriterForTesting(std::move(mock_ts_writer_));
   segmenter.SetTsWriterFileOpenedForTesting(true);
   EXPECT_OK(segmenter.FinalizeSegment(0, 100 /* arbitrary duration */));
@@ -334,7 +348,7 @@ TEST_F(TsSegmenterTest, EncryptedSample) {
 
   ON_CALL(*mock_ts_writer_, NewSegment(_)).WillByDefault(Return(true));
   ON_CALL(*mock_ts_writer_, FinalizeSegment()).WillByDefault(Return(true));
-  ON_CALL(*mock_ts_writer_, AddPesPacketMock(_)).WillByDefault(Return(true));
+  ON_CALL(*mock_ts_writer_, AddPesPacketMock(_, _)).WillByDefault(Return(true));
   ON_CALL(*mock_pes_packet_generator_, Initialize(_))
       .WillByDefault(Return(true));
   ON_CALL(*mock_pes_packet_generator_, Flush()).WillByDefault(Return(true));
@@ -373,7 +387,7 @@ TEST_F(TsSegmenterTest, EncryptedSample) {
       .InSequence(ready_pes_sequence)
       .WillOnce(Return(0u));
 
-  EXPECT_CALL(*mock_ts_writer_, AddPesPacketMock(_))
+  EXPECT_CALL(*mock_ts_writer_, AddPesPacketMock(_, _))
       .Times(2)
       .WillRepeatedly(Return(true));
 
@@ -391,15 +405,56 @@ TEST_F(TsSegmenterTest, EncryptedSample) {
   segmenter.InjectPesPacketGeneratorForTesting(
       std::move(mock_pes_packet_generator_));
 
-  EXPECT_OK(segmenter.Initialize(*stream_info));
+  EXPECT_OK(segmenter.Initialize({stream_info}));
   segmenter.InjectTsWriterForTesting(std::move(mock_ts_writer_));
-  EXPECT_OK(segmenter.AddSample(*sample1));
+  EXPECT_OK(segmenter.AddSample(0, *sample1));
 
   EXPECT_OK(segmenter.FinalizeSegment(1, sample1->duration()));
   // Signal encrypted if sample is encrypted.
   EXPECT_CALL(*mock_ts_writer_raw, SignalEncrypted());
   sample2->set_is_encrypted(true);
-  EXPECT_OK(segmenter.AddSample(*sample2));
+  EXPECT_OK(segmenter.AddSample(0, *sample2));
+}
+
+// Verify that the PES packets of multiplexed streams are written in DTS order
+// in one segment.
+TEST_F(TsSegmenterTest, MultiplexedStreams) {
+  std::vector<std::shared_ptr<const StreamInfo>> streams;
+  for (int track_id : {1, 2}) {
+    streams.emplace_back(new AudioStreamInfo(
+        track_id, kTimeScale, kDuration, kAacCodec, kAacCodecString,
+        kAacExtraData, arraysize(kAacExtraData), kSampleBits, kNumChannels,
+        kSamplingFrequency, kSeekPreroll, kCodecDelay, kMaxBitrate,
+        kAverageBitrate, kLanguage, kIsEncrypted));
+  }
+  MuxerOptions options;
+  options.segment_template = "file$Number$.ts";
+  TsSegmenter segmenter(options, nullptr);
+
+  InSequence s;
+  EXPECT_CALL(*mock_ts_writer_, NewSegment(StrEq("file1.ts")))
+      .WillOnce(Return(true));
+  for (const auto& pes : {std::make_pair(0u, 1000), std::make_pair(1u, 1500),
+                          std::make_pair(0u, 2000), std::make_pair(1u, 2500)}) {
+    EXPECT_CALL(*mock_ts_writer_,
+                AddPesPacketMock(pes.first, Property(&PesPacket::pts,
+                                                     pes.second)))
+        .WillOnce(Return(true));
+  }
+  EXPECT_CALL(*mock_ts_writer_, FinalizeSegment()).WillOnce(Return(true));
+
+  ASSERT_OK(segmenter.Initialize(streams));
+  segmenter.InjectTsWriterForTesting(std::move(mock_ts_writer_));
+  for (const auto& sample_timestamp :
+       {std::make_pair(0u, 1000), std::make_pair(0u, 2000),
+        std::make_pair(1u, 1500), std::make_pair(1u, 2500)}) {
+    std::shared_ptr<MediaSample> sample =
+        MediaSample::CopyFrom(kAnyData, arraysize(kAnyData), kIsKeyFrame);
+    sample->set_pts(sample_timestamp.second);
+    sample->set_dts(sample_timestamp.second);
+    EXPECT_OK(segmenter.AddSample(sample_timestamp.first, *sample));
+  }
+  EXPECT_OK(segmenter.FinalizeSegment(1000, 2000));
 }
 
 }  // namespace mp2t
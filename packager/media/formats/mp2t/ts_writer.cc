@@ -87,7 +87,10 @@ void WritePtsOrDts(uint8_t leading_bits,
   writer->AppendInt(fifth_byte);
 }
 
+// Only the first elementary stream in the program, i.e. the one with
+// |stream_index| 0, carries the PCR.
 bool WritePesToFile(const PesPacket& pes,
+                    size_t stream_index,
                     ContinuityCounter* continuity_counter,
                     File* file) {
   // The size of the length field.
@@ -99,7 +102,8 @@ bool WritePesToFile(const PesPacket& pes,
       kTsPacketMaximumPayloadSize - kAdaptationFieldLengthSize -
       kAdaptationFieldHeaderSize - kPcrFieldSize;
   const uint64_t pcr_base = pes.has_dts() ? pes.dts() : pes.pts();
-  const int pid = ProgramMapTableWriter::kElementaryPid;
+  const int pid = ProgramMapTableWriter::ElementaryPid(stream_index);
+  const bool has_pcr = stream_index == 0;
 
   // This writer will hold part of PES packet after PES_packet_length field.
   BufferWriter pes_header_writer;
@@ -136,14 +140,15 @@ bool WritePesToFile(const PesPacket& pes,
   first_ts_packet_buffer.AppendBuffer(pes_header_writer);
 
   const size_t available_payload =
-      kTsPacketMaxPayloadWithPcr - first_ts_packet_buffer.Size();
+      (has_pcr ? kTsPacketMaxPayloadWithPcr : kTsPacketMaximumPayloadSize) -
+      first_ts_packet_buffer.Size();
   const size_t bytes_consumed = std::min(pes.data().size(), available_payload);
   first_ts_packet_buffer.AppendArray(pes.data().data(), bytes_consumed);
 
   BufferWriter output_writer;
   WritePayloadToBufferWriter(first_ts_packet_buffer.Buffer(),
                              first_ts_packet_buffer.Size(),
-                             kPayloadUnitStartIndicator, pid, kHasPcr, pcr_base,
+                             kPayloadUnitStartIndicator, pid, has_pcr, pcr_base,
                              continuity_counter, &output_writer);
 
   const size_t remaining_pes_data_size = pes.data().size() - bytes_consumed;
@@ -202,9 +207,11 @@ bool TsWriter::FinalizeSegment() {
   return current_file_.release()->Close();
 }
 
-bool TsWriter::AddPesPacket(std::unique_ptr<PesPacket> pes_packet) {
+bool TsWriter::AddPesPacket(size_t stream_index,
+                            std::unique_ptr<PesPacket> pes_packet) {
   DCHECK(current_file_);
-  if (!WritePesToFile(*pes_packet, &elementary_stream_continuity_counter_,
+  if (!WritePesToFile(*pes_packet, stream_index,
+                      &elementary_stream_continuity_counters_[stream_index],
                       current_file_.get())) {
     LOG(ERROR) << "Failed to write pes to file.";
     return false;
@@ -24,7 +24,9 @@ class PesPacket;
 class ProgramMapTableWriter;
 
 /// This class takes PesPackets, encapsulates them into TS packets, and write
-/// the data to file. This also creates PSI from StreamInfo.
+/// the data to file. This also creates PSI from StreamInfo. The PesPackets of
+/// all the elementary streams in the program can be interleaved in one
+/// segment.
 class TsWriter {
  public:
   explicit TsWriter(std::unique_ptr<ProgramMapTableWriter> pmt_writer);
@@ -46,9 +48,12 @@ class TsWriter {
 
   /// Add PesPacket to the instance. PesPacket might not get written to file
   /// immediately.
+  /// @param stream_index is the index of the elementary stream of the packet
+  ///        in the program. The first stream carries the PCR.
   /// @param pes_packet gets added to the writer.
   /// @return true on success, false otherwise.
-  virtual bool AddPesPacket(std::unique_ptr<PesPacket> pes_packet);
+  virtual bool AddPesPacket(size_t stream_index,
+                            std::unique_ptr<PesPacket> pes_packet);
 
  private:
   TsWriter(const TsWriter&) = delete;
@@ -58,7 +63,8 @@ class TsWriter {
   bool encrypted_ = false;
 
   ContinuityCounter pat_continuity_counter_;
-  ContinuityCounter elementary_stream_continuity_counter_;
+  // Continuity counters of the elementary streams by stream index.
+  std::map<size_t, ContinuityCounter> elementary_stream_continuity_counters_;
 
   std::unique_ptr<ProgramMapTableWriter> pmt_writer_;
 
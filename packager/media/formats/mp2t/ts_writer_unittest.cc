@@ -28,6 +28,8 @@ namespace {
 
 const int kTsPacketSize = 188;
 const Codec kCodecForTesting = kCodecH264;
+// The first elementary stream in the program carries the PCR.
+const size_t kPcrStreamIndex = 0;
 
 class MockProgramMapTableWriter : public ProgramMapTableWriter {
  public:
@@ -340,7 +342,7 @@ TEST_F(TsWriterTest, AddPesPacket) {
   };
   pes->mutable_data()->assign(kAnyData, kAnyData + arraysize(kAnyData));
 
-  EXPECT_TRUE(ts_writer.AddPesPacket(std::move(pes)));
+  EXPECT_TRUE(ts_writer.AddPesPacket(kPcrStreamIndex, std::move(pes)));
   ASSERT_TRUE(ts_writer.FinalizeSegment());
 
   std::vector<uint8_t> content;
@@ -400,7 +402,7 @@ TEST_F(TsWriterTest, BigPesPacket) {
   const std::vector<uint8_t> big_data(400, 0x23);
   *pes->mutable_data() = big_data;
 
-  EXPECT_TRUE(ts_writer.AddPesPacket(std::move(pes)));
+  EXPECT_TRUE(ts_writer.AddPesPacket(kPcrStreamIndex, std::move(pes)));
   ASSERT_TRUE(ts_writer.FinalizeSegment());
 
   std::vector<uint8_t> content;
@@ -434,7 +436,7 @@ TEST_F(TsWriterTest, PesPtsZeroNoDts) {
   };
   pes->mutable_data()->assign(kAnyData, kAnyData + arraysize(kAnyData));
 
-  EXPECT_TRUE(ts_writer.AddPesPacket(std::move(pes)));
+  EXPECT_TRUE(ts_writer.AddPesPacket(kPcrStreamIndex, std::move(pes)));
   ASSERT_TRUE(ts_writer.FinalizeSegment());
 
   std::vector<uint8_t> content;
@@ -495,7 +497,7 @@ TEST_F(TsWriterTest, TsPacketPayload183Bytes) {
   std::vector<uint8_t> pes_payload(157 + 183, 0xAF);
   *pes->mutable_data() = pes_payload;
 
-  EXPECT_TRUE(ts_writer.AddPesPacket(std::move(pes)));
+  EXPECT_TRUE(ts_writer.AddPesPacket(kPcrStreamIndex, std::move(pes)));
   ASSERT_TRUE(ts_writer.FinalizeSegment());
 
   const uint8_t kExpectedOutputPrefix[] = {
@@ -520,6 +522,75 @@ TEST_F(TsWriterTest, TsPacketPayload183Bytes) {
       actual_prefix);
 }
 
+// Verify that the PES packets of the other elementary streams in the program
+// are carried on their own PID without PCR.
+TEST_F(TsWriterTest, AddPesPacketMultiplexed) {
+  std::vector<std::unique_ptr<ProgramMapTableWriter>> stream_writers;
+  stream_writers.emplace_back(new VideoProgramMapTableWriter(kCodecH264));
+  const uint8_t kAacBasicProfileExtraData[] = {0x12, 0x10};
+  stream_writers.emplace_back(new AudioProgramMapTableWriter(
+      kCodecAAC,
+      std::vector<uint8_t>(
+          kAacBasicProfileExtraData,
+          kAacBasicProfileExtraData + arraysize(kAacBasicProfileExtraData))));
+  TsWriter ts_writer(std::unique_ptr<ProgramMapTableWriter>(
+      new MultiStreamProgramMapTableWriter(std::move(stream_writers))));
+  EXPECT_TRUE(ts_writer.NewSegment(test_file_name_));
+
+  const uint8_t kAnyData[] = {
+      0x12, 0x88, 0x4F, 0x4A,
+  };
+  std::unique_ptr<PesPacket> video_pes(new PesPacket());
+  video_pes->set_stream_id(0xE0);
+  video_pes->set_pts(0x900);
+  video_pes->set_dts(0x900);
+  video_pes->mutable_data()->assign(kAnyData, kAnyData + arraysize(kAnyData));
+  std::unique_ptr<PesPacket> audio_pes(new PesPacket());
+  audio_pes->set_stream_id(0xC0);
+  audio_pes->set_pts(0x900);
+  audio_pes->mutable_data()->assign(kAnyData, kAnyData + arraysize(kAnyData));
+
+  const size_t kAudioStreamIndex = 1;
+  EXPECT_TRUE(ts_writer.AddPesPacket(kPcrStreamIndex, std::move(video_pes)));
+  EXPECT_TRUE(ts_writer.AddPesPacket(kAudioStreamIndex, std::move(audio_pes)));
+  ASSERT_TRUE(ts_writer.FinalizeSegment());
+
+  std::vector<uint8_t> content;
+  ASSERT_TRUE(ReadFileToVector(test_file_path_, &content));
+  // 4 TS Packets. PAT, PMT, video PES and audio PES.
+  ASSERT_EQ(752u, content.size());
+
+  const int kAudioPesStartPosition = 564;
+
+  const uint8_t kExpectedOutputPrefix[] = {
+      0x47,  // Sync byte.
+      0x40,  // payload_unit_start_indicator set.
+      0x51,  // pid.
+      0x30,  // Adaptation field and payload are both present. counter = 0.
+      0xA5,  // Adaptation Field length.
+      0x00,  // All adaptation field flags 0.
+  };
+
+  const uint8_t kExpectedPayload[] = {
+      0x00, 0x00, 0x01,  // Start code.
+      0xC0,              // stream id.
+      0x00, 0x0C,        // PES_packet_length.
+      0x80,              // Flags.
+      0x80,              // Only PTS present.
+      0x05,              // PES_header_data_length.
+      0x21,  // Since PTS is 0 this is '0010' (fixed) and marker bit at LSB.
+      0x00,  // PTS leading bits 0.
+      0x01,  // PTS 0 followed by marker bit.
+      0x12,  // PTS 0x900 shifted.
+      0x01,  // PTS 0 followed by marker bit.
+      0x12, 0x88, 0x4F, 0x4A,  // Payload.
+  };
+  EXPECT_NO_FATAL_FAILURE(ExpectTsPacketEqual(
+      kExpectedOutputPrefix, arraysize(kExpectedOutputPrefix), 164,
+      kExpectedPayload, arraysize(kExpectedPayload),
+      content.data() + kAudioPesStartPosition));
+}
+
 }  // namespace mp2t
 }  // namespace media
 }  // namespace shaka
@@ -0,0 +1,640 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/mp4/fragment_remuxer.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "packager/base/logging.h"
+#include "packager/file/file.h"
+#include "packager/media/base/aes_encryptor.h"
+#include "packager/media/base/aes_pattern_cryptor.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/base/decrypt_config.h"
+#include "packager/media/base/decryptor_source.h"
+#include "packager/media/formats/mp4/box_definitions.h"
+#include "packager/media/formats/mp4/box_reader.h"
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+// The version of cenc implemented here. CENC 4.
+const uint32_t kCencSchemeVersion = 0x00010000;
+const size_t kCencBlockSize = 16u;
+
+const Track* FindTrack(const Movie& moov, uint32_t track_id) {
+  for (const Track& track : moov.tracks) {
+    if (track.header.track_id == track_id)
+      return &track;
+  }
+  return nullptr;
+}
+
+const TrackExtends* FindTrackExtends(const Movie& moov, uint32_t track_id) {
+  for (const TrackExtends& trex : moov.extends.tracks) {
+    if (trex.track_id == track_id)
+      return &trex;
+  }
+  return nullptr;
+}
+
+// Returns the protection scheme info of the sample entry used by a track
+// fragment, or null if the samples in the track fragment are not encrypted.
+const ProtectionSchemeInfo* GetProtectionSchemeInfo(
+    const Track& track,
+    const TrackExtends& trex,
+    const TrackFragmentHeader& tfhd) {
+  const SampleDescription& stsd =
+      track.media.information.sample_table.description;
+  size_t desc_idx = tfhd.sample_description_index;
+  if (!desc_idx)
+    desc_idx = trex.default_sample_description_index;
+  // Descriptions are one-indexed in the file.
+  desc_idx = desc_idx > 0 ? desc_idx - 1 : 0;
+
+  switch (stsd.type) {
+    case kVideo: {
+      if (stsd.video_entries.empty())
+        return nullptr;
+      if (desc_idx >= stsd.video_entries.size())
+        desc_idx = 0;
+      const VideoSampleEntry& entry = stsd.video_entries[desc_idx];
+      return entry.format == FOURCC_encv ? &entry.sinf : nullptr;
+    }
+    case kAudio: {
+      if (stsd.audio_entries.empty())
+        return nullptr;
+      if (desc_idx >= stsd.audio_entries.size())
+        desc_idx = 0;
+      const AudioSampleEntry& entry = stsd.audio_entries[desc_idx];
+      return entry.format == FOURCC_enca ? &entry.sinf : nullptr;
+    }
+    default:
+      return nullptr;
+  }
+}
+
+uint32_t GetSampleSize(const TrackExtends& trex,
+                       const TrackFragmentHeader& tfhd,
+                       const TrackFragmentRun& trun,
+                       size_t i) {
+  if (i < trun.sample_sizes.size())
+    return trun.sample_sizes[i];
+  if (tfhd.default_sample_size > 0)
+    return tfhd.default_sample_size;
+  return trex.default_sample_size;
+}
+
+// Same patterns as EncryptionHandler: 1:9 for 'cbcs' video and whole-block
+// full-sample encryption, i.e. 1:0, for other 'cbcs' tracks.
+void GetProtectionPattern(FourCC protection_scheme,
+                          TrackType track_type,
+                          uint8_t* crypt_byte_block,
+                          uint8_t* skip_byte_block) {
+  *crypt_byte_block = 0u;
+  *skip_byte_block = 0u;
+  if (protection_scheme == FOURCC_cbcs) {
+    *crypt_byte_block = 1u;
+    *skip_byte_block = track_type == kVideo ? 9u : 0u;
+  }
+}
+
+std::unique_ptr<AesCryptor> CreateEncryptor(FourCC protection_scheme,
+                                            uint8_t crypt_byte_block,
+                                            uint8_t skip_byte_block) {
+  switch (protection_scheme) {
+    case FOURCC_cenc:
+      return std::unique_ptr<AesCryptor>(new AesCtrEncryptor);
+    case FOURCC_cbcs:
+      return std::unique_ptr<AesCryptor>(new AesPatternCryptor(
+          crypt_byte_block, skip_byte_block,
+          AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
+          AesCryptor::kUseConstantIv,
+          std::unique_ptr<AesCryptor>(new AesCbcEncryptor(kNoPadding))));
+    default:
+      return std::unique_ptr<AesCryptor>();
+  }
+}
+
+// Rebuilds the 'saiz' box of |traf| from its 'senc' box, and resets the
+// 'saio' box to a single offset, which is set once the size of 'moof' is
+// known.
+void UpdateAuxiliaryInformation(TrackFragment* traf) {
+  const std::vector<SampleEncryptionEntry>& entries =
+      traf->sample_encryption.sample_encryption_entries;
+  DCHECK(!entries.empty());
+
+  SampleAuxiliaryInformationSize& saiz = traf->auxiliary_size;
+  saiz.flags = 0;
+  saiz.sample_count = static_cast<uint32_t>(entries.size());
+  saiz.sample_info_sizes.clear();
+  for (const SampleEncryptionEntry& entry : entries)
+    saiz.sample_info_sizes.push_back(static_cast<uint8_t>(entry.ComputeSize()));
+  saiz.default_sample_info_size = 0;
+  if (std::adjacent_find(saiz.sample_info_sizes.begin(),
+                         saiz.sample_info_sizes.end(),
+                         std::not_equal_to<uint8_t>()) ==
+      saiz.sample_info_sizes.end()) {
+    saiz.default_sample_info_size = saiz.sample_info_sizes.front();
+    saiz.sample_info_sizes.clear();
+  }
+
+  SampleAuxiliaryInformationOffset& saio = traf->auxiliary_offset;
+  saio.version = 0;
+  saio.flags = 0;
+  saio.offsets.assign(1, 0);
+
+  // It should only happen with full sample encryption + constant iv, i.e.
+  // 'cbcs' applying to audio. The sample auxiliary information is empty and
+  // should be omitted.
+  if (saiz.default_sample_info_size == 0 && saiz.sample_info_sizes.empty()) {
+    saiz.sample_count = 0;
+    saio.offsets.clear();
+  }
+}
+
+}  // namespace
+
+FragmentRemuxer::FragmentRemuxer(const FragmentRemuxerOptions& options,
+                                 File* output)
+    : options_(options), output_(output) {
+  DCHECK(output_);
+}
+
+FragmentRemuxer::~FragmentRemuxer() {}
+
+Status FragmentRemuxer::Parse(const uint8_t* buf, size_t size) {
+  queue_.Push(buf, static_cast<int>(size));
+  while (true) {
+    const uint8_t* data = nullptr;
+    int data_size = 0;
+    queue_.Peek(&data, &data_size);
+    if (data_size == 0)
+      return Status::OK;
+
+    if (bytes_to_copy_ > 0) {
+      const int copy_size = static_cast<int>(
+          std::min(bytes_to_copy_, static_cast<uint64_t>(data_size)));
+      Status status = WriteBytes(data, copy_size);
+      if (!status.ok())
+        return status;
+      queue_.Pop(copy_size);
+      bytes_to_copy_ -= copy_size;
+      continue;
+    }
+
+    FourCC type = FOURCC_NULL;
+    uint64_t box_size = 0;
+    bool err = false;
+    if (!BoxReader::StartBox(data, data_size, &type, &box_size, &err)) {
+      if (err)
+        return Status(error::PARSER_FAILURE, "Failed to read box header.");
+      return Status::OK;
+    }
+
+    if (input_moof_) {
+      // A fragment being re-encrypted needs its complete 'mdat' box.
+      if (type != FOURCC_mdat) {
+        return Status(error::PARSER_FAILURE,
+                      "Expecting 'mdat' box after 'moof' box.");
+      }
+    } else if (type != FOURCC_moov && type != FOURCC_moof &&
+               type != FOURCC_mfra) {
+      // Other boxes, 'mdat' included, are copied as they arrive.
+      if (type == FOURCC_sidx)
+        sidx_seen_ = true;
+      bytes_to_copy_ = box_size;
+      continue;
+    }
+
+    if (box_size > static_cast<uint64_t>(data_size))
+      return Status::OK;
+
+    Status status = input_moof_ ? ReencryptFragment(data, box_size)
+                                : ProcessBox(type, data, box_size);
+    if (!status.ok())
+      return status;
+    queue_.Pop(static_cast<int>(box_size));
+  }
+}
+
+Status FragmentRemuxer::Flush() {
+  const uint8_t* data = nullptr;
+  int data_size = 0;
+  queue_.Peek(&data, &data_size);
+  if (bytes_to_copy_ > 0 || data_size > 0 || input_moof_) {
+    return Status(error::PARSER_FAILURE,
+                  "Input ended in the middle of a fragment.");
+  }
+  return Status::OK;
+}
+
+Status FragmentRemuxer::ProcessBox(FourCC type,
+                                   const uint8_t* data,
+                                   size_t size) {
+  switch (type) {
+    case FOURCC_moov:
+      return ProcessMovie(data, size);
+    case FOURCC_moof:
+      return ProcessMovieFragment(data, size);
+    case FOURCC_mfra:
+      // The offsets in 'mfra' point to the input fragments. It is optional, so
+      // it is dropped instead of being updated.
+      return Status::OK;
+    default:
+      NOTREACHED();
+      return Status::OK;
+  }
+}
+
+Status FragmentRemuxer::ProcessMovie(const uint8_t* data, size_t size) {
+  if (moov_)
+    return Status(error::PARSER_FAILURE, "Multiple 'moov' boxes in input.");
+  if (options_.protection_scheme != FOURCC_NULL &&
+      options_.protection_scheme != FOURCC_cenc &&
+      options_.protection_scheme != FOURCC_cbcs) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Only 'cenc' and 'cbcs' are supported for re-encryption.");
+  }
+
+  bool err = false;
+  std::unique_ptr<BoxReader> reader(BoxReader::ReadBox(data, size, &err));
+  moov_.reset(new Movie);
+  if (!reader || !moov_->Parse(reader.get()))
+    return Status(error::PARSER_FAILURE, "Failed to parse 'moov' box.");
+  if (moov_->extends.tracks.empty())
+    return Status(error::UNIMPLEMENTED, "Input is not fragmented.");
+
+  Movie moov = *moov_;
+  uint32_t next_track_id = 0;
+  for (Track& track : moov.tracks) {
+    const uint32_t input_track_id = track.header.track_id;
+    track.header.track_id = MapTrackId(input_track_id);
+    next_track_id = std::max(next_track_id, track.header.track_id + 1);
+    if (options_.protection_scheme == FOURCC_NULL)
+      continue;
+
+    // Re-encrypt the encrypted sample entries; clear tracks stay clear.
+    SampleDescription& stsd = track.media.information.sample_table.description;
+    std::vector<ProtectionSchemeInfo*> sinfs;
+    for (VideoSampleEntry& entry : stsd.video_entries) {
+      if (entry.format == FOURCC_encv)
+        sinfs.push_back(&entry.sinf);
+    }
+    for (AudioSampleEntry& entry : stsd.audio_entries) {
+      if (entry.format == FOURCC_enca)
+        sinfs.push_back(&entry.sinf);
+    }
+    if (sinfs.empty())
+      continue;
+
+    uint8_t crypt_byte_block = 0;
+    uint8_t skip_byte_block = 0;
+    GetProtectionPattern(options_.protection_scheme, stsd.type,
+                         &crypt_byte_block, &skip_byte_block);
+    std::unique_ptr<AesCryptor> encryptor = CreateEncryptor(
+        options_.protection_scheme, crypt_byte_block, skip_byte_block);
+    std::vector<uint8_t> iv = options_.encryption_key.iv;
+    if (iv.empty() &&
+        !AesCryptor::GenerateRandomIv(options_.protection_scheme, &iv)) {
+      return Status(error::ENCRYPTION_FAILURE, "Failed to generate random iv.");
+    }
+    if (!encryptor->InitializeWithIv(options_.encryption_key.key, iv))
+      return Status(error::ENCRYPTION_FAILURE, "Failed to create encryptor.");
+
+    for (ProtectionSchemeInfo* sinf : sinfs) {
+      sinf->type.type = options_.protection_scheme;
+      sinf->type.version = kCencSchemeVersion;
+      TrackEncryption& track_encryption = sinf->info.track_encryption;
+      // Version 1 is set on write if a pattern is used.
+      track_encryption.version = 0;
+      track_encryption.default_is_protected = 1;
+      track_encryption.default_crypt_byte_block = crypt_byte_block;
+      track_encryption.default_skip_byte_block = skip_byte_block;
+      track_encryption.default_kid = options_.encryption_key.key_id;
+      if (encryptor->use_constant_iv()) {
+        track_encryption.default_per_sample_iv_size = 0;
+        track_encryption.default_constant_iv = iv;
+      } else {
+        track_encryption.default_per_sample_iv_size =
+            static_cast<uint8_t>(iv.size());
+        track_encryption.default_constant_iv.clear();
+      }
+    }
+    encryptors_[input_track_id] = std::move(encryptor);
+  }
+  for (TrackExtends& trex : moov.extends.tracks)
+    trex.track_id = MapTrackId(trex.track_id);
+  if (!options_.track_id_map.empty())
+    moov.header.next_track_id = next_track_id;
+
+  if (!encryptors_.empty()) {
+    if (!options_.decryption_key_source) {
+      return Status(error::INVALID_ARGUMENT,
+                    "A decryption key source is needed for re-encryption.");
+    }
+    decryptor_source_.reset(
+        new DecryptorSource(options_.decryption_key_source));
+
+    const std::vector<ProtectionSystemSpecificInfo>& key_system_info =
+        options_.encryption_key.key_system_info;
+    moov.pssh.resize(key_system_info.size());
+    for (size_t i = 0; i < key_system_info.size(); ++i)
+      moov.pssh[i].raw_box = key_system_info[i].CreateBox();
+  }
+
+  BufferWriter buffer;
+  moov.Write(&buffer);
+  return buffer.WriteToFile(output_);
+}
+
+Status FragmentRemuxer::ProcessMovieFragment(const uint8_t* data,
+                                             size_t size) {
+  if (!moov_)
+    return Status(error::PARSER_FAILURE, "'moof' box before 'moov' box.");
+
+  bool err = false;
+  std::unique_ptr<BoxReader> reader(BoxReader::ReadBox(data, size, &err));
+  std::unique_ptr<MovieFragment> moof(new MovieFragment);
+  if (!reader || !moof->Parse(reader.get()))
+    return Status(error::PARSER_FAILURE, "Failed to parse 'moof' box.");
+
+  bool reencrypt = false;
+  for (TrackFragment& traf : moof->tracks) {
+    const Track* track = FindTrack(*moov_, traf.header.track_id);
+    const TrackExtends* trex = FindTrackExtends(*moov_, traf.header.track_id);
+    if (!track || !trex) {
+      LOG(ERROR) << "Track " << traf.header.track_id << " not in 'moov'.";
+      return Status(error::PARSER_FAILURE, "Unknown track in 'moof' box.");
+    }
+    for (const TrackFragmentRun& trun : traf.runs) {
+      if (!(trun.flags & TrackFragmentRun::kDataOffsetPresentMask)) {
+        return Status(error::UNIMPLEMENTED,
+                      "'trun' boxes without data offset are not supported.");
+      }
+    }
+
+    // Sample encryption entries can only be parsed once the iv size is known.
+    const ProtectionSchemeInfo* sinf =
+        GetProtectionSchemeInfo(*track, *trex, traf.header);
+    SampleEncryption& sample_encryption = traf.sample_encryption;
+    const bool has_sample_encryption =
+        !sample_encryption.sample_encryption_data.empty();
+    if (has_sample_encryption) {
+      if (!sinf) {
+        return Status(error::PARSER_FAILURE,
+                      "'senc' box in a clear track fragment.");
+      }
+      sample_encryption.iv_size =
+          sinf->info.track_encryption.default_per_sample_iv_size;
+      if (!sample_encryption.ParseFromSampleEncryptionData(
+              sample_encryption.iv_size,
+              &sample_encryption.sample_encryption_entries)) {
+        return Status(error::PARSER_FAILURE, "Failed to parse 'senc' box.");
+      }
+      sample_encryption.sample_encryption_data.clear();
+    }
+
+    if (options_.protection_scheme != FOURCC_NULL && sinf) {
+      for (const SampleGroupDescription& sample_group_description :
+           traf.sample_group_descriptions) {
+        if (sample_group_description.grouping_type == FOURCC_seig) {
+          return Status(error::UNIMPLEMENTED,
+                        "Re-encrypting key rotated input is not supported.");
+        }
+      }
+      if (!has_sample_encryption) {
+        return Status(error::UNIMPLEMENTED,
+                      "Re-encrypting input without 'senc' boxes is not "
+                      "supported.");
+      }
+      reencrypt = true;
+    }
+  }
+
+  std::unique_ptr<MovieFragment> output_moof(new MovieFragment(*moof));
+  for (TrackFragment& traf : output_moof->tracks) {
+    traf.header.track_id = MapTrackId(traf.header.track_id);
+    // The base data offset is relative to the input file. Use 'moof' as the
+    // base instead, which is what MP4MediaParser assumes anyway.
+    traf.header.flags &= ~TrackFragmentHeader::kBaseDataOffsetPresentMask;
+    traf.header.flags |= TrackFragmentHeader::kDefaultBaseIsMoofMask;
+  }
+  // The 'pssh' boxes of the input are not valid for the new key.
+  if (!encryptors_.empty())
+    output_moof->pssh.clear();
+
+  if (!reencrypt)
+    return WriteMovieFragment(size, output_moof.get());
+
+  input_moof_ = std::move(moof);
+  output_moof_ = std::move(output_moof);
+  input_moof_size_ = size;
+  return Status::OK;
+}
+
+Status FragmentRemuxer::ReencryptFragment(const uint8_t* mdat,
+                                          size_t mdat_size) {
+  DCHECK(input_moof_);
+  DCHECK(output_moof_);
+
+  // Clear bytes are copied as they are. Encrypted samples are decrypted from
+  // the input into the output, then encrypted again in place.
+  std::vector<uint8_t> output_mdat(mdat, mdat + mdat_size);
+  for (size_t i = 0; i < input_moof_->tracks.size(); ++i) {
+    const TrackFragment& traf = input_moof_->tracks[i];
+    if (traf.sample_encryption.sample_encryption_entries.empty() ||
+        encryptors_.find(traf.header.track_id) == encryptors_.end()) {
+      continue;
+    }
+    Status status = ReencryptTrackFragment(traf, mdat, mdat_size,
+                                           output_mdat.data(),
+                                           &output_moof_->tracks[i]);
+    if (!status.ok())
+      return status;
+  }
+
+  Status status = WriteMovieFragment(input_moof_size_, output_moof_.get());
+  input_moof_.reset();
+  output_moof_.reset();
+  if (!status.ok())
+    return status;
+  return WriteBytes(output_mdat.data(), output_mdat.size());
+}
+
+Status FragmentRemuxer::ReencryptTrackFragment(const TrackFragment& traf,
+                                               const uint8_t* mdat,
+                                               size_t mdat_size,
+                                               uint8_t* output_mdat,
+                                               TrackFragment* output_traf) {
+  const TrackExtends* trex = FindTrackExtends(*moov_, traf.header.track_id);
+  const ProtectionSchemeInfo* sinf = GetProtectionSchemeInfo(
+      *FindTrack(*moov_, traf.header.track_id), *trex, traf.header);
+  DCHECK(sinf);
+  const TrackEncryption& track_encryption = sinf->info.track_encryption;
+  AesCryptor* encryptor = encryptors_[traf.header.track_id].get();
+  const std::vector<SampleEncryptionEntry>& entries =
+      traf.sample_encryption.sample_encryption_entries;
+
+  std::vector<SampleEncryptionEntry> output_entries;
+  for (const TrackFragmentRun& trun : traf.runs) {
+    // The 'mdat' box follows the 'moof' box directly.
+    if (trun.data_offset < input_moof_size_)
+      return Status(error::PARSER_FAILURE, "Samples outside of 'mdat' box.");
+    uint64_t position = trun.data_offset - input_moof_size_;
+    for (uint32_t k = 0; k < trun.sample_count; ++k) {
+      if (output_entries.size() >= entries.size())
+        return Status(error::PARSER_FAILURE, "Too few 'senc' entries.");
+      const SampleEncryptionEntry& entry = entries[output_entries.size()];
+      const uint32_t sample_size = GetSampleSize(*trex, traf.header, trun, k);
+      if (position + sample_size > mdat_size)
+        return Status(error::PARSER_FAILURE, "Samples outside of 'mdat' box.");
+      if (!entry.subsamples.empty() &&
+          entry.GetTotalSizeOfSubsamples() != sample_size) {
+        return Status(error::PARSER_FAILURE, "Incorrect CENC subsample size.");
+      }
+
+      const std::vector<uint8_t>& iv =
+          entry.initialization_vector.empty()
+              ? track_encryption.default_constant_iv
+              : entry.initialization_vector;
+      DecryptConfig decrypt_config(track_encryption.default_kid, iv,
+                                   entry.subsamples, sinf->type.type,
+                                   track_encryption.default_crypt_byte_block,
+                                   track_encryption.default_skip_byte_block);
+      uint8_t* sample = output_mdat + position;
+      if (!decryptor_source_->DecryptSampleBuffer(
+              &decrypt_config, mdat + position, sample_size, sample)) {
+        return Status(error::ENCRYPTION_FAILURE, "Failed to decrypt sample.");
+      }
+
+      // The protected ranges of the input are encrypted with the new key.
+      SampleEncryptionEntry output_entry;
+      output_entry.subsamples = entry.subsamples;
+      std::vector<AesCryptor::BatchText> texts;
+      if (output_entry.subsamples.empty())
+        texts.push_back({sample, sample_size, sample});
+      size_t offset = 0;
+      for (SubsampleEntry& subsample : output_entry.subsamples) {
+        if (options_.protection_scheme == FOURCC_cenc) {
+          // CMAF requires 'cenc' scheme BytesOfProtectedData to be a multiple
+          // of 16 bytes. Leave the leading misaligned bytes in the clear.
+          const uint32_t misalign_bytes =
+              subsample.cipher_bytes % kCencBlockSize;
+          if (subsample.clear_bytes + misalign_bytes >
+              std::numeric_limits<uint16_t>::max()) {
+            return Status(error::ENCRYPTION_FAILURE,
+                          "Too many clear bytes in a subsample.");
+          }
+          subsample.clear_bytes += misalign_bytes;
+          subsample.cipher_bytes -= misalign_bytes;
+        }
+        offset += subsample.clear_bytes;
+        if (subsample.cipher_bytes > 0) {
+          texts.push_back(
+              {sample + offset, subsample.cipher_bytes, sample + offset});
+        }
+        offset += subsample.cipher_bytes;
+      }
+      if (!encryptor->use_constant_iv())
+        output_entry.initialization_vector = encryptor->iv();
+      if (!encryptor->CryptBatch(texts))
+        return Status(error::ENCRYPTION_FAILURE, "Failed to encrypt sample.");
+      encryptor->UpdateIv();
+
+      output_entries.push_back(std::move(output_entry));
+      position += sample_size;
+    }
+  }
+
+  SampleEncryption& sample_encryption = output_traf->sample_encryption;
+  sample_encryption.iv_size =
+      encryptor->use_constant_iv()
+          ? 0
+          : static_cast<uint8_t>(encryptor->iv().size());
+  sample_encryption.sample_encryption_entries = std::move(output_entries);
+  return Status::OK;
+}
+
+Status FragmentRemuxer::WriteMovieFragment(uint64_t input_moof_size,
+                                           MovieFragment* moof) {
+  for (TrackFragment& traf : moof->tracks) {
+    if (!traf.sample_encryption.sample_encryption_entries.empty()) {
+      UpdateAuxiliaryInformation(&traf);
+    } else {
+      // The auxiliary information is in 'mdat'. The optional aux_info_type is
+      // dropped as it is not kept when parsing.
+      traf.auxiliary_size.flags &= ~1;
+      traf.auxiliary_offset.flags &= ~1;
+    }
+  }
+
+  // Data offsets are relative to 'moof', so they move with its size.
+  const int64_t size_change =
+      static_cast<int64_t>(moof->ComputeSize()) -
+      static_cast<int64_t>(input_moof_size);
+  if (size_change != 0 && sidx_seen_) {
+    return Status(error::UNIMPLEMENTED,
+                  "Changing the size of fragments indexed by 'sidx' is not "
+                  "supported.");
+  }
+
+  // 'traf' should follow 'mfhd' moof header box.
+  uint64_t next_traf_position = moof->HeaderSize() + moof->header.box_size();
+  for (TrackFragment& traf : moof->tracks) {
+    next_traf_position += traf.box_size();
+    SampleEncryption& sample_encryption = traf.sample_encryption;
+    if (!sample_encryption.sample_encryption_entries.empty()) {
+      if (!traf.auxiliary_offset.offsets.empty()) {
+        // SampleEncryption 'senc' box should be the last box in 'traf'.
+        // |auxiliary_offset| should point to the data of SampleEncryption.
+        traf.auxiliary_offset.offsets[0] =
+            next_traf_position - sample_encryption.box_size() +
+            sample_encryption.HeaderSize() +
+            sizeof(uint32_t);  // for sample count field in 'senc'
+      }
+    } else {
+      for (uint64_t& offset : traf.auxiliary_offset.offsets)
+        offset += size_change;
+    }
+    for (TrackFragmentRun& trun : traf.runs) {
+      const int64_t data_offset = trun.data_offset + size_change;
+      if (data_offset < 0 ||
+          data_offset > std::numeric_limits<uint32_t>::max()) {
+        return Status(error::MUXER_FAILURE, "Data offset out of range.");
+      }
+      trun.data_offset = static_cast<uint32_t>(data_offset);
+    }
+  }
+
+  BufferWriter buffer;
+  moof->Write(&buffer);
+  return buffer.WriteToFile(output_);
+}
+
+Status FragmentRemuxer::WriteBytes(const uint8_t* data, size_t size) {
+  while (size > 0) {
+    const int64_t size_written = output_->Write(data, size);
+    if (size_written <= 0)
+      return Status(error::FILE_FAILURE, "Failed to write remuxed output.");
+    data += size_written;
+    size -= size_written;
+  }
+  return Status::OK;
+}
+
+uint32_t FragmentRemuxer::MapTrackId(uint32_t track_id) const {
+  auto iter = options_.track_id_map.find(track_id);
+  return iter == options_.track_id_map.end() ? track_id : iter->second;
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
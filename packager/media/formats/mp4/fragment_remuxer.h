@@ -0,0 +1,129 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_MP4_FRAGMENT_REMUXER_H_
+#define PACKAGER_MEDIA_FORMATS_MP4_FRAGMENT_REMUXER_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/media/base/byte_queue.h"
+#include "packager/media/base/fourccs.h"
+#include "packager/media/base/key_source.h"
+#include "packager/status.h"
+
+namespace shaka {
+
+class File;
+
+namespace media {
+
+class AesCryptor;
+class DecryptorSource;
+
+namespace mp4 {
+
+struct Movie;
+struct MovieFragment;
+struct TrackFragment;
+
+/// Options for FragmentRemuxer.
+struct FragmentRemuxerOptions {
+  /// Maps input track ids to output track ids. Tracks not in the map keep
+  /// their track ids.
+  std::map<uint32_t, uint32_t> track_id_map;
+  /// The protection scheme of the output encrypted tracks, FOURCC_cenc or
+  /// FOURCC_cbcs. FOURCC_NULL keeps the input encryption, in which case the
+  /// 'mdat' boxes are copied to the output as they are.
+  FourCC protection_scheme = FOURCC_NULL;
+  /// The key to re-encrypt the encrypted tracks with. Only used if
+  /// @a protection_scheme is set.
+  EncryptionKey encryption_key;
+  /// Provides the keys to decrypt the encrypted tracks. Only used if
+  /// @a protection_scheme is set. Not owned; it must outlive the remuxer.
+  KeySource* decryption_key_source = nullptr;
+};
+
+/// FragmentRemuxer remuxes fragmented MP4 input without demuxing it into
+/// samples. Each fragment is handled as a unit: the 'moof' box is parsed and
+/// rewritten, and the 'mdat' payload is copied to the output in blocks, as it
+/// arrives. When re-encrypting, only the protected ranges of the samples in
+/// 'mdat' are decrypted and encrypted again, in place.
+///
+/// Limitations:
+/// - The encrypted tracks of the input must carry 'senc' boxes to be
+///   re-encrypted, and must not use key rotation. Clear tracks stay clear.
+/// - The subsample layout of the input is kept when re-encrypting, except
+///   that 'cenc' protected ranges are shrunk to multiples of 16 bytes.
+/// - A 'sidx' box is copied as is, so fragments following it must not change
+///   in size.
+/// - 'mfra' boxes are dropped.
+class FragmentRemuxer {
+ public:
+  /// @param options specifies how the fragments are remuxed.
+  /// @param output is where the remuxed boxes are written. Not owned; it must
+  ///        outlive the remuxer.
+  FragmentRemuxer(const FragmentRemuxerOptions& options, File* output);
+  ~FragmentRemuxer();
+
+  /// Remux the next chunk of the input. The boxes completed by the chunk are
+  /// written to the output; 'mdat' payloads are written as they arrive unless
+  /// they are re-encrypted.
+  /// @param buf points to the chunk.
+  /// @param size is the size of the chunk in bytes.
+  /// @return OK on success, an error status otherwise.
+  Status Parse(const uint8_t* buf, size_t size);
+
+  /// Signal the end of the input.
+  /// @return OK if the input ended on a box boundary, an error status
+  ///         otherwise.
+  Status Flush();
+
+ private:
+  Status ProcessBox(FourCC type, const uint8_t* data, size_t size);
+  Status ProcessMovie(const uint8_t* data, size_t size);
+  Status ProcessMovieFragment(const uint8_t* data, size_t size);
+  Status ReencryptFragment(const uint8_t* mdat, size_t mdat_size);
+  Status ReencryptTrackFragment(const TrackFragment& traf,
+                                const uint8_t* mdat,
+                                size_t mdat_size,
+                                uint8_t* output_mdat,
+                                TrackFragment* output_traf);
+  // Updates the offsets in |moof|, which replaces a 'moof' box of
+  // |input_moof_size| bytes, and writes it to the output.
+  Status WriteMovieFragment(uint64_t input_moof_size, MovieFragment* moof);
+  Status WriteBytes(const uint8_t* data, size_t size);
+  uint32_t MapTrackId(uint32_t track_id) const;
+
+  const FragmentRemuxerOptions options_;
+  File* const output_;
+  ByteQueue queue_;
+  // Remaining bytes of the box being copied from the input to the output.
+  uint64_t bytes_to_copy_ = 0;
+  // The 'moov' box of the input.
+  std::unique_ptr<Movie> moov_;
+  // The 'moof' box waiting for its 'mdat' box to be re-encrypted, as in the
+  // input, and as it is going to be written.
+  std::unique_ptr<MovieFragment> input_moof_;
+  std::unique_ptr<MovieFragment> output_moof_;
+  uint64_t input_moof_size_ = 0;
+  bool sidx_seen_ = false;
+  // Encryptors of the encrypted tracks, keyed by input track id.
+  std::map<uint32_t, std::unique_ptr<AesCryptor>> encryptors_;
+  std::unique_ptr<DecryptorSource> decryptor_source_;
+
+  DISALLOW_COPY_AND_ASSIGN(FragmentRemuxer);
+};
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_MP4_FRAGMENT_REMUXER_H_
@@ -0,0 +1,477 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/mp4/fragment_remuxer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "packager/file/file.h"
+#include "packager/file/memory_file.h"
+#include "packager/media/base/aes_encryptor.h"
+#include "packager/media/base/aes_pattern_cryptor.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/base/decrypt_config.h"
+#include "packager/media/base/decryptor_source.h"
+#include "packager/media/base/raw_key_source.h"
+#include "packager/media/formats/mp4/box_definitions.h"
+#include "packager/media/formats/mp4/box_reader.h"
+#include "packager/status_test_util.h"
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace shaka {
+namespace media {
+
+namespace {
+const char kOutputFile[] = "memory://output.mp4";
+const uint32_t kTrackId = 1;
+const uint32_t kTimescale = 90000;
+const uint32_t kSampleDuration = 3000;
+const uint8_t kCodecConfig[] = {0x01, 0x64, 0x00, 0x1e, 0xff, 0xe1};
+const uint8_t kInputKeyId[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+                               0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10};
+const uint8_t kInputKey[] = {0xeb, 0xdd, 0x62, 0xf1, 0x68, 0x14, 0xd2, 0x7b,
+                             0x68, 0xef, 0x12, 0x2a, 0xfc, 0xe4, 0xae, 0x3c};
+const uint8_t kInputIv[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0};
+const uint8_t kInputConstantIv[] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xab,
+                                    0xcd, 0xef, 0x01, 0x23, 0x45, 0x67,
+                                    0x89, 0xab, 0xcd, 0xef};
+const uint8_t kOutputKeyId[] = {0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+                                0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c,
+                                0x1d, 0x1e, 0x1f, 0x20};
+const uint8_t kOutputKey[] = {0x6f, 0xc9, 0x6f, 0xe6, 0x28, 0xa2, 0x65, 0xb1,
+                              0x3a, 0xed, 0xde, 0xc0, 0xbc, 0x42, 0x1f, 0x4d};
+// A 'pssh' box only needs to be well formed to be carried in 'moov'.
+const uint8_t kPsshBox[] = {0x00, 0x00, 0x00, 0x0c, 'p', 's',
+                            's',  'h',  0x00, 0x00, 0x00, 0x00};
+
+class MockKeySource : public RawKeySource {
+ public:
+  MOCK_METHOD2(GetKey,
+               Status(const std::vector<uint8_t>& key_id, EncryptionKey* key));
+};
+
+EncryptionKey CreateKey(const uint8_t* key_id, const uint8_t* key) {
+  EncryptionKey encryption_key;
+  encryption_key.key_id.assign(key_id, key_id + 16);
+  encryption_key.key.assign(key, key + 16);
+  return encryption_key;
+}
+
+struct TestSample {
+  std::vector<uint8_t> data;
+  std::vector<SubsampleEntry> subsamples;
+};
+
+std::vector<TestSample> CreateSamples(size_t first_sample) {
+  // Protected ranges are not multiples of 16 bytes, and one sample is larger
+  // than a 1:9 pattern.
+  const size_t kSampleSizes[] = {100, 57, 400};
+  std::vector<TestSample> samples;
+  for (size_t i = 0; i < arraysize(kSampleSizes); ++i) {
+    TestSample sample;
+    for (size_t j = 0; j < kSampleSizes[i]; ++j)
+      sample.data.push_back(static_cast<uint8_t>((first_sample + i) * 31 + j));
+    samples.push_back(sample);
+  }
+  samples[0].subsamples = {{10, 90}};
+  samples[1].subsamples = {{5, 52}};
+  samples[2].subsamples = {{20, 300}, {80, 0}};
+  return samples;
+}
+
+}  // namespace
+
+namespace mp4 {
+
+class FragmentRemuxerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    EXPECT_CALL(input_key_source_, GetKey(_, _))
+        .WillRepeatedly(DoAll(SetArgPointee<1>(CreateKey(kInputKeyId,
+                                                         kInputKey)),
+                              Return(Status::OK)));
+    EXPECT_CALL(output_key_source_, GetKey(_, _))
+        .WillRepeatedly(DoAll(SetArgPointee<1>(CreateKey(kOutputKeyId,
+                                                         kOutputKey)),
+                              Return(Status::OK)));
+  }
+
+  void TearDown() override { MemoryFile::DeleteAll(); }
+
+  // Creates an input with the given fragments, encrypted with
+  // |protection_scheme| unless it is FOURCC_NULL.
+  void CreateInput(FourCC protection_scheme,
+                   const std::vector<std::vector<TestSample>>& fragments) {
+    BufferWriter buffer;
+    FileType ftyp;
+    ftyp.major_brand = FOURCC_iso6;
+    ftyp.compatible_brands.push_back(FOURCC_cmfc);
+    ftyp.Write(&buffer);
+    ftyp_size_ = buffer.Size();
+
+    Movie moov;
+    moov.header.timescale = 1000;
+    moov.header.next_track_id = kTrackId + 1;
+    moov.tracks.resize(1);
+    Track& track = moov.tracks[0];
+    track.header.track_id = kTrackId;
+    track.media.header.timescale = kTimescale;
+    track.media.handler.handler_type = FOURCC_vide;
+    SampleDescription& stsd = track.media.information.sample_table.description;
+    stsd.type = kVideo;
+    stsd.video_entries.resize(1);
+    VideoSampleEntry& entry = stsd.video_entries[0];
+    entry.format = FOURCC_avc1;
+    entry.width = 640;
+    entry.height = 360;
+    entry.codec_configuration.data.assign(
+        kCodecConfig, kCodecConfig + arraysize(kCodecConfig));
+    moov.extends.tracks.resize(1);
+    moov.extends.tracks[0].track_id = kTrackId;
+    moov.extends.tracks[0].default_sample_description_index = 1;
+
+    std::unique_ptr<AesCryptor> encryptor;
+    if (protection_scheme != FOURCC_NULL) {
+      entry.sinf.format.format = entry.format;
+      entry.format = FOURCC_encv;
+      entry.sinf.type.type = protection_scheme;
+      entry.sinf.type.version = 0x00010000;
+      TrackEncryption& tenc = entry.sinf.info.track_encryption;
+      tenc.default_is_protected = 1;
+      tenc.default_kid.assign(kInputKeyId, kInputKeyId + 16);
+      if (protection_scheme == FOURCC_cenc) {
+        tenc.default_per_sample_iv_size = arraysize(kInputIv);
+        encryptor.reset(new AesCtrEncryptor);
+        ASSERT_TRUE(encryptor->InitializeWithIv(
+            std::vector<uint8_t>(kInputKey, kInputKey + 16),
+            std::vector<uint8_t>(kInputIv, kInputIv + arraysize(kInputIv))));
+      } else {
+        tenc.default_crypt_byte_block = 1;
+        tenc.default_skip_byte_block = 9;
+        tenc.default_constant_iv.assign(
+            kInputConstantIv, kInputConstantIv + arraysize(kInputConstantIv));
+        encryptor.reset(new AesPatternCryptor(
+            1, 9, AesPatternCryptor::kEncryptIfCryptByteBlockRemaining,
+            AesCryptor::kUseConstantIv,
+            std::unique_ptr<AesCryptor>(new AesCbcEncryptor(kNoPadding))));
+        ASSERT_TRUE(encryptor->InitializeWithIv(
+            std::vector<uint8_t>(kInputKey, kInputKey + 16),
+            tenc.default_constant_iv));
+      }
+      moov.pssh.resize(1);
+      moov.pssh[0].raw_box.assign(kPsshBox, kPsshBox + arraysize(kPsshBox));
+    }
+    moov.Write(&buffer);
+
+    for (size_t i = 0; i < fragments.size(); ++i) {
+      MovieFragment moof;
+      moof.header.sequence_number = i + 1;
+      moof.tracks.resize(1);
+      TrackFragment& traf = moof.tracks[0];
+      traf.header.track_id = kTrackId;
+      traf.header.flags = TrackFragmentHeader::kDefaultBaseIsMoofMask;
+      traf.decode_time.decode_time = i * 3 * kSampleDuration;
+      traf.runs.resize(1);
+      TrackFragmentRun& trun = traf.runs[0];
+      trun.flags = TrackFragmentRun::kDataOffsetPresentMask |
+                   TrackFragmentRun::kSampleDurationPresentMask |
+                   TrackFragmentRun::kSampleSizePresentMask;
+      trun.sample_count = fragments[i].size();
+
+      // Encrypt the samples. The input has no 'saiz' and 'saio' boxes, which
+      // the remuxer adds.
+      std::vector<uint8_t> mdat_data;
+      for (const TestSample& sample : fragments[i]) {
+        trun.sample_durations.push_back(kSampleDuration);
+        trun.sample_sizes.push_back(sample.data.size());
+        std::vector<uint8_t> data = sample.data;
+        if (encryptor) {
+          SampleEncryptionEntry sample_encryption_entry;
+          if (!encryptor->use_constant_iv())
+            sample_encryption_entry.initialization_vector = encryptor->iv();
+          sample_encryption_entry.subsamples = sample.subsamples;
+          traf.sample_encryption.sample_encryption_entries.push_back(
+              sample_encryption_entry);
+          std::vector<AesCryptor::BatchText> texts;
+          size_t offset = 0;
+          for (const SubsampleEntry& subsample : sample.subsamples) {
+            offset += subsample.clear_bytes;
+            texts.push_back({&data[offset], subsample.cipher_bytes,
+                             &data[offset]});
+            offset += subsample.cipher_bytes;
+          }
+          ASSERT_TRUE(encryptor->CryptBatch(texts));
+          encryptor->UpdateIv();
+        }
+        mdat_data.insert(mdat_data.end(), data.begin(), data.end());
+      }
+      if (encryptor) {
+        traf.sample_encryption.flags =
+            SampleEncryption::kUseSubsampleEncryption;
+        traf.sample_encryption.iv_size =
+            encryptor->use_constant_iv() ? 0 : arraysize(kInputIv);
+      }
+
+      const uint32_t kMdatHeaderSize = 8;
+      trun.data_offset = moof.ComputeSize() + kMdatHeaderSize;
+      moof.Write(&buffer);
+      buffer.AppendInt(static_cast<uint32_t>(kMdatHeaderSize +
+                                             mdat_data.size()));
+      buffer.AppendInt(static_cast<uint32_t>(FOURCC_mdat));
+      buffer.AppendVector(mdat_data);
+      input_mdat_data_.push_back(mdat_data);
+    }
+    input_.assign(buffer.Buffer(), buffer.Buffer() + buffer.Size());
+  }
+
+  // Remuxes the input, in chunks of |chunk_size| bytes.
+  Status Remux(const FragmentRemuxerOptions& options, size_t chunk_size) {
+    File* file = File::Open(kOutputFile, "w");
+    EXPECT_TRUE(file);
+    FragmentRemuxer remuxer(options, file);
+    Status status;
+    for (size_t offset = 0; offset < input_.size() && status.ok();
+         offset += chunk_size) {
+      status = remuxer.Parse(input_.data() + offset,
+                             std::min(chunk_size, input_.size() - offset));
+    }
+    if (status.ok())
+      status = remuxer.Flush();
+    EXPECT_TRUE(file->Close());
+    return status;
+  }
+
+  // Parses the boxes in the output.
+  void ParseOutput() {
+    ASSERT_TRUE(File::ReadFileToString(kOutputFile, &output_));
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(output_.data());
+    size_t position = 0;
+    while (position < output_.size()) {
+      bool err = false;
+      std::unique_ptr<BoxReader> reader(
+          BoxReader::ReadBox(data + position, output_.size() - position, &err));
+      ASSERT_TRUE(reader);
+      if (reader->type() == FOURCC_moov) {
+        ASSERT_TRUE(output_moov_.Parse(reader.get()));
+      } else if (reader->type() == FOURCC_moof) {
+        output_moofs_.resize(output_moofs_.size() + 1);
+        ASSERT_TRUE(output_moofs_.back().Parse(reader.get()));
+        output_moof_positions_.push_back(position);
+      } else if (reader->type() == FOURCC_mdat) {
+        output_mdat_data_.push_back(std::vector<uint8_t>(
+            data + position + 8, data + position + reader->size()));
+      }
+      position += reader->size();
+    }
+    ASSERT_EQ(output_moofs_.size(), output_mdat_data_.size());
+  }
+
+  const TrackEncryption& output_track_encryption() {
+    return output_moov_.tracks[0]
+        .media.information.sample_table.description.video_entries[0]
+        .sinf.info.track_encryption;
+  }
+
+  std::vector<SampleEncryptionEntry> GetSampleEncryptionEntries(
+      const TrackFragment& traf) {
+    std::vector<SampleEncryptionEntry> entries;
+    if (!traf.sample_encryption.sample_encryption_data.empty()) {
+      EXPECT_TRUE(traf.sample_encryption.ParseFromSampleEncryptionData(
+          output_track_encryption().default_per_sample_iv_size, &entries));
+    }
+    return entries;
+  }
+
+  // Extracts the samples of fragment |index| from the output, decrypted with
+  // the keys of |key_source|.
+  std::vector<std::vector<uint8_t>> GetOutputSamples(size_t index,
+                                                     KeySource* key_source) {
+    const VideoSampleEntry& entry =
+        output_moov_.tracks[0]
+            .media.information.sample_table.description.video_entries[0];
+    const TrackEncryption& tenc = entry.sinf.info.track_encryption;
+    const TrackFragment& traf = output_moofs_[index].tracks[0];
+    const std::vector<SampleEncryptionEntry> entries =
+        GetSampleEncryptionEntries(traf);
+    DecryptorSource decryptor_source(key_source);
+
+    std::vector<std::vector<uint8_t>> samples;
+    const TrackFragmentRun& trun = traf.runs[0];
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(output_.data()) +
+                          output_moof_positions_[index] + trun.data_offset;
+    for (uint32_t i = 0; i < trun.sample_count; ++i) {
+      const uint32_t size = trun.sample_sizes[i];
+      std::vector<uint8_t> sample(data, data + size);
+      if (!entries.empty()) {
+        std::vector<uint8_t> iv = entries[i].initialization_vector;
+        if (iv.empty())
+          iv = tenc.default_constant_iv;
+        DecryptConfig decrypt_config(
+            tenc.default_kid, iv, entries[i].subsamples, entry.sinf.type.type,
+            tenc.default_crypt_byte_block, tenc.default_skip_byte_block);
+        EXPECT_TRUE(decryptor_source.DecryptSampleBuffer(&decrypt_config, data,
+                                                         size, &sample[0]));
+      }
+      samples.push_back(sample);
+      data += size;
+    }
+    return samples;
+  }
+
+  void ExpectClearSamples(const std::vector<std::vector<TestSample>>& fragments,
+                          KeySource* key_source) {
+    ASSERT_EQ(fragments.size(), output_moofs_.size());
+    for (size_t i = 0; i < fragments.size(); ++i) {
+      const std::vector<std::vector<uint8_t>> samples =
+          GetOutputSamples(i, key_source);
+      ASSERT_EQ(fragments[i].size(), samples.size());
+      for (size_t j = 0; j < samples.size(); ++j)
+        EXPECT_EQ(fragments[i][j].data, samples[j]);
+    }
+  }
+
+  // 'saio' should point to the 'senc' entries of the fragment.
+  void ExpectAuxiliaryOffsetToSampleEncryption(size_t index) {
+    const TrackFragment& traf = output_moofs_[index].tracks[0];
+    ASSERT_EQ(1u, traf.auxiliary_offset.offsets.size());
+    const std::vector<SampleEncryptionEntry> entries =
+        GetSampleEncryptionEntries(traf);
+    ASSERT_FALSE(entries.empty());
+    const size_t auxiliary_info_position =
+        output_moof_positions_[index] + traf.auxiliary_offset.offsets[0];
+    const std::vector<uint8_t>& iv = entries[0].initialization_vector;
+    ASSERT_FALSE(iv.empty());
+    EXPECT_EQ(std::string(iv.begin(), iv.end()),
+              output_.substr(auxiliary_info_position, iv.size()));
+  }
+
+  MockKeySource input_key_source_;
+  MockKeySource output_key_source_;
+  std::vector<uint8_t> input_;
+  size_t ftyp_size_ = 0;
+  std::vector<std::vector<uint8_t>> input_mdat_data_;
+  std::string output_;
+  Movie output_moov_;
+  std::vector<MovieFragment> output_moofs_;
+  std::vector<size_t> output_moof_positions_;
+  std::vector<std::vector<uint8_t>> output_mdat_data_;
+};
+
+TEST_F(FragmentRemuxerTest, CopyMapsTrackIds) {
+  const std::vector<std::vector<TestSample>> fragments = {CreateSamples(0),
+                                                          CreateSamples(3)};
+  CreateInput(FOURCC_NULL, fragments);
+  FragmentRemuxerOptions options;
+  options.track_id_map[kTrackId] = 3;
+  ASSERT_OK(Remux(options, 7));
+  ASSERT_NO_FATAL_FAILURE(ParseOutput());
+
+  EXPECT_EQ(input_.size(), output_.size());
+  EXPECT_EQ(std::string(input_.begin(), input_.begin() + ftyp_size_),
+            output_.substr(0, ftyp_size_));
+  EXPECT_EQ(3u, output_moov_.tracks[0].header.track_id);
+  EXPECT_EQ(3u, output_moov_.extends.tracks[0].track_id);
+  EXPECT_EQ(4u, output_moov_.header.next_track_id);
+  for (const MovieFragment& moof : output_moofs_)
+    EXPECT_EQ(3u, moof.tracks[0].header.track_id);
+  EXPECT_EQ(input_mdat_data_, output_mdat_data_);
+  ExpectClearSamples(fragments, &input_key_source_);
+}
+
+TEST_F(FragmentRemuxerTest, CopyUpdatesOffsetsOfLargerFragments) {
+  const std::vector<std::vector<TestSample>> fragments = {CreateSamples(0),
+                                                          CreateSamples(3)};
+  CreateInput(FOURCC_cenc, fragments);
+  ASSERT_OK(Remux(FragmentRemuxerOptions(), 1000));
+  ASSERT_NO_FATAL_FAILURE(ParseOutput());
+
+  // 'saiz' and 'saio' boxes are added, the 'mdat' boxes are copied.
+  EXPECT_LT(input_.size(), output_.size());
+  EXPECT_EQ(input_mdat_data_, output_mdat_data_);
+  EXPECT_EQ(FOURCC_cenc, output_moov_.tracks[0]
+                             .media.information.sample_table.description
+                             .video_entries[0].sinf.type.type);
+  EXPECT_EQ(1u, output_moov_.pssh.size());
+  for (size_t i = 0; i < output_moofs_.size(); ++i)
+    ExpectAuxiliaryOffsetToSampleEncryption(i);
+  ExpectClearSamples(fragments, &input_key_source_);
+}
+
+TEST_F(FragmentRemuxerTest, ReencryptCencToCbcs) {
+  const std::vector<std::vector<TestSample>> fragments = {CreateSamples(0),
+                                                          CreateSamples(3)};
+  CreateInput(FOURCC_cenc, fragments);
+  FragmentRemuxerOptions options;
+  options.protection_scheme = FOURCC_cbcs;
+  options.encryption_key = CreateKey(kOutputKeyId, kOutputKey);
+  options.decryption_key_source = &input_key_source_;
+  ASSERT_OK(Remux(options, 100));
+  ASSERT_NO_FATAL_FAILURE(ParseOutput());
+
+  const ProtectionSchemeInfo& sinf =
+      output_moov_.tracks[0]
+          .media.information.sample_table.description.video_entries[0]
+          .sinf;
+  EXPECT_EQ(FOURCC_cbcs, sinf.type.type);
+  const TrackEncryption& tenc = sinf.info.track_encryption;
+  EXPECT_EQ(std::vector<uint8_t>(kOutputKeyId, kOutputKeyId + 16),
+            tenc.default_kid);
+  EXPECT_EQ(0u, tenc.default_per_sample_iv_size);
+  EXPECT_EQ(16u, tenc.default_constant_iv.size());
+  EXPECT_EQ(1u, tenc.default_crypt_byte_block);
+  EXPECT_EQ(9u, tenc.default_skip_byte_block);
+  // The 'pssh' boxes for the input key are dropped.
+  EXPECT_TRUE(output_moov_.pssh.empty());
+
+  // The samples are encrypted with the new key.
+  EXPECT_NE(input_mdat_data_, output_mdat_data_);
+  ExpectClearSamples(fragments, &output_key_source_);
+}
+
+TEST_F(FragmentRemuxerTest, ReencryptCbcsToCenc) {
+  const std::vector<std::vector<TestSample>> fragments = {CreateSamples(0)};
+  CreateInput(FOURCC_cbcs, fragments);
+  FragmentRemuxerOptions options;
+  options.protection_scheme = FOURCC_cenc;
+  options.encryption_key = CreateKey(kOutputKeyId, kOutputKey);
+  options.decryption_key_source = &input_key_source_;
+  ASSERT_OK(Remux(options, 33));
+  ASSERT_NO_FATAL_FAILURE(ParseOutput());
+
+  const TrackEncryption& tenc = output_track_encryption();
+  EXPECT_EQ(8u, tenc.default_per_sample_iv_size);
+  EXPECT_TRUE(tenc.default_constant_iv.empty());
+  EXPECT_EQ(0u, tenc.default_crypt_byte_block);
+  EXPECT_EQ(0u, tenc.default_skip_byte_block);
+
+  // 'cenc' protected ranges are multiples of 16 bytes.
+  for (const SampleEncryptionEntry& entry :
+       GetSampleEncryptionEntries(output_moofs_[0].tracks[0])) {
+    for (const SubsampleEntry& subsample : entry.subsamples)
+      EXPECT_EQ(0u, subsample.cipher_bytes % 16);
+  }
+  ExpectAuxiliaryOffsetToSampleEncryption(0);
+  ExpectClearSamples(fragments, &output_key_source_);
+}
+
+TEST_F(FragmentRemuxerTest, TruncatedInput) {
+  CreateInput(FOURCC_NULL, {CreateSamples(0)});
+  input_.resize(input_.size() - 1);
+  EXPECT_EQ(error::PARSER_FAILURE,
+            Remux(FragmentRemuxerOptions(), 100).error_code());
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
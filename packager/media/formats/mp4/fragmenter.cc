@@ -54,7 +54,8 @@ Fragmenter::Fragmenter(std::shared_ptr<const StreamInfo> stream_info,
       fragment_finalized_(false),
       fragment_duration_(0),
       earliest_presentation_time_(kInvalidTime),
-      first_sap_time_(kInvalidTime) {
+      first_sap_time_(kInvalidTime),
+      data_memory_(MemoryComponent::kFragmenter) {
   DCHECK(stream_info_);
   DCHECK(traf);
 }
@@ -90,6 +91,7 @@ Status Fragmenter::AddSample(const MediaSample& sample) {
   }
 
   data_->AppendArray(sample.data(), sample.data_size());
+  data_memory_.Charge(sample.data_size());
   fragment_duration_ += sample.duration();
 
   const int64_t pts = sample.pts();
@@ -131,6 +133,7 @@ Status Fragmenter::InitializeFragment(int64_t first_sample_dts) {
   fragment_duration_ = 0;
   earliest_presentation_time_ = kInvalidTime;
   first_sap_time_ = kInvalidTime;
+  data_memory_.ReleaseAll();
   data_.reset(new BufferWriter());
   return Status::OK;
 }
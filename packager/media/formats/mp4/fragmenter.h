@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "packager/base/logging.h"
+#include "packager/file/memory_accountant.h"
 #include "packager/status.h"
 
 namespace shaka {
@@ -96,6 +97,8 @@ class Fragmenter {
   int64_t earliest_presentation_time_;
   int64_t first_sap_time_;
   std::unique_ptr<BufferWriter> data_;
+  // Memory held by |data_|.
+  MemoryCharge data_memory_;
 
   DISALLOW_COPY_AND_ASSIGN(Fragmenter);
 };
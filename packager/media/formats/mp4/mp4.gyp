@@ -26,6 +26,8 @@
         'composition_offset_iterator.h',
         'decoding_time_iterator.cc',
         'decoding_time_iterator.h',
+        'fragment_remuxer.cc',
+        'fragment_remuxer.h',
         'fragmenter.cc',
         'fragmenter.h',
         'mp4_media_parser.cc',
@@ -59,6 +61,7 @@
         'chunk_info_iterator_unittest.cc',
         'composition_offset_iterator_unittest.cc',
         'decoding_time_iterator_unittest.cc',
+        'fragment_remuxer_unittest.cc',
         'mp4_media_parser_unittest.cc',
         'sync_sample_iterator_unittest.cc',
         'track_run_iterator_unittest.cc',
@@ -106,7 +106,11 @@ MP4MediaParser::MP4MediaParser()
       moof_head_(0),
       mdat_tail_(0) {}
 
-MP4MediaParser::~MP4MediaParser() {}
+MP4MediaParser::~MP4MediaParser() {
+  const AllocationStats stats = buffer_pool_.stats();
+  VLOG(1) << "Sample buffers: " << stats.num_system_allocations
+          << " allocated, " << stats.num_recycled_allocations << " recycled.";
+}
 
 void MP4MediaParser::Init(const InitCB& init_cb,
                           const NewSampleCB& new_sample_cb,
@@ -722,15 +726,12 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
 
   const uint8_t* media_data = buf;
   const size_t media_data_size = runs_->sample_size();
-  // Use a dummy data size of 0 to avoid copying overhead.
   // Actual media data is set later.
-  const size_t kDummyDataSize = 0;
   std::shared_ptr<MediaSample> stream_sample(
-      MediaSample::CopyFrom(media_data, kDummyDataSize, runs_->is_keyframe()));
+      MediaSample::CreateEmptyMediaSample());
+  stream_sample->set_is_key_frame(runs_->is_keyframe());
 
   if (runs_->is_encrypted()) {
-    std::shared_ptr<uint8_t> decrypted_media_data(
-        new uint8_t[media_data_size], std::default_delete<uint8_t[]>());
     std::unique_ptr<DecryptConfig> decrypt_config = runs_->GetDecryptConfig();
     if (!decrypt_config) {
       *err = true;
@@ -739,12 +740,14 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
     }
 
     if (!decryptor_source_) {
-      stream_sample->SetData(media_data, media_data_size);
+      stream_sample->SetData(media_data, media_data_size, &buffer_pool_);
       // If the demuxer does not have the decryptor_source_, store
       // decrypt_config so that the demuxed sample can be decrypted later.
       stream_sample->set_decrypt_config(std::move(decrypt_config));
       stream_sample->set_is_encrypted(true);
     } else {
+      std::shared_ptr<uint8_t> decrypted_media_data =
+          buffer_pool_.Allocate(media_data_size);
       if (!decryptor_source_->DecryptSampleBuffer(decrypt_config.get(),
                                                   media_data, media_data_size,
                                                   decrypted_media_data.get())) {
@@ -756,7 +759,7 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
                                   media_data_size);
     }
   } else {
-    stream_sample->SetData(media_data, media_data_size);
+    stream_sample->SetData(media_data, media_data_size, &buffer_pool_);
   }
 
   stream_sample->set_dts(runs_->dts());
@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "packager/base/callback_forward.h"
+#include "packager/media/base/buffer_pool.h"
 #include "packager/media/base/decryptor_source.h"
 #include "packager/media/base/media_parser.h"
 #include "packager/media/base/offset_byte_queue.h"
@@ -87,6 +88,8 @@ class MP4MediaParser : public MediaParser {
   std::unique_ptr<DecryptorSource> decryptor_source_;
 
   OffsetByteQueue queue_;
+  // Sample payloads are allocated from the pool.
+  BufferPool buffer_pool_;
 
   // These two parameters are only valid in the |kEmittingSegments| state.
   //
@@ -42,6 +42,7 @@ Segmenter::Segmenter(const MuxerOptions& options,
       moov_(std::move(moov)),
       moof_(new MovieFragment()),
       fragment_buffer_(new BufferWriter()),
+      fragment_buffer_memory_(MemoryComponent::kFragmenter),
       sidx_(new SegmentIndex()) {}
 
 Segmenter::~Segmenter() {}
@@ -189,10 +190,13 @@ Status Segmenter::FinalizeSegment(size_t stream_id,
       data_offset + mdat.data_size;
 
   // Write the fragment to buffer.
+  const size_t fragment_buffer_size = fragment_buffer_->Size();
   moof_->Write(fragment_buffer_.get());
   mdat.WriteHeader(fragment_buffer_.get());
   for (const std::unique_ptr<Fragmenter>& fragmenter : fragmenters_)
     fragment_buffer_->AppendBuffer(*fragmenter->data());
+  fragment_buffer_memory_.Charge(fragment_buffer_->Size() -
+                                 fragment_buffer_size);
 
   // Increase sequence_number for next fragment.
   ++moof_->header.sequence_number;
@@ -201,6 +205,8 @@ Status Segmenter::FinalizeSegment(size_t stream_id,
     fragmenter->ClearFragmentFinalized();
   if (!segment_info.is_subsegment) {
     Status status = DoFinalizeSegment();
+    // The fragments are written out with the segment.
+    fragment_buffer_memory_.ReleaseAll();
     // Reset segment information to initial state.
     sidx_->references.clear();
     return status;
@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "packager/base/optional.h"
+#include "packager/file/memory_accountant.h"
 #include "packager/media/base/fourccs.h"
 #include "packager/media/base/range.h"
 #include "packager/media/formats/mp4/box_definitions.h"
@@ -134,6 +135,8 @@ class Segmenter {
   std::unique_ptr<Movie> moov_;
   std::unique_ptr<MovieFragment> moof_;
   std::unique_ptr<BufferWriter> fragment_buffer_;
+  // Memory held by |fragment_buffer_| until the segment is written.
+  MemoryCharge fragment_buffer_memory_;
   std::unique_ptr<SegmentIndex> sidx_;
   std::vector<std::unique_ptr<Fragmenter>> fragmenters_;
   MuxerListener* muxer_listener_ = nullptr;
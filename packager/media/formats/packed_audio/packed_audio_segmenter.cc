@@ -0,0 +1,101 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/packed_audio/packed_audio_segmenter.h"
+
+#include <string>
+#include <vector>
+
+#include "packager/base/logging.h"
+#include "packager/media/base/id3_tag.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/codecs/aac_audio_specific_config.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const double kPackedAudioTimescale = 90000;
+const char kTimestampOwnerIdentifier[] =
+    "com.apple.streaming.transportStreamTimestamp";
+
+// The timestamp is a 33-bit MPEG-2 Program Elementary Stream timestamp,
+// carried in a big-endian 64-bit integer with the upper 31 bits set to 0.
+std::string TimestampToString(int64_t timestamp) {
+  const uint64_t kTimestampMask = (UINT64_C(1) << 33) - 1;
+  BufferWriter buffer;
+  buffer.AppendInt(static_cast<uint64_t>(timestamp) & kTimestampMask);
+  return std::string(buffer.Buffer(), buffer.Buffer() + buffer.Size());
+}
+
+}  // namespace
+
+PackedAudioSegmenter::PackedAudioSegmenter() = default;
+PackedAudioSegmenter::~PackedAudioSegmenter() = default;
+
+Status PackedAudioSegmenter::Initialize(const StreamInfo& stream_info) {
+  if (stream_info.stream_type() != kStreamAudio) {
+    LOG(ERROR) << "Packed audio cannot handle stream type "
+               << stream_info.stream_type();
+    return Status(error::MUXER_FAILURE, "Unsupported stream type.");
+  }
+
+  codec_ = stream_info.codec();
+  timescale_scale_ = kPackedAudioTimescale / stream_info.time_scale();
+  switch (codec_) {
+    case kCodecAAC:
+      adts_converter_.reset(new AACAudioSpecificConfig());
+      if (!adts_converter_->Parse(stream_info.codec_config())) {
+        return Status(error::MUXER_FAILURE,
+                      "Failed to parse AAC audio specific config.");
+      }
+      break;
+    case kCodecAC3:
+    case kCodecEAC3:
+      // AC-3 and E-AC-3 samples are sync frames already.
+      break;
+    default:
+      LOG(ERROR) << "Packed audio does not support codec " << codec_;
+      return Status(error::MUXER_FAILURE, "Unsupported codec.");
+  }
+  return Status::OK;
+}
+
+Status PackedAudioSegmenter::AddSample(const MediaSample& sample) {
+  if (sample.is_encrypted()) {
+    return Status(error::UNIMPLEMENTED,
+                  "Encrypted packed audio is not supported yet.");
+  }
+
+  if (segment_buffer_.Size() == 0) {
+    Status status = WriteId3Tag(sample.pts());
+    if (!status.ok())
+      return status;
+  }
+
+  if (adts_converter_) {
+    std::vector<uint8_t> audio_frame(sample.data(),
+                                     sample.data() + sample.data_size());
+    if (!adts_converter_->ConvertToADTS(&audio_frame))
+      return Status(error::MUXER_FAILURE, "Failed to convert AAC to ADTS.");
+    segment_buffer_.AppendVector(audio_frame);
+  } else {
+    segment_buffer_.AppendArray(sample.data(), sample.data_size());
+  }
+  return Status::OK;
+}
+
+Status PackedAudioSegmenter::WriteId3Tag(int64_t pts) {
+  Id3Tag id3_tag;
+  id3_tag.AddPrivateFrame(kTimestampOwnerIdentifier,
+                          TimestampToString(pts * timescale_scale_));
+  if (!id3_tag.WriteToBuffer(&segment_buffer_))
+    return Status(error::MUXER_FAILURE, "Failed to write ID3 tag.");
+  return Status::OK;
+}
+
+}  // namespace media
+}  // namespace shaka
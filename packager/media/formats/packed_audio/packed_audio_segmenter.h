@@ -0,0 +1,65 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_PACKED_AUDIO_PACKED_AUDIO_SEGMENTER_H_
+#define PACKAGER_MEDIA_FORMATS_PACKED_AUDIO_PACKED_AUDIO_SEGMENTER_H_
+
+#include <memory>
+
+#include "packager/base/macros.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/status.h"
+
+namespace shaka {
+namespace media {
+
+class AACAudioSpecificConfig;
+class MediaSample;
+
+/// Segments an audio stream into HLS packed audio segments, i.e. the audio
+/// elementary stream without any container, preceded by an ID3 tag with the
+/// timestamp of the first sample in a PRIV frame with owner
+/// "com.apple.streaming.transportStreamTimestamp". AAC is carried in ADTS and
+/// AC-3 / E-AC-3 in their sync frames.
+/// See https://tools.ietf.org/html/draft-pantos-http-live-streaming 3.4.
+class PackedAudioSegmenter {
+ public:
+  PackedAudioSegmenter();
+  ~PackedAudioSegmenter();
+
+  /// Initialize the object.
+  /// @param stream_info is the stream info for the segmenter.
+  /// @return OK on success.
+  Status Initialize(const StreamInfo& stream_info);
+
+  /// @param sample gets added to the current segment.
+  /// @return OK on success.
+  Status AddSample(const MediaSample& sample);
+
+  /// @return The buffer of the current segment. It is empty if no sample has
+  ///         been added since the buffer was last cleared, in which case the
+  ///         next sample starts a new segment.
+  BufferWriter* segment_buffer() { return &segment_buffer_; }
+
+ private:
+  Status WriteId3Tag(int64_t pts);
+
+  Codec codec_ = kUnknownCodec;
+  // Scale to convert the stream timestamps to the 90 kHz MPEG-2 timestamps in
+  // the ID3 tag.
+  double timescale_scale_ = 0;
+  // AAC samples are converted to ADTS.
+  std::unique_ptr<AACAudioSpecificConfig> adts_converter_;
+  BufferWriter segment_buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackedAudioSegmenter);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_PACKED_AUDIO_PACKED_AUDIO_SEGMENTER_H_
@@ -0,0 +1,116 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/packed_audio/packed_audio_segmenter.h"
+
+#include <gtest/gtest.h>
+
+#include "packager/media/base/audio_stream_info.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/status_test_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const int kTrackId = 0;
+const uint32_t kTimeScale = 90000;
+const uint64_t kDuration = 180000;
+const char kLanguage[] = "eng";
+const bool kIsKeyFrame = true;
+const bool kIsEncrypted = false;
+const uint8_t kAacExtraData[] = {0x12, 0x10};
+const char kAacCodecString[] = "mp4a.40.2";
+const char kAc3CodecString[] = "ac-3";
+const uint8_t kSampleBits = 16;
+const uint8_t kNumChannels = 2;
+const uint32_t kSamplingFrequency = 44100;
+const uint64_t kSeekPreroll = 0;
+const uint64_t kCodecDelay = 0;
+const uint32_t kMaxBitrate = 320000;
+const uint32_t kAverageBitrate = 256000;
+
+const uint8_t kAnyData[] = {
+    0x01, 0x0F, 0x3C,
+};
+// A 33-bit timestamp.
+const int64_t kPts = 0x123456789;
+
+// ID3 tag with the transport stream timestamp of |kPts|.
+const uint8_t kExpectedId3Tag[] = {
+    'I', 'D', '3', 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3F,
+    'P', 'R', 'I', 'V', 0x00, 0x00, 0x00, 0x35, 0x00, 0x00,
+    'c', 'o', 'm', '.', 'a', 'p', 'p', 'l', 'e', '.', 's', 't', 'r', 'e',
+    'a', 'm', 'i', 'n', 'g', '.', 't', 'r', 'a', 'n', 's', 'p', 'o', 'r',
+    't', 'S', 't', 'r', 'e', 'a', 'm', 'T', 'i', 'm', 'e', 's', 't', 'a',
+    'm', 'p', 0x00,
+    0x00, 0x00, 0x00, 0x01, 0x23, 0x45, 0x67, 0x89,
+};
+
+std::shared_ptr<AudioStreamInfo> CreateAudioStreamInfo(Codec codec) {
+  const bool is_aac = codec == kCodecAAC;
+  return std::make_shared<AudioStreamInfo>(
+      kTrackId, kTimeScale, kDuration, codec,
+      is_aac ? kAacCodecString : kAc3CodecString, kAacExtraData,
+      is_aac ? arraysize(kAacExtraData) : 0, kSampleBits, kNumChannels,
+      kSamplingFrequency, kSeekPreroll, kCodecDelay, kMaxBitrate,
+      kAverageBitrate, kLanguage, kIsEncrypted);
+}
+
+std::shared_ptr<MediaSample> CreateSample(int64_t pts) {
+  std::shared_ptr<MediaSample> sample =
+      MediaSample::CopyFrom(kAnyData, arraysize(kAnyData), kIsKeyFrame);
+  sample->set_pts(pts);
+  sample->set_dts(pts);
+  return sample;
+}
+
+std::vector<uint8_t> ToVector(const BufferWriter& buffer) {
+  return std::vector<uint8_t>(buffer.Buffer(), buffer.Buffer() + buffer.Size());
+}
+
+}  // namespace
+
+TEST(PackedAudioSegmenterTest, Aac) {
+  PackedAudioSegmenter segmenter;
+  ASSERT_OK(segmenter.Initialize(*CreateAudioStreamInfo(kCodecAAC)));
+  ASSERT_OK(segmenter.AddSample(*CreateSample(kPts)));
+  ASSERT_OK(segmenter.AddSample(*CreateSample(kPts + 1024)));
+
+  std::vector<uint8_t> expected(std::begin(kExpectedId3Tag),
+                                std::end(kExpectedId3Tag));
+  // Only the first sample of the segment gets the ID3 tag.
+  for (int i = 0; i < 2; ++i) {
+    const uint8_t kAdtsHeader[] = {0xFF, 0xF1, 0x50, 0x80, 0x01, 0x5F, 0xFC};
+    expected.insert(expected.end(), std::begin(kAdtsHeader),
+                    std::end(kAdtsHeader));
+    expected.insert(expected.end(), std::begin(kAnyData), std::end(kAnyData));
+  }
+  EXPECT_EQ(expected, ToVector(*segmenter.segment_buffer()));
+}
+
+TEST(PackedAudioSegmenterTest, Ac3NewSegment) {
+  PackedAudioSegmenter segmenter;
+  ASSERT_OK(segmenter.Initialize(*CreateAudioStreamInfo(kCodecAC3)));
+  ASSERT_OK(segmenter.AddSample(*CreateSample(0)));
+  segmenter.segment_buffer()->Clear();
+
+  // A new segment starts once the buffer is cleared.
+  ASSERT_OK(segmenter.AddSample(*CreateSample(kPts)));
+  std::vector<uint8_t> expected(std::begin(kExpectedId3Tag),
+                                std::end(kExpectedId3Tag));
+  expected.insert(expected.end(), std::begin(kAnyData), std::end(kAnyData));
+  EXPECT_EQ(expected, ToVector(*segmenter.segment_buffer()));
+}
+
+TEST(PackedAudioSegmenterTest, UnsupportedCodec) {
+  PackedAudioSegmenter segmenter;
+  EXPECT_NE(Status::OK,
+            segmenter.Initialize(*CreateAudioStreamInfo(kCodecOpus)));
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,87 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/packed_audio/packed_audio_writer.h"
+
+#include "packager/file/file.h"
+#include "packager/media/base/muxer_util.h"
+#include "packager/media/event/muxer_listener.h"
+
+namespace shaka {
+namespace media {
+
+PackedAudioWriter::PackedAudioWriter(const MuxerOptions& muxer_options)
+    : Muxer(muxer_options) {}
+PackedAudioWriter::~PackedAudioWriter() {}
+
+Status PackedAudioWriter::InitializeMuxer() {
+  if (streams().size() > 1u)
+    return Status(error::MUXER_FAILURE, "Cannot handle more than one stream.");
+  if (options().segment_template.empty())
+    return Status(error::MUXER_FAILURE, "Segment template not specified.");
+
+  segmenter_.reset(new PackedAudioSegmenter());
+  Status status = segmenter_->Initialize(*streams().front());
+  if (!status.ok())
+    return status;
+
+  if (muxer_listener()) {
+    muxer_listener()->OnMediaStart(options(), *streams().front(),
+                                   streams().front()->time_scale(),
+                                   MuxerListener::kContainerPackedAudio);
+  }
+  return Status::OK;
+}
+
+Status PackedAudioWriter::Finalize() {
+  if (muxer_listener()) {
+    // There is no single file packed audio output, so no ranges to report.
+    MuxerListener::MediaRanges media_ranges;
+    muxer_listener()->OnMediaEnd(media_ranges, 0);
+  }
+  return Status::OK;
+}
+
+Status PackedAudioWriter::AddSample(size_t stream_id,
+                                    const MediaSample& sample) {
+  DCHECK_EQ(stream_id, 0u);
+  return segmenter_->AddSample(sample);
+}
+
+Status PackedAudioWriter::FinalizeSegment(size_t stream_id,
+                                          const SegmentInfo& segment_info) {
+  DCHECK_EQ(stream_id, 0u);
+  if (segment_info.is_subsegment)
+    return Status::OK;
+
+  BufferWriter* segment_buffer = segmenter_->segment_buffer();
+  if (segment_buffer->Size() == 0)
+    return Status::OK;
+
+  const std::string segment_name = GetSegmentName(
+      options().segment_template, segment_info.start_timestamp,
+      segment_number_++, options().bandwidth);
+  File* file = File::Open(segment_name.c_str(), "w");
+  if (!file) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot open file for write " + segment_name);
+  }
+  const size_t segment_size = segment_buffer->Size();
+  Status status = segment_buffer->WriteToFile(file);
+  if (!file->Close())
+    LOG(WARNING) << "Failed to close the file properly: " << segment_name;
+  if (!status.ok())
+    return status;
+
+  if (muxer_listener()) {
+    muxer_listener()->OnNewSegment(segment_name, segment_info.start_timestamp,
+                                   segment_info.duration, segment_size);
+  }
+  return Status::OK;
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,45 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_PACKED_AUDIO_PACKED_AUDIO_WRITER_H_
+#define PACKAGER_MEDIA_FORMATS_PACKED_AUDIO_PACKED_AUDIO_WRITER_H_
+
+#include <memory>
+
+#include "packager/base/macros.h"
+#include "packager/media/base/muxer.h"
+#include "packager/media/formats/packed_audio/packed_audio_segmenter.h"
+
+namespace shaka {
+namespace media {
+
+/// Muxer for HLS packed audio, i.e. AAC in ADTS or AC-3 / E-AC-3 elementary
+/// streams with an ID3 timestamp at the start of every segment. It avoids the
+/// TS and PES overhead for audio-only renditions. Like TS, the segments are
+/// self-initializing, so only multi-segment output is supported.
+class PackedAudioWriter : public Muxer {
+ public:
+  explicit PackedAudioWriter(const MuxerOptions& muxer_options);
+  ~PackedAudioWriter() override;
+
+ private:
+  // Muxer implementation.
+  Status InitializeMuxer() override;
+  Status Finalize() override;
+  Status AddSample(size_t stream_id, const MediaSample& sample) override;
+  Status FinalizeSegment(size_t stream_id,
+                         const SegmentInfo& segment_info) override;
+
+  std::unique_ptr<PackedAudioSegmenter> segmenter_;
+  uint32_t segment_number_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(PackedAudioWriter);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_PACKED_AUDIO_PACKED_AUDIO_WRITER_H_
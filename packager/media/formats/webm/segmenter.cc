@@ -264,6 +264,8 @@ Status Segmenter::SetCluster(uint64_t start_webm_timecode,
   const uint64_t scale = segment_info_.timecode_scale();
   cluster_.reset(new mkvmuxer::Cluster(start_webm_timecode, position, scale));
   cluster_->Init(writer);
+  cluster_writer_ = writer;
+  cluster_header_written_ = false;
   return Status::OK;
 }
 
@@ -365,6 +367,32 @@ Status Segmenter::InitializeAudioTrack(const AudioStreamInfo& info,
 }
 
 Status Segmenter::WriteFrame(bool write_duration) {
+  const uint64_t timestamp_ns =
+      BmffTimestampToNs(prev_sample_->pts(), time_scale_);
+  // GetRelativeTimecode will return -1 if the relative timecode is too large
+  // to fit in the frame.
+  const int64_t relative_timecode = cluster_->GetRelativeTimecode(
+      NsToWebMTimecode(timestamp_ns, cluster_->timecode_scale()));
+  if (relative_timecode < 0) {
+    const double segment_duration =
+        static_cast<double>(timestamp_ns -
+                            WebMTimecodeToNs(cluster_->timecode(),
+                                             cluster_->timecode_scale())) /
+        kSecondsToNs;
+    LOG(ERROR) << "Error adding sample to segment: segment too large, "
+               << segment_duration
+               << " seconds. Please check your GOP size and segment duration.";
+    return Status(error::MUXER_FAILURE,
+                  "Error adding sample to segment: segment too large");
+  }
+
+  // Frames without duration or additional data are SimpleBlocks, which are
+  // written without copying the sample data.
+  if (!write_duration && prev_sample_->side_data_size() == 0 &&
+      cluster_header_written_) {
+    return WriteSimpleBlock(relative_timecode);
+  }
+
   // Create a frame manually so we can create non-SimpleBlock frames.  This
   // is required to allow the frame duration to be added.  If the duration
   // is not set, then a SimpleBlock will still be written.
@@ -380,8 +408,7 @@ Status Segmenter::WriteFrame(bool write_duration) {
         BmffTimestampToNs(prev_sample_->duration(), time_scale_));
   }
   frame.set_is_key(prev_sample_->is_key_frame());
-  frame.set_timestamp(
-      BmffTimestampToNs(prev_sample_->pts(), time_scale_));
+  frame.set_timestamp(timestamp_ns);
   frame.set_track_number(track_id_);
 
   if (prev_sample_->side_data_size() > 0) {
@@ -405,26 +432,11 @@ Status Segmenter::WriteFrame(bool write_duration) {
         BmffTimestampToNs(reference_frame_timestamp_, time_scale_));
   }
 
-  // GetRelativeTimecode will return -1 if the relative timecode is too large
-  // to fit in the frame.
-  if (cluster_->GetRelativeTimecode(NsToWebMTimecode(
-          frame.timestamp(), cluster_->timecode_scale())) < 0) {
-    const double segment_duration =
-        static_cast<double>(frame.timestamp() -
-                            WebMTimecodeToNs(cluster_->timecode(),
-                                             cluster_->timecode_scale())) /
-        kSecondsToNs;
-    LOG(ERROR) << "Error adding sample to segment: segment too large, "
-               << segment_duration
-               << " seconds. Please check your GOP size and segment duration.";
-    return Status(error::MUXER_FAILURE,
-                  "Error adding sample to segment: segment too large");
-  }
-
   if (!cluster_->AddFrame(&frame)) {
     return Status(error::MUXER_FAILURE,
                   "Error adding sample to segment: Cluster::AddFrame failed");
   }
+  cluster_header_written_ = true;
 
   // A reference frame is needed for non-keyframes.  Having a reference to the
   // previous block is good enough.
@@ -433,6 +445,30 @@ Status Segmenter::WriteFrame(bool write_duration) {
   return Status::OK;
 }
 
+Status Segmenter::WriteSimpleBlock(int64_t relative_timecode) {
+  // Same layout as libwebm WriteSimpleBlock: track number, relative timecode
+  // and flags, followed by the frame.
+  const uint64_t kBlockHeaderSize = 4;
+  const uint64_t block_size = kBlockHeaderSize + prev_sample_->data_size();
+  const uint64_t flags = prev_sample_->is_key_frame() ? 0x80 : 0;
+  if (mkvmuxer::WriteID(cluster_writer_, mkvmuxer::kMkvSimpleBlock) != 0 ||
+      mkvmuxer::WriteUInt(cluster_writer_, block_size) != 0 ||
+      mkvmuxer::WriteUInt(cluster_writer_, track_id_) != 0 ||
+      mkvmuxer::SerializeInt(cluster_writer_, relative_timecode, 2) != 0 ||
+      mkvmuxer::SerializeInt(cluster_writer_, flags, 1) != 0 ||
+      cluster_writer_->Write(prev_sample_->data(),
+                             prev_sample_->data_size()) != 0) {
+    return Status(error::MUXER_FAILURE,
+                  "Error adding sample to segment: failed to write block");
+  }
+  cluster_->AddPayloadSize(mkvmuxer::GetUIntSize(mkvmuxer::kMkvSimpleBlock) +
+                           mkvmuxer::GetCodedUIntSize(block_size) +
+                           block_size);
+
+  reference_frame_timestamp_ = prev_sample_->pts();
+  return Status::OK;
+}
+
 }  // namespace webm
 }  // namespace media
 }  // namespace shaka
@@ -113,6 +113,9 @@ class Segmenter {
 
   // Writes the previous frame to the file.
   Status WriteFrame(bool write_duration);
+  // Writes the previous frame as a SimpleBlock straight from the sample data,
+  // avoiding the copy into mkvmuxer::Frame.
+  Status WriteSimpleBlock(int64_t relative_timecode);
 
   // This is called when there needs to be a new (sub)segment.
   // In single-segment mode, a Cluster is a segment and there is no subsegment.
@@ -129,6 +132,10 @@ class Segmenter {
   const MuxerOptions& options_;
 
   std::unique_ptr<mkvmuxer::Cluster> cluster_;
+  // The writer of |cluster_|. The cluster writes its header with its first
+  // frame, so only the following frames can be written directly.
+  MkvWriter* cluster_writer_ = nullptr;
+  bool cluster_header_written_ = false;
   mkvmuxer::Cues cues_;
   SeekHead seek_head_;
   mkvmuxer::SegmentInfo segment_info_;
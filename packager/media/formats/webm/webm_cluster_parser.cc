@@ -75,7 +75,11 @@ WebMClusterParser::WebMClusterParser(
   }
 }
 
-WebMClusterParser::~WebMClusterParser() {}
+WebMClusterParser::~WebMClusterParser() {
+  const AllocationStats stats = buffer_pool_.stats();
+  VLOG(1) << "Sample buffers: " << stats.num_system_allocations
+          << " allocated, " << stats.num_recycled_allocations << " recycled.";
+}
 
 void WebMClusterParser::Reset() {
   last_block_timecode_ = -1;
@@ -160,9 +164,10 @@ bool WebMClusterParser::OnListEnd(int id) {
   }
 
   bool result = ParseBlock(
-      false, block_data_.get(), block_data_size_, block_additional_data_.get(),
-      block_additional_data_size_, block_duration_,
-      discard_padding_set_ ? discard_padding_ : 0, reference_block_set_);
+      false, block_data_, block_data_.get(), block_data_size_,
+      block_additional_data_.get(), block_additional_data_size_,
+      block_duration_, discard_padding_set_ ? discard_padding_ : 0,
+      reference_block_set_);
   block_data_.reset();
   block_data_size_ = -1;
   block_duration_ = -1;
@@ -197,6 +202,7 @@ bool WebMClusterParser::OnUInt(int id, int64_t val) {
 }
 
 bool WebMClusterParser::ParseBlock(bool is_simple_block,
+                                   const std::shared_ptr<uint8_t>& buf_owner,
                                    const uint8_t* buf,
                                    int size,
                                    const uint8_t* additional,
@@ -237,15 +243,15 @@ bool WebMClusterParser::ParseBlock(bool is_simple_block,
 
   const uint8_t* frame_data = buf + 4;
   int frame_size = size - (frame_data - buf);
-  return OnBlock(is_simple_block, track_num, timecode, duration, frame_data,
-                 frame_size, additional, additional_size, discard_padding,
-                 is_key_frame);
+  return OnBlock(is_simple_block, track_num, timecode, duration, buf_owner,
+                 frame_data, frame_size, additional, additional_size,
+                 discard_padding, is_key_frame);
 }
 
 bool WebMClusterParser::OnBinary(int id, const uint8_t* data, int size) {
   switch (id) {
     case kWebMIdSimpleBlock:
-      return ParseBlock(true, data, size, NULL, 0, -1, 0, false);
+      return ParseBlock(true, nullptr, data, size, NULL, 0, -1, 0, false);
 
     case kWebMIdBlock:
       if (block_data_) {
@@ -253,7 +259,9 @@ bool WebMClusterParser::OnBinary(int id, const uint8_t* data, int size) {
                       "supported.";
         return false;
       }
-      block_data_.reset(new uint8_t[size]);
+      // The BlockGroup may end in a later Parse() call, so the Block is
+      // copied out of the parse buffer. The samples reference this copy.
+      block_data_ = buffer_pool_.Allocate(size);
       memcpy(block_data_.get(), data, size);
       block_data_size_ = size;
       return true;
@@ -306,6 +314,7 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
                                 int track_num,
                                 int timecode,
                                 int block_duration,
+                                const std::shared_ptr<uint8_t>& data_owner,
                                 const uint8_t* data,
                                 int size,
                                 const uint8_t* additional,
@@ -384,16 +393,28 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
     buffer = MediaSample::CopyFrom(media_data, kDummyDataSize, additional,
                                    additional_size, is_key_frame);
 
+    // Samples reference the media data in |data_owner| if there is one, and
+    // copy it to a pooled buffer otherwise.
+    std::shared_ptr<uint8_t> shared_media_data;
+    if (data_owner) {
+      shared_media_data = std::shared_ptr<uint8_t>(
+          data_owner, const_cast<uint8_t*>(media_data));
+    }
+
     if (decrypt_config) {
       if (!decryptor_source_) {
-        buffer->SetData(media_data, media_data_size);
+        if (shared_media_data) {
+          buffer->TransferData(std::move(shared_media_data), media_data_size);
+        } else {
+          buffer->SetData(media_data, media_data_size, &buffer_pool_);
+        }
         // If the demuxer does not have the decryptor_source_, store
         // decrypt_config so that the demuxed sample can be decrypted later.
         buffer->set_decrypt_config(std::move(decrypt_config));
         buffer->set_is_encrypted(true);
       } else {
-        std::shared_ptr<uint8_t> decrypted_media_data(
-            new uint8_t[media_data_size], std::default_delete<uint8_t[]>());
+        std::shared_ptr<uint8_t> decrypted_media_data =
+            buffer_pool_.Allocate(media_data_size);
         if (!decryptor_source_->DecryptSampleBuffer(
                 decrypt_config.get(), media_data, media_data_size,
                 decrypted_media_data.get())) {
@@ -402,8 +423,10 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
         }
         buffer->TransferData(std::move(decrypted_media_data), media_data_size);
       }
+    } else if (shared_media_data) {
+      buffer->TransferData(std::move(shared_media_data), media_data_size);
     } else {
-      buffer->SetData(media_data, media_data_size);
+      buffer->SetData(media_data, media_data_size, &buffer_pool_);
     }
   } else {
     std::string id, settings, content;
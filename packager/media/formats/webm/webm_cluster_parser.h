@@ -12,6 +12,7 @@
 #include <string>
 
 #include "packager/base/compiler_specific.h"
+#include "packager/media/base/buffer_pool.h"
 #include "packager/media/base/decryptor_source.h"
 #include "packager/media/base/media_parser.h"
 #include "packager/media/base/media_sample.h"
@@ -160,7 +161,10 @@ class WebMClusterParser : public WebMParserClient {
   bool OnUInt(int id, int64_t val) override;
   bool OnBinary(int id, const uint8_t* data, int size) override;
 
+  // |buf_owner| owns |buf| if it is not null, in which case the samples
+  // reference |buf| instead of copying it.
   bool ParseBlock(bool is_simple_block,
+                  const std::shared_ptr<uint8_t>& buf_owner,
                   const uint8_t* buf,
                   int size,
                   const uint8_t* additional,
@@ -172,6 +176,7 @@ class WebMClusterParser : public WebMParserClient {
                int track_num,
                int timecode,
                int duration,
+               const std::shared_ptr<uint8_t>& data_owner,
                const uint8_t* data,
                int size,
                const uint8_t* additional,
@@ -207,7 +212,10 @@ class WebMClusterParser : public WebMParserClient {
   MediaParser::InitCB init_cb_;
 
   int64_t last_block_timecode_ = -1;
-  std::unique_ptr<uint8_t[]> block_data_;
+  // Sample payloads are allocated from the pool.
+  BufferPool buffer_pool_;
+  // The Block of a BlockGroup, which the samples reference.
+  std::shared_ptr<uint8_t> block_data_;
   int block_data_size_ = -1;
   int64_t block_duration_ = -1;
   int64_t block_add_id_ = -1;
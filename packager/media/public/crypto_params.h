@@ -64,6 +64,23 @@ struct WidevineEncryptionParams {
   WidevineSigner signer;
   /// Group identifier, if present licenses will belong to this group.
   std::vector<uint8_t> group_id;
+  /// Caches the keys fetched from the key server, in a cache shared by all
+  /// packager instances in the process. Keys for the same content, policy and
+  /// crypto period are only fetched once.
+  bool enable_key_cache = false;
+  /// Optional directory to persist the key cache to, so it survives restarts.
+  /// Only used if `enable_key_cache` is set.
+  std::string key_cache_directory;
+  /// 16 or 32 byte AES key used to encrypt the persisted key cache entries.
+  /// Required if `key_cache_directory` is set.
+  std::vector<uint8_t> key_cache_encryption_key;
+  /// With key rotation, keys are prefetched so the keys needed in the next
+  /// `key_prefetch_horizon_in_seconds`, plus the time to fetch them, are
+  /// available before they are needed. The number of crypto periods to
+  /// prefetch adapts to the rate keys are consumed and the key server latency.
+  /// 0, the default, sends key requests back to back, as fast as a key pool
+  /// of one key request worth of crypto periods takes the keys.
+  double key_prefetch_horizon_in_seconds = 0;
 };
 
 /// Playready encryption parameters.
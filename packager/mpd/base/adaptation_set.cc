@@ -237,7 +237,7 @@ void AdaptationSet::AddRole(Role role) {
 // can be passed to Representation to avoid setting redundant attributes. For
 // example, if AdaptationSet@width is set, then Representation@width is
 // redundant and should not be set.
-xml::scoped_xml_ptr<xmlNode> AdaptationSet::GetXml() {
+std::unique_ptr<xml::XmlNode> AdaptationSet::GetXml() {
   xml::AdaptationSetXmlNode adaptation_set;
 
   bool suppress_representation_width = false;
@@ -292,7 +292,7 @@ xml::scoped_xml_ptr<xmlNode> AdaptationSet::GetXml() {
 
   if (!adaptation_set.AddContentProtectionElements(
           content_protection_elements_)) {
-    return xml::scoped_xml_ptr<xmlNode>();
+    return nullptr;
   }
 
   if (!trick_play_reference_ids_.empty()) {
@@ -328,12 +328,14 @@ xml::scoped_xml_ptr<xmlNode> AdaptationSet::GetXml() {
       representation->SuppressOnce(Representation::kSuppressHeight);
     if (suppress_representation_frame_rate)
       representation->SuppressOnce(Representation::kSuppressFrameRate);
-    xml::scoped_xml_ptr<xmlNode> child(representation->GetXml());
-    if (!child || !adaptation_set.AddChild(std::move(child)))
-      return xml::scoped_xml_ptr<xmlNode>();
+    std::unique_ptr<xml::XmlNode> child(representation->GetXml());
+    if (!child)
+      return nullptr;
+    adaptation_set.AddChild(std::move(*child));
   }
 
-  return adaptation_set.PassScopedPtr();
+  return std::unique_ptr<xml::XmlNode>(
+      new xml::XmlNode(std::move(adaptation_set)));
 }
 
 void AdaptationSet::ForceSetSegmentAlignment(bool segment_alignment) {
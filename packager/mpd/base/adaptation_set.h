@@ -18,7 +18,6 @@
 #include <vector>
 
 #include "packager/base/atomic_sequence_num.h"
-#include "packager/mpd/base/xml/scoped_xml_ptr.h"
 
 namespace shaka {
 
@@ -105,9 +104,8 @@ class AdaptationSet {
 
   /// Makes a copy of AdaptationSet xml element with its child Representation
   /// and ContentProtection elements.
-  /// @return On success returns a non-NULL scoped_xml_ptr. Otherwise returns a
-  ///         NULL scoped_xml_ptr.
-  xml::scoped_xml_ptr<xmlNode> GetXml();
+  /// @return On success returns a non-NULL XmlNode. Otherwise returns NULL.
+  std::unique_ptr<xml::XmlNode> GetXml();
 
   /// Forces the (sub)segmentAlignment field to be set to @a segment_alignment.
   /// Use this if you are certain that the (sub)segments are alinged/unaligned
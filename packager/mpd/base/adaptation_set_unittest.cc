@@ -198,7 +198,7 @@ TEST_F(AdaptationSetTest, CheckContentProtectionRoleRepresentationOrder) {
       "container_type: 1\n";
   adaptation_set->AddRepresentation(ConvertToMediaInfo(kAudioMediaInfo));
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   const char kExpectedOutput[] =
       "<AdaptationSet id=\"1\" contentType=\"audio\">\n"
       "  <ContentProtection schemeIdUri=\"any_scheme\"/>\n"
@@ -241,7 +241,7 @@ TEST_F(AdaptationSetTest, AdapatationSetFrameRate) {
   ASSERT_TRUE(
       adaptation_set->AddRepresentation(ConvertToMediaInfo(kVideoMediaInfo2)));
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   EXPECT_THAT(adaptation_set_xml.get(), AttributeEqual("frameRate", "10/3"));
   EXPECT_THAT(adaptation_set_xml.get(), Not(AttributeSet("maxFrameRate")));
 }
@@ -274,7 +274,7 @@ TEST_F(AdaptationSetTest, AdapatationSetMaxFrameRate) {
   ASSERT_TRUE(adaptation_set->AddRepresentation(
       ConvertToMediaInfo(kVideoMediaInfo15fps)));
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   EXPECT_THAT(adaptation_set_xml.get(),
               AttributeEqual("maxFrameRate", "3000/100"));
   EXPECT_THAT(adaptation_set_xml.get(), Not(AttributeSet("frameRate")));
@@ -318,7 +318,7 @@ TEST_F(AdaptationSetTest,
 
   // First, make sure that maxFrameRate nor frameRate are set because
   // frame durations were not provided in the MediaInfo.
-  xml::scoped_xml_ptr<xmlNode> no_frame_rate(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> no_frame_rate(adaptation_set->GetXml());
   EXPECT_THAT(no_frame_rate.get(), Not(AttributeSet("maxFrameRate")));
   EXPECT_THAT(no_frame_rate.get(), Not(AttributeSet("frameRate")));
 
@@ -328,7 +328,7 @@ TEST_F(AdaptationSetTest,
   representation_480p->SetSampleDuration(kSameFrameDuration);
   representation_360p->SetSampleDuration(kSameFrameDuration);
 
-  xml::scoped_xml_ptr<xmlNode> same_frame_rate(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> same_frame_rate(adaptation_set->GetXml());
   EXPECT_THAT(same_frame_rate.get(), Not(AttributeSet("maxFrameRate")));
   EXPECT_THAT(same_frame_rate.get(), AttributeEqual("frameRate", "10/3"));
 
@@ -338,7 +338,7 @@ TEST_F(AdaptationSetTest,
                 "frame_duration_must_be_shorter_for_max_frame_rate");
   representation_480p->SetSampleDuration(k5FPSFrameDuration);
 
-  xml::scoped_xml_ptr<xmlNode> max_frame_rate(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> max_frame_rate(adaptation_set->GetXml());
   EXPECT_THAT(max_frame_rate.get(), AttributeEqual("maxFrameRate", "10/2"));
   EXPECT_THAT(max_frame_rate.get(), Not(AttributeSet("frameRate")));
 }
@@ -404,7 +404,7 @@ TEST_F(AdaptationSetTest, AdaptationSetParAllSame) {
   ASSERT_TRUE(
       adaptation_set->AddRepresentation(ConvertToMediaInfo(k360pVideoInfo)));
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   EXPECT_THAT(adaptation_set_xml.get(), AttributeEqual("par", "16:9"));
 }
 
@@ -441,7 +441,7 @@ TEST_F(AdaptationSetTest, AdaptationSetParDifferent) {
   ASSERT_TRUE(
       adaptation_set->AddRepresentation(ConvertToMediaInfo(k2by1VideoInfo)));
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   EXPECT_THAT(adaptation_set_xml.get(), Not(AttributeSet("par")));
 }
 
@@ -462,7 +462,7 @@ TEST_F(AdaptationSetTest, AdaptationSetParUnknown) {
   ASSERT_TRUE(adaptation_set->AddRepresentation(
       ConvertToMediaInfo(kUknownPixelWidthAndHeight)));
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   EXPECT_THAT(adaptation_set_xml.get(), Not(AttributeSet("par")));
 }
 
@@ -496,7 +496,7 @@ TEST_F(AdaptationSetTest, AdapatationSetMaxFrameRateIntegerDivisionEdgeCase) {
   ASSERT_TRUE(
       adaptation_set->AddRepresentation(ConvertToMediaInfo(kVideoMediaInfo2)));
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   EXPECT_THAT(adaptation_set_xml.get(), AttributeEqual("maxFrameRate", "11/3"));
   EXPECT_THAT(adaptation_set_xml.get(), Not(AttributeSet("frameRate")));
 }
@@ -558,7 +558,7 @@ TEST_F(AdaptationSetTest, BubbleUpAttributesToAdaptationSet) {
   auto adaptation_set = CreateAdaptationSet(kAnyAdaptationSetId, kNoLanguage);
   ASSERT_TRUE(adaptation_set->AddRepresentation(ConvertToMediaInfo(k1080p)));
 
-  xml::scoped_xml_ptr<xmlNode> all_attributes_on_adaptation_set(
+  std::unique_ptr<xml::XmlNode> all_attributes_on_adaptation_set(
       adaptation_set->GetXml());
   EXPECT_THAT(all_attributes_on_adaptation_set.get(),
               AttributeEqual("width", "1920"));
@@ -569,21 +569,21 @@ TEST_F(AdaptationSetTest, BubbleUpAttributesToAdaptationSet) {
 
   ASSERT_TRUE(
       adaptation_set->AddRepresentation(ConvertToMediaInfo(kDifferentWidth)));
-  xml::scoped_xml_ptr<xmlNode> width_not_set(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> width_not_set(adaptation_set->GetXml());
   EXPECT_THAT(width_not_set.get(), Not(AttributeSet("width")));
   EXPECT_THAT(width_not_set.get(), AttributeEqual("height", "1080"));
   EXPECT_THAT(width_not_set.get(), AttributeEqual("frameRate", "30/1"));
 
   ASSERT_TRUE(
       adaptation_set->AddRepresentation(ConvertToMediaInfo(kDifferentHeight)));
-  xml::scoped_xml_ptr<xmlNode> width_height_not_set(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> width_height_not_set(adaptation_set->GetXml());
   EXPECT_THAT(width_height_not_set.get(), Not(AttributeSet("width")));
   EXPECT_THAT(width_height_not_set.get(), Not(AttributeSet("height")));
   EXPECT_THAT(width_height_not_set.get(), AttributeEqual("frameRate", "30/1"));
 
   ASSERT_TRUE(adaptation_set->AddRepresentation(
       ConvertToMediaInfo(kDifferentFrameRate)));
-  xml::scoped_xml_ptr<xmlNode> no_common_attributes(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> no_common_attributes(adaptation_set->GetXml());
   EXPECT_THAT(no_common_attributes.get(), Not(AttributeSet("width")));
   EXPECT_THAT(no_common_attributes.get(), Not(AttributeSet("height")));
   EXPECT_THAT(no_common_attributes.get(), Not(AttributeSet("frameRate")));
@@ -671,12 +671,12 @@ TEST_F(OnDemandAdaptationSetTest, SubsegmentAlignment) {
       adaptation_set->AddRepresentation(ConvertToMediaInfo(k360pMediaInfo));
   representation_360p->AddNewSegment(kStartTime, kDuration, kAnySize);
 
-  xml::scoped_xml_ptr<xmlNode> aligned(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> aligned(adaptation_set->GetXml());
   EXPECT_THAT(aligned.get(), AttributeEqual("subsegmentAlignment", "true"));
 
   // Unknown because 480p has an extra subsegments.
   representation_480p->AddNewSegment(11, 20, kAnySize);
-  xml::scoped_xml_ptr<xmlNode> alignment_unknown(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> alignment_unknown(adaptation_set->GetXml());
   EXPECT_THAT(alignment_unknown.get(),
               Not(AttributeSet("subsegmentAlignment")));
 
@@ -684,7 +684,7 @@ TEST_F(OnDemandAdaptationSetTest, SubsegmentAlignment) {
   representation_360p->AddNewSegment(10, 1, kAnySize);
   representation_360p->AddNewSegment(11, 19, kAnySize);
 
-  xml::scoped_xml_ptr<xmlNode> unaligned(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> unaligned(adaptation_set->GetXml());
   EXPECT_THAT(unaligned.get(), Not(AttributeSet("subsegmentAlignment")));
 }
 
@@ -726,12 +726,12 @@ TEST_F(OnDemandAdaptationSetTest, ForceSetsubsegmentAlignment) {
   const uint64_t kAnySize = 19834u;
   representation_480p->AddNewSegment(kStartTime1, kDuration, kAnySize);
   representation_360p->AddNewSegment(kStartTime2, kDuration, kAnySize);
-  xml::scoped_xml_ptr<xmlNode> unaligned(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> unaligned(adaptation_set->GetXml());
   EXPECT_THAT(unaligned.get(), Not(AttributeSet("subsegmentAlignment")));
 
   // Then force set the segment alignment attribute to true.
   adaptation_set->ForceSetSegmentAlignment(true);
-  xml::scoped_xml_ptr<xmlNode> aligned(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> aligned(adaptation_set->GetXml());
   EXPECT_THAT(aligned.get(), AttributeEqual("subsegmentAlignment", "true"));
 }
 
@@ -773,7 +773,7 @@ TEST_F(LiveAdaptationSetTest, SegmentAlignment) {
   const uint64_t kAnySize = 19834u;
   representation_480p->AddNewSegment(kStartTime, kDuration, kAnySize);
   representation_360p->AddNewSegment(kStartTime, kDuration, kAnySize);
-  xml::scoped_xml_ptr<xmlNode> aligned(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> aligned(adaptation_set->GetXml());
   EXPECT_THAT(aligned.get(), AttributeEqual("segmentAlignment", "true"));
 
   // Add segments that make them not aligned.
@@ -781,7 +781,7 @@ TEST_F(LiveAdaptationSetTest, SegmentAlignment) {
   representation_360p->AddNewSegment(10, 1, kAnySize);
   representation_360p->AddNewSegment(11, 19, kAnySize);
 
-  xml::scoped_xml_ptr<xmlNode> unaligned(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> unaligned(adaptation_set->GetXml());
   EXPECT_THAT(unaligned.get(), Not(AttributeSet("segmentAlignment")));
 }
 
@@ -813,7 +813,7 @@ TEST_F(OnDemandAdaptationSetTest, AdapatationSetWidthAndHeight) {
   ASSERT_TRUE(
       adaptation_set->AddRepresentation(ConvertToMediaInfo(kVideoMediaInfo2)));
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   EXPECT_THAT(adaptation_set_xml.get(), AttributeEqual("width", "1280"));
   EXPECT_THAT(adaptation_set_xml.get(), AttributeEqual("height", "720"));
   EXPECT_THAT(adaptation_set_xml.get(), Not(AttributeSet("maxWidth")));
@@ -847,7 +847,7 @@ TEST_F(OnDemandAdaptationSetTest, AdaptationSetMaxWidthAndMaxHeight) {
   ASSERT_TRUE(adaptation_set->AddRepresentation(
       ConvertToMediaInfo(kVideoMediaInfo720p)));
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   EXPECT_THAT(adaptation_set_xml.get(), AttributeEqual("maxWidth", "1920"));
   EXPECT_THAT(adaptation_set_xml.get(), AttributeEqual("maxHeight", "1080"));
   EXPECT_THAT(adaptation_set_xml.get(), Not(AttributeSet("width")));
@@ -874,7 +874,7 @@ TEST_F(AdaptationSetTest, SetSampleDuration) {
       adaptation_set->AddRepresentation(video_media_info);
   EXPECT_TRUE(representation->Init());
 
-  xml::scoped_xml_ptr<xmlNode> adaptation_set_xml(adaptation_set->GetXml());
+  std::unique_ptr<xml::XmlNode> adaptation_set_xml(adaptation_set->GetXml());
   EXPECT_THAT(adaptation_set_xml.get(), Not(AttributeSet("frameRate")));
 
   representation->SetSampleDuration(2u);
@@ -10,10 +10,10 @@
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/stringprintf.h"
-#include "packager/base/synchronization/lock.h"
 #include "packager/base/time/default_clock.h"
 #include "packager/base/time/time.h"
 #include "packager/mpd/base/adaptation_set.h"
+#include "packager/mpd/base/mpd_patch.h"
 #include "packager/mpd/base/mpd_utils.h"
 #include "packager/mpd/base/period.h"
 #include "packager/mpd/base/representation.h"
@@ -82,31 +82,9 @@ std::string MakePathRelative(const std::string& media_path,
   return relative_path.NormalizePathSeparatorsTo('/').AsUTF8Unsafe();
 }
 
-// Spooky static initialization/cleanup of libxml.
-class LibXmlInitializer {
- public:
-  LibXmlInitializer() : initialized_(false) {
-    base::AutoLock lock(lock_);
-    if (!initialized_) {
-      xmlInitParser();
-      initialized_ = true;
-    }
-  }
-
-  ~LibXmlInitializer() {
-    base::AutoLock lock(lock_);
-    if (initialized_) {
-      xmlCleanupParser();
-      initialized_ = false;
-    }
-  }
-
- private:
-  base::Lock lock_;
-  bool initialized_;
-
-  DISALLOW_COPY_AND_ASSIGN(LibXmlInitializer);
-};
+// Same document layout as libxml2 xmlDocDumpFormatMemoryEnc() with UTF-8
+// encoding.
+const char kXmlDeclaration[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
 
 }  // namespace
 
@@ -136,47 +114,122 @@ Period* MpdBuilder::GetOrCreatePeriod(double start_time_in_seconds) {
 
 bool MpdBuilder::ToString(std::string* output) {
   DCHECK(output);
-  static LibXmlInitializer lib_xml_initializer;
 
-  xml::scoped_xml_ptr<xmlDoc> doc(GenerateMpd());
-  if (!doc)
+  std::unique_ptr<XmlNode> mpd(new XmlNode("MPD"));
+  if (!GenerateMpd(mpd.get()))
     return false;
 
-  static const int kNiceFormat = 1;
-  int doc_str_size = 0;
-  xmlChar* doc_str = nullptr;
-  xmlDocDumpFormatMemoryEnc(doc.get(), &doc_str, &doc_str_size, "UTF-8",
-                            kNiceFormat);
-  output->assign(doc_str, doc_str + doc_str_size);
-  xmlFree(doc_str);
+  output->clear();
+  output->reserve(last_mpd_size_);
+  output->append(kXmlDeclaration);
+  const std::string version = GetPackagerVersion();
+  if (!version.empty()) {
+    base::StringAppendF(output, "<!--Generated with %s version %s-->\n",
+                        GetPackagerProjectUrl().c_str(), version.c_str());
+  }
+  mpd->WriteTo(output);
+  output->push_back('\n');
+  last_mpd_size_ = output->size();
 
-  // Cleanup, free the doc.
-  doc.reset();
+  if (MpdPatchesEnabled())
+    RetainMpd(std::move(mpd));
   return true;
 }
 
-xmlDocPtr MpdBuilder::GenerateMpd() {
-  // Setup nodes.
-  static const char kXmlVersion[] = "1.0";
-  xml::scoped_xml_ptr<xmlDoc> doc(xmlNewDoc(BAD_CAST kXmlVersion));
-  XmlNode mpd("MPD");
+void MpdBuilder::GetMpdPatches(std::map<std::string, std::string>* patches,
+                               std::vector<std::string>* expired_patch_paths) {
+  DCHECK(patches);
+  DCHECK(expired_patch_paths);
+
+  patches->clear();
+  expired_patch_paths->swap(expired_patch_paths_);
+  expired_patch_paths_.clear();
+  if (published_mpds_.empty())
+    return;
+
+  const XmlNode& mpd = *published_mpds_.back().mpd;
+  for (auto it = published_mpds_.begin(); it->mpd.get() != &mpd; ++it) {
+    XmlNode patch("Patch");
+    // The previous patch, if any, remains valid if the MPD cannot be patched.
+    // It just brings clients to an older MPD.
+    if (!GenerateMpdPatch(*it->mpd, mpd, &patch))
+      continue;
+    std::string& output = (*patches)[it->patch_path];
+    output = kXmlDeclaration;
+    patch.WriteTo(&output);
+    output.push_back('\n');
+  }
+}
+
+bool MpdBuilder::MpdPatchesEnabled() const {
+  return mpd_options_.mpd_type == MpdType::kDynamic &&
+         Positive(mpd_options_.mpd_params.mpd_patch_retention) &&
+         !mpd_options_.mpd_params.mpd_output.empty();
+}
+
+std::string MpdBuilder::GetPatchPath(uint32_t index) const {
+  return FilePath::FromUTF8Unsafe(mpd_options_.mpd_params.mpd_output)
+             .RemoveExtension()
+             .AsUTF8Unsafe() +
+         base::StringPrintf("_%u.mpp", index);
+}
 
+void MpdBuilder::RetainMpd(std::unique_ptr<XmlNode> mpd) {
+  // Patches identify the MPDs by publishTime, which has a resolution of one
+  // second. An MPD published within the same second replaces the previous one.
+  std::string publish_time;
+  std::string last_publish_time;
+  if (!published_mpds_.empty() &&
+      mpd->GetAttribute("publishTime", &publish_time) &&
+      published_mpds_.back().mpd->GetAttribute("publishTime",
+                                               &last_publish_time) &&
+      publish_time == last_publish_time) {
+    expired_patch_paths_.push_back(published_mpds_.back().patch_path);
+    published_mpds_.pop_back();
+  }
+
+  const base::Time now = clock_->Now();
+  while (!published_mpds_.empty() &&
+         (now - published_mpds_.front().publish_time).InSecondsF() >
+             mpd_options_.mpd_params.mpd_patch_retention) {
+    expired_patch_paths_.push_back(published_mpds_.front().patch_path);
+    published_mpds_.pop_front();
+  }
+
+  PublishedMpd published_mpd;
+  published_mpd.publish_time = now;
+  published_mpd.patch_path = GetPatchPath(num_published_mpds_++);
+  published_mpd.mpd = std::move(mpd);
+  published_mpds_.push_back(std::move(published_mpd));
+}
+
+bool MpdBuilder::GenerateMpd(XmlNode* mpd) {
   // Add baseurls to MPD.
   for (const std::string& base_url : base_urls_) {
     XmlNode xml_base_url("BaseURL");
     xml_base_url.SetContent(base_url);
+    mpd->AddChild(std::move(xml_base_url));
+  }
 
-    if (!mpd.AddChild(xml_base_url.PassScopedPtr()))
-      return nullptr;
+  if (MpdPatchesEnabled()) {
+    XmlNode patch_location("PatchLocation");
+    patch_location.SetFloatingPointAttribute(
+        "ttl", mpd_options_.mpd_params.mpd_patch_retention);
+    patch_location.SetContent(
+        FilePath::FromUTF8Unsafe(GetPatchPath(num_published_mpds_))
+            .BaseName()
+            .AsUTF8Unsafe());
+    mpd->AddChild(std::move(patch_location));
   }
 
   for (const auto& period : periods_) {
-    xml::scoped_xml_ptr<xmlNode> period_node(period->GetXml());
-    if (!period_node || !mpd.AddChild(std::move(period_node)))
-      return nullptr;
+    std::unique_ptr<XmlNode> period_node(period->GetXml());
+    if (!period_node)
+      return false;
+    mpd->AddChild(std::move(*period_node));
   }
 
-  AddMpdNameSpaceInfo(&mpd);
+  AddMpdNameSpaceInfo(mpd);
 
   static const char kOnDemandProfile[] =
       "urn:mpeg:dash:profile:isoff-on-demand:2011";
@@ -184,10 +237,10 @@ xmlDocPtr MpdBuilder::GenerateMpd() {
       "urn:mpeg:dash:profile:isoff-live:2011";
   switch (mpd_options_.dash_profile) {
     case DashProfile::kOnDemand:
-      mpd.SetStringAttribute("profiles", kOnDemandProfile);
+      mpd->SetStringAttribute("profiles", kOnDemandProfile);
       break;
     case DashProfile::kLive:
-      mpd.SetStringAttribute("profiles", kLiveProfile);
+      mpd->SetStringAttribute("profiles", kLiveProfile);
       break;
     default:
       NOTREACHED() << "Unknown DASH profile: "
@@ -195,34 +248,20 @@ xmlDocPtr MpdBuilder::GenerateMpd() {
       break;
   }
 
-  AddCommonMpdInfo(&mpd);
+  AddCommonMpdInfo(mpd);
   switch (mpd_options_.mpd_type) {
     case MpdType::kStatic:
-      AddStaticMpdInfo(&mpd);
+      AddStaticMpdInfo(mpd);
       break;
     case MpdType::kDynamic:
-      AddDynamicMpdInfo(&mpd);
+      AddDynamicMpdInfo(mpd);
       break;
     default:
       NOTREACHED() << "Unknown MPD type: "
                    << static_cast<int>(mpd_options_.mpd_type);
       break;
   }
-
-  DCHECK(doc);
-  const std::string version = GetPackagerVersion();
-  if (!version.empty()) {
-    std::string version_string =
-        base::StringPrintf("Generated with %s version %s",
-                           GetPackagerProjectUrl().c_str(), version.c_str());
-    xml::scoped_xml_ptr<xmlNode> comment(
-        xmlNewDocComment(doc.get(), BAD_CAST version_string.c_str()));
-    xmlDocSetRootElement(doc.get(), comment.get());
-    xmlAddSibling(comment.release(), mpd.Release());
-  } else {
-    xmlDocSetRootElement(doc.get(), mpd.Release());
-  }
-  return doc.release();
+  return true;
 }
 
 void MpdBuilder::AddCommonMpdInfo(XmlNode* mpd_node) {
@@ -253,6 +292,14 @@ void MpdBuilder::AddDynamicMpdInfo(XmlNode* mpd_node) {
 
   static const char kDynamicMpdType[] = "dynamic";
   mpd_node->SetStringAttribute("type", kDynamicMpdType);
+  if (MpdPatchesEnabled()) {
+    // MPD@id is required for MPD patches.
+    mpd_node->SetStringAttribute(
+        "id", FilePath::FromUTF8Unsafe(mpd_options_.mpd_params.mpd_output)
+                  .BaseName()
+                  .RemoveExtension()
+                  .AsUTF8Unsafe());
+  }
 
   // No offset from NOW.
   mpd_node->SetStringAttribute("publishTime",
@@ -5,20 +5,19 @@
 // https://developers.google.com/open-source/licenses/bsd
 //
 /// All the methods that are virtual are virtual for mocking.
-/// NOTE: Inclusion of this module will cause xmlInitParser and xmlCleanupParser
-///       to be called at static initialization / deinitialization time.
 
 #ifndef MPD_BASE_MPD_BUILDER_H_
 #define MPD_BASE_MPD_BUILDER_H_
 
-#include <libxml/tree.h>
-
 #include <list>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "packager/base/atomic_sequence_num.h"
 #include "packager/base/time/clock.h"
+#include "packager/base/time/time.h"
 #include "packager/mpd/base/mpd_options.h"
 
 // TODO(rkuroiwa): For classes with |id_|, consider removing the field and let
@@ -54,12 +53,23 @@ class MpdBuilder {
   ///         return a new Period.
   virtual Period* GetOrCreatePeriod(double start_time_in_seconds);
 
-  /// Writes the MPD to the given string.
+  /// Writes the MPD to the given string. If MPD patches are enabled, see
+  /// MpdParams::mpd_patch_retention, the MPD is also retained to generate
+  /// patches against.
   /// @param[out] output is an output string where the MPD gets written.
   /// @return true on success, false otherwise.
   // TODO(kqyang): Handle file IO in this class as in HLS media_playlist?
   virtual bool ToString(std::string* output);
 
+  /// Generates the MPD Patch documents which bring the MPDs published within
+  /// the patch retention up to date with the MPD last written by ToString().
+  /// Does nothing if MPD patches are not enabled.
+  /// @param[out] patches maps the patch file paths to the patch documents.
+  /// @param[out] expired_patch_paths is set to the paths of the patches no
+  ///             longer referenced by a retained MPD, which can be removed.
+  void GetMpdPatches(std::map<std::string, std::string>* patches,
+                     std::vector<std::string>* expired_patch_paths);
+
   /// Adjusts the fields of MediaInfo so that paths are relative to the
   /// specified MPD path.
   /// @param mpd_path is the file path of the MPD file.
@@ -84,10 +94,24 @@ class MpdBuilder {
   template <DashProfile profile>
   friend class MpdBuilderTest;
 
-  // Returns the document pointer to the MPD. This must be freed by the caller
-  // using appropriate xmlDocPtr freeing function.
-  // On failure, this returns NULL.
-  xmlDocPtr GenerateMpd();
+  // An MPD retained to generate patches against.
+  struct PublishedMpd {
+    base::Time publish_time;
+    std::string patch_path;
+    std::unique_ptr<xml::XmlNode> mpd;
+  };
+
+  bool MpdPatchesEnabled() const;
+
+  // Returns the path of the patch for the |index|th published MPD.
+  std::string GetPatchPath(uint32_t index) const;
+
+  // Retains |mpd| and releases the MPDs published before the patch retention.
+  void RetainMpd(std::unique_ptr<xml::XmlNode> mpd);
+
+  // Populates |mpd_node| with the MPD element and its descendants.
+  // Returns true on success, false otherwise.
+  bool GenerateMpd(xml::XmlNode* mpd_node);
 
   // Set MPD attributes common to all profiles. Uses non-zero |mpd_options_| to
   // set attributes for the MPD.
@@ -115,6 +139,14 @@ class MpdBuilder {
 
   std::list<std::string> base_urls_;
   std::string availability_start_time_;
+  // Size of the last generated MPD, used to size the output up front.
+  size_t last_mpd_size_ = 0;
+
+  // MPDs published within the patch retention, oldest first. The last one is
+  // the MPD last written by ToString().
+  std::list<PublishedMpd> published_mpds_;
+  uint32_t num_published_mpds_ = 0;
+  std::vector<std::string> expired_patch_paths_;
 
   base::AtomicSequenceNumber period_counter_;
   base::AtomicSequenceNumber adaptation_set_counter_;
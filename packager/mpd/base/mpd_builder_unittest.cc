@@ -218,6 +218,57 @@ TEST_F(LiveMpdBuilderTest, StaticCheckMpdAttributes) {
   ASSERT_EQ(kExpectedOutput, mpd_doc);
 }
 
+TEST_F(LiveMpdBuilderTest, MpdPatches) {
+  static const char kExpectedPatch[] =
+      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<Patch xmlns=\"urn:mpeg:dash:schema:mpd-patch:2020\""
+      " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+      " xsi:schemaLocation=\"urn:mpeg:dash:schema:mpd-patch:2020"
+      " DASH-MPD-PATCH.xsd\" mpdId=\"live\""
+      " originalPublishTime=\"2016-01-11T15:10:24Z\""
+      " publishTime=\"2016-01-11T15:10:29Z\">\n"
+      "  <replace sel=\"/MPD/@publishTime\">2016-01-11T15:10:29Z</replace>\n"
+      "  <replace sel=\"/MPD/PatchLocation\">\n"
+      "    <PatchLocation ttl=\"30\">live_1.mpp</PatchLocation>\n"
+      "  </replace>\n"
+      "</Patch>\n";
+  static const char kPatchLocation[] =
+      "<PatchLocation ttl=\"30\">live_0.mpp</PatchLocation>";
+
+  mutable_mpd_options()->mpd_params.mpd_output = "foo/live.mpd";
+  mutable_mpd_options()->mpd_params.mpd_patch_retention = 30;
+  std::string mpd_doc;
+  ASSERT_TRUE(mpd_.ToString(&mpd_doc));
+  EXPECT_NE(std::string::npos, mpd_doc.find(" id=\"live\""));
+  EXPECT_NE(std::string::npos, mpd_doc.find(kPatchLocation));
+
+  std::map<std::string, std::string> patches;
+  std::vector<std::string> expired_patch_paths;
+  mpd_.GetMpdPatches(&patches, &expired_patch_paths);
+  EXPECT_TRUE(patches.empty());
+  EXPECT_TRUE(expired_patch_paths.empty());
+
+  base::Time::Exploded test_time = {2016, 1, 1, 11, 15, 10, 29, 0};
+  mpd_.InjectClockForTesting(std::unique_ptr<base::Clock>(
+      new TestClock(base::Time::FromUTCExploded(test_time))));
+  ASSERT_TRUE(mpd_.ToString(&mpd_doc));
+  mpd_.GetMpdPatches(&patches, &expired_patch_paths);
+  ASSERT_EQ(1u, patches.size());
+  EXPECT_EQ("foo/live_0.mpp", patches.begin()->first);
+  EXPECT_EQ(kExpectedPatch, patches.begin()->second);
+  EXPECT_TRUE(expired_patch_paths.empty());
+
+  // The first MPD is no longer retained 31 seconds after it was published.
+  test_time.second = 55;
+  mpd_.InjectClockForTesting(std::unique_ptr<base::Clock>(
+      new TestClock(base::Time::FromUTCExploded(test_time))));
+  ASSERT_TRUE(mpd_.ToString(&mpd_doc));
+  mpd_.GetMpdPatches(&patches, &expired_patch_paths);
+  ASSERT_EQ(1u, patches.size());
+  EXPECT_EQ("foo/live_1.mpp", patches.begin()->first);
+  EXPECT_EQ(std::vector<std::string>{"foo/live_0.mpp"}, expired_patch_paths);
+}
+
 namespace {
 const char kMediaFile[] = "foo/bar/media.mp4";
 const char kMediaFileBase[] = "media.mp4";
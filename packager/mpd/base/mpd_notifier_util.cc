@@ -26,6 +26,20 @@ bool WriteMpdToFile(const std::string& output_path, MpdBuilder* mpd_builder) {
     LOG(ERROR) << "Failed to write mpd to: " << output_path;
     return false;
   }
+
+  std::map<std::string, std::string> patches;
+  std::vector<std::string> expired_patch_paths;
+  mpd_builder->GetMpdPatches(&patches, &expired_patch_paths);
+  for (const auto& patch : patches) {
+    if (!File::WriteFileAtomically(patch.first.c_str(), patch.second)) {
+      LOG(ERROR) << "Failed to write mpd patch to: " << patch.first;
+      return false;
+    }
+  }
+  for (const std::string& patch_path : expired_patch_paths) {
+    // The patch does not exist if no MPD was published after its MPD.
+    File::Delete(patch_path.c_str());
+  }
   return true;
 }
 
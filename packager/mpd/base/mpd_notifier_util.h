@@ -26,7 +26,7 @@ enum ContentType {
   kContentTypeText
 };
 
-/// Outputs MPD to @a output_path.
+/// Outputs MPD to @a output_path, along with the MPD patches if enabled.
 /// @param output_path is the path to the MPD output location.
 /// @param mpd_builder is the MPD builder instance.
 bool WriteMpdToFile(const std::string& output_path, MpdBuilder* mpd_builder);
@@ -0,0 +1,294 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/mpd/base/mpd_patch.h"
+
+#include <algorithm>
+
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/mpd/base/xml/xml_node.h"
+
+namespace shaka {
+
+using xml::XmlNode;
+
+namespace {
+
+const char kPatchNamespace[] = "urn:mpeg:dash:schema:mpd-patch:2020";
+const char kXmlNamespaceXsi[] = "http://www.w3.org/2001/XMLSchema-instance";
+const char kPatchSchemaLocation[] =
+    "urn:mpeg:dash:schema:mpd-patch:2020 DASH-MPD-PATCH.xsd";
+const char kSegmentTimeline[] = "SegmentTimeline";
+
+bool SegmentsEqual(const SegmentInfo& a, const SegmentInfo& b) {
+  return a.start_time == b.start_time && a.duration == b.duration &&
+         a.repeat == b.repeat;
+}
+
+bool ElementsEqual(const XmlNode& a, const XmlNode& b) {
+  if (a.name() != b.name() || a.attributes() != b.attributes() ||
+      a.content() != b.content() ||
+      a.children().size() != b.children().size() ||
+      a.segments().size() != b.segments().size() ||
+      !std::equal(a.segments().begin(), a.segments().end(),
+                  b.segments().begin(), SegmentsEqual)) {
+    return false;
+  }
+  for (size_t i = 0; i < a.children().size(); ++i) {
+    if (!ElementsEqual(a.children()[i], b.children()[i]))
+      return false;
+  }
+  return true;
+}
+
+// Returns the 1-based position of |siblings|[|index|] among the siblings with
+// the same name, and the number of such siblings in |count| if not null.
+size_t GetPosition(const std::vector<XmlNode>& siblings,
+                   size_t index,
+                   size_t* count) {
+  const std::string& name = siblings[index].name();
+  size_t position = 0;
+  size_t num_siblings = 0;
+  for (size_t i = 0; i < siblings.size(); ++i) {
+    if (siblings[i].name() != name)
+      continue;
+    ++num_siblings;
+    if (i <= index)
+      ++position;
+  }
+  if (count)
+    *count = num_siblings;
+  return position;
+}
+
+// Returns the key used to match up |siblings|[|index|] with an element of the
+// other MPD.
+std::string GetKey(const std::vector<XmlNode>& siblings, size_t index) {
+  const XmlNode& element = siblings[index];
+  std::string id;
+  if (element.GetAttribute("id", &id))
+    return element.name() + "[@id='" + id + "']";
+  return base::StringPrintf("%s[%zu]", element.name().c_str(),
+                            GetPosition(siblings, index, nullptr));
+}
+
+// Returns the path selector step of |siblings|[|index|]. Same as the key,
+// except that the position is omitted for an element with a unique name.
+std::string GetSelectorStep(const std::vector<XmlNode>& siblings,
+                            size_t index) {
+  const XmlNode& element = siblings[index];
+  std::string id;
+  if (element.GetAttribute("id", &id))
+    return element.name() + "[@id='" + id + "']";
+  size_t count = 0;
+  const size_t position = GetPosition(siblings, index, &count);
+  if (count == 1)
+    return element.name();
+  return base::StringPrintf("%s[%zu]", element.name().c_str(), position);
+}
+
+// Returns true if |updated| can be reached from |original| with operations on
+// its attributes and descendants, i.e. without replacing it as a whole.
+bool CanDiff(const XmlNode& original, const XmlNode& updated) {
+  if (original.name() != updated.name() ||
+      original.content() != updated.content()) {
+    return false;
+  }
+  if (original.name() == kSegmentTimeline)
+    return true;
+  // The children of |original| have to be matched by the first children of
+  // |updated|. The remaining ones get appended.
+  const std::vector<XmlNode>& original_children = original.children();
+  const std::vector<XmlNode>& updated_children = updated.children();
+  if (original_children.size() > updated_children.size())
+    return false;
+  for (size_t i = 0; i < original_children.size(); ++i) {
+    if (GetKey(original_children, i) != GetKey(updated_children, i))
+      return false;
+  }
+  return true;
+}
+
+XmlNode MakeOperation(const char* operation, const std::string& selector) {
+  XmlNode node(operation);
+  node.SetStringAttribute("sel", selector);
+  return node;
+}
+
+// Attribute values are literal text, while '&' starts a reference in content.
+void SetAttributeValueContent(const std::string& value, XmlNode* operation) {
+  std::string content;
+  base::ReplaceChars(value, "&", "&amp;", &content);
+  operation->SetContent(content);
+}
+
+void AddRemoveOperation(const std::string& selector, XmlNode* patch) {
+  patch->AddChild(MakeOperation("remove", selector));
+}
+
+void AddReplaceOperation(const std::string& selector,
+                         const XmlNode& element,
+                         XmlNode* patch) {
+  XmlNode replace = MakeOperation("replace", selector);
+  replace.AddChild(element.Clone());
+  patch->AddChild(std::move(replace));
+}
+
+// Appends |elements| from |begin| on as the last children of the element
+// selected by |selector|.
+void AddAddOperation(const std::string& selector,
+                     const std::vector<XmlNode>& elements,
+                     size_t begin,
+                     XmlNode* patch) {
+  if (begin >= elements.size())
+    return;
+  XmlNode add = MakeOperation("add", selector);
+  for (size_t i = begin; i < elements.size(); ++i)
+    add.AddChild(elements[i].Clone());
+  patch->AddChild(std::move(add));
+}
+
+void DiffAttributes(const XmlNode& original,
+                    const XmlNode& updated,
+                    const std::string& path,
+                    XmlNode* patch) {
+  for (const auto& attribute : updated.attributes()) {
+    std::string original_value;
+    if (!original.GetAttribute(attribute.first, &original_value)) {
+      XmlNode add = MakeOperation("add", path);
+      add.SetStringAttribute("type", "@" + attribute.first);
+      SetAttributeValueContent(attribute.second, &add);
+      patch->AddChild(std::move(add));
+    } else if (original_value != attribute.second) {
+      XmlNode replace = MakeOperation("replace", path + "/@" + attribute.first);
+      SetAttributeValueContent(attribute.second, &replace);
+      patch->AddChild(std::move(replace));
+    }
+  }
+  for (const auto& attribute : original.attributes()) {
+    std::string updated_value;
+    if (!updated.GetAttribute(attribute.first, &updated_value))
+      AddRemoveOperation(path + "/@" + attribute.first, patch);
+  }
+}
+
+XmlNode MakeSegmentElement(const SegmentInfo& segment) {
+  XmlNode s_element("S");
+  s_element.SetIntegerAttribute("t", segment.start_time);
+  s_element.SetIntegerAttribute("d", segment.duration);
+  if (segment.repeat > 0)
+    s_element.SetIntegerAttribute("r", segment.repeat);
+  return s_element;
+}
+
+uint64_t GetSegmentEndTime(const SegmentInfo& segment) {
+  return segment.start_time + segment.duration * (segment.repeat + 1);
+}
+
+// Live SegmentTimelines only change at both ends: segments expire at the front
+// and new segments are appended, possibly by increasing the repeat count of the
+// last S element.
+void DiffSegmentTimeline(const XmlNode& original,
+                         const XmlNode& updated,
+                         const std::string& path,
+                         XmlNode* patch) {
+  const std::vector<SegmentInfo>& original_segments = original.segments();
+  const std::vector<SegmentInfo>& updated_segments = updated.segments();
+
+  size_t num_expired = original_segments.size();
+  if (!updated_segments.empty()) {
+    const uint64_t start_time = updated_segments.front().start_time;
+    num_expired = 0;
+    while (num_expired < original_segments.size() &&
+           GetSegmentEndTime(original_segments[num_expired]) <= start_time) {
+      ++num_expired;
+    }
+  }
+  for (size_t i = 0; i < num_expired; ++i)
+    AddRemoveOperation(path + "/S[1]", patch);
+
+  const size_t num_remaining = original_segments.size() - num_expired;
+  const size_t num_common = std::min(num_remaining, updated_segments.size());
+  for (size_t i = 0; i < num_common; ++i) {
+    if (!SegmentsEqual(original_segments[num_expired + i],
+                       updated_segments[i])) {
+      AddReplaceOperation(base::StringPrintf("%s/S[%zu]", path.c_str(), i + 1),
+                          MakeSegmentElement(updated_segments[i]), patch);
+    }
+  }
+  for (size_t i = num_common; i < num_remaining; ++i) {
+    AddRemoveOperation(
+        base::StringPrintf("%s/S[%zu]", path.c_str(), num_common + 1), patch);
+  }
+  if (num_common < updated_segments.size()) {
+    XmlNode add = MakeOperation("add", path);
+    for (size_t i = num_common; i < updated_segments.size(); ++i)
+      add.AddChild(MakeSegmentElement(updated_segments[i]));
+    patch->AddChild(std::move(add));
+  }
+}
+
+// |original| and |updated| must satisfy CanDiff().
+void DiffElement(const XmlNode& original,
+                 const XmlNode& updated,
+                 const std::string& path,
+                 XmlNode* patch) {
+  DiffAttributes(original, updated, path, patch);
+  if (original.name() == kSegmentTimeline) {
+    DiffSegmentTimeline(original, updated, path, patch);
+    return;
+  }
+
+  const std::vector<XmlNode>& original_children = original.children();
+  const std::vector<XmlNode>& updated_children = updated.children();
+  for (size_t i = 0; i < original_children.size(); ++i) {
+    const std::string child_path =
+        path + "/" + GetSelectorStep(original_children, i);
+    if (CanDiff(original_children[i], updated_children[i])) {
+      DiffElement(original_children[i], updated_children[i], child_path,
+                  patch);
+    } else {
+      AddReplaceOperation(child_path, updated_children[i], patch);
+    }
+  }
+  AddAddOperation(path, updated_children, original_children.size(), patch);
+}
+
+}  // namespace
+
+bool GenerateMpdPatch(const XmlNode& original_mpd,
+                      const XmlNode& mpd,
+                      XmlNode* patch) {
+  DCHECK(patch);
+
+  std::string mpd_id;
+  std::string original_publish_time;
+  std::string publish_time;
+  if (!mpd.GetAttribute("id", &mpd_id) ||
+      !original_mpd.GetAttribute("publishTime", &original_publish_time) ||
+      !mpd.GetAttribute("publishTime", &publish_time)) {
+    LOG(ERROR) << "MPD id and publishTime are required for MPD patches.";
+    return false;
+  }
+  if (!CanDiff(original_mpd, mpd)) {
+    VLOG(1) << "Unable to patch MPD published at " << original_publish_time
+            << " to MPD published at " << publish_time << ".";
+    return false;
+  }
+
+  patch->SetStringAttribute("xmlns", kPatchNamespace);
+  patch->SetStringAttribute("xmlns:xsi", kXmlNamespaceXsi);
+  patch->SetStringAttribute("xsi:schemaLocation", kPatchSchemaLocation);
+  patch->SetStringAttribute("mpdId", mpd_id);
+  patch->SetStringAttribute("originalPublishTime", original_publish_time);
+  patch->SetStringAttribute("publishTime", publish_time);
+  DiffElement(original_mpd, mpd, "/" + mpd.name(), patch);
+  return true;
+}
+
+}  // namespace shaka
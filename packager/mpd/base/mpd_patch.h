@@ -0,0 +1,36 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MPD_BASE_MPD_PATCH_H_
+#define MPD_BASE_MPD_PATCH_H_
+
+namespace shaka {
+
+namespace xml {
+class XmlNode;
+}  // namespace xml
+
+/// Generates an MPD Patch document (ISO/IEC 23009-1 5th edition, MPD Patch),
+/// which turns @a original_mpd into @a mpd. Changed attributes and text
+/// elements are replaced, new elements are appended and expired S elements are
+/// removed from the front of the SegmentTimelines. Elements are selected by
+/// their id attribute when present, by position otherwise. Elements whose
+/// children cannot be matched up are replaced as a whole.
+/// @param original_mpd is the MPD element the patch applies to.
+/// @param mpd is the MPD element resulting from applying the patch. Both MPD
+///        elements must have id and publishTime attributes.
+/// @param[out] patch is populated with the Patch element. It should be an
+///        empty element named "Patch".
+/// @return true on success. false if the MPDs cannot be patched, e.g. if the
+///         MPD element itself would have to be replaced, in which case clients
+///         need to fetch the full MPD.
+bool GenerateMpdPatch(const xml::XmlNode& original_mpd,
+                      const xml::XmlNode& mpd,
+                      xml::XmlNode* patch);
+
+}  // namespace shaka
+
+#endif  // MPD_BASE_MPD_PATCH_H_
@@ -0,0 +1,176 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/mpd/base/mpd_patch.h"
+#include "packager/mpd/base/xml/xml_node.h"
+
+namespace shaka {
+
+using xml::XmlNode;
+
+namespace {
+
+const char kPatchStart[] =
+    "<Patch xmlns=\"urn:mpeg:dash:schema:mpd-patch:2020\""
+    " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+    " xsi:schemaLocation=\"urn:mpeg:dash:schema:mpd-patch:2020"
+    " DASH-MPD-PATCH.xsd\" mpdId=\"live\""
+    " originalPublishTime=\"2017-01-01T00:00:00Z\""
+    " publishTime=\"2017-01-01T00:00:05Z\">\n"
+    "  <replace sel=\"/MPD/@publishTime\">2017-01-01T00:00:05Z</replace>\n";
+const char kTimelinePath[] =
+    "/MPD/Period[@id='0']/AdaptationSet[@id='0']/Representation[@id='0']"
+    "/SegmentTemplate/SegmentTimeline";
+
+XmlNode MakeMpd(const std::string& publish_time) {
+  XmlNode mpd("MPD");
+  mpd.SetStringAttribute("id", "live");
+  mpd.SetStringAttribute("type", "dynamic");
+  mpd.SetStringAttribute("publishTime", publish_time);
+  return mpd;
+}
+
+XmlNode MakePeriod(uint32_t id, const std::vector<SegmentInfo>& segments) {
+  XmlNode segment_timeline("SegmentTimeline");
+  segment_timeline.SetSegments(segments);
+  XmlNode segment_template("SegmentTemplate");
+  segment_template.SetStringAttribute("media", "segment-$Number$.m4s");
+  segment_template.AddChild(std::move(segment_timeline));
+  XmlNode representation("Representation");
+  representation.SetId(0);
+  representation.AddChild(std::move(segment_template));
+  XmlNode adaptation_set("AdaptationSet");
+  adaptation_set.SetId(0);
+  adaptation_set.AddChild(std::move(representation));
+  XmlNode period("Period");
+  period.SetId(id);
+  period.AddChild(std::move(adaptation_set));
+  return period;
+}
+
+std::string GeneratePatch(const XmlNode& original_mpd, const XmlNode& mpd) {
+  XmlNode patch("Patch");
+  EXPECT_TRUE(GenerateMpdPatch(original_mpd, mpd, &patch));
+  return patch.ToString();
+}
+
+}  // namespace
+
+TEST(MpdPatchTest, SegmentTimeline) {
+  XmlNode original_mpd = MakeMpd("2017-01-01T00:00:00Z");
+  original_mpd.AddChild(MakePeriod(0, {{0, 10, 2}, {30, 5, 0}}));
+  XmlNode mpd = MakeMpd("2017-01-01T00:00:05Z");
+  mpd.AddChild(MakePeriod(0, {{10, 10, 1}, {30, 5, 2}, {45, 7, 0}}));
+
+  const std::string expected_patch =
+      std::string(kPatchStart) + "  <replace sel=\"" + kTimelinePath +
+      "/S[1]\">\n"
+      "    <S t=\"10\" d=\"10\" r=\"1\"/>\n"
+      "  </replace>\n"
+      "  <replace sel=\"" + kTimelinePath + "/S[2]\">\n"
+      "    <S t=\"30\" d=\"5\" r=\"2\"/>\n"
+      "  </replace>\n"
+      "  <add sel=\"" + kTimelinePath + "\">\n"
+      "    <S t=\"45\" d=\"7\"/>\n"
+      "  </add>\n"
+      "</Patch>";
+  EXPECT_EQ(expected_patch, GeneratePatch(original_mpd, mpd));
+}
+
+TEST(MpdPatchTest, ExpiredSegments) {
+  XmlNode original_mpd = MakeMpd("2017-01-01T00:00:00Z");
+  original_mpd.AddChild(
+      MakePeriod(0, {{0, 10, 0}, {10, 5, 0}, {15, 10, 0}, {25, 5, 0}}));
+  XmlNode mpd = MakeMpd("2017-01-01T00:00:05Z");
+  mpd.AddChild(MakePeriod(0, {{15, 10, 0}, {25, 5, 0}, {30, 10, 0}}));
+
+  const std::string expected_patch =
+      std::string(kPatchStart) + "  <remove sel=\"" + kTimelinePath +
+      "/S[1]\"/>\n"
+      "  <remove sel=\"" + kTimelinePath + "/S[1]\"/>\n"
+      "  <add sel=\"" + kTimelinePath + "\">\n"
+      "    <S t=\"30\" d=\"10\"/>\n"
+      "  </add>\n"
+      "</Patch>";
+  EXPECT_EQ(expected_patch, GeneratePatch(original_mpd, mpd));
+}
+
+TEST(MpdPatchTest, AttributesAndElements) {
+  XmlNode original_mpd = MakeMpd("2017-01-01T00:00:00Z");
+  XmlNode base_url("BaseURL");
+  base_url.SetContent("http://a/");
+  original_mpd.AddChild(std::move(base_url));
+  original_mpd.SetStringAttribute("minimumUpdatePeriod", "PT5S");
+  original_mpd.AddChild(MakePeriod(0, {{0, 10, 0}}));
+
+  XmlNode mpd = MakeMpd("2017-01-01T00:00:05Z");
+  base_url = XmlNode("BaseURL");
+  base_url.SetContent("http://b/");
+  mpd.AddChild(std::move(base_url));
+  mpd.SetStringAttribute("suggestedPresentationDelay", "PT2S");
+  mpd.AddChild(MakePeriod(0, {{0, 10, 0}}));
+  mpd.AddChild(MakePeriod(1, {{10, 10, 0}}));
+
+  const std::string expected_patch =
+      std::string(kPatchStart) +
+      "  <add sel=\"/MPD\" type=\"@suggestedPresentationDelay\">PT2S</add>\n"
+      "  <remove sel=\"/MPD/@minimumUpdatePeriod\"/>\n"
+      "  <replace sel=\"/MPD/BaseURL\">\n"
+      "    <BaseURL>http://b/</BaseURL>\n"
+      "  </replace>\n"
+      "  <add sel=\"/MPD\">\n"
+      "    <Period id=\"1\">\n"
+      "      <AdaptationSet id=\"0\">\n"
+      "        <Representation id=\"0\">\n"
+      "          <SegmentTemplate media=\"segment-$Number$.m4s\">\n"
+      "            <SegmentTimeline>\n"
+      "              <S t=\"10\" d=\"10\"/>\n"
+      "            </SegmentTimeline>\n"
+      "          </SegmentTemplate>\n"
+      "        </Representation>\n"
+      "      </AdaptationSet>\n"
+      "    </Period>\n"
+      "  </add>\n"
+      "</Patch>";
+  EXPECT_EQ(expected_patch, GeneratePatch(original_mpd, mpd));
+}
+
+TEST(MpdPatchTest, AttributeValueWithAmpersand) {
+  XmlNode original_mpd = MakeMpd("2017-01-01T00:00:00Z");
+  original_mpd.SetStringAttribute("profiles", "a");
+  XmlNode mpd = MakeMpd("2017-01-01T00:00:05Z");
+  mpd.SetStringAttribute("profiles", "a&b");
+
+  const std::string expected_patch =
+      std::string(kPatchStart) +
+      "  <replace sel=\"/MPD/@profiles\">a&amp;b</replace>\n"
+      "</Patch>";
+  EXPECT_EQ(expected_patch, GeneratePatch(original_mpd, mpd));
+}
+
+TEST(MpdPatchTest, MissingMpdId) {
+  XmlNode original_mpd("MPD");
+  original_mpd.SetStringAttribute("publishTime", "2017-01-01T00:00:00Z");
+  XmlNode mpd("MPD");
+  mpd.SetStringAttribute("publishTime", "2017-01-01T00:00:05Z");
+  XmlNode patch("Patch");
+  EXPECT_FALSE(GenerateMpdPatch(original_mpd, mpd, &patch));
+}
+
+TEST(MpdPatchTest, RemovedPeriod) {
+  XmlNode original_mpd = MakeMpd("2017-01-01T00:00:00Z");
+  original_mpd.AddChild(MakePeriod(0, {{0, 10, 0}}));
+  original_mpd.AddChild(MakePeriod(1, {{10, 10, 0}}));
+  XmlNode mpd = MakeMpd("2017-01-01T00:00:05Z");
+  mpd.AddChild(MakePeriod(1, {{10, 10, 0}}));
+  // The MPD element would have to be replaced as a whole.
+  XmlNode patch("Patch");
+  EXPECT_FALSE(GenerateMpdPatch(original_mpd, mpd, &patch));
+}
+
+}  // namespace shaka
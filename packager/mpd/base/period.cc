@@ -93,16 +93,17 @@ AdaptationSet* Period::GetOrCreateAdaptationSet(
   return adaptation_sets_.back().get();
 }
 
-xml::scoped_xml_ptr<xmlNode> Period::GetXml() {
+std::unique_ptr<xml::XmlNode> Period::GetXml() {
   xml::XmlNode period("Period");
 
   // Required for 'dynamic' MPDs.
   period.SetId(id_);
   // Iterate thru AdaptationSets and add them to one big Period element.
   for (const auto& adaptation_set : adaptation_sets_) {
-    xml::scoped_xml_ptr<xmlNode> child(adaptation_set->GetXml());
-    if (!child || !period.AddChild(std::move(child)))
+    std::unique_ptr<xml::XmlNode> child(adaptation_set->GetXml());
+    if (!child)
       return nullptr;
+    period.AddChild(std::move(*child));
   }
 
   if (mpd_options_.mpd_type == MpdType::kDynamic ||
@@ -110,7 +111,7 @@ xml::scoped_xml_ptr<xmlNode> Period::GetXml() {
     period.SetStringAttribute("start",
                               SecondsToXmlDuration(start_time_in_seconds_));
   }
-  return period.PassScopedPtr();
+  return std::unique_ptr<xml::XmlNode>(new xml::XmlNode(std::move(period)));
 }
 
 const std::list<AdaptationSet*> Period::GetAdaptationSets() const {
@@ -15,7 +15,6 @@
 #include "packager/base/atomic_sequence_num.h"
 #include "packager/mpd/base/adaptation_set.h"
 #include "packager/mpd/base/media_info.pb.h"
-#include "packager/mpd/base/xml/scoped_xml_ptr.h"
 
 namespace shaka {
 
@@ -46,9 +45,8 @@ class Period {
       bool content_protection_in_adaptation_set);
 
   /// Generates <Period> xml element with its child AdaptationSet elements.
-  /// @return On success returns a non-NULL scoped_xml_ptr. Otherwise returns a
-  ///         NULL scoped_xml_ptr.
-  xml::scoped_xml_ptr<xmlNode> GetXml();
+  /// @return On success returns a non-NULL XmlNode. Otherwise returns NULL.
+  std::unique_ptr<xml::XmlNode> GetXml();
 
   /// @return The list of AdaptationSets in this Period.
   const std::list<AdaptationSet*> GetAdaptationSets() const;
@@ -73,33 +73,6 @@ uint32_t GetTimeScale(const MediaInfo& media_info) {
   return 1;
 }
 
-uint64_t LastSegmentStartTime(const SegmentInfo& segment_info) {
-  return segment_info.start_time + segment_info.duration * segment_info.repeat;
-}
-
-// This is equal to |segment_info| end time
-uint64_t LastSegmentEndTime(const SegmentInfo& segment_info) {
-  return segment_info.start_time +
-         segment_info.duration * (segment_info.repeat + 1);
-}
-
-uint64_t LatestSegmentStartTime(const std::list<SegmentInfo>& segments) {
-  DCHECK(!segments.empty());
-  const SegmentInfo& latest_segment = segments.back();
-  return LastSegmentStartTime(latest_segment);
-}
-
-// Given |timeshift_limit|, finds out the number of segments that are no longer
-// valid and should be removed from |segment_info|.
-int SearchTimedOutRepeatIndex(uint64_t timeshift_limit,
-                              const SegmentInfo& segment_info) {
-  DCHECK_LE(timeshift_limit, LastSegmentEndTime(segment_info));
-  if (timeshift_limit < segment_info.start_time)
-    return 0;
-
-  return (timeshift_limit - segment_info.start_time) / segment_info.duration;
-}
-
 }  // namespace
 
 Representation::Representation(
@@ -126,9 +99,8 @@ Representation::Representation(
   mime_type_ = representation.mime_type_;
   codecs_ = representation.codecs_;
 
-  start_number_ = representation.start_number_;
-  for (const SegmentInfo& segment_info : representation.segment_infos_)
-    start_number_ += segment_info.repeat + 1;
+  start_number_ = representation.start_number_ +
+                  representation.segment_timeline_.num_segments();
 
   media_info_.set_presentation_time_offset(presentation_time_offset);
 }
@@ -200,17 +172,17 @@ void Representation::AddNewSegment(uint64_t start_time,
   if (state_change_listener_)
     state_change_listener_->OnNewSegmentForRepresentation(start_time, duration);
   if (IsContiguous(start_time, duration, size)) {
-    ++segment_infos_.back().repeat;
+    segment_timeline_.ExtendBack();
   } else {
     SegmentInfo s = {start_time, duration, /* Not repeat. */ 0};
-    segment_infos_.push_back(s);
+    segment_timeline_.PushBack(s);
   }
 
   bandwidth_estimator_.AddBlock(
       size, static_cast<double>(duration) / media_info_.reference_time_scale());
 
   SlideWindow();
-  DCHECK_GE(segment_infos_.size(), 1u);
+  DCHECK(!segment_timeline_.empty());
 }
 
 void Representation::SetSampleDuration(uint32_t sample_duration) {
@@ -233,10 +205,10 @@ const MediaInfo& Representation::GetMediaInfo() const {
 // AddVideoInfo() (possibly adds FramePacking elements), AddAudioInfo() (Adds
 // AudioChannelConfig elements), AddContentProtectionElements*(), and
 // AddVODOnlyInfo() (Adds segment info).
-xml::scoped_xml_ptr<xmlNode> Representation::GetXml() {
+std::unique_ptr<xml::XmlNode> Representation::GetXml() {
   if (!HasRequiredMediaInfoFields()) {
     LOG(ERROR) << "MediaInfo missing required fields.";
-    return xml::scoped_xml_ptr<xmlNode>();
+    return nullptr;
   }
 
   const uint64_t bandwidth = media_info_.has_bandwidth()
@@ -263,37 +235,38 @@ xml::scoped_xml_ptr<xmlNode> Representation::GetXml() {
           !(output_suppression_flags_ & kSuppressHeight),
           !(output_suppression_flags_ & kSuppressFrameRate))) {
     LOG(ERROR) << "Failed to add video info to Representation XML.";
-    return xml::scoped_xml_ptr<xmlNode>();
+    return nullptr;
   }
 
   if (has_audio_info &&
       !representation.AddAudioInfo(media_info_.audio_info())) {
     LOG(ERROR) << "Failed to add audio info to Representation XML.";
-    return xml::scoped_xml_ptr<xmlNode>();
+    return nullptr;
   }
 
   if (!representation.AddContentProtectionElements(
           content_protection_elements_)) {
-    return xml::scoped_xml_ptr<xmlNode>();
+    return nullptr;
   }
 
   if (HasVODOnlyFields(media_info_) &&
       !representation.AddVODOnlyInfo(media_info_)) {
     LOG(ERROR) << "Failed to add VOD segment info.";
-    return xml::scoped_xml_ptr<xmlNode>();
+    return nullptr;
   }
 
   if (HasLiveOnlyFields(media_info_) &&
-      !representation.AddLiveOnlyInfo(media_info_, segment_infos_,
+      !representation.AddLiveOnlyInfo(media_info_, segment_timeline_,
                                       start_number_)) {
     LOG(ERROR) << "Failed to add Live info.";
-    return xml::scoped_xml_ptr<xmlNode>();
+    return nullptr;
   }
   // TODO(rkuroiwa): It is likely that all representations have the exact same
   // SegmentTemplate. Optimize and propagate the tag up to AdaptationSet level.
 
   output_suppression_flags_ = 0;
-  return representation.PassScopedPtr();
+  return std::unique_ptr<xml::XmlNode>(
+      new xml::XmlNode(std::move(representation)));
 }
 
 void Representation::SuppressOnce(SuppressFlag flag) {
@@ -303,11 +276,12 @@ void Representation::SuppressOnce(SuppressFlag flag) {
 bool Representation::GetEarliestTimestamp(double* timestamp_seconds) const {
   DCHECK(timestamp_seconds);
 
-  if (segment_infos_.empty())
+  if (segment_timeline_.empty())
     return false;
 
-  *timestamp_seconds = static_cast<double>(segment_infos_.begin()->start_time) /
-                       GetTimeScale(media_info_);
+  *timestamp_seconds =
+      static_cast<double>(segment_timeline_.earliest_segment_start_time()) /
+      GetTimeScale(media_info_);
   return true;
 }
 
@@ -342,15 +316,15 @@ bool Representation::HasRequiredMediaInfoFields() {
 bool Representation::IsContiguous(uint64_t start_time,
                                   uint64_t duration,
                                   uint64_t size) const {
-  if (segment_infos_.empty())
+  if (segment_timeline_.empty())
     return false;
 
   // Contiguous segment.
-  const SegmentInfo& previous = segment_infos_.back();
+  const SegmentInfo& previous = segment_timeline_.back();
   const uint64_t previous_segment_end_time =
       previous.start_time + previous.duration * (previous.repeat + 1);
   if (previous_segment_end_time == start_time &&
-      segment_infos_.back().duration == duration) {
+      previous.duration == duration) {
     return true;
   }
 
@@ -391,7 +365,7 @@ bool Representation::IsContiguous(uint64_t start_time,
 }
 
 void Representation::SlideWindow() {
-  DCHECK(!segment_infos_.empty());
+  DCHECK(!segment_timeline_.empty());
   if (mpd_options_.mpd_params.time_shift_buffer_depth <= 0.0 ||
       mpd_options_.mpd_type == MpdType::kStatic)
     return;
@@ -404,42 +378,15 @@ void Representation::SlideWindow() {
 
   // The start time of the latest segment is considered the current_play_time,
   // and this should guarantee that the latest segment will stay in the list.
-  const uint64_t current_play_time = LatestSegmentStartTime(segment_infos_);
+  const uint64_t current_play_time =
+      segment_timeline_.latest_segment_start_time();
   if (current_play_time <= time_shift_buffer_depth)
     return;
 
   const uint64_t timeshift_limit = current_play_time - time_shift_buffer_depth;
-
-  // First remove all the SegmentInfos that are completely out of range, by
-  // looking at the very last segment's end time.
-  std::list<SegmentInfo>::iterator first = segment_infos_.begin();
-  std::list<SegmentInfo>::iterator last = first;
-  size_t num_segments_removed = 0;
-  for (; last != segment_infos_.end(); ++last) {
-    const uint64_t last_segment_end_time = LastSegmentEndTime(*last);
-    if (timeshift_limit < last_segment_end_time)
-      break;
-    num_segments_removed += last->repeat + 1;
-  }
-  segment_infos_.erase(first, last);
-  start_number_ += num_segments_removed;
-
-  // Now some segment in the first SegmentInfo should be left in the list.
-  SegmentInfo* first_segment_info = &segment_infos_.front();
-  DCHECK_LE(timeshift_limit, LastSegmentEndTime(*first_segment_info));
-
-  // Identify which segments should still be in the SegmentInfo.
-  const int repeat_index =
-      SearchTimedOutRepeatIndex(timeshift_limit, *first_segment_info);
-  CHECK_GE(repeat_index, 0);
-  if (repeat_index == 0)
-    return;
-
-  first_segment_info->start_time = first_segment_info->start_time +
-                                   first_segment_info->duration * repeat_index;
-
-  first_segment_info->repeat = first_segment_info->repeat - repeat_index;
-  start_number_ += repeat_index;
+  start_number_ += static_cast<uint32_t>(
+      segment_timeline_.RemoveSegmentsEndingBy(timeshift_limit));
+  DCHECK(!segment_timeline_.empty());
 }
 
 std::string Representation::GetVideoMimeType() const {
@@ -11,8 +11,7 @@
 
 #include "packager/mpd/base/bandwidth_estimator.h"
 #include "packager/mpd/base/media_info.pb.h"
-#include "packager/mpd/base/segment_info.h"
-#include "packager/mpd/base/xml/scoped_xml_ptr.h"
+#include "packager/mpd/base/segment_timeline.h"
 
 #include <stdint.h>
 
@@ -116,7 +115,7 @@ class Representation {
   virtual const MediaInfo& GetMediaInfo() const;
 
   /// @return Copy of <Representation>.
-  xml::scoped_xml_ptr<xmlNode> GetXml();
+  std::unique_ptr<xml::XmlNode> GetXml();
 
   /// By calling this methods, the next time GetXml() is
   /// called, the corresponding attributes will not be set.
@@ -180,8 +179,8 @@ class Representation {
                     uint64_t duration,
                     uint64_t size) const;
 
-  // Remove elements from |segment_infos_| for dynamic live profile. Increments
-  // |start_number_| by the number of segments removed.
+  // Remove segments from |segment_timeline_| for dynamic live profile.
+  // Increments |start_number_| by the number of segments removed.
   void SlideWindow();
 
   // Note: Because 'mimeType' is a required field for a valid MPD, these return
@@ -195,7 +194,7 @@ class Representation {
   MediaInfo media_info_;
   std::list<ContentProtectionElement> content_protection_elements_;
   // TODO(kqyang): Address sliding window issue with multiple periods.
-  std::list<SegmentInfo> segment_infos_;
+  SegmentTimeline segment_timeline_;
 
   const uint32_t id_;
   std::string mime_type_;
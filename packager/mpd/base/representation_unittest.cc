@@ -350,19 +350,19 @@ TEST_F(RepresentationTest, SuppressRepresentationAttributes) {
       ConvertToMediaInfo(kTestMediaInfo), kAnyRepresentationId, NoListener());
 
   representation->SuppressOnce(Representation::kSuppressWidth);
-  xml::scoped_xml_ptr<xmlNode> no_width(representation->GetXml());
+  std::unique_ptr<xml::XmlNode> no_width(representation->GetXml());
   EXPECT_THAT(no_width.get(), Not(AttributeSet("width")));
   EXPECT_THAT(no_width.get(), AttributeEqual("height", "480"));
   EXPECT_THAT(no_width.get(), AttributeEqual("frameRate", "10/10"));
 
   representation->SuppressOnce(Representation::kSuppressHeight);
-  xml::scoped_xml_ptr<xmlNode> no_height(representation->GetXml());
+  std::unique_ptr<xml::XmlNode> no_height(representation->GetXml());
   EXPECT_THAT(no_height.get(), Not(AttributeSet("height")));
   EXPECT_THAT(no_height.get(), AttributeEqual("width", "720"));
   EXPECT_THAT(no_height.get(), AttributeEqual("frameRate", "10/10"));
 
   representation->SuppressOnce(Representation::kSuppressFrameRate);
-  xml::scoped_xml_ptr<xmlNode> no_frame_rate(representation->GetXml());
+  std::unique_ptr<xml::XmlNode> no_frame_rate(representation->GetXml());
   EXPECT_THAT(no_frame_rate.get(), Not(AttributeSet("frameRate")));
   EXPECT_THAT(no_frame_rate.get(), AttributeEqual("width", "720"));
   EXPECT_THAT(no_frame_rate.get(), AttributeEqual("height", "480"));
@@ -0,0 +1,111 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/mpd/base/segment_timeline.h"
+
+#include <algorithm>
+
+#include "packager/base/logging.h"
+
+namespace shaka {
+
+namespace {
+const size_t kMinCapacity = 16;
+}  // namespace
+
+SegmentTimeline::SegmentTimeline() {}
+SegmentTimeline::~SegmentTimeline() {}
+
+const SegmentInfo& SegmentTimeline::operator[](size_t index) const {
+  DCHECK_LT(index, num_entries_);
+  size_t position = first_entry_ + index;
+  if (position >= entries_.size())
+    position -= entries_.size();
+  return entries_[position];
+}
+
+const SegmentInfo& SegmentTimeline::front() const {
+  DCHECK(!empty());
+  return (*this)[0];
+}
+
+const SegmentInfo& SegmentTimeline::back() const {
+  DCHECK(!empty());
+  return (*this)[num_entries_ - 1];
+}
+
+SegmentInfo& SegmentTimeline::At(size_t index) {
+  return const_cast<SegmentInfo&>(
+      static_cast<const SegmentTimeline&>(*this)[index]);
+}
+
+void SegmentTimeline::PushBack(const SegmentInfo& segment_info) {
+  DCHECK_GT(segment_info.duration, 0u);
+  if (num_entries_ == entries_.size()) {
+    // Grow the ring buffer, unwrapping the entries.
+    std::vector<SegmentInfo> entries;
+    entries.reserve(std::max(kMinCapacity, 2 * entries_.size()));
+    for (size_t i = 0; i < num_entries_; ++i)
+      entries.push_back((*this)[i]);
+    entries.resize(entries.capacity());
+    entries_.swap(entries);
+    first_entry_ = 0;
+  }
+  ++num_entries_;
+  At(num_entries_ - 1) = segment_info;
+
+  num_segments_ += segment_info.repeat + 1;
+}
+
+void SegmentTimeline::ExtendBack() {
+  DCHECK(!empty());
+  SegmentInfo& last_entry = At(num_entries_ - 1);
+  ++last_entry.repeat;
+  ++num_segments_;
+}
+
+uint64_t SegmentTimeline::RemoveSegmentsEndingBy(uint64_t time) {
+  uint64_t num_segments_removed = 0;
+  while (!empty()) {
+    SegmentInfo& first_entry = At(0);
+    const uint64_t end_time =
+        first_entry.start_time +
+        first_entry.duration * (first_entry.repeat + 1);
+    if (end_time <= time) {
+      num_segments_removed += first_entry.repeat + 1;
+      PopFront();
+      continue;
+    }
+
+    // Some segments of the first entry remain.
+    if (time >= first_entry.start_time) {
+      const uint64_t num_timed_out_segments =
+          (time - first_entry.start_time) / first_entry.duration;
+      first_entry.start_time += first_entry.duration * num_timed_out_segments;
+      first_entry.repeat -= num_timed_out_segments;
+      num_segments_ -= num_timed_out_segments;
+      num_segments_removed += num_timed_out_segments;
+    }
+    break;
+  }
+  return num_segments_removed;
+}
+
+uint64_t SegmentTimeline::latest_segment_start_time() const {
+  const SegmentInfo& last_entry = back();
+  return last_entry.start_time + last_entry.duration * last_entry.repeat;
+}
+
+void SegmentTimeline::PopFront() {
+  DCHECK(!empty());
+  const SegmentInfo& first_entry = (*this)[0];
+  num_segments_ -= first_entry.repeat + 1;
+  --num_entries_;
+  if (++first_entry_ == entries_.size())
+    first_entry_ = 0;
+}
+
+}  // namespace shaka
@@ -0,0 +1,69 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MPD_BASE_SEGMENT_TIMELINE_H_
+#define MPD_BASE_SEGMENT_TIMELINE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "packager/mpd/base/segment_info.h"
+
+namespace shaka {
+
+/// Run-length encoded list of the segments of a live Representation, i.e. the
+/// content of its SegmentTimeline element, ordered by start time.
+/// The entries are kept in a contiguous ring buffer, so appending and trimming
+/// are constant time and do not allocate once the buffer has grown to the size
+/// of the time shift buffer. The segment count is maintained incrementally.
+class SegmentTimeline {
+ public:
+  SegmentTimeline();
+  ~SegmentTimeline();
+
+  /// @return true if there are no segments.
+  bool empty() const { return num_entries_ == 0; }
+  /// @return The number of entries, i.e. S elements.
+  size_t size() const { return num_entries_; }
+  /// @param index is the index of the entry, from the earliest.
+  /// @return The entry.
+  const SegmentInfo& operator[](size_t index) const;
+  const SegmentInfo& front() const;
+  const SegmentInfo& back() const;
+
+  /// Append an entry. Its segments must start after the existing segments.
+  void PushBack(const SegmentInfo& segment_info);
+  /// Append a segment with the same duration right after the last segment,
+  /// by incrementing the repeat count of the last entry.
+  void ExtendBack();
+  /// Remove the segments which end at or before @a time.
+  /// @return The number of segments removed.
+  uint64_t RemoveSegmentsEndingBy(uint64_t time);
+
+  /// @return The number of segments, counting repeated segments.
+  uint64_t num_segments() const { return num_segments_; }
+  /// @return The start time of the first segment.
+  uint64_t earliest_segment_start_time() const { return front().start_time; }
+  /// @return The start time of the last segment.
+  uint64_t latest_segment_start_time() const;
+
+ private:
+  SegmentInfo& At(size_t index);
+  void PopFront();
+
+  // Ring buffer of |num_entries_| entries starting at |first_entry_|.
+  std::vector<SegmentInfo> entries_;
+  size_t first_entry_ = 0;
+  size_t num_entries_ = 0;
+
+  uint64_t num_segments_ = 0;
+};
+
+}  // namespace shaka
+
+#endif  // MPD_BASE_SEGMENT_TIMELINE_H_
@@ -0,0 +1,85 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/mpd/base/segment_timeline.h"
+
+namespace shaka {
+
+namespace {
+SegmentInfo MakeSegmentInfo(uint64_t start_time,
+                            uint64_t duration,
+                            uint64_t repeat) {
+  SegmentInfo segment_info = {start_time, duration, repeat};
+  return segment_info;
+}
+}  // namespace
+
+TEST(SegmentTimelineTest, Empty) {
+  SegmentTimeline timeline;
+  EXPECT_TRUE(timeline.empty());
+  EXPECT_EQ(0u, timeline.num_segments());
+  EXPECT_EQ(0u, timeline.RemoveSegmentsEndingBy(100));
+}
+
+TEST(SegmentTimelineTest, PushBackAndExtendBack) {
+  SegmentTimeline timeline;
+  timeline.PushBack(MakeSegmentInfo(0, 10, 0));
+  timeline.ExtendBack();
+  timeline.ExtendBack();
+  timeline.PushBack(MakeSegmentInfo(30, 5, 1));
+
+  ASSERT_EQ(2u, timeline.size());
+  EXPECT_EQ(0u, timeline[0].start_time);
+  EXPECT_EQ(2u, timeline[0].repeat);
+  EXPECT_EQ(30u, timeline.back().start_time);
+  EXPECT_EQ(5u, timeline.num_segments());
+  EXPECT_EQ(0u, timeline.earliest_segment_start_time());
+  EXPECT_EQ(35u, timeline.latest_segment_start_time());
+}
+
+TEST(SegmentTimelineTest, RemoveSegmentsEndingBy) {
+  SegmentTimeline timeline;
+  timeline.PushBack(MakeSegmentInfo(0, 10, 1));
+  timeline.PushBack(MakeSegmentInfo(20, 5, 3));
+
+  // Removes the first entry and a segment of the second one.
+  EXPECT_EQ(3u, timeline.RemoveSegmentsEndingBy(27));
+  ASSERT_EQ(1u, timeline.size());
+  EXPECT_EQ(25u, timeline.earliest_segment_start_time());
+  EXPECT_EQ(2u, timeline.front().repeat);
+  EXPECT_EQ(3u, timeline.num_segments());
+
+  // Nothing ends by 29.
+  EXPECT_EQ(0u, timeline.RemoveSegmentsEndingBy(29));
+  EXPECT_EQ(3u, timeline.num_segments());
+}
+
+TEST(SegmentTimelineTest, RingBufferWrapsAround) {
+  SegmentTimeline timeline;
+  const uint64_t kWindowSize = 20;
+  uint64_t num_removed = 0;
+  // Alternating durations so that every segment gets its own entry.
+  uint64_t start_time = 0;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    const uint64_t duration = i % 2 == 0 ? 2 : 3;
+    timeline.PushBack(MakeSegmentInfo(start_time, duration, 0));
+    start_time += duration;
+    if (timeline.size() > kWindowSize)
+      num_removed += timeline.RemoveSegmentsEndingBy(timeline[1].start_time);
+  }
+  EXPECT_EQ(kWindowSize, timeline.size());
+  EXPECT_EQ(1000u, num_removed + timeline.num_segments());
+  EXPECT_EQ(start_time,
+            timeline.latest_segment_start_time() + timeline.back().duration);
+  for (size_t i = 1; i < timeline.size(); ++i) {
+    EXPECT_EQ(timeline[i - 1].start_time + timeline[i - 1].duration,
+              timeline[i].start_time);
+  }
+}
+
+}  // namespace shaka
@@ -6,6 +6,7 @@
 
 #include "packager/mpd/base/xml/xml_node.h"
 
+#include <algorithm>
 #include <limits>
 #include <set>
 
@@ -15,7 +16,7 @@
 #include "packager/base/sys_byteorder.h"
 #include "packager/mpd/base/media_info.pb.h"
 #include "packager/mpd/base/mpd_utils.h"
-#include "packager/mpd/base/segment_info.h"
+#include "packager/mpd/base/segment_timeline.h"
 
 namespace shaka {
 
@@ -31,47 +32,198 @@ std::string RangeToString(const Range& range) {
          base::Uint64ToString(range.end());
 }
 
-bool PopulateSegmentTimeline(const std::list<SegmentInfo>& segment_infos,
+void PopulateSegmentTimeline(const SegmentTimeline& segment_infos,
                              XmlNode* segment_timeline) {
-  for (std::list<SegmentInfo>::const_iterator it = segment_infos.begin();
-       it != segment_infos.end();
-       ++it) {
-    XmlNode s_element("S");
-    s_element.SetIntegerAttribute("t", it->start_time);
-    s_element.SetIntegerAttribute("d", it->duration);
-    if (it->repeat > 0)
-      s_element.SetIntegerAttribute("r", it->repeat);
-
-    CHECK(segment_timeline->AddChild(s_element.PassScopedPtr()));
+  std::vector<SegmentInfo> segments;
+  segments.reserve(segment_infos.size());
+  for (size_t i = 0; i < segment_infos.size(); ++i)
+    segments.push_back(segment_infos[i]);
+  segment_timeline->SetSegments(std::move(segments));
+}
+
+// Same escaping as libxml2 applies to attribute values when saving a document.
+void AppendEscapedAttribute(const std::string& value, std::string* output) {
+  for (char c : value) {
+    switch (c) {
+      case '<':
+        output->append("&lt;");
+        break;
+      case '>':
+        output->append("&gt;");
+        break;
+      case '&':
+        output->append("&amp;");
+        break;
+      case '"':
+        output->append("&quot;");
+        break;
+      case '\n':
+        output->append("&#10;");
+        break;
+      case '\r':
+        output->append("&#13;");
+        break;
+      case '\t':
+        output->append("&#9;");
+        break;
+      default:
+        output->push_back(c);
+        break;
+    }
   }
+}
 
-  return true;
+// Same escaping as libxml2 applies to text content when saving a document.
+void AppendEscapedContent(const std::string& content, std::string* output) {
+  for (char c : content) {
+    switch (c) {
+      case '<':
+        output->append("&lt;");
+        break;
+      case '>':
+        output->append("&gt;");
+        break;
+      case '&':
+        output->append("&amp;");
+        break;
+      case '\r':
+        output->append("&#13;");
+        break;
+      default:
+        output->push_back(c);
+        break;
+    }
+  }
+}
+
+// libxml2 stops indenting beyond this depth.
+const int kMaxIndentLevel = 30;
+
+void AppendIndent(int level, std::string* output) {
+  output->append(2 * std::min(level, kMaxIndentLevel), ' ');
+}
+
+// Appends the UTF-8 encoding of |code_point|, or nothing if it is out of
+// range, like libxml2 xmlCopyCharMultiByte().
+void AppendUtf8(uint32_t code_point, std::string* output) {
+  if (code_point < 0x80) {
+    output->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    output->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    output->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    output->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    output->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    output->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x110000) {
+    output->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    output->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    output->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    output->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+// Parses the character reference at |content|[|*pos|], just after "&#", and
+// advances |*pos| past it. Returns 0 if the reference is invalid, in which
+// case |*pos| is left at the invalid character.
+uint32_t ParseCharacterReference(const std::string& content, size_t* pos) {
+  const bool hex = *pos < content.size() && content[*pos] == 'x';
+  if (hex)
+    ++*pos;
+  uint32_t value = 0;
+  while (*pos < content.size() && content[*pos] != ';') {
+    const char c = content[*pos];
+    uint32_t digit = 0;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (hex && c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (hex && c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      // The invalid character is kept as text.
+      return 0;
+    }
+    // Anything beyond the last code point is dropped anyway.
+    value = std::min<uint32_t>(value * (hex ? 16 : 10) + digit, 0x110000);
+    ++*pos;
+  }
+  if (*pos == content.size())
+    return 0;
+  ++*pos;
+  return value;
+}
+
+// Converts |content| the way libxml2 xmlStringGetNodeList() does, and escapes
+// it as it is written out. Character references and predefined entities are
+// replaced, other entity references are kept, and an unterminated reference
+// drops the text after the last kept entity reference.
+std::string ConvertContent(const std::string& content) {
+  std::string output;
+  std::string text;
+  size_t pos = 0;
+  while (pos < content.size()) {
+    const size_t ampersand = content.find('&', pos);
+    text.append(content, pos, ampersand - pos);
+    if (ampersand == std::string::npos)
+      break;
+    pos = ampersand + 1;
+    if (pos < content.size() && content[pos] == '#') {
+      ++pos;
+      const uint32_t code_point = ParseCharacterReference(content, &pos);
+      if (code_point != 0)
+        AppendUtf8(code_point, &text);
+      continue;
+    }
+
+    const size_t semicolon = content.find(';', pos);
+    if (semicolon == std::string::npos)
+      return output;
+    const std::string name = content.substr(pos, semicolon - pos);
+    pos = semicolon + 1;
+    if (name.empty())
+      continue;
+    if (name == "lt") {
+      text.push_back('<');
+    } else if (name == "gt") {
+      text.push_back('>');
+    } else if (name == "amp") {
+      text.push_back('&');
+    } else if (name == "apos") {
+      text.push_back('\'');
+    } else if (name == "quot") {
+      text.push_back('"');
+    } else {
+      AppendEscapedContent(text, &output);
+      text.clear();
+      // Like xmlNewReference(), drop a leading '&' from the name.
+      output.push_back('&');
+      output.append(name, name[0] == '&' ? 1 : 0, std::string::npos);
+      output.push_back(';');
+    }
+  }
+  AppendEscapedContent(text, &output);
+  return output;
 }
 
 }  // namespace
 
 namespace xml {
 
-XmlNode::XmlNode(const char* name) : node_(xmlNewNode(NULL, BAD_CAST name)) {
+XmlNode::XmlNode(const char* name) : name_(name) {
   DCHECK(name);
-  DCHECK(node_);
 }
 
-XmlNode::~XmlNode() {}
+XmlNode::XmlNode(XmlNode&& other) = default;
+XmlNode& XmlNode::operator=(XmlNode&& other) = default;
 
-bool XmlNode::AddChild(scoped_xml_ptr<xmlNode> child) {
-  DCHECK(node_);
-  DCHECK(child);
-  if (!xmlAddChild(node_.get(), child.get()))
-    return false;
+XmlNode::~XmlNode() {}
 
-  // Reaching here means the ownership of |child| transfered to |node_|.
-  // Release the pointer so that it doesn't get destructed in this scope.
-  ignore_result(child.release());
-  return true;
+void XmlNode::AddChild(XmlNode child) {
+  children_.push_back(std::move(child));
 }
 
-bool XmlNode::AddElements(const std::vector<Element>& elements) {
+void XmlNode::AddElements(const std::vector<Element>& elements) {
   for (size_t element_index = 0; element_index < elements.size();
        ++element_index) {
     const Element& child_element = elements[element_index];
@@ -83,45 +235,32 @@ bool XmlNode::AddElements(const std::vector<Element>& elements) {
                                     attribute_it->second);
     }
     // Recursively set children for the child.
-    if (!child_node.AddElements(child_element.subelements))
-      return false;
+    child_node.AddElements(child_element.subelements);
 
     child_node.SetContent(child_element.content);
-
-    if (!xmlAddChild(node_.get(), child_node.GetRawPtr())) {
-      LOG(ERROR) << "Failed to set child " << child_element.name
-                 << " to parent element "
-                 << reinterpret_cast<const char*>(node_->name);
-      return false;
-    }
-    // Reaching here means the ownership of |child_node| transfered to |node_|.
-    // Release the pointer so that it doesn't get destructed in this scope.
-    ignore_result(child_node.Release());
+    AddChild(std::move(child_node));
   }
-  return true;
 }
 
 void XmlNode::SetStringAttribute(const char* attribute_name,
                                  const std::string& attribute) {
-  DCHECK(node_);
   DCHECK(attribute_name);
-  xmlSetProp(node_.get(), BAD_CAST attribute_name, BAD_CAST attribute.c_str());
+  for (auto& existing_attribute : attributes_) {
+    if (existing_attribute.first == attribute_name) {
+      existing_attribute.second = attribute;
+      return;
+    }
+  }
+  attributes_.emplace_back(attribute_name, attribute);
 }
 
 void XmlNode::SetIntegerAttribute(const char* attribute_name, uint64_t number) {
-  DCHECK(node_);
-  DCHECK(attribute_name);
-  xmlSetProp(node_.get(),
-             BAD_CAST attribute_name,
-             BAD_CAST (base::Uint64ToString(number).c_str()));
+  SetStringAttribute(attribute_name, base::Uint64ToString(number));
 }
 
 void XmlNode::SetFloatingPointAttribute(const char* attribute_name,
                                         double number) {
-  DCHECK(node_);
-  DCHECK(attribute_name);
-  xmlSetProp(node_.get(), BAD_CAST attribute_name,
-             BAD_CAST(DoubleToString(number).c_str()));
+  SetStringAttribute(attribute_name, DoubleToString(number));
 }
 
 void XmlNode::SetId(uint32_t id) {
@@ -129,24 +268,101 @@ void XmlNode::SetId(uint32_t id) {
 }
 
 void XmlNode::SetContent(const std::string& content) {
-  DCHECK(node_);
-  xmlNodeSetContent(node_.get(), BAD_CAST content.c_str());
+  children_.clear();
+  content_ = ConvertContent(content);
 }
 
-scoped_xml_ptr<xmlNode> XmlNode::PassScopedPtr() {
-  DVLOG(2) << "Passing node_.";
-  DCHECK(node_);
-  return std::move(node_);
+void XmlNode::SetSegments(std::vector<SegmentInfo> segments) {
+  segments_ = std::move(segments);
 }
 
-xmlNodePtr XmlNode::Release() {
-  DVLOG(2) << "Releasing node_.";
-  DCHECK(node_);
-  return node_.release();
+bool XmlNode::GetAttribute(const std::string& attribute_name,
+                           std::string* value) const {
+  DCHECK(value);
+  for (const auto& attribute : attributes_) {
+    if (attribute.first == attribute_name) {
+      *value = attribute.second;
+      return true;
+    }
+  }
+  return false;
+}
+
+void XmlNode::WriteTo(std::string* output) const {
+  DCHECK(output);
+  WriteTo(0, true, output);
 }
 
-xmlNodePtr XmlNode::GetRawPtr() {
-  return node_.get();
+std::string XmlNode::ToString() const {
+  std::string output;
+  WriteTo(&output);
+  return output;
+}
+
+XmlNode XmlNode::Clone() const {
+  XmlNode clone(name_.c_str());
+  clone.attributes_ = attributes_;
+  clone.content_ = content_;
+  clone.segments_ = segments_;
+  clone.children_.reserve(children_.size());
+  for (const XmlNode& child : children_)
+    clone.children_.push_back(child.Clone());
+  return clone;
+}
+
+void XmlNode::WriteTo(int level, bool format, std::string* output) const {
+  output->push_back('<');
+  output->append(name_);
+  for (const auto& attribute : attributes_) {
+    output->push_back(' ');
+    output->append(attribute.first);
+    output->append("=\"");
+    AppendEscapedAttribute(attribute.second, output);
+    output->push_back('"');
+  }
+  if (content_.empty() && children_.empty() && segments_.empty()) {
+    output->append("/>");
+    return;
+  }
+  output->push_back('>');
+
+  // Like libxml2, do not indent the children of an element with text content,
+  // as the whitespace would become part of its content.
+  if (!content_.empty()) {
+    format = false;
+    output->append(content_);
+  }
+  if (!children_.empty() || !segments_.empty()) {
+    if (format)
+      output->push_back('\n');
+    for (const SegmentInfo& segment : segments_) {
+      if (format)
+        AppendIndent(level + 1, output);
+      output->append("<S t=\"");
+      output->append(base::Uint64ToString(segment.start_time));
+      output->append("\" d=\"");
+      output->append(base::Uint64ToString(segment.duration));
+      if (segment.repeat > 0) {
+        output->append("\" r=\"");
+        output->append(base::Uint64ToString(segment.repeat));
+      }
+      output->append("\"/>");
+      if (format)
+        output->push_back('\n');
+    }
+    for (const XmlNode& child : children_) {
+      if (format)
+        AppendIndent(level + 1, output);
+      child.WriteTo(level + 1, format, output);
+      if (format)
+        output->push_back('\n');
+    }
+    if (format)
+      AppendIndent(level, output);
+  }
+  output->append("</");
+  output->append(name_);
+  output->push_back('>');
 }
 
 RepresentationBaseXmlNode::RepresentationBaseXmlNode(const char* name)
@@ -172,7 +388,7 @@ void RepresentationBaseXmlNode::AddSupplementalProperty(
   XmlNode supplemental_property("SupplementalProperty");
   supplemental_property.SetStringAttribute("schemeIdUri", scheme_id_uri);
   supplemental_property.SetStringAttribute("value", value);
-  AddChild(supplemental_property.PassScopedPtr());
+  AddChild(std::move(supplemental_property));
 }
 
 void RepresentationBaseXmlNode::AddEssentialProperty(
@@ -181,7 +397,7 @@ void RepresentationBaseXmlNode::AddEssentialProperty(
   XmlNode essential_property("EssentialProperty");
   essential_property.SetStringAttribute("schemeIdUri", scheme_id_uri);
   essential_property.SetStringAttribute("value", value);
-  AddChild(essential_property.PassScopedPtr());
+  AddChild(std::move(essential_property));
 }
 
 bool RepresentationBaseXmlNode::AddContentProtectionElement(
@@ -207,11 +423,9 @@ bool RepresentationBaseXmlNode::AddContentProtectionElement(
                                                attributes_it->second);
   }
 
-  if (!content_protection_node.AddElements(
-          content_protection_element.subelements)) {
-    return false;
-  }
-  return AddChild(content_protection_node.PassScopedPtr());
+  content_protection_node.AddElements(content_protection_element.subelements);
+  AddChild(std::move(content_protection_node));
+  return true;
 }
 
 AdaptationSetXmlNode::AdaptationSetXmlNode()
@@ -223,7 +437,7 @@ void AdaptationSetXmlNode::AddRoleElement(const std::string& scheme_id_uri,
   XmlNode role("Role");
   role.SetStringAttribute("schemeIdUri", scheme_id_uri);
   role.SetStringAttribute("value", value);
-  AddChild(role.PassScopedPtr());
+  AddChild(std::move(role));
 }
 
 RepresentationXmlNode::RepresentationXmlNode()
@@ -280,8 +494,7 @@ bool RepresentationXmlNode::AddVODOnlyInfo(const MediaInfo& media_info) {
     XmlNode base_url("BaseURL");
     base_url.SetContent(media_info.media_file_name());
 
-    if (!AddChild(base_url.PassScopedPtr()))
-      return false;
+    AddChild(std::move(base_url));
   }
 
   const bool need_segment_base = media_info.has_index_range() ||
@@ -310,12 +523,10 @@ bool RepresentationXmlNode::AddVODOnlyInfo(const MediaInfo& media_info) {
       initialization.SetStringAttribute("range",
                                         RangeToString(media_info.init_range()));
 
-      if (!segment_base.AddChild(initialization.PassScopedPtr()))
-        return false;
+      segment_base.AddChild(std::move(initialization));
     }
 
-    if (!AddChild(segment_base.PassScopedPtr()))
-      return false;
+    AddChild(std::move(segment_base));
   }
 
   return true;
@@ -323,7 +534,7 @@ bool RepresentationXmlNode::AddVODOnlyInfo(const MediaInfo& media_info) {
 
 bool RepresentationXmlNode::AddLiveOnlyInfo(
     const MediaInfo& media_info,
-    const std::list<SegmentInfo>& segment_infos,
+    const SegmentTimeline& segment_infos,
     uint32_t start_number) {
   XmlNode segment_template("SegmentTemplate");
   if (media_info.has_reference_time_scale()) {
@@ -366,9 +577,10 @@ bool RepresentationXmlNode::AddLiveOnlyInfo(
   // TODO(rkuroiwa): Find out when a live MPD doesn't require SegmentTimeline.
   XmlNode segment_timeline("SegmentTimeline");
 
-  return PopulateSegmentTimeline(segment_infos, &segment_timeline) &&
-         segment_template.AddChild(segment_timeline.PassScopedPtr()) &&
-         AddChild(segment_template.PassScopedPtr());
+  PopulateSegmentTimeline(segment_infos, &segment_timeline);
+  segment_template.AddChild(std::move(segment_timeline));
+  AddChild(std::move(segment_template));
+  return true;
 }
 
 bool RepresentationXmlNode::AddAudioChannelInfo(const AudioInfo& audio_info) {
@@ -395,7 +607,8 @@ bool RepresentationXmlNode::AddAudioChannelInfo(const AudioInfo& audio_info) {
                                           audio_channel_config_scheme);
   audio_channel_config.SetStringAttribute("value", audio_channel_config_value);
 
-  return AddChild(audio_channel_config.PassScopedPtr());
+  AddChild(std::move(audio_channel_config));
+  return true;
 }
 
 // MPD expects one number for sampling frequency, or if it is a range it should
@@ -4,25 +4,28 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 //
-// Classes to wrap XML operations. XmlNode is a generic wrapper class for
-// XmlNode in libxml2. There are also MPD XML specific classes as well.
+// Classes to generate XML. XmlNode is a lightweight XML element which writes
+// itself out as formatted text directly, without building a libxml2 tree.
+// There are also MPD XML specific classes as well.
 
 #ifndef MPD_BASE_XML_XML_NODE_H_
 #define MPD_BASE_XML_XML_NODE_H_
 
-#include <libxml/tree.h>
 #include <stdint.h>
 
 #include <list>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "packager/base/macros.h"
 #include "packager/mpd/base/content_protection_element.h"
 #include "packager/mpd/base/media_info.pb.h"
-#include "packager/mpd/base/xml/scoped_xml_ptr.h"
+#include "packager/mpd/base/segment_info.h"
 
 namespace shaka {
 
-struct SegmentInfo;
+class SegmentTimeline;
 
 namespace xml {
 
@@ -34,16 +37,17 @@ class XmlNode {
   /// Make an XML element.
   /// @param name is the name of the element, which should not be NULL.
   explicit XmlNode(const char* name);
+  XmlNode(XmlNode&& other);
+  XmlNode& operator=(XmlNode&& other);
   virtual ~XmlNode();
 
   /// Add a child element to this element.
-  /// @param child is a xmlNode to add as a child for this element. Ownership
-  ///        of the child node is transferred.
-  /// @return true on success, false otherwise.
-  bool AddChild(scoped_xml_ptr<xmlNode> child);
+  /// @param child is the element to add as a child for this element. It is
+  ///        moved into this element.
+  void AddChild(XmlNode child);
 
   /// Adds Elements to this node using the Element struct.
-  bool AddElements(const std::vector<Element>& elements);
+  void AddElements(const std::vector<Element>& elements);
 
   /// Set a string attribute.
   /// @param attribute_name The name (lhs) of the attribute.
@@ -68,25 +72,53 @@ class XmlNode {
   /// Set the contents of an XML element using a string.
   /// This cannot set child elements because <> will become &lt; and &rt;
   /// This should be used to set the text for the element, e.g. setting
-  /// a URL for <BaseURL> element.
-  /// @param content is a string containing the text-encoded child elements to
-  ///        be added to the element.
+  /// a URL for <BaseURL> element. Existing child elements are removed.
+  /// Like libxml2 xmlNodeSetContent(), '&' starts a character or entity
+  /// reference, so a literal '&' has to be passed as "&amp;".
+  /// @param content is the text content of the element.
   void SetContent(const std::string& content);
 
-  /// Transfer the ownership of the xmlNodePtr. After calling this method, the
-  /// behavior of any methods, except the destructor, is undefined.
-  /// @return The resource of this object.
-  scoped_xml_ptr<xmlNode> PassScopedPtr();
-
-  /// Release the xmlNodePtr of this object. After calling this method, the
-  /// behavior of any methods, except the destructor, is undefined.
-  xmlNodePtr Release();
-
-  /// @return Raw pointer to the element.
-  xmlNodePtr GetRawPtr();
+  /// Set the S elements of a SegmentTimeline element. They are kept as
+  /// SegmentInfo entries and written out directly, before the children.
+  /// @param segments contains the segments, sorted by start time.
+  void SetSegments(std::vector<SegmentInfo> segments);
+
+  /// @param attribute_name is the name of the attribute to look up.
+  /// @param[out] value is set to the value of the attribute if it is set.
+  /// @return true if the attribute is set, false otherwise.
+  bool GetAttribute(const std::string& attribute_name,
+                    std::string* value) const;
+
+  /// Write this element and its descendants as text, indented with two spaces
+  /// per level. The format is identical to the one of libxml2
+  /// xmlDocDumpFormatMemoryEnc() with UTF-8 encoding.
+  /// @param[out] output is the string the XML text is appended to.
+  void WriteTo(std::string* output) const;
+
+  /// @return The element as text, see WriteTo().
+  std::string ToString() const;
+
+  /// @return a deep copy of this element and its descendants.
+  XmlNode Clone() const;
+
+  const std::string& name() const { return name_; }
+  const std::vector<std::pair<std::string, std::string>>& attributes() const {
+    return attributes_;
+  }
+  /// @return The text content, escaped as it is written out.
+  const std::string& content() const { return content_; }
+  const std::vector<XmlNode>& children() const { return children_; }
+  const std::vector<SegmentInfo>& segments() const { return segments_; }
 
  private:
-  scoped_xml_ptr<xmlNode> node_;
+  void WriteTo(int level, bool format, std::string* output) const;
+
+  std::string name_;
+  // Attributes in the order they are first set.
+  std::vector<std::pair<std::string, std::string>> attributes_;
+  std::string content_;
+  std::vector<XmlNode> children_;
+  std::vector<SegmentInfo> segments_;
 
   DISALLOW_COPY_AND_ASSIGN(XmlNode);
 };
@@ -165,10 +197,9 @@ class RepresentationXmlNode : public RepresentationBaseXmlNode {
   /// @return true on success, false otherwise.
   bool AddVODOnlyInfo(const MediaInfo& media_info);
 
-  /// @param segment_infos is a set of SegmentInfos. This method assumes that
-  ///        SegmentInfos are sorted by its start time.
+  /// @param segment_infos contains the segments, sorted by start time.
   bool AddLiveOnlyInfo(const MediaInfo& media_info,
-                       const std::list<SegmentInfo>& segment_infos,
+                       const SegmentTimeline& segment_infos,
                        uint32_t start_number);
 
  private:
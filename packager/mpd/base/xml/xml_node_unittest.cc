@@ -12,7 +12,7 @@
 
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_util.h"
-#include "packager/mpd/base/segment_info.h"
+#include "packager/mpd/base/segment_timeline.h"
 #include "packager/mpd/base/xml/xml_node.h"
 #include "packager/mpd/test/xml_compare.h"
 
@@ -158,7 +158,7 @@ TEST(XmlNodeTest, AddContentProtectionElements) {
   RepresentationXmlNode representation;
   representation.AddContentProtectionElements(content_protections);
   EXPECT_THAT(
-      representation.GetRawPtr(),
+      &representation,
       XmlNodeEqual(
           "<Representation>\n"
           " <ContentProtection\n"
@@ -181,7 +181,7 @@ TEST(XmlNodeTest, AddEC3AudioInfo) {
   RepresentationXmlNode representation;
   representation.AddAudioInfo(audio_info);
   EXPECT_THAT(
-      representation.GetRawPtr(),
+      &representation,
       XmlNodeEqual(
           "<Representation audioSamplingRate=\"44100\">\n"
           "  <AudioChannelConfiguration\n"
@@ -191,11 +191,98 @@ TEST(XmlNodeTest, AddEC3AudioInfo) {
           "</Representation>\n"));
 }
 
+// The output must stay byte identical to what libxml2 generated for the same
+// tree.
+TEST(XmlNodeTest, WriteTo) {
+  XmlNode root("Root");
+  root.SetStringAttribute("b", "\"<tab>\t&\n");
+  root.SetIntegerAttribute("a", 1);
+  root.SetIntegerAttribute("b", 2);
+
+  XmlNode text("Text");
+  text.SetContent("a<b>&amp;\"c\"\r");
+  root.AddChild(std::move(text));
+
+  XmlNode parent("Parent");
+  XmlNode child("Child");
+  child.SetStringAttribute("id", "x");
+  parent.AddChild(std::move(child));
+  root.AddChild(std::move(parent));
+
+  XmlNode mixed("Mixed");
+  mixed.SetContent("text");
+  mixed.AddChild(XmlNode("Inline"));
+  root.AddChild(std::move(mixed));
+
+  XmlNode empty_content("Empty");
+  empty_content.AddChild(XmlNode("Removed"));
+  empty_content.SetContent("");
+  root.AddChild(std::move(empty_content));
+
+  EXPECT_EQ(
+      "<Root b=\"2\" a=\"1\">\n"
+      "  <Text>a&lt;b&gt;&amp;\"c\"&#13;</Text>\n"
+      "  <Parent>\n"
+      "    <Child id=\"x\"/>\n"
+      "  </Parent>\n"
+      "  <Mixed>text<Inline/></Mixed>\n"
+      "  <Empty/>\n"
+      "</Root>",
+      root.ToString());
+
+  XmlNode attribute_escaping("A");
+  attribute_escaping.SetStringAttribute("v", "\"<tab>\t&\n\r");
+  EXPECT_EQ("<A v=\"&quot;&lt;tab&gt;&#9;&amp;&#10;&#13;\"/>",
+            attribute_escaping.ToString());
+}
+
+// Like libxml2 xmlNodeSetContent(), '&' starts a reference.
+TEST(XmlNodeTest, SetContentReferences) {
+  XmlNode node("A");
+  node.SetContent("&lt;&gt;&amp;&apos;&quot; &#65;&#x42;&#xe9; &custom;x");
+  EXPECT_EQ("<A>&lt;&gt;&amp;'\" AB\xC3\xA9 &custom;x</A>", node.ToString());
+
+  // Invalid character references are dropped, but not the text after them.
+  node.SetContent("a&#0;b&#12z;c&#xg;");
+  EXPECT_EQ("<A>abz;cg;</A>", node.ToString());
+
+  // An unterminated reference drops the text after the last entity reference.
+  node.SetContent("a&b;c&d");
+  EXPECT_EQ("<A>a&b;</A>", node.ToString());
+  node.SetContent("http://a/?b=1&c=2");
+  EXPECT_EQ("<A/>", node.ToString());
+}
+
+TEST(XmlNodeTest, SegmentTimeline) {
+  MediaInfo media_info;
+  media_info.set_segment_template("$Number$.m4s");
+  SegmentTimeline segment_infos;
+  segment_infos.PushBack({0, 10, 2});
+  segment_infos.PushBack({30, 5, 0});
+  RepresentationXmlNode representation;
+  ASSERT_TRUE(representation.AddLiveOnlyInfo(media_info, segment_infos, 1));
+  EXPECT_EQ(
+      "<Representation>\n"
+      "  <SegmentTemplate media=\"$Number$.m4s\" startNumber=\"1\">\n"
+      "    <SegmentTimeline>\n"
+      "      <S t=\"0\" d=\"10\" r=\"2\"/>\n"
+      "      <S t=\"30\" d=\"5\"/>\n"
+      "    </SegmentTimeline>\n"
+      "  </SegmentTemplate>\n"
+      "</Representation>",
+      representation.ToString());
+
+  // The segments are copied, so they are not affected by later updates.
+  XmlNode clone = representation.Clone();
+  segment_infos.PushBack({35, 5, 0});
+  EXPECT_EQ(representation.ToString(), clone.ToString());
+}
+
 // Some template names cannot be used for init segment name.
 TEST(XmlNodeTest, InvalidLiveInitSegmentName) {
   MediaInfo media_info;
   const uint32_t kDefaultStartNumber = 1;
-  std::list<SegmentInfo> segment_infos;
+  SegmentTimeline segment_infos;
   RepresentationXmlNode representation;
 
   // $Number$ cannot be used for segment name.
@@ -39,6 +39,8 @@
         'base/mpd_notifier_util.h',
         'base/mpd_notifier.h',
         'base/mpd_options.h',
+        'base/mpd_patch.cc',
+        'base/mpd_patch.h',
         'base/mpd_utils.cc',
         'base/mpd_utils.h',
         'base/period.cc',
@@ -46,6 +48,8 @@
         'base/representation.cc',
         'base/representation.h',
         'base/segment_info.h',
+        'base/segment_timeline.cc',
+        'base/segment_timeline.h',
         'base/simple_mpd_notifier.cc',
         'base/simple_mpd_notifier.h',
         'base/xml/scoped_xml_ptr.h',
@@ -87,8 +91,10 @@
         'base/adaptation_set_unittest.cc',
         'base/bandwidth_estimator_unittest.cc',
         'base/mpd_builder_unittest.cc',
+        'base/mpd_patch_unittest.cc',
         'base/period_unittest.cc',
         'base/representation_unittest.cc',
+        'base/segment_timeline_unittest.cc',
         'base/simple_mpd_notifier_unittest.cc',
         'base/xml/xml_node_unittest.cc',
         'test/mpd_builder_test_helper.cc',
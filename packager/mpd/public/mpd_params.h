@@ -40,6 +40,12 @@ struct MpdParams {
   /// Set MPD@minimumUpdatePeriod attribute, which indicates to the player how
   /// often to refresh the MPD in seconds. For dynamic MPD only.
   double minimum_update_period = 0;
+  /// Generate MPD Patch documents for dynamic MPDs if positive. Each MPD gets
+  /// a <PatchLocation> element referencing a patch file next to the MPD, which
+  /// brings that MPD up to date with the latest MPD. The patch files are kept
+  /// up to date for this many seconds after the MPD is published, which is
+  /// also the PatchLocation@ttl.
+  double mpd_patch_retention = 0;
   /// The tracks tagged with this language will have <Role ... value=\"main\" />
   /// in the manifest. This allows the player to choose the correct default
   /// language for the content.
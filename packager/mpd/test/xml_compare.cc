@@ -178,6 +178,11 @@ bool XmlEqual(const std::string& xml1, xmlNodePtr xml2) {
   return CompareNodes(xml1_root_element, xml2);
 }
 
+bool XmlEqual(const std::string& xml1, const xml::XmlNode* xml2) {
+  DCHECK(xml2);
+  return XmlEqual(xml1, xml2->ToString());
+}
+
 std::string XmlNodeToString(xmlNodePtr xml_node) {
   // Create an xmlDoc from xmlNodePtr. The node is copied so ownership does not
   // transfer.
@@ -200,4 +205,9 @@ std::string XmlNodeToString(xmlNodePtr xml_node) {
   return output.substr(first_newline_char_pos + 1);
 }
 
+std::string XmlNodeToString(const xml::XmlNode* xml_node) {
+  DCHECK(xml_node);
+  return xml_node->ToString() + "\n";
+}
+
 }  // namespace shaka
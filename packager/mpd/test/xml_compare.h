@@ -7,6 +7,7 @@
 #include <string>
 
 #include "packager/mpd/base/xml/scoped_xml_ptr.h"
+#include "packager/mpd/base/xml/xml_node.h"
 
 namespace shaka {
 
@@ -22,12 +23,14 @@ bool XmlEqual(const std::string& xml1, const std::string& xml2);
 bool XmlEqual(const std::string& xml1, xmlDocPtr xml2);
 bool XmlEqual(xmlDocPtr xml1, xmlDocPtr xml2);
 bool XmlEqual(const std::string& xml1, xmlNodePtr xml2);
+bool XmlEqual(const std::string& xml1, const xml::XmlNode* xml2);
 
 /// Get string representation of the xml node.
 /// Note that the ownership is not transferred.
 std::string XmlNodeToString(xmlNodePtr xml_node);
+std::string XmlNodeToString(const xml::XmlNode* xml_node);
 
-/// Match an xmlNodePtr with an xml in string representation.
+/// Match an xmlNodePtr or an XmlNode with an xml in string representation.
 MATCHER_P(XmlNodeEqual,
           xml,
           std::string("xml node equal (ignore extra white spaces)\n") + xml) {
@@ -35,27 +38,23 @@ MATCHER_P(XmlNodeEqual,
   return XmlEqual(xml, arg);
 }
 
-/// Match the attribute of an xmlNodePtr with expected value.
+/// Match the attribute of an XmlNode with expected value.
 /// Note that the ownership is not transferred.
 MATCHER_P2(AttributeEqual, attribute, expected_value, "") {
-  xml::scoped_xml_ptr<xmlChar> attribute_xml_str(
-      xmlGetProp(arg, BAD_CAST attribute));
-  if (!attribute_xml_str) {
+  std::string actual_value;
+  if (!arg->GetAttribute(attribute, &actual_value)) {
     *result_listener << "no attribute '" << attribute << "'";
     return false;
   }
-  std::string actual_value =
-      reinterpret_cast<const char*>(attribute_xml_str.get());
   *result_listener << actual_value;
   return expected_value == actual_value;
 }
 
-/// Check if the attribute is set in an xmlNodePtr.
+/// Check if the attribute is set in an XmlNode.
 /// Note that the ownership is not transferred.
 MATCHER_P(AttributeSet, attribute, "") {
-  xml::scoped_xml_ptr<xmlChar> attribute_xml_str(
-      xmlGetProp(arg, BAD_CAST attribute));
-  return attribute_xml_str != nullptr;
+  std::string value;
+  return arg->GetAttribute(attribute, &value);
 }
 }  // namespace shaka
 
@@ -21,6 +21,7 @@
 #include "packager/base/threading/simple_thread.h"
 #include "packager/base/time/clock.h"
 #include "packager/file/file.h"
+#include "packager/file/memory_accountant.h"
 #include "packager/hls/base/hls_notifier.h"
 #include "packager/hls/base/simple_hls_notifier.h"
 #include "packager/media/ad_cue_generator/ad_cue_generator.h"
@@ -28,6 +29,7 @@
 #include "packager/media/base/fourccs.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/language_utils.h"
+#include "packager/media/base/latency_tracer.h"
 #include "packager/media/base/muxer.h"
 #include "packager/media/base/muxer_options.h"
 #include "packager/media/base/muxer_util.h"
@@ -35,6 +37,7 @@
 #include "packager/media/crypto/encryption_handler.h"
 #include "packager/media/demuxer/demuxer.h"
 #include "packager/media/event/muxer_listener_factory.h"
+#include "packager/media/event/progress_tracking_muxer_listener.h"
 #include "packager/media/event/vod_media_info_dump_muxer_listener.h"
 #include "packager/media/formats/webvtt/text_readers.h"
 #include "packager/media/formats/webvtt/webvtt_output_handler.h"
@@ -59,6 +62,9 @@ namespace media {
 namespace {
 
 const char kMediaInfoSuffix[] = ".media_info";
+// Minimum interval between the writes of the latency trace while packaging,
+// in microseconds.
+const int64_t kLatencyTraceFlushInterval = 1000000;
 
 MuxerOptions CreateMuxerOptions(const StreamDescriptor& stream,
                                 const PackagingParams& params) {
@@ -127,6 +133,11 @@ MediaContainerName GetOutputFormat(const StreamDescriptor& descriptor) {
   return output_format;
 }
 
+bool IsPackedAudio(MediaContainerName output_format) {
+  return output_format == CONTAINER_AAC || output_format == CONTAINER_AC3 ||
+         output_format == CONTAINER_EAC3;
+}
+
 Status ValidateStreamDescriptor(bool dump_stream_info,
                                 const StreamDescriptor& stream) {
   if (stream.input.empty()) {
@@ -180,6 +191,13 @@ Status ValidateStreamDescriptor(bool dump_stream_info,
                     "All TS segments must be self-initializing. Stream "
                     "descriptors 'output' or 'init_segment' are not allowed.");
     }
+  } else if (IsPackedAudio(output_format)) {
+    // Packed audio segments are self-initializing like TS segments.
+    if (stream.segment_template.empty() || stream.output.length()) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Packed audio output requires 'segment_template' only. "
+                    "Single file and 'init_segment' are not supported.");
+    }
   } else {
     // For any other format, if there is a segment template, there must be an
     // init segment provided.
@@ -225,6 +243,12 @@ Status ValidateParams(const PackagingParams& packaging_params,
     if (!stream_check.ok()) {
       return stream_check;
     }
+
+    if (IsPackedAudio(GetOutputFormat(descriptor)) &&
+        !packaging_params.mpd_params.mpd_output.empty()) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Packed audio output is only supported in HLS.");
+    }
   }
 
   if (packaging_params.output_media_info && !on_demand_dash_profile) {
@@ -309,6 +333,8 @@ Status CreateDemuxer(const StreamDescriptor& stream,
                      std::shared_ptr<Demuxer>* new_demuxer) {
   std::shared_ptr<Demuxer> demuxer = std::make_shared<Demuxer>(stream.input);
   demuxer->set_dump_stream_info(packaging_params.test_params.dump_stream_info);
+  demuxer->set_record_ingest_time(
+      !packaging_params.latency_trace_output.empty());
 
   if (packaging_params.decryption_params.key_provider != KeyProvider::kNone) {
     std::unique_ptr<KeySource> decryption_key_source(
@@ -325,29 +351,65 @@ Status CreateDemuxer(const StreamDescriptor& stream,
   return Status::OK;
 }
 
-std::shared_ptr<MediaHandler> CreateEncryptionHandler(
-    const PackagingParams& packaging_params,
-    const StreamDescriptor& stream,
-    KeySource* key_source) {
-  if (stream.skip_encryption) {
-    return nullptr;
-  }
-
-  if (!key_source) {
-    return nullptr;
-  }
-
-  // Make a copy so that we can modify it for this specific stream.
-  EncryptionParams encryption_params = packaging_params.encryption_params;
+// Returns the protection scheme the output of |stream| is encrypted with, or
+// FOURCC_NULL if it is not encrypted.
+FourCC GetProtectionScheme(const PackagingParams& packaging_params,
+                           const StreamDescriptor& stream,
+                           KeySource* key_source) {
+  if (stream.skip_encryption || !key_source)
+    return FOURCC_NULL;
 
   // Use Sample AES in MPEG2TS.
   // TODO(kqyang): Consider adding a new flag to enable Sample AES as we
   // will support CENC in TS in the future.
   if (GetOutputFormat(stream) == CONTAINER_MPEG2TS) {
     VLOG(1) << "Use Apple Sample AES encryption for MPEG2TS.";
-    encryption_params.protection_scheme = kAppleSampleAesProtectionScheme;
+    return kAppleSampleAesProtectionScheme;
   }
 
+  if (stream.protection_scheme != 0)
+    return static_cast<FourCC>(stream.protection_scheme);
+  return static_cast<FourCC>(
+      packaging_params.encryption_params.protection_scheme);
+}
+
+// Outputs of a stream with the same protection scheme and DRM label share
+// the encryption.
+typedef std::pair<FourCC, std::string> EncryptionVariant;
+
+EncryptionVariant GetEncryptionVariant(const PackagingParams& packaging_params,
+                                       const StreamDescriptor& stream,
+                                       KeySource* key_source) {
+  const FourCC protection_scheme =
+      GetProtectionScheme(packaging_params, stream, key_source);
+  if (protection_scheme == FOURCC_NULL)
+    return EncryptionVariant(FOURCC_NULL, std::string());
+  return EncryptionVariant(protection_scheme, stream.drm_label);
+}
+
+// The stream label shared by the streams multiplexed into an output, so that
+// they are encrypted with the same key.
+struct SharedStreamLabel {
+  bool assigned = false;
+  std::string label;
+};
+
+// |shared_label|, if not null, overrides the label of the stream once it is
+// assigned.
+std::shared_ptr<MediaHandler> CreateEncryptionHandler(
+    const PackagingParams& packaging_params,
+    const StreamDescriptor& stream,
+    KeySource* key_source,
+    std::shared_ptr<SharedStreamLabel> shared_label = nullptr) {
+  const FourCC protection_scheme =
+      GetProtectionScheme(packaging_params, stream, key_source);
+  if (protection_scheme == FOURCC_NULL)
+    return nullptr;
+
+  // Make a copy so that we can modify it for this specific stream.
+  EncryptionParams encryption_params = packaging_params.encryption_params;
+  encryption_params.protection_scheme = protection_scheme;
+
   if (!stream.drm_label.empty()) {
     const std::string& drm_label = stream.drm_label;
     encryption_params.stream_label_func =
@@ -363,6 +425,21 @@ std::shared_ptr<MediaHandler> CreateEncryptionHandler(
         kDefaultMaxHdPixels, kDefaultMaxUhd1Pixels, std::placeholders::_1);
   }
 
+  if (shared_label) {
+    // The label is assigned by the first stream labelled. The encryption
+    // handlers of the multiplexed streams run on the demuxer thread.
+    const auto stream_label_func = encryption_params.stream_label_func;
+    encryption_params.stream_label_func =
+        [stream_label_func, shared_label](
+            const EncryptionParams::EncryptedStreamAttributes& attributes) {
+          if (!shared_label->assigned) {
+            shared_label->label = stream_label_func(attributes);
+            shared_label->assigned = true;
+          }
+          return shared_label->label;
+        };
+  }
+
   return std::make_shared<EncryptionHandler>(encryption_params, key_source);
 }
 
@@ -570,6 +647,119 @@ Status CreateTextJobs(
   return Status::OK;
 }
 
+// Returns the indices of the MPEG2-TS streams that are multiplexed with
+// |streams[index]|, i.e. the streams from the same input writing to the same
+// segment template. The returned group is empty if the stream is not
+// multiplexed.
+std::vector<size_t> GetMultiplexedTsGroup(
+    const std::vector<std::reference_wrapper<const StreamDescriptor>>& streams,
+    size_t index) {
+  const StreamDescriptor& stream = streams[index];
+  std::vector<size_t> group;
+  if (stream.segment_template.empty() ||
+      GetOutputFormat(stream) != CONTAINER_MPEG2TS) {
+    return group;
+  }
+  for (size_t i = 0; i < streams.size(); ++i) {
+    const StreamDescriptor& other = streams[i];
+    if (other.input == stream.input &&
+        other.segment_template == stream.segment_template &&
+        GetOutputFormat(other) == CONTAINER_MPEG2TS) {
+      group.push_back(i);
+    }
+  }
+  if (group.size() < 2)
+    group.clear();
+  return group;
+}
+
+// Creates the pipeline for streams multiplexed into a single MPEG2-TS output.
+// The streams share one chunker, so their segments are aligned, one muxer and
+// one key. The chunker dispatches the stream info of its main stream, the
+// video stream, first, so the key is chosen by the label of the video stream.
+Status CreateMultiplexedTsJob(
+    const std::vector<std::reference_wrapper<const StreamDescriptor>>& streams,
+    const std::vector<size_t>& group,
+    const PackagingParams& packaging_params,
+    Demuxer* demuxer,
+    KeySource* encryption_key_source,
+    MuxerListenerFactory* muxer_listener_factory,
+    MuxerFactory* muxer_factory) {
+  const StreamDescriptor& first_stream = streams[group.front()];
+  for (size_t i = 0; i < streams.size(); ++i) {
+    if (std::find(group.begin(), group.end(), i) != group.end())
+      continue;
+    const StreamDescriptor& stream = streams[i];
+    for (size_t index : group) {
+      const StreamDescriptor& multiplexed_stream = streams[index];
+      if (stream.input == multiplexed_stream.input &&
+          stream.stream_selector == multiplexed_stream.stream_selector) {
+        return Status(error::INVALID_ARGUMENT,
+                      "Stream " + stream.input + ":" + stream.stream_selector +
+                          " is multiplexed into " +
+                          first_stream.segment_template +
+                          " and cannot have other outputs.");
+      }
+    }
+  }
+
+  std::shared_ptr<Muxer> muxer =
+      muxer_factory->CreateMuxer(CONTAINER_MPEG2TS, first_stream);
+  if (!muxer) {
+    return Status(error::INVALID_ARGUMENT, "Failed to create muxer for " +
+                                               first_stream.segment_template);
+  }
+  // The playlist is named after the first stream. The muxer describes all the
+  // multiplexed streams to the listener, and reports the other events once
+  // for the output.
+  muxer->SetMuxerListener(muxer_listener_factory->CreateListener(
+      ToMuxerListenerData(first_stream)));
+
+  std::shared_ptr<MediaHandler> chunker =
+      std::make_shared<ChunkingHandler>(packaging_params.chunking_params);
+  std::shared_ptr<SharedStreamLabel> shared_label =
+      std::make_shared<SharedStreamLabel>();
+
+  Status status;
+  for (size_t index : group) {
+    const StreamDescriptor& stream = streams[index];
+    if (stream.trick_play_factor) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Trick play is not supported for multiplexed stream " +
+                        stream.input + ":" + stream.stream_selector);
+    }
+    if (stream.drm_label != first_stream.drm_label) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Streams multiplexed into " +
+                        first_stream.segment_template +
+                        " should have the same drm_label.");
+    }
+
+    // The chunker only keeps the cues of its main stream and dispatches them
+    // to all the streams.
+    if (!packaging_params.ad_cue_generator_params.cue_points.empty()) {
+      std::shared_ptr<MediaHandler> ad_cue_generator =
+          std::make_shared<AdCueGenerator>(
+              packaging_params.ad_cue_generator_params);
+      status.Update(
+          demuxer->SetHandler(stream.stream_selector, ad_cue_generator));
+      status.Update(ad_cue_generator->AddHandler(chunker));
+    } else {
+      status.Update(demuxer->SetHandler(stream.stream_selector, chunker));
+    }
+
+    std::shared_ptr<MediaHandler> encryptor = CreateEncryptionHandler(
+        packaging_params, stream, encryption_key_source, shared_label);
+    if (encryptor) {
+      status.Update(chunker->AddHandler(encryptor));
+      status.Update(encryptor->AddHandler(muxer));
+    } else {
+      status.Update(chunker->AddHandler(muxer));
+    }
+  }
+  return status;
+}
+
 Status CreateAudioVideoJobs(
     const std::vector<std::reference_wrapper<const StreamDescriptor>>& streams,
     const PackagingParams& packaging_params,
@@ -583,14 +773,20 @@ Status CreateAudioVideoJobs(
 
   // Demuxers are shared among all streams with the same input.
   std::shared_ptr<Demuxer> demuxer;
-  // Replicators are shared among all streams with the same input and stream
-  // selector.
-  std::shared_ptr<MediaHandler> replicator;
+  // Chunkers are shared among all streams with the same input and stream
+  // selector. Their output is replicated if the streams are encrypted
+  // differently.
+  std::shared_ptr<MediaHandler> chunker_output;
+  // Replicators are shared among all streams with the same input, stream
+  // selector and encryption variant.
+  std::map<EncryptionVariant, std::shared_ptr<MediaHandler>> replicators;
 
   std::string previous_input;
   std::string previous_selector;
 
-  for (const StreamDescriptor& stream : streams) {
+  for (size_t i = 0; i < streams.size(); ++i) {
+    const StreamDescriptor& stream = streams[i];
+
     // If we changed our input files, we need a new demuxer.
     if (previous_input != stream.input) {
       Status status = CreateDemuxer(stream, packaging_params, &demuxer);
@@ -605,6 +801,23 @@ Status CreateAudioVideoJobs(
       demuxer->SetLanguageOverride(stream.stream_selector, stream.language);
     }
 
+    // Multiplexed streams get a pipeline of their own, created when the first
+    // stream of the group is reached.
+    const std::vector<size_t> multiplexed_group =
+        GetMultiplexedTsGroup(streams, i);
+    if (!multiplexed_group.empty()) {
+      previous_input = stream.input;
+      previous_selector = stream.stream_selector;
+      if (multiplexed_group.front() != i)
+        continue;
+      Status status = CreateMultiplexedTsJob(
+          streams, multiplexed_group, packaging_params, demuxer.get(),
+          encryption_key_source, muxer_listener_factory, muxer_factory);
+      if (!status.ok())
+        return status;
+      continue;
+    }
+
     const bool new_stream = previous_input != stream.input ||
                             previous_selector != stream.stream_selector;
     previous_input = stream.input;
@@ -616,6 +829,15 @@ Status CreateAudioVideoJobs(
       continue;
     }
 
+    const EncryptionVariant encryption_variant = GetEncryptionVariant(
+        packaging_params, stream, encryption_key_source);
+    if (IsPackedAudio(GetOutputFormat(stream)) &&
+        encryption_variant.first != FOURCC_NULL) {
+      return Status(error::UNIMPLEMENTED,
+                    "Encrypted packed audio is not supported yet. Set "
+                    "'skip_encryption' for " + stream.segment_template + ".");
+    }
+
     if (new_stream) {
       std::shared_ptr<MediaHandler> ad_cue_generator;
       if (!packaging_params.ad_cue_generator_params.cue_points.empty()) {
@@ -623,14 +845,9 @@ Status CreateAudioVideoJobs(
             packaging_params.ad_cue_generator_params);
       }
 
-      replicator = std::make_shared<Replicator>();
-
       std::shared_ptr<MediaHandler> chunker =
           std::make_shared<ChunkingHandler>(packaging_params.chunking_params);
 
-      std::shared_ptr<MediaHandler> encryptor = CreateEncryptionHandler(
-          packaging_params, stream, encryption_key_source);
-
       Status status;
       if (ad_cue_generator) {
         status.Update(
@@ -639,12 +856,33 @@ Status CreateAudioVideoJobs(
       } else {
         status.Update(demuxer->SetHandler(stream.stream_selector, chunker));
       }
-      if (encryptor) {
-        status.Update(chunker->AddHandler(encryptor));
-        status.Update(encryptor->AddHandler(replicator));
-      } else {
-        status.Update(chunker->AddHandler(replicator));
+
+      // The streams sharing the chunker follow this one. Only replicate the
+      // chunker output if they are encrypted differently, so the samples are
+      // encrypted in place in the common case.
+      bool same_encryption = true;
+      for (size_t j = i + 1; j < streams.size(); ++j) {
+        const StreamDescriptor& next_stream = streams[j];
+        if (next_stream.input != stream.input ||
+            next_stream.stream_selector != stream.stream_selector) {
+          break;
+        }
+        if (next_stream.output.empty() &&
+            next_stream.segment_template.empty()) {
+          continue;
+        }
+        if (GetEncryptionVariant(packaging_params, next_stream,
+                                 encryption_key_source) != encryption_variant) {
+          same_encryption = false;
+          break;
+        }
       }
+      chunker_output = chunker;
+      if (!same_encryption) {
+        chunker_output = std::make_shared<Replicator>();
+        status.Update(chunker->AddHandler(chunker_output));
+      }
+      replicators.clear();
 
       if (!status.ok()) {
         return status;
@@ -655,6 +893,27 @@ Status CreateAudioVideoJobs(
       }
     }
 
+    std::shared_ptr<MediaHandler>& replicator =
+        replicators[encryption_variant];
+    if (!replicator) {
+      replicator = std::make_shared<Replicator>();
+
+      std::shared_ptr<MediaHandler> encryptor = CreateEncryptionHandler(
+          packaging_params, stream, encryption_key_source);
+
+      Status status;
+      if (encryptor) {
+        status.Update(chunker_output->AddHandler(encryptor));
+        status.Update(encryptor->AddHandler(replicator));
+      } else {
+        status.Update(chunker_output->AddHandler(replicator));
+      }
+
+      if (!status.ok()) {
+        return status;
+      }
+    }
+
     // Create the muxer (output) for this track.
     std::unique_ptr<MuxerListener> muxer_listener =
         muxer_listener_factory->CreateListener(ToMuxerListenerData(stream));
@@ -743,10 +1002,18 @@ Status CreateAllJobs(const std::vector<StreamDescriptor>& stream_descriptors,
 }  // namespace media
 
 struct Packager::PackagerInternal {
+  ~PackagerInternal() {
+    if (uses_memory_budget)
+      MemoryAccountant::GetInstance()->RemoveBudgetUser();
+  }
+
+  bool uses_memory_budget = false;
   media::FakeClock fake_clock;
-  std::unique_ptr<KeySource> encryption_key_source;
+  std::shared_ptr<KeySource> encryption_key_source;
   std::unique_ptr<MpdNotifier> mpd_notifier;
   std::unique_ptr<hls::HlsNotifier> hls_notifier;
+  std::unique_ptr<media::LatencyTracer> latency_tracer;
+  media::OutputProgress output_progress;
   BufferCallbackParams buffer_callback_params;
   media::JobManager job_manager;
 };
@@ -758,6 +1025,13 @@ Packager::~Packager() {}
 Status Packager::Initialize(
     const PackagingParams& packaging_params,
     const std::vector<StreamDescriptor>& stream_descriptors) {
+  return Initialize(packaging_params, stream_descriptors, nullptr);
+}
+
+Status Packager::Initialize(
+    const PackagingParams& packaging_params,
+    const std::vector<StreamDescriptor>& stream_descriptors,
+    std::shared_ptr<KeySource> encryption_key_source) {
   // Needed by base::WorkedPool used in ThreadedIoFile.
   static base::AtExitManager exit;
   static media::LibcryptoThreading libcrypto_threading;
@@ -778,8 +1052,22 @@ Status Packager::Initialize(
 
   std::unique_ptr<PackagerInternal> internal(new PackagerInternal);
 
+  if (packaging_params.memory_budget > 0) {
+    // The budget is process wide.
+    if (!MemoryAccountant::GetInstance()->AddBudgetUser(
+            packaging_params.memory_budget)) {
+      return Status(error::INVALID_ARGUMENT,
+                    "The memory budget conflicts with the memory budget of "
+                    "another Packager instance.");
+    }
+    internal->uses_memory_budget = true;
+  }
+
   // Create encryption key source if needed.
-  if (packaging_params.encryption_params.key_provider != KeyProvider::kNone) {
+  if (encryption_key_source) {
+    internal->encryption_key_source = std::move(encryption_key_source);
+  } else if (packaging_params.encryption_params.key_provider !=
+             KeyProvider::kNone) {
     internal->encryption_key_source = CreateEncryptionKeySource(
         static_cast<media::FourCC>(
             packaging_params.encryption_params.protection_scheme),
@@ -794,7 +1082,10 @@ Status Packager::Initialize(
   // Update MPD output and HLS output if callback param is specified.
   MpdParams mpd_params = packaging_params.mpd_params;
   HlsParams hls_params = packaging_params.hls_params;
-  if (internal->buffer_callback_params.write_func) {
+  const bool write_to_callback =
+      internal->buffer_callback_params.write_func ||
+      internal->buffer_callback_params.file_ready_func;
+  if (write_to_callback) {
     mpd_params.mpd_output = File::MakeCallbackFileName(
         internal->buffer_callback_params, mpd_params.mpd_output);
     hls_params.master_playlist_output = File::MakeCallbackFileName(
@@ -821,7 +1112,7 @@ Status Packager::Initialize(
 
     internal->hls_notifier.reset(new hls::SimpleHlsNotifier(
         hls_params.playlist_type, hls_params.time_shift_buffer_depth,
-        hls_params.base_url, hls_params.key_uri,
+        hls_params.can_skip_until, hls_params.base_url, hls_params.key_uri,
         master_playlist_path.DirName().AsEndingWithSeparator().AsUTF8Unsafe(),
         master_playlist_name.AsUTF8Unsafe()));
   }
@@ -837,7 +1128,7 @@ Status Packager::Initialize(
                                               descriptor.input);
     }
 
-    if (internal->buffer_callback_params.write_func) {
+    if (write_to_callback) {
       copy.output = File::MakeCallbackFileName(internal->buffer_callback_params,
                                                descriptor.output);
       copy.segment_template = File::MakeCallbackFileName(
@@ -862,9 +1153,16 @@ Status Packager::Initialize(
     muxer_factory.OverrideClock(&internal->fake_clock);
   }
 
+  if (!packaging_params.latency_trace_output.empty()) {
+    internal->latency_tracer.reset(new media::LatencyTracer(
+        packaging_params.latency_trace_output,
+        media::kLatencyTraceFlushInterval));
+  }
+
   media::MuxerListenerFactory muxer_listener_factory(
       packaging_params.output_media_info, internal->mpd_notifier.get(),
-      internal->hls_notifier.get());
+      internal->hls_notifier.get(), internal->latency_tracer.get(),
+      &internal->output_progress);
 
   Status status = media::CreateAllJobs(
       streams_for_jobs, packaging_params, internal->mpd_notifier.get(),
@@ -884,6 +1182,16 @@ Status Packager::Run() {
     return Status(error::INVALID_ARGUMENT, "Not yet initialized.");
 
   Status status = internal_->job_manager.RunJobs();
+  if (internal_->uses_memory_budget) {
+    LOG(INFO) << "Memory high watermarks (bytes): "
+              << MemoryAccountant::GetInstance()->GetHighWatermarkReport();
+  }
+  // The trace is written periodically while packaging. Write the final trace
+  // even if packaging failed.
+  if (internal_->latency_tracer && !internal_->latency_tracer->Flush()) {
+    status.Update(
+        Status(error::FILE_FAILURE, "Failed to write latency trace."));
+  }
   if (!status.ok())
     return status;
 
@@ -898,6 +1206,12 @@ Status Packager::Run() {
   return Status::OK;
 }
 
+void Packager::GetOutputProgress(uint64_t* num_segments,
+                                 uint64_t* num_bytes) const {
+  DCHECK(internal_);
+  internal_->output_progress.Get(num_segments, num_bytes);
+}
+
 void Packager::Cancel() {
   if (!internal_) {
     LOG(INFO) << "Not yet initialized. Return directly.";
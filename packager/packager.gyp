@@ -24,6 +24,8 @@
         'app/packager_util.h',
         'packager.cc',
         'packager.h',
+        'packager_service.cc',
+        'packager_service.h',
       ],
       'dependencies': [
         'file/file.gyp:file',
@@ -36,6 +38,7 @@
         'media/event/media_event.gyp:media_event',
         'media/formats/mp2t/mp2t.gyp:mp2t',
         'media/formats/mp4/mp4.gyp:mp4',
+        'media/formats/packed_audio/packed_audio.gyp:packed_audio',
         'media/formats/webm/webm.gyp:webm',
         'media/formats/webvtt/webvtt.gyp:webvtt',
         'media/formats/wvm/wvm.gyp:wvm',
@@ -81,6 +84,8 @@
         'app/raw_key_encryption_flags.h',
         'app/retired_flags.cc',
         'app/retired_flags.h',
+        'app/service_mode.cc',
+        'app/service_mode.h',
         'app/stream_descriptor.cc',
         'app/stream_descriptor.h',
         'app/validate_flag.cc',
@@ -119,6 +124,21 @@
         'third_party/gflags/gflags.gyp:gflags',
       ],
     },
+    {
+      'target_name': 'udp_capture_replay',
+      'type': 'executable',
+      'sources': [
+        'app/udp_capture_replay.cc',
+        'app/vlog_flags.cc',
+        'app/vlog_flags.h',
+      ],
+      'dependencies': [
+        'base/base.gyp:base',
+        'file/file.gyp:file',
+        'third_party/gflags/gflags.gyp:gflags',
+        'version/version.gyp:version',
+      ],
+    },
     {
       'target_name': 'packager_test',
       'type': '<(gtest_target_type)',
@@ -192,6 +212,7 @@
         'media/event/media_event.gyp:media_event_unittest',
         'media/formats/mp2t/mp2t.gyp:mp2t_unittest',
         'media/formats/mp4/mp4.gyp:mp4_unittest',
+        'media/formats/packed_audio/packed_audio.gyp:packed_audio_unittest',
         'media/formats/webm/webm.gyp:webm_unittest',
         'media/formats/webvtt/webvtt.gyp:webvtt_unittest',
         'media/formats/wvm/wvm.gyp:wvm_unittest',
@@ -22,6 +22,10 @@
 
 namespace shaka {
 
+namespace media {
+class KeySource;
+}  // namespace media
+
 /// Parameters used for testing.
 struct TestParams {
   /// Whether to dump input stream info.
@@ -58,9 +62,26 @@ struct PackagingParams {
   EncryptionParams encryption_params;
   DecryptionParams decryption_params;
 
-  /// Buffer callback params.
+  /// Buffer callback params. The callbacks are called on the packaging
+  /// threads, possibly concurrently, see BufferCallbackParams.
   BufferCallbackParams buffer_callback_params;
 
+  /// Memory budget in bytes for the data buffered by the packaging pipelines
+  /// (parser queues, chunking queues, fragments, PES packets and output
+  /// caches). Reading input is throttled while the buffered data exceeds the
+  /// budget. 0 means unlimited.
+  /// The budget is process wide: it is shared by, and also throttles, the
+  /// Packager instances without a budget. Packager instances running at the
+  /// same time must not set different budgets; Initialize() fails if they
+  /// do.
+  uint64_t memory_budget = 0;
+
+  /// Output file for live latency tracing. If set, the wall clock time of
+  /// every segment is recorded from the ingest of its first sample to the
+  /// publication of the manifests, and latency histograms of the stages are
+  /// written to this file in JSON, updated as segments are published.
+  std::string latency_trace_output;
+
   // Parameters for testing. Do not use in production.
   TestParams test_params;
 };
@@ -86,6 +107,13 @@ struct StreamDescriptor {
   /// If set to true, the stream will not be encrypted. This is useful, e.g. to
   /// encrypt only video streams.
   bool skip_encryption = false;
+  /// Optional protection scheme of the output, which overrides
+  /// EncryptionParams::protection_scheme if set to one of the
+  /// EncryptionParams::kProtectionScheme* values. Outputs of the same input
+  /// stream can be encrypted with different protection schemes, or left
+  /// clear with `skip_encryption`, while the input is demuxed and chunked only
+  /// once.
+  uint32_t protection_scheme = 0;
   /// Specifies a custom DRM stream label, which can be a DRM label defined by
   /// the DRM system. Typically values include AUDIO, SD, HD, UHD1, UHD2. If not
   /// provided, the DRM stream label is derived from stream type (video, audio),
@@ -167,6 +195,21 @@ class SHAKA_EXPORT Packager {
   Packager(const Packager&) = delete;
   Packager& operator=(const Packager&) = delete;
 
+  friend class PackagerService;
+
+  // Same as the public Initialize, but encrypts with @a encryption_key_source
+  // if it is not null instead of creating a key source from
+  // `packaging_params.encryption_params`. Used by PackagerService to share
+  // key sources between jobs.
+  Status Initialize(const PackagingParams& packaging_params,
+                    const std::vector<StreamDescriptor>& stream_descriptors,
+                    std::shared_ptr<media::KeySource> encryption_key_source);
+
+  // Gets the number of (sub)segments, and their size in bytes, written so far.
+  // Can be called from any thread once initialized. Used by PackagerService to
+  // report the progress of its jobs.
+  void GetOutputProgress(uint64_t* num_segments, uint64_t* num_bytes) const;
+
   struct PackagerInternal;
   std::unique_ptr<PackagerInternal> internal_;
 };
@@ -0,0 +1,407 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/packager_service.h"
+
+#include <map>
+#include <string>
+
+#include "packager/app/packager_util.h"
+#include "packager/base/logging.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/simple_thread.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/fourccs.h"
+#include "packager/media/base/key_source.h"
+
+namespace shaka {
+
+namespace {
+
+// Key sources not used by any job are dropped once the service holds this
+// many key sources.
+const size_t kMaxSharedKeySources = 16;
+
+bool IsFinalState(PackagerService::JobState state) {
+  return state == PackagerService::JobState::kCompleted ||
+         state == PackagerService::JobState::kFailed ||
+         state == PackagerService::JobState::kCancelled;
+}
+
+void AppendField(const std::string& field, std::string* key) {
+  key->append(std::to_string(field.size()));
+  key->push_back(':');
+  key->append(field);
+}
+
+void AppendField(const std::vector<uint8_t>& field, std::string* key) {
+  AppendField(std::string(field.begin(), field.end()), key);
+}
+
+// Widevine key sources shared by the jobs with the same key request, so the
+// keys, and the connection to the key server, are reused instead of being
+// fetched again by every job. Key sources with key rotation are not shared,
+// as the crypto period keys they produce follow the progress of a single job.
+class SharedKeySources {
+ public:
+  SharedKeySources() {}
+
+  // Gets the key source shared by the jobs with |encryption_params|,
+  // creating it if needed. |key_source| is set to null if the key source
+  // should not be shared, in which case the job creates its own.
+  Status GetKeySource(const EncryptionParams& encryption_params,
+                      std::shared_ptr<media::KeySource>* key_source) {
+    key_source->reset();
+    if (encryption_params.key_provider != KeyProvider::kWidevine ||
+        encryption_params.crypto_period_duration_in_seconds > 0) {
+      return Status::OK;
+    }
+    const std::string key = GetCacheKey(encryption_params);
+
+    // Keys are fetched with the lock held, so that concurrent jobs with the
+    // same request wait for a single fetch.
+    base::AutoLock auto_lock(lock_);
+    auto iter = key_sources_.find(key);
+    if (iter != key_sources_.end()) {
+      *key_source = iter->second;
+      return Status::OK;
+    }
+    std::shared_ptr<media::KeySource> new_key_source =
+        CreateEncryptionKeySource(
+            static_cast<media::FourCC>(encryption_params.protection_scheme),
+            encryption_params);
+    if (!new_key_source)
+      return Status(error::INVALID_ARGUMENT, "Failed to create key source.");
+    EvictIdleKeySources();
+    key_sources_[key] = new_key_source;
+    *key_source = std::move(new_key_source);
+    return Status::OK;
+  }
+
+ private:
+  SharedKeySources(const SharedKeySources&) = delete;
+  SharedKeySources& operator=(const SharedKeySources&) = delete;
+
+  // Identifies the key request, i.e. all the parameters used to create the
+  // key source.
+  static std::string GetCacheKey(const EncryptionParams& encryption_params) {
+    const WidevineEncryptionParams& widevine = encryption_params.widevine;
+    std::string key;
+    AppendField(std::to_string(encryption_params.protection_scheme), &key);
+    AppendField(widevine.key_server_url, &key);
+    AppendField(widevine.include_common_pssh ? "1" : "0", &key);
+    AppendField(widevine.content_id, &key);
+    AppendField(widevine.policy, &key);
+    AppendField(widevine.signer.signer_name, &key);
+    AppendField(
+        std::to_string(static_cast<int>(widevine.signer.signing_key_type)),
+        &key);
+    AppendField(widevine.signer.aes.key, &key);
+    AppendField(widevine.signer.aes.iv, &key);
+    AppendField(widevine.signer.rsa.key, &key);
+    AppendField(widevine.group_id, &key);
+    AppendField(widevine.enable_key_cache ? "1" : "0", &key);
+    AppendField(widevine.key_cache_directory, &key);
+    AppendField(widevine.key_cache_encryption_key, &key);
+    return key;
+  }
+
+  // Drops key sources not used by any job once there are too many of them.
+  void EvictIdleKeySources() {
+    lock_.AssertAcquired();
+    auto iter = key_sources_.begin();
+    while (key_sources_.size() >= kMaxSharedKeySources &&
+           iter != key_sources_.end()) {
+      if (iter->second.use_count() == 1)
+        iter = key_sources_.erase(iter);
+      else
+        ++iter;
+    }
+  }
+
+  base::Lock lock_;
+  std::map<std::string, std::shared_ptr<media::KeySource>> key_sources_;
+};
+
+// Initializes the Packager of a job. It is created by PackagerService, which
+// can initialize Packager with a shared key source.
+typedef std::function<Status(const PackagingParams& packaging_params,
+                             const std::vector<StreamDescriptor>& descriptors,
+                             Packager* packager)>
+    PackagerInitializer;
+
+// A single packaging job scheduled on the service thread pool.
+class ServiceJob : public base::DelegateSimpleThread::Delegate,
+                   public std::enable_shared_from_this<ServiceJob> {
+ public:
+  ServiceJob(int64_t job_id,
+             const PackagingParams& packaging_params,
+             const std::vector<StreamDescriptor>& stream_descriptors,
+             const PackagerService::JobCallback& job_callback,
+             const PackagerInitializer& packager_initializer)
+      : job_id_(job_id),
+        packaging_params_(packaging_params),
+        stream_descriptors_(stream_descriptors),
+        job_callback_(job_callback),
+        packager_initializer_(packager_initializer),
+        queued_time_(base::TimeTicks::Now()),
+        done_(base::WaitableEvent::ResetPolicy::MANUAL,
+              base::WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+  // Adds the job to |thread_pool|. The worker thread keeps the job alive until
+  // Run() returns, as the job may be released as soon as it is finished.
+  void Schedule(base::DelegateSimpleThreadPool* thread_pool) {
+    self_ = shared_from_this();
+    thread_pool->AddWork(this);
+  }
+
+  void Run() override {
+    std::shared_ptr<ServiceJob> self = std::move(self_);
+    PackagerService::JobInfo job_info;
+    {
+      base::AutoLock auto_lock(lock_);
+      job_info_.queued_seconds =
+          (base::TimeTicks::Now() - queued_time_).InSecondsF();
+      if (cancel_requested_) {
+        FinishWithLockHeld(PackagerService::JobState::kCancelled,
+                           Status(error::CANCELLED, "Cancelled while queued."),
+                           &job_info);
+      } else {
+        job_info_.state = PackagerService::JobState::kRunning;
+        job_info = job_info_;
+      }
+    }
+    Notify(job_info);
+    if (IsFinalState(job_info.state)) {
+      done_.Signal();
+      return;
+    }
+
+    const base::TimeTicks start_time = base::TimeTicks::Now();
+    Packager packager;
+    Status status = packager_initializer_(packaging_params_,
+                                          stream_descriptors_, &packager);
+    if (status.ok()) {
+      bool cancelled = false;
+      {
+        base::AutoLock auto_lock(lock_);
+        cancelled = cancel_requested_;
+        if (!cancelled)
+          packager_ = &packager;
+      }
+      status = cancelled ? Status(error::CANCELLED, "Job cancelled.")
+                         : packager.Run();
+      base::AutoLock auto_lock(lock_);
+      packager.GetOutputProgress(&job_info_.segments_written,
+                                 &job_info_.bytes_written);
+      packager_ = nullptr;
+    }
+
+    {
+      base::AutoLock auto_lock(lock_);
+      job_info_.running_seconds =
+          (base::TimeTicks::Now() - start_time).InSecondsF();
+      PackagerService::JobState state = PackagerService::JobState::kCompleted;
+      if (!status.ok()) {
+        state = cancel_requested_ ? PackagerService::JobState::kCancelled
+                                  : PackagerService::JobState::kFailed;
+      }
+      FinishWithLockHeld(state, status, &job_info);
+    }
+    Notify(job_info);
+    done_.Signal();
+  }
+
+  void Cancel() {
+    base::AutoLock auto_lock(lock_);
+    cancel_requested_ = true;
+    if (packager_)
+      packager_->Cancel();
+  }
+
+  PackagerService::JobInfo job_info() const {
+    base::AutoLock auto_lock(lock_);
+    PackagerService::JobInfo job_info = job_info_;
+    if (packager_) {
+      packager_->GetOutputProgress(&job_info.segments_written,
+                                   &job_info.bytes_written);
+    }
+    return job_info;
+  }
+
+  PackagerService::JobInfo Wait() {
+    done_.Wait();
+    return job_info();
+  }
+
+  bool IsFinished() const { return done_.IsSignaled(); }
+
+ private:
+  ServiceJob(const ServiceJob&) = delete;
+  ServiceJob& operator=(const ServiceJob&) = delete;
+
+  void FinishWithLockHeld(PackagerService::JobState state,
+                          const Status& status,
+                          PackagerService::JobInfo* job_info) {
+    lock_.AssertAcquired();
+    job_info_.state = state;
+    job_info_.status = status;
+    *job_info = job_info_;
+  }
+
+  void Notify(const PackagerService::JobInfo& job_info) {
+    if (job_callback_)
+      job_callback_(job_id_, job_info);
+  }
+
+  const int64_t job_id_;
+  const PackagingParams packaging_params_;
+  const std::vector<StreamDescriptor> stream_descriptors_;
+  const PackagerService::JobCallback job_callback_;
+  const PackagerInitializer packager_initializer_;
+  const base::TimeTicks queued_time_;
+
+  mutable base::Lock lock_;
+  // Protected by |lock_|.
+  PackagerService::JobInfo job_info_;
+  bool cancel_requested_ = false;
+  Packager* packager_ = nullptr;
+
+  // Signalled when the job reaches a final state. Mutable as
+  // WaitableEvent::IsSignaled is not const.
+  mutable base::WaitableEvent done_;
+  // Keeps the job alive from Schedule() until Run() starts.
+  std::shared_ptr<ServiceJob> self_;
+};
+
+}  // namespace
+
+struct PackagerService::ServiceInternal {
+  explicit ServiceInternal(const PackagerServiceParams& params)
+      : thread_pool("PackagerServiceWorker", params.max_concurrent_jobs) {}
+
+  base::DelegateSimpleThreadPool thread_pool;
+  JobCallback job_callback;
+  SharedKeySources key_sources;
+
+  mutable base::Lock lock;
+  // Protected by |lock|.
+  bool started = false;
+  bool stopped = false;
+  int64_t next_job_id = 1;
+  std::map<int64_t, std::shared_ptr<ServiceJob>> jobs;
+
+  std::shared_ptr<ServiceJob> FindJob(int64_t job_id) const {
+    base::AutoLock auto_lock(lock);
+    auto iter = jobs.find(job_id);
+    return iter == jobs.end() ? nullptr : iter->second;
+  }
+};
+
+PackagerService::PackagerService(const PackagerServiceParams& params)
+    : internal_(new ServiceInternal(params)) {
+  DCHECK_GT(params.max_concurrent_jobs, 0);
+}
+
+PackagerService::~PackagerService() {
+  Shutdown();
+}
+
+Status PackagerService::Start() {
+  base::AutoLock auto_lock(internal_->lock);
+  if (internal_->started)
+    return Status(error::INVALID_ARGUMENT, "Already started.");
+  internal_->started = true;
+  internal_->thread_pool.Start();
+  return Status::OK;
+}
+
+int64_t PackagerService::AddJob(
+    const PackagingParams& packaging_params,
+    const std::vector<StreamDescriptor>& stream_descriptors) {
+  base::AutoLock auto_lock(internal_->lock);
+  if (!internal_->started || internal_->stopped) {
+    LOG(ERROR) << "PackagerService is not running.";
+    return -1;
+  }
+  const int64_t job_id = internal_->next_job_id++;
+  SharedKeySources* key_sources = &internal_->key_sources;
+  PackagerInitializer packager_initializer =
+      [key_sources](const PackagingParams& packaging_params,
+                    const std::vector<StreamDescriptor>& stream_descriptors,
+                    Packager* packager) {
+        std::shared_ptr<media::KeySource> key_source;
+        Status status = key_sources->GetKeySource(
+            packaging_params.encryption_params, &key_source);
+        if (!status.ok())
+          return status;
+        return packager->Initialize(packaging_params, stream_descriptors,
+                                    std::move(key_source));
+      };
+  std::shared_ptr<ServiceJob> job(
+      new ServiceJob(job_id, packaging_params, stream_descriptors,
+                     internal_->job_callback, packager_initializer));
+  internal_->jobs[job_id] = job;
+  job->Schedule(&internal_->thread_pool);
+  return job_id;
+}
+
+void PackagerService::CancelJob(int64_t job_id) {
+  std::shared_ptr<ServiceJob> job = internal_->FindJob(job_id);
+  if (job)
+    job->Cancel();
+}
+
+bool PackagerService::GetJobInfo(int64_t job_id, JobInfo* job_info) const {
+  DCHECK(job_info);
+  std::shared_ptr<ServiceJob> job = internal_->FindJob(job_id);
+  if (!job)
+    return false;
+  *job_info = job->job_info();
+  return true;
+}
+
+bool PackagerService::WaitForJob(int64_t job_id, JobInfo* job_info) {
+  DCHECK(job_info);
+  std::shared_ptr<ServiceJob> job = internal_->FindJob(job_id);
+  if (!job)
+    return false;
+  *job_info = job->Wait();
+  return true;
+}
+
+bool PackagerService::ReleaseJob(int64_t job_id) {
+  base::AutoLock auto_lock(internal_->lock);
+  auto iter = internal_->jobs.find(job_id);
+  if (iter == internal_->jobs.end() || !iter->second->IsFinished())
+    return false;
+  internal_->jobs.erase(iter);
+  return true;
+}
+
+void PackagerService::Shutdown() {
+  {
+    base::AutoLock auto_lock(internal_->lock);
+    if (!internal_->started || internal_->stopped)
+      return;
+    internal_->stopped = true;
+    for (auto& entry : internal_->jobs) {
+      if (entry.second->job_info().state == JobState::kQueued)
+        entry.second->Cancel();
+    }
+  }
+  // Queued (cancelled) jobs are drained before the worker threads exit.
+  internal_->thread_pool.JoinAll();
+}
+
+void PackagerService::set_job_callback(const JobCallback& job_callback) {
+  base::AutoLock auto_lock(internal_->lock);
+  DCHECK(!internal_->started);
+  internal_->job_callback = job_callback;
+}
+
+}  // namespace shaka
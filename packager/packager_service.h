@@ -0,0 +1,117 @@
+// Copyright 2017 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_PACKAGER_SERVICE_H_
+#define PACKAGER_PACKAGER_SERVICE_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "packager/packager.h"
+
+namespace shaka {
+
+/// Parameters for the long running packager service.
+struct PackagerServiceParams {
+  /// The maximum number of packaging jobs that run concurrently. Additional
+  /// jobs are queued until a running job completes.
+  int max_concurrent_jobs = 4;
+};
+
+/// PackagerService runs many independent packaging jobs in a single process.
+/// Process-wide initialization is done once, jobs are scheduled on a fixed
+/// pool of worker threads and each job is packaged by its own Packager
+/// instance. Widevine key sources without key rotation are shared by the jobs
+/// with the same encryption parameters, so keys are fetched once and the
+/// connection to the key server is reused.
+class SHAKA_EXPORT PackagerService {
+ public:
+  enum class JobState {
+    kQueued,
+    kRunning,
+    kCompleted,
+    kFailed,
+    kCancelled,
+  };
+
+  /// Progress and status of a single job.
+  struct JobInfo {
+    JobState state = JobState::kQueued;
+    /// The job status. Only meaningful when the job is in a final state, i.e.
+    /// kCompleted, kFailed or kCancelled.
+    Status status;
+    /// Time spent waiting in the queue, in seconds.
+    double queued_seconds = 0;
+    /// Time spent initializing and running the job, in seconds.
+    double running_seconds = 0;
+    /// Number of segments, or subsegments for single file outputs, written
+    /// so far by all the streams of the job.
+    uint64_t segments_written = 0;
+    /// Size of these segments, in bytes.
+    uint64_t bytes_written = 0;
+  };
+
+  /// Called on job state changes. It is invoked on the worker thread running
+  /// the job, so it should not block.
+  typedef std::function<void(int64_t job_id, const JobInfo& job_info)>
+      JobCallback;
+
+  explicit PackagerService(const PackagerServiceParams& params);
+  /// Cancels queued jobs and waits for running jobs to finish.
+  ~PackagerService();
+
+  /// Start the worker threads.
+  /// @return OK on success, an appropriate error code on failure.
+  Status Start();
+
+  /// Queue a packaging job.
+  /// @param packaging_params contains the packaging parameters of the job.
+  /// @param stream_descriptors a list of stream descriptors of the job.
+  /// @return A positive job id on success, or a negative value if the service
+  ///         is not running.
+  int64_t AddJob(const PackagingParams& packaging_params,
+                 const std::vector<StreamDescriptor>& stream_descriptors);
+
+  /// Cancel a job. A queued job is dropped; a running job is cancelled and
+  /// finishes with an error status. It is a no-op for finished jobs.
+  void CancelJob(int64_t job_id);
+
+  /// Get the current progress and status of a job.
+  /// @return true if @a job_id is a known job, false otherwise.
+  bool GetJobInfo(int64_t job_id, JobInfo* job_info) const;
+
+  /// Block until the job finishes.
+  /// @return true if @a job_id is a known job, false otherwise.
+  bool WaitForJob(int64_t job_id, JobInfo* job_info);
+
+  /// Forget a finished job and release its resources. Long running services
+  /// should release jobs once their status has been consumed.
+  /// @return true if the job was released, false if the job is unknown or not
+  ///         finished yet.
+  bool ReleaseJob(int64_t job_id);
+
+  /// Stop accepting new jobs, cancel queued jobs and wait for running jobs to
+  /// finish.
+  void Shutdown();
+
+  /// Set a callback to be notified of job state changes. Must be called before
+  /// Start().
+  void set_job_callback(const JobCallback& job_callback);
+
+ private:
+  PackagerService(const PackagerService&) = delete;
+  PackagerService& operator=(const PackagerService&) = delete;
+
+  struct ServiceInternal;
+  std::unique_ptr<ServiceInternal> internal_;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_PACKAGER_SERVICE_H_
@@ -7,13 +7,19 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <map>
+
+#include "packager/base/base64.h"
 #include "packager/base/files/file_util.h"
 #include "packager/base/logging.h"
 #include "packager/base/path_service.h"
 #include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/synchronization/lock.h"
 #include "packager/packager.h"
+#include "packager/packager_service.h"
 
 using testing::_;
+using testing::ElementsAre;
 using testing::Invoke;
 using testing::MockFunction;
 using testing::Return;
@@ -29,10 +35,18 @@ const char kOutputVideo[] = "output_video.mp4";
 const char kOutputVideoTemplate[] = "output_video_$Number$.m4s";
 const char kOutputAudio[] = "output_audio.mp4";
 const char kOutputMpd[] = "output.mpd";
+const char kOutputCenc[] = "output_cenc.mp4";
+const char kOutputCbcs[] = "output_cbcs.mp4";
+const char kOutputClear[] = "output_clear.mp4";
+const char kOutputTsTemplate[] = "output_$Number$.ts";
+const char kOutputMasterPlaylist[] = "master.m3u8";
+const char kOutputMediaPlaylist[] = "output.m3u8";
 
 const double kSegmentDurationInSeconds = 1.0;
 const char kKeyIdHex[] = "e5007e6e9dcd5ac095202ed3758382cd";
 const char kKeyHex[] = "6fc96fe628a265b13aeddec0bc421f4d";
+const char kAudioKeyIdHex[] = "2a0ba7c4f5e4b4a8b4f0a8a93a3c2e1d";
+const char kAudioKeyHex[] = "1ae8ccd0e7985cc0b6203a55855a1034";
 const double kClearLeadInSeconds = 1.0;
 
 std::string GetTestDataFilePath(const std::string& name) {
@@ -47,6 +61,16 @@ std::string GetTestDataFilePath(const std::string& name) {
   return file_path.AsUTF8Unsafe();
 }
 
+// Returns the scheme type in the first 'schm' box of an MP4 file, or an empty
+// string if the file is not encrypted.
+std::string GetSchemeType(const std::string& contents) {
+  const size_t pos = contents.find("schm");
+  if (pos == std::string::npos)
+    return std::string();
+  // The box type is followed by the version and flags, then the scheme type.
+  return contents.substr(pos + 8, 4);
+}
+
 }  // namespace
 
 class PackagerTest : public ::testing::Test {
@@ -101,6 +125,82 @@ class PackagerTest : public ::testing::Test {
     return stream_descriptors;
   }
 
+  std::string ReadOutput(const std::string& file_name) {
+    std::string contents;
+    EXPECT_TRUE(base::ReadFileToString(
+        base::FilePath::FromUTF8Unsafe(GetFullPath(file_name)), &contents));
+    return contents;
+  }
+
+  // Packages |input| with the outputs in |stream_descriptors|, and checks
+  // that the input is read only once.
+  void PackageOnce(const std::string& input,
+                   std::vector<StreamDescriptor> stream_descriptors) {
+    auto packaging_params = SetupPackagingParams();
+    packaging_params.mpd_params.mpd_output.clear();
+
+    // The outputs of an input share its demuxer, so the input is read once.
+    // Separate demuxers would read the same FILE, so they could not produce
+    // complete outputs either. A demuxer stream feeds a single handler, so
+    // the outputs of a stream also share its chunker.
+    FILE* file_ptr =
+        base::OpenFile(base::FilePath::FromUTF8Unsafe(input), "rb");
+    ASSERT_TRUE(file_ptr);
+    int64_t bytes_read = 0;
+    packaging_params.buffer_callback_params.read_func =
+        [file_ptr, &bytes_read](const std::string& name, void* buffer,
+                                uint64_t size) {
+          const int64_t result = fread(buffer, sizeof(char), size, file_ptr);
+          bytes_read += result;
+          return result;
+        };
+    for (StreamDescriptor& stream_descriptor : stream_descriptors)
+      stream_descriptor.input = input;
+
+    Packager packager;
+    ASSERT_EQ(Status::OK,
+              packager.Initialize(packaging_params, stream_descriptors));
+    ASSERT_EQ(Status::OK, packager.Run());
+    base::CloseFile(file_ptr);
+
+    int64_t file_size = 0;
+    ASSERT_TRUE(
+        base::GetFileSize(base::FilePath::FromUTF8Unsafe(input), &file_size));
+    EXPECT_EQ(file_size, bytes_read);
+  }
+
+  // Packages |stream_selector| of |file_name| again, clear and with a fixed
+  // clock, decrypting it with the test key if |decrypt| is set.
+  std::string Repackage(const std::string& file_name,
+                        const std::string& stream_selector,
+                        bool decrypt) {
+    PackagingParams packaging_params;
+    packaging_params.temp_dir = test_directory_.AsUTF8Unsafe();
+    packaging_params.chunking_params.segment_duration_in_seconds =
+        kSegmentDurationInSeconds;
+    packaging_params.test_params.inject_fake_clock = true;
+    if (decrypt) {
+      DecryptionParams& decryption_params = packaging_params.decryption_params;
+      decryption_params.key_provider = KeyProvider::kRawKey;
+      CHECK(base::HexStringToBytes(
+          kKeyIdHex, &decryption_params.raw_key.key_map[""].key_id));
+      CHECK(base::HexStringToBytes(
+          kKeyHex, &decryption_params.raw_key.key_map[""].key));
+    }
+
+    const std::string output = "repackaged_" + file_name;
+    StreamDescriptor stream_descriptor;
+    stream_descriptor.input = GetFullPath(file_name);
+    stream_descriptor.stream_selector = stream_selector;
+    stream_descriptor.output = GetFullPath(output);
+
+    Packager packager;
+    EXPECT_EQ(Status::OK,
+              packager.Initialize(packaging_params, {stream_descriptor}));
+    EXPECT_EQ(Status::OK, packager.Run());
+    return ReadOutput(output);
+  }
+
  protected:
   base::FilePath test_directory_;
 };
@@ -184,6 +284,30 @@ TEST_F(PackagerTest, WriteOutputToBuffer) {
   ASSERT_EQ(Status::OK, packager.Run());
 }
 
+TEST_F(PackagerTest, WriteOutputToFileReadyCallback) {
+  auto packaging_params = SetupPackagingParams();
+
+  // The callback is called concurrently from the packaging threads.
+  base::Lock lock;
+  std::map<std::string, std::shared_ptr<const std::vector<uint8_t>>> files;
+  packaging_params.buffer_callback_params.file_ready_func =
+      [&lock, &files](const std::string& name,
+                      std::shared_ptr<const std::vector<uint8_t>> buffer) {
+        base::AutoLock auto_lock(lock);
+        files[name] = std::move(buffer);
+      };
+
+  Packager packager;
+  ASSERT_EQ(Status::OK,
+            packager.Initialize(packaging_params, SetupStreamDescriptors()));
+  ASSERT_EQ(Status::OK, packager.Run());
+
+  for (const char* output : {kOutputVideo, kOutputAudio, kOutputMpd}) {
+    ASSERT_TRUE(files[GetFullPath(output)]) << output;
+    EXPECT_FALSE(files[GetFullPath(output)]->empty()) << output;
+  }
+}
+
 TEST_F(PackagerTest, ReadFromBuffer) {
   auto packaging_params = SetupPackagingParams();
 
@@ -226,6 +350,205 @@ TEST_F(PackagerTest, ReadFromBufferFailed) {
   ASSERT_EQ(error::FILE_FAILURE, packager.Run().error_code());
 }
 
+TEST_F(PackagerTest, ServiceRunsJobsConcurrently) {
+  PackagerServiceParams service_params;
+  service_params.max_concurrent_jobs = 2;
+  PackagerService service(service_params);
+  ASSERT_EQ(Status::OK, service.Start());
+
+  const int kNumJobs = 3;
+  std::vector<int64_t> job_ids;
+  for (int i = 0; i < kNumJobs; ++i) {
+    const std::string prefix = base::IntToString(i) + "_";
+    auto packaging_params = SetupPackagingParams();
+    packaging_params.mpd_params.mpd_output = GetFullPath(prefix + kOutputMpd);
+    auto stream_descriptors = SetupStreamDescriptors();
+    stream_descriptors[0].output = GetFullPath(prefix + kOutputVideo);
+    stream_descriptors[1].output = GetFullPath(prefix + kOutputAudio);
+    const int64_t job_id =
+        service.AddJob(packaging_params, stream_descriptors);
+    ASSERT_GT(job_id, 0);
+    job_ids.push_back(job_id);
+  }
+
+  for (int64_t job_id : job_ids) {
+    PackagerService::JobInfo job_info;
+    ASSERT_TRUE(service.WaitForJob(job_id, &job_info));
+    EXPECT_EQ(PackagerService::JobState::kCompleted, job_info.state);
+    EXPECT_EQ(Status::OK, job_info.status);
+    EXPECT_GT(job_info.segments_written, 0u);
+    EXPECT_GT(job_info.bytes_written, 0u);
+    EXPECT_TRUE(service.ReleaseJob(job_id));
+  }
+  PackagerService::JobInfo job_info;
+  EXPECT_FALSE(service.GetJobInfo(job_ids[0], &job_info));
+}
+
+TEST_F(PackagerTest, ServiceReportsJobFailure) {
+  std::vector<PackagerService::JobState> states;
+  PackagerService service(PackagerServiceParams{});
+  service.set_job_callback(
+      [&states](int64_t job_id, const PackagerService::JobInfo& job_info) {
+        states.push_back(job_info.state);
+      });
+  ASSERT_EQ(Status::OK, service.Start());
+
+  const int64_t job_id =
+      service.AddJob(SetupPackagingParams(), std::vector<StreamDescriptor>());
+  PackagerService::JobInfo job_info;
+  ASSERT_TRUE(service.WaitForJob(job_id, &job_info));
+  EXPECT_EQ(PackagerService::JobState::kFailed, job_info.state);
+  EXPECT_EQ(error::INVALID_ARGUMENT, job_info.status.error_code());
+
+  service.Shutdown();
+  EXPECT_THAT(states, ElementsAre(PackagerService::JobState::kRunning,
+                                  PackagerService::JobState::kFailed));
+}
+
+TEST_F(PackagerTest, ServiceRejectsJobsAfterShutdown) {
+  PackagerService service(PackagerServiceParams{});
+  ASSERT_EQ(Status::OK, service.Start());
+  service.Shutdown();
+  EXPECT_LT(service.AddJob(SetupPackagingParams(), SetupStreamDescriptors()),
+            0);
+}
+
+TEST_F(PackagerTest, ProtectionSchemePerOutput) {
+  std::vector<StreamDescriptor> stream_descriptors(3);
+  for (StreamDescriptor& stream_descriptor : stream_descriptors)
+    stream_descriptor.stream_selector = "video";
+  stream_descriptors[0].output = GetFullPath(kOutputCenc);
+  stream_descriptors[0].protection_scheme =
+      EncryptionParams::kProtectionSchemeCenc;
+  stream_descriptors[1].output = GetFullPath(kOutputCbcs);
+  stream_descriptors[1].protection_scheme =
+      EncryptionParams::kProtectionSchemeCbcs;
+  stream_descriptors[2].output = GetFullPath(kOutputClear);
+  stream_descriptors[2].skip_encryption = true;
+  ASSERT_NO_FATAL_FAILURE(
+      PackageOnce(GetTestDataFilePath(kTestFile), stream_descriptors));
+
+  EXPECT_EQ("cenc", GetSchemeType(ReadOutput(kOutputCenc)));
+  EXPECT_EQ("cbcs", GetSchemeType(ReadOutput(kOutputCbcs)));
+  EXPECT_EQ("", GetSchemeType(ReadOutput(kOutputClear)));
+
+  // Both encrypted outputs decrypt to the clear output.
+  const std::string clear = Repackage(kOutputClear, "video", false);
+  ASSERT_FALSE(clear.empty());
+  EXPECT_EQ(clear, Repackage(kOutputCenc, "video", true));
+  EXPECT_EQ(clear, Repackage(kOutputCbcs, "video", true));
+}
+
+TEST_F(PackagerTest, ClearAndEncryptedOutputs) {
+  std::vector<StreamDescriptor> stream_descriptors(2);
+  for (StreamDescriptor& stream_descriptor : stream_descriptors)
+    stream_descriptor.stream_selector = "audio";
+  // Encrypted with the default protection scheme.
+  stream_descriptors[0].output = GetFullPath(kOutputCenc);
+  stream_descriptors[1].output = GetFullPath(kOutputClear);
+  stream_descriptors[1].skip_encryption = true;
+  ASSERT_NO_FATAL_FAILURE(
+      PackageOnce(GetTestDataFilePath(kTestFile), stream_descriptors));
+
+  EXPECT_EQ("cenc", GetSchemeType(ReadOutput(kOutputCenc)));
+  EXPECT_EQ("", GetSchemeType(ReadOutput(kOutputClear)));
+
+  const std::string clear = Repackage(kOutputClear, "audio", false);
+  ASSERT_FALSE(clear.empty());
+  EXPECT_EQ(clear, Repackage(kOutputCenc, "audio", true));
+}
+
+// Audio and video multiplexed in a transport stream have a single playlist,
+// which lists both codecs.
+TEST_F(PackagerTest, MultiplexedTs) {
+  auto packaging_params = SetupPackagingParams();
+  packaging_params.mpd_params.mpd_output.clear();
+  packaging_params.hls_params.master_playlist_output =
+      GetFullPath(kOutputMasterPlaylist);
+
+  std::vector<StreamDescriptor> stream_descriptors(2);
+  stream_descriptors[0].stream_selector = "video";
+  stream_descriptors[1].stream_selector = "audio";
+  for (StreamDescriptor& stream_descriptor : stream_descriptors) {
+    stream_descriptor.input = GetTestDataFilePath(kTestFile);
+    stream_descriptor.segment_template = GetFullPath(kOutputTsTemplate);
+    stream_descriptor.skip_encryption = true;
+    stream_descriptor.hls_playlist_name = kOutputMediaPlaylist;
+  }
+
+  Packager packager;
+  ASSERT_EQ(Status::OK,
+            packager.Initialize(packaging_params, stream_descriptors));
+  ASSERT_EQ(Status::OK, packager.Run());
+
+  const std::string master_playlist = ReadOutput(kOutputMasterPlaylist);
+  const std::string kStreamInf = "#EXT-X-STREAM-INF:";
+  const size_t pos = master_playlist.find(kStreamInf);
+  ASSERT_NE(std::string::npos, pos) << master_playlist;
+  EXPECT_EQ(std::string::npos, master_playlist.find(kStreamInf, pos + 1))
+      << master_playlist;
+  EXPECT_THAT(master_playlist,
+              testing::ContainsRegex("CODECS=\"avc1[^,\"]*,mp4a[^,\"]*\""));
+
+  const std::string media_playlist = ReadOutput(kOutputMediaPlaylist);
+  EXPECT_NE(std::string::npos, media_playlist.find("output_1.ts"))
+      << media_playlist;
+}
+
+// Multiplexed streams are encrypted with the key of the video stream when the
+// streams have the default labels, which differ between audio and video.
+TEST_F(PackagerTest, MultiplexedTsEncrypted) {
+  auto packaging_params = SetupPackagingParams();
+  packaging_params.mpd_params.mpd_output.clear();
+  packaging_params.hls_params.master_playlist_output =
+      GetFullPath(kOutputMasterPlaylist);
+  // A key for each default label, with no fallback key.
+  RawKeyParams& raw_key = packaging_params.encryption_params.raw_key;
+  raw_key.key_map.clear();
+  std::vector<uint8_t> video_key_id;
+  ASSERT_TRUE(base::HexStringToBytes(kKeyIdHex, &video_key_id));
+  raw_key.key_map["SD"].key_id = video_key_id;
+  ASSERT_TRUE(base::HexStringToBytes(kKeyHex, &raw_key.key_map["SD"].key));
+  std::vector<uint8_t> audio_key_id;
+  ASSERT_TRUE(base::HexStringToBytes(kAudioKeyIdHex, &audio_key_id));
+  raw_key.key_map["AUDIO"].key_id = audio_key_id;
+  ASSERT_TRUE(
+      base::HexStringToBytes(kAudioKeyHex, &raw_key.key_map["AUDIO"].key));
+
+  // The audio stream comes first.
+  std::vector<StreamDescriptor> stream_descriptors(2);
+  stream_descriptors[0].stream_selector = "audio";
+  stream_descriptors[1].stream_selector = "video";
+  for (StreamDescriptor& stream_descriptor : stream_descriptors) {
+    stream_descriptor.input = GetTestDataFilePath(kTestFile);
+    stream_descriptor.segment_template = GetFullPath(kOutputTsTemplate);
+    stream_descriptor.hls_playlist_name = kOutputMediaPlaylist;
+  }
+
+  Packager packager;
+  ASSERT_EQ(Status::OK,
+            packager.Initialize(packaging_params, stream_descriptors));
+  ASSERT_EQ(Status::OK, packager.Run());
+
+  // The key URI carries the key id.
+  std::string video_key_uri;
+  base::Base64Encode(
+      std::string(video_key_id.begin(), video_key_id.end()), &video_key_uri);
+  std::string audio_key_uri;
+  base::Base64Encode(
+      std::string(audio_key_id.begin(), audio_key_id.end()), &audio_key_uri);
+  const std::string media_playlist = ReadOutput(kOutputMediaPlaylist);
+  const std::string kExtKey = "#EXT-X-KEY:";
+  const size_t pos = media_playlist.find(kExtKey);
+  ASSERT_NE(std::string::npos, pos) << media_playlist;
+  EXPECT_EQ(std::string::npos, media_playlist.find(kExtKey, pos + 1))
+      << media_playlist;
+  EXPECT_NE(std::string::npos, media_playlist.find(video_key_uri))
+      << media_playlist;
+  EXPECT_EQ(std::string::npos, media_playlist.find(audio_key_uri))
+      << media_playlist;
+}
+
 // TODO(kqyang): Add more tests.
 
 }  // namespace shaka